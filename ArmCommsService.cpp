@@ -57,12 +57,17 @@ bool ArmCommsService::ConnectSim()
 {
 	m_lastError.clear();
 	m_connectedCom.clear();
-	m_useSim = true;
-	if (!m_fake.IsOpen())
 	{
-		m_fake.Open();
+		std::lock_guard<std::mutex> portLock(m_portMu);
+		m_useSim = true;
+		if (!m_fake.IsOpen())
+		{
+			m_fake.Open();
+		}
+		std::lock_guard<std::mutex> lock(m_ioMu);
+		m_estimator.Reset();
+		m_connected.store(true, std::memory_order_release);
 	}
-	m_connected = true;
 	LogLine(L"[INFO] Connected (simulated).");
 	return true;
 }
@@ -71,52 +76,187 @@ bool ArmCommsService::ConnectReal(const std::wstring& comName, DWORD baud)
 {
 	m_lastError.clear();
 	m_connectedCom.clear();
-	m_useSim = false;
-	m_fake.Close();
-	if (!m_real.Open(comName, baud))
+	bool opened = false;
+	{
+		std::lock_guard<std::mutex> portLock(m_portMu);
+		m_useSim = false;
+		m_fake.Close();
+		opened = m_real.Open(comName, baud);
+		if (!opened)
+		{
+			m_lastError = m_real.GetLastErrorText();
+		}
+		std::lock_guard<std::mutex> lock(m_ioMu);
+		m_estimator.Reset();
+		m_connected.store(opened, std::memory_order_release);
+	}
+	if (!opened)
 	{
-		m_lastError = m_real.GetLastErrorText();
 		std::wstring msg = L"[ERR] Failed to open serial port: " + m_lastError;
 		LogLine(msg);
-		m_connected = false;
 		return false;
 	}
 	m_connectedCom = comName;
-	m_connected = true;
 	LogLine(L"[INFO] Connected (real).");
 	return true;
 }
 
 void ArmCommsService::Disconnect()
 {
-	if (m_connected)
+	if (IsConnected())
 	{
 		LogLine(L"[INFO] Disconnected.");
 	}
-	m_connected = false;
 	m_connectedCom.clear();
-	m_real.Close();
-	m_fake.Close();
+	{
+		std::lock_guard<std::mutex> portLock(m_portMu);
+		{
+			std::lock_guard<std::mutex> lock(m_ioMu);
+			m_connected.store(false, std::memory_order_release);
+			m_timedSession++;
+		}
+		m_real.Close();
+		m_fake.Close();
+	}
 	ClearTxQueue();
 }
 
 void ArmCommsService::Tick()
 {
+	FlushDeferred();
 	PumpTx();
 	PollRx();
 }
 
+void ArmCommsService::FlushDeferred()
+{
+	// Copied out under the lock (fixed size, no allocation), formatted after releasing it.
+	std::array<TimedTxLog, kTimedLogSize> entries;
+	size_t count = 0;
+	size_t dropped = 0;
+	size_t sends = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_ioMu);
+		if (m_timedLogCount == 0 && m_timedLogDropped == 0 && m_deferredSends == 0) return;
+		count = m_timedLogCount;
+		for (size_t i = 0; i < count; i++)
+		{
+			entries[i] = m_timedLog[(m_timedLogHead + i) % kTimedLogSize];
+		}
+		m_timedLogHead = (m_timedLogHead + count) % kTimedLogSize;
+		m_timedLogCount = 0;
+		dropped = m_timedLogDropped;
+		m_timedLogDropped = 0;
+		sends = m_deferredSends;
+		m_deferredSends = 0;
+	}
+	for (size_t i = 0; i < count; i++)
+	{
+		const TimedTxLog& e = entries[i];
+		if (e.written)
+		{
+			std::wstring line = L"[TX] " + ArmProtocol::ToHex(e.bytes.data(), e.stored);
+			if (e.stored < e.len) line += L" ... (" + std::to_wstring(e.len) + L" bytes)";
+			LogLine(line);
+		}
+		else
+		{
+			std::wstring err;
+			{
+				std::lock_guard<std::mutex> portLock(m_portMu);
+				err = m_real.GetLastErrorText();
+			}
+			LogLine(L"[ERR] Write failed: " + err);
+		}
+	}
+	if (dropped > 0)
+	{
+		LogLine(L"[WARN] " + std::to_wstring(dropped) + L" timed TX log lines dropped.");
+	}
+	if (m_sendStatsCb)
+	{
+		for (size_t i = 0; i < sends; i++) m_sendStatsCb();
+	}
+}
+
 void ArmCommsService::ClearTxQueue()
 {
+	for (size_t i = m_txHead; i < m_txQueue.size(); i++)
+	{
+		RecycleTxBuffer(std::move(m_txQueue[i]));
+	}
 	m_txQueue.clear();
+	m_txHead = 0;
 }
 
 void ArmCommsService::EmergencyStop()
 {
 	ClearTxQueue();
+	{
+		// Same order as Disconnect: taking m_portMu waits out an in-flight SendTimed, so no timed frame
+		// can reach the port once this returns.
+		std::lock_guard<std::mutex> portLock(m_portMu);
+		std::lock_guard<std::mutex> lock(m_ioMu);
+		m_timedSession++;
+	}
 	LogLine(L"[WARN] EmergencyStop: TX queue cleared.");
 }
 
+uint32_t ArmCommsService::BeginTimedSession()
+{
+	std::lock_guard<std::mutex> lock(m_ioMu);
+	return ++m_timedSession;
+}
+
+bool ArmCommsService::IsTimedSessionCurrent(uint32_t session) const
+{
+	std::lock_guard<std::mutex> lock(m_ioMu);
+	return session == m_timedSession;
+}
+
+bool ArmCommsService::SendTimed(uint32_t session, const uint8_t* bytes, size_t len)
+{
+	if (!m_connected.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+	std::wstring err;
+	std::lock_guard<std::mutex> portLock(m_portMu);
+	{
+		std::lock_guard<std::mutex> lock(m_ioMu);
+		if (session != m_timedSession)
+		{
+			return false;
+		}
+	}
+	// The port write (up to the write timeout) happens outside m_ioMu.
+	const bool written = WritePortLocked(bytes, len, err);
+
+	// Listeners are UI objects: the bytes are kept in the ring and formatted by FlushDeferred on the UI thread.
+	std::lock_guard<std::mutex> lock(m_ioMu);
+	if (written)
+	{
+		NoteSentLocked(bytes, len);
+		m_deferredSends++;
+	}
+	if (m_hasLogListeners.load(std::memory_order_relaxed))
+	{
+		if (m_timedLogCount < kTimedLogSize)
+		{
+			TimedTxLog& e = m_timedLog[(m_timedLogHead + m_timedLogCount++) % kTimedLogSize];
+			e.stored = static_cast<uint8_t>(std::min(len, kTimedLogBytes));
+			e.len = static_cast<uint16_t>(std::min<size_t>(len, 0xFFFF));
+			e.written = written;
+			std::copy(bytes, bytes + e.stored, e.bytes.begin());
+		}
+		else
+		{
+			m_timedLogDropped++;
+		}
+	}
+	return written;
+}
+
 bool ArmCommsService::GetLastReadPos(uint8_t id, uint16_t& outPos) const
 {
 	if (id < 1 || id > 6) return false;
@@ -132,12 +272,27 @@ void ArmCommsService::ClearReadback()
 		m_lastReadPos[i] = 0;
 		m_lastReadValid[i] = false;
 	}
+	std::lock_guard<std::mutex> lock(m_ioMu);
+	m_estimator.Reset();
+}
+
+bool ArmCommsService::GetServoEstimate(uint8_t id, ServoStateEstimator::State& out) const
+{
+	std::lock_guard<std::mutex> lock(m_ioMu);
+	return m_estimator.Estimate(id, static_cast<double>(GetTickCount64()), out);
+}
+
+ServoStateEstimator::Stats ArmCommsService::GetEstimatorStats() const
+{
+	std::lock_guard<std::mutex> lock(m_ioMu);
+	return m_estimator.GetStats();
 }
 
 int ArmCommsService::AddLogListener(LogListener cb)
 {
 	const int id = m_nextSubId++;
 	m_logSubs.push_back(LogSub{ id, std::move(cb) });
+	m_hasLogListeners.store(true, std::memory_order_relaxed);
 	return id;
 }
 
@@ -145,6 +300,7 @@ void ArmCommsService::RemoveLogListener(int token)
 {
 	m_logSubs.erase(std::remove_if(m_logSubs.begin(), m_logSubs.end(),
 		[token](const LogSub& s) { return s.id == token; }), m_logSubs.end());
+	m_hasLogListeners.store(!m_logSubs.empty(), std::memory_order_relaxed);
 }
 
 int ArmCommsService::AddFrameListener(FrameListener cb)
@@ -167,76 +323,156 @@ int ArmCommsService::GetThrottleMs() const
 
 void ArmCommsService::EnqueueTx(std::vector<uint8_t> bytes)
 {
+	// Compact the consumed prefix only once it dominates (amortized O(1), keeps capacity).
+	if (m_txHead > 0 && m_txHead * 2 >= m_txQueue.size())
+	{
+		m_txQueue.erase(m_txQueue.begin(), m_txQueue.begin() + static_cast<ptrdiff_t>(m_txHead));
+		m_txHead = 0;
+	}
 	m_txQueue.push_back(std::move(bytes));
 }
 
+std::vector<uint8_t> ArmCommsService::AcquireTxBuffer()
+{
+	if (m_txPool.empty())
+	{
+		return std::vector<uint8_t>();
+	}
+	std::vector<uint8_t> buf = std::move(m_txPool.back());
+	m_txPool.pop_back();
+	buf.clear();
+	return buf;
+}
+
+void ArmCommsService::RecycleTxBuffer(std::vector<uint8_t>&& bytes)
+{
+	// Small cap: Jog keeps at most a couple of frames in flight.
+	constexpr size_t kMaxPooled = 8;
+	if (bytes.capacity() == 0 || m_txPool.size() >= kMaxPooled)
+	{
+		return;
+	}
+	m_txPool.push_back(std::move(bytes));
+}
+
 void ArmCommsService::PumpTx()
 {
-	if (m_txQueue.empty())
+	if (m_txHead >= m_txQueue.size())
 	{
 		return;
 	}
+	DWORD lastTx = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_ioMu);
+		lastTx = m_lastTxTick;
+	}
 	const DWORD now = GetTickCount();
 	const int throttle = GetThrottleMs();
-	const DWORD elapsed = now - m_lastTxTick;
-	if (m_lastTxTick != 0 && elapsed < static_cast<DWORD>(throttle))
+	const DWORD elapsed = now - lastTx;
+	if (lastTx != 0 && elapsed < static_cast<DWORD>(throttle))
 	{
 		return;
 	}
-	auto bytes = std::move(m_txQueue.front());
-	m_txQueue.pop_front();
+	auto bytes = std::move(m_txQueue[m_txHead++]);
+	if (m_txHead == m_txQueue.size())
+	{
+		m_txQueue.clear();
+		m_txHead = 0;
+	}
 	TxBytesNow(bytes);
-	m_lastTxTick = GetTickCount();
+	RecycleTxBuffer(std::move(bytes));
 }
 
 void ArmCommsService::TxBytesNow(const std::vector<uint8_t>& bytes)
 {
-	if (!m_connected)
+	if (!IsConnected())
 	{
 		LogLine(L"[WARN] Not connected.");
 		return;
 	}
 
+	if (!m_logSubs.empty())
 	{
 		const std::wstring hex = ArmProtocol::ToHex(bytes.data(), bytes.size());
 		std::wstring line = L"[TX] " + hex;
 		LogLine(line);
 	}
 
+	std::wstring err;
+	bool written = false;
+	{
+		std::lock_guard<std::mutex> portLock(m_portMu);
+		written = WritePortLocked(bytes.data(), bytes.size(), err);
+		std::lock_guard<std::mutex> lock(m_ioMu);
+		if (written) NoteSentLocked(bytes.data(), bytes.size());
+	}
+	if (!written)
+	{
+		m_lastError = err;
+		std::wstring line = L"[ERR] Write failed: " + m_lastError;
+		LogLine(line);
+	}
+
+	// Notify stats callback (for Control page FPS display)
+	if (m_sendStatsCb) m_sendStatsCb();
+}
+
+bool ArmCommsService::WritePortLocked(const uint8_t* bytes, size_t len, std::wstring& outErr)
+{
+	bool written = true;
 	if (m_useSim)
 	{
 		if (!m_fake.IsOpen()) m_fake.Open();
-		m_fake.Write(bytes.data(), bytes.size());
+		m_fake.Write(bytes, len);
 	}
 	else
 	{
-		if (!m_real.WriteBytes(bytes.data(), bytes.size(), nullptr))
+		if (!m_real.WriteBytes(bytes, len, nullptr))
 		{
-			m_lastError = m_real.GetLastErrorText();
-			std::wstring line = L"[ERR] Write failed: " + m_lastError;
-			LogLine(line);
+			outErr = m_real.GetLastErrorText();
+			written = false;
 		}
 	}
+	return written;
+}
 
-	// Notify stats callback (for Control page FPS display)
-	if (m_sendStatsCb) m_sendStatsCb();
+void ArmCommsService::NoteSentLocked(const uint8_t* bytes, size_t len)
+{
+	m_lastTxTick = GetTickCount();
+
+	// Every sender (Jog, scripts, pages) ends up here, so this is where the estimator learns what the servos were told.
+	constexpr size_t kMaxDecoded = 16;
+	ArmProtocol::ServoTarget moved[kMaxDecoded];
+	uint16_t timeMs = 0;
+	size_t count = 0;
+	if (ArmProtocol::DecodeMove(bytes, len, timeMs, moved, kMaxDecoded, count))
+	{
+		const double now = static_cast<double>(GetTickCount64());
+		for (size_t i = 0; i < count && i < kMaxDecoded; i++)
+		{
+			m_estimator.OnCommand(moved[i].id, moved[i].position, timeMs, now);
+		}
+	}
 }
 
 void ArmCommsService::PollRx()
 {
-	if (!m_connected)
+	if (!IsConnected())
 	{
 		return;
 	}
 
 	std::vector<uint8_t> chunk;
-	if (m_useSim)
-	{
-		chunk = m_fake.ReadAvailable();
-	}
-	else
 	{
-		chunk = m_real.ReadAvailable();
+		std::lock_guard<std::mutex> portLock(m_portMu);
+		if (m_useSim)
+		{
+			chunk = m_fake.ReadAvailable();
+		}
+		else
+		{
+			chunk = m_real.ReadAvailable();
+		}
 	}
 	if (chunk.empty())
 	{
@@ -249,6 +485,8 @@ void ArmCommsService::PollRx()
 		LogLine(line);
 	}
 
+	// Receive time for the estimator: the chunk arrived at most one Tick ago (covered by its readLatencyMs).
+	const double rxMs = static_cast<double>(GetTickCount64());
 	m_rxBuf.insert(m_rxBuf.end(), chunk.begin(), chunk.end());
 	while (!m_rxBuf.empty())
 	{
@@ -284,6 +522,8 @@ void ArmCommsService::PollRx()
 				{
 					m_lastReadPos[s.id] = s.position;
 					m_lastReadValid[s.id] = true;
+					std::lock_guard<std::mutex> lock(m_ioMu);
+					m_estimator.OnReadback(s.id, s.position, rxMs);
 				}
 			}
 		}
@@ -1,14 +1,17 @@
 #pragma once
 
 #include <Windows.h>
+#include <array>
+#include <atomic>
 #include <cstdint>
-#include <deque>
 #include <functional>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "FakeSerialPort.h"
 #include "SerialPortWin32.h"
+#include "ServoStateEstimator.h"
 
 namespace ArmProtocol { struct ParsedFrame; }
 
@@ -16,6 +19,11 @@ namespace ArmProtocol { struct ParsedFrame; }
 // - Single place for connect/disconnect (real/sim)
 // - Throttled TX queue (Throttle\\Ms)
 // - RX polling + protocol parsing + readback cache
+// - Servo state estimate fused from sent Move frames and readbacks (ServoStateEstimator)
+// - Timed sends from the MotionScheduler thread (SendTimed); everything else is UI-thread only.
+//   m_portMu serializes port I/O (a serial write may block up to its timeout); m_ioMu is only held for short
+//   bookkeeping (estimator, TX timestamp, session, timed-TX log ring), so GetServoEstimate never waits on the port.
+//   Lock order: m_portMu before m_ioMu.
 // - Broadcast logs and parsed frames to multiple listeners
 class ArmCommsService
 {
@@ -33,7 +41,7 @@ public:
 	bool ConnectSim();
 	bool ConnectReal(const std::wstring& comName, DWORD baud = CBR_9600);
 	void Disconnect();
-	bool IsConnected() const { return m_connected; }
+	bool IsConnected() const { return m_connected.load(std::memory_order_acquire); }
 	bool IsSim() const { return m_useSim; }
 	std::wstring GetConnectedCom() const { return m_connectedCom; }
 	std::wstring GetLastErrorText() const { return m_lastError; }
@@ -44,12 +52,32 @@ public:
 	// TX queue
 	void ClearTxQueue();
 	void EnqueueTx(std::vector<uint8_t> bytes);
+	// Returns an empty buffer, reusing the capacity of a frame that was already sent or cleared.
+	// Pair with EnqueueTx(std::move(buf)) so periodic senders (Jog) do not allocate per frame.
+	std::vector<uint8_t> AcquireTxBuffer();
 	void EmergencyStop(); // clears queue; optional future: send hold position
+	// Minimum spacing between TX frames (Throttle\Ms). Streams of setpoints must not be denser.
+	int GetThrottleMs() const;
+
+	// Timed sends (MotionScheduler thread): written to the port at once, bypassing the throttled queue
+	// (the schedule is already spaced). Thread-safe; the TX log lines and send stats are delivered on the next Tick.
+	// A session token is valid until EmergencyStop/Disconnect or the next BeginTimedSession; sends with a stale
+	// token are refused, so an emergency stop also silences a playback thread that has not been stopped yet
+	// (EmergencyStop waits for a timed write already in progress, so none is written after it returns).
+	uint32_t BeginTimedSession();
+	bool IsTimedSessionCurrent(uint32_t session) const;
+	bool SendTimed(uint32_t session, const uint8_t* bytes, size_t len);
 
 	// RX / readback
 	bool GetLastReadPos(uint8_t id, uint16_t& outPos) const;
 	void ClearReadback();
 
+	// Servo position/velocity now, predicted from the Move frames sent so far and corrected by readbacks
+	// (ids 1..6). Valid after the first command or readback since connecting; prefer it over GetLastReadPos,
+	// which is stale while the arm moves and empty when nobody requested a read.
+	bool GetServoEstimate(uint8_t id, ServoStateEstimator::State& out) const;
+	ServoStateEstimator::Stats GetEstimatorStats() const;
+
 	// Listeners (caller must remove on destroy)
 	int AddLogListener(LogListener cb);
 	void RemoveLogListener(int token);
@@ -61,15 +89,20 @@ private:
 	ArmCommsService(const ArmCommsService&) = delete;
 	ArmCommsService& operator=(const ArmCommsService&) = delete;
 
-	int GetThrottleMs() const;
 	void PumpTx();
 	void PollRx();
 	void TxBytesNow(const std::vector<uint8_t>& bytes);
+	// Port write; caller holds m_portMu.
+	bool WritePortLocked(const uint8_t* bytes, size_t len, std::wstring& outErr);
+	// TX timestamp + estimator feed for a written frame; caller holds m_ioMu.
+	void NoteSentLocked(const uint8_t* bytes, size_t len);
+	void FlushDeferred();
+	void RecycleTxBuffer(std::vector<uint8_t>&& bytes);
 
 	void LogLine(const std::wstring& line);
 
 private:
-	bool m_connected = false;
+	std::atomic<bool> m_connected{ false };
 	bool m_useSim = true;
 	std::wstring m_connectedCom;
 	std::wstring m_lastError;
@@ -77,9 +110,36 @@ private:
 	SerialPortWin32 m_real;
 	FakeSerialPort m_fake;
 
-	// TX throttling + queue
-	std::deque<std::vector<uint8_t>> m_txQueue;
-	DWORD m_lastTxTick = 0;
+	// TX throttling + queue.
+	// FIFO as vector + head index (a deque allocates per node on MSVC for this element size);
+	// sent/cleared frames go to m_txPool so their capacity is reused by AcquireTxBuffer.
+	std::vector<std::vector<uint8_t>> m_txQueue;
+	size_t m_txHead = 0;
+	std::vector<std::vector<uint8_t>> m_txPool;
+	DWORD m_lastTxTick = 0; // m_ioMu
+
+	// Shared with the scheduler thread.
+	std::mutex m_portMu;
+	mutable std::mutex m_ioMu;
+	uint32_t m_timedSession = 0;
+
+	// Timed sends are logged as raw bytes into a fixed ring (no allocation on the scheduler thread) and
+	// formatted by FlushDeferred on the UI thread. Only filled while a log listener is registered. m_ioMu.
+	static constexpr size_t kTimedLogBytes = 32;  // a Move frame for 6 servos is 25 bytes
+	static constexpr size_t kTimedLogSize = 256;
+	struct TimedTxLog
+	{
+		std::array<uint8_t, kTimedLogBytes> bytes;
+		uint8_t stored = 0;  // bytes kept (longer frames are truncated in the log)
+		uint16_t len = 0;
+		bool written = false;
+	};
+	std::array<TimedTxLog, kTimedLogSize> m_timedLog{};
+	size_t m_timedLogHead = 0;
+	size_t m_timedLogCount = 0;
+	size_t m_timedLogDropped = 0;
+	size_t m_deferredSends = 0;
+	std::atomic<bool> m_hasLogListeners{ false };
 
 	// RX parsing buffer
 	std::vector<uint8_t> m_rxBuf;
@@ -88,6 +148,9 @@ private:
 	uint16_t m_lastReadPos[7] = { 0 };
 	bool m_lastReadValid[7] = { false };
 
+	// Fed by TxBytesNow/SendTimed (sent moves) and PollRx (readbacks); times are GetTickCount64 ms. m_ioMu.
+	ServoStateEstimator m_estimator;
+
 	struct LogSub { int id; LogListener cb; };
 	struct FrameSub { int id; FrameListener cb; };
 	int m_nextSubId = 1;
@@ -39,28 +39,22 @@ double ArmKinematics::WrapToPi(double a)
 	return a;
 }
 
+double ArmKinematics::WrapPitchDeg(double pitchDeg)
+{
+	double p = std::fmod(pitchDeg + 180.0, 360.0);
+	if (p < 0.0) p += 360.0;
+	return p - 180.0;
+}
+
 bool ArmKinematics::ServoPosToJointRad(const KinematicsConfig& kc,
                                        const MotionConfig* pMc,
                                        int nJoint,
                                        int pos,
                                        double& outQRad)
 {
+	// 单次换算只编译该关节（两点标定斜率、轴向符号、invert、零位偏置折叠为 offset/scale）
 	if (nJoint < 1 || nJoint > kJointCount) return false;
-	const auto& c = kc.GetJoint(nJoint);
-	if (c.plusDeg == 0) return false;
-	const double posPerDeg = (static_cast<double>(c.posAtPlusDeg - c.posAt0Deg) / static_cast<double>(c.plusDeg));
-	if (std::fabs(posPerDeg) < kEps) return false;
-
-	// 由舵机位置反解“物理角度（度）”
-	const double degPhysical = (static_cast<double>(pos - c.posAt0Deg) / posPerDeg);
-	const double degZeroAdjusted = degPhysical - c.zeroOffsetDeg;
-
-	// 轴向符号 +（可选）MotionConfig::invert 叠加修正
-	int sign = KinematicsConfig::AxisSignForJoint(nJoint);
-	if (pMc && pMc->Get(nJoint).invert) sign = -sign;
-
-	outQRad = DegToRad(degZeroAdjusted) * static_cast<double>(sign);
-	return true;
+	return KinematicsCalib::JointServoPosToRad(KinematicsCalib::CompileJoint(kc, pMc, nJoint), pos, outQRad);
 }
 
 bool ArmKinematics::JointRadToServoPos(const KinematicsConfig& kc,
@@ -70,53 +64,24 @@ bool ArmKinematics::JointRadToServoPos(const KinematicsConfig& kc,
                                        int& outPos)
 {
 	if (nJoint < 1 || nJoint > kJointCount) return false;
-	const auto& c = kc.GetJoint(nJoint);
-	if (c.plusDeg == 0) return false;
-	const double posPerDeg = (static_cast<double>(c.posAtPlusDeg - c.posAt0Deg) / static_cast<double>(c.plusDeg));
-	if (std::fabs(posPerDeg) < kEps) return false;
-
-	int sign = KinematicsConfig::AxisSignForJoint(nJoint);
-	if (pMc && pMc->Get(nJoint).invert) sign = -sign;
-	const double degZeroAdjusted = RadToDeg(qRad) / static_cast<double>(sign);
-	const double degPhysical = degZeroAdjusted + c.zeroOffsetDeg;
-
-	const double posF = static_cast<double>(c.posAt0Deg) + degPhysical * posPerDeg;
-	int pos = static_cast<int>(std::lround(posF));
-
-	// 位置域做一个基础保护（最终仍由 MotionController 做 min/max 裁剪）
-	if (pos < 0) pos = 0;
-	if (pos > 1000) pos = 1000;
-	outPos = pos;
-	return true;
+	return KinematicsCalib::JointRadToPos(KinematicsCalib::CompileJoint(kc, pMc, nJoint), qRad, outPos);
 }
 
-bool ArmKinematics::GetJointLimitRad(const KinematicsConfig& kc,
-                                    const MotionConfig* pMc,
-                                    int nJoint,
-                                    double& outMinRad,
-                                    double& outMaxRad)
+ArmKinematics::PoseTarget ArmKinematics::ForwardKinematics(const KinematicsConfig& kc,
+                                                          const JointAnglesRad& q)
 {
-	// 限位来自 MotionConfig 的 pos(min/max)，我们把它转换成 rad 范围。
-	// 注意：pos->rad 可能是单调递减（posPerDeg 为负），因此要做 min/max 交换。
-	if (!pMc) return false;
-	if (nJoint < 1 || nJoint > kJointCount) return false;
-
-	const auto& jc = pMc->Get(nJoint);
-	if (jc.minPos == 0 && jc.maxPos == 0) return false;
-
-	double rMin = 0.0, rMax = 0.0;
-	if (!ServoPosToJointRad(kc, pMc, nJoint, jc.minPos, rMin)) return false;
-	if (!ServoPosToJointRad(kc, pMc, nJoint, jc.maxPos, rMax)) return false;
-	if (rMin > rMax) std::swap(rMin, rMax);
-	outMinRad = rMin;
-	outMaxRad = rMax;
-	return true;
+	return ForwardKinematicsLinks(kc.Links(), q);
 }
 
-ArmKinematics::PoseTarget ArmKinematics::ForwardKinematics(const KinematicsConfig& kc,
+ArmKinematics::PoseTarget ArmKinematics::ForwardKinematics(const KinematicsCalib& calib,
                                                           const JointAnglesRad& q)
 {
-	const auto& L = kc.Links();
+	return ForwardKinematicsLinks(calib.Links(), q);
+}
+
+ArmKinematics::PoseTarget ArmKinematics::ForwardKinematicsLinks(const KinematicsConfig::LinkLengthsMm& L,
+                                                               const JointAnglesRad& q)
+{
 
 	// q2/q3/q4 为平面俯仰（统一绕 +X），pitch 为三者和
 	const double q1 = q.q[1];
@@ -151,40 +116,97 @@ ArmKinematics::PoseTarget ArmKinematics::ForwardKinematics(const KinematicsConfi
 	out.y_mm = y;
 	out.z_mm = z_ee;
 	out.pitch_deg = RadToDeg(a234);
+	out.roll_deg = RadToDeg(q.q[5]);
 	return out;
 }
 
+void ArmKinematics::ForwardKinematicsFrames(const KinematicsCalib& calib, const JointAnglesRad& q, LinkFrames& out)
+{
+	// J1..J5 由编译期运动链 KinematicChain::Arm5Dof 生成（与 ForwardKinematics 同一模型），Base 恒为单位阵
+	KinematicChain::Arm5Dof::Q qc;
+	for (int j = 0; j < kJointCount; j++) qc[j] = q.q[j + 1];
+	out.f[LinkFrames::kBase] = Frame();
+	KinematicChain::ForwardFrames<KinematicChain::Arm5Dof>(calib.Links(), qc, &out.f[LinkFrames::kTurntable]);
+	const Frame& fl = out.f[LinkFrames::kFlange];
+
+	// 相机：法兰系中的安装位姿（手眼标定结果，或名义安装：顶面上方 L_cam、光轴沿法兰 y）
+	const auto& mount = calib.Camera();
+	Frame& cam = out.f[LinkFrames::kCamera];
+	for (int i = 0; i < 3; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			cam.R[i][c] = fl.R[i][0] * mount.R[0][c] + fl.R[i][1] * mount.R[1][c] + fl.R[i][2] * mount.R[2][c];
+		}
+		cam.p[i] = fl.p[i] + fl.R[i][0] * mount.p[0] + fl.R[i][1] * mount.p[1] + fl.R[i][2] * mount.p[2];
+	}
+}
+
 bool ArmKinematics::JointAnglesToServoPos(const KinematicsConfig& kc,
                                          const MotionConfig* pMc,
                                          const JointAnglesRad& q,
                                          ServoPos& outPos,
                                          std::wstring& outWhy)
+{
+	return JointAnglesToServoPos(KinematicsCalib::Compile(kc, pMc), q, outPos, outWhy);
+}
+
+bool ArmKinematics::JointAnglesToServoPos(const KinematicsCalib& calib,
+                                         const JointAnglesRad& q,
+                                         ServoPos& outPos,
+                                         std::wstring& outWhy)
 {
 	outWhy.clear();
+	const IkError e = JointAnglesToServoPos(calib, q, outPos);
+	if (e != IkError::None)
+	{
+		outWhy = IkErrorText(e);
+		return false;
+	}
+	return true;
+}
+
+ArmKinematics::IkError ArmKinematics::JointAnglesToServoPos(const KinematicsCalib& calib,
+                                                           const JointAnglesRad& q,
+                                                           ServoPos& outPos)
+{
 	for (int j = 0; j <= kJointCount; j++) outPos.pos[j] = -1;
 	for (int j = 1; j <= kJointCount; j++)
 	{
+		const auto& jc = calib.GetJoint(j);
+
 		// 仅当该关节在 MotionConfig 中已绑定 ServoId 时才输出
-		if (pMc)
+		if (calib.HasMotionConfig())
 		{
-			const int sid = pMc->Get(j).servoId;
-			if (sid < 1 || sid > 6)
+			if (jc.servoId < 1 || jc.servoId > 6)
 			{
 				// Jog/IK 场景：未绑定时直接失败，提示用户先完成映射
-				outWhy = L"关节未绑定舵机ID，请先在运动标定中设置 ServoId。";
-				return false;
+				return IkError::ServoUnbound;
 			}
 		}
 
 		int pos = 0;
-		if (!JointRadToServoPos(kc, pMc, j, q.q[j], pos))
+		if (!KinematicsCalib::JointRadToPos(jc, q.q[j], pos))
 		{
-			outWhy = L"关节标定参数无效（两点标定不足或除0），请检查 KinematicsConfig。";
-			return false;
+			return IkError::CalibInvalid;
 		}
 		outPos.pos[j] = pos;
 	}
-	return true;
+	return IkError::None;
+}
+
+const wchar_t* ArmKinematics::IkErrorText(IkError e)
+{
+	switch (e)
+	{
+	case IkError::None: return L"";
+	case IkError::Unreachable: return L"目标超出可达范围（两连杆无法到达腕中心）。";
+	case IkError::OutOfLimits: return L"存在可达解，但该解可能超出软限位范围。";
+	case IkError::NoSolution: return L"未找到有效解。";
+	case IkError::ServoUnbound: return L"关节未绑定舵机ID，请先在运动标定中设置 ServoId。";
+	case IkError::CalibInvalid: return L"关节标定参数无效（两点标定不足或除0），请检查 KinematicsConfig。";
+	default: return L"未找到有效解。";
+	}
 }
 
 ArmKinematics::IkResult ArmKinematics::InverseKinematics(const KinematicsConfig& kc,
@@ -192,17 +214,53 @@ ArmKinematics::IkResult ArmKinematics::InverseKinematics(const KinematicsConfig&
                                                          const PoseTarget& target,
                                                          const JointAnglesRad* pQCurrent)
 {
+	return InverseKinematics(KinematicsCalib::Compile(kc, pMc), target, pQCurrent);
+}
+
+ArmKinematics::IkResult ArmKinematics::InverseKinematics(const KinematicsCalib& calib,
+                                                         const PoseTarget& target,
+                                                         const JointAnglesRad* pQCurrent)
+{
+	// 兼容接口：在无分配版本之上包装出 vector + wstring
+	IkResultLite lite;
+	InverseKinematics(calib, target, pQCurrent, lite);
+
 	IkResult r;
+	r.ok = lite.ok;
+	r.reason = IkErrorText(lite.error);
+	r.candidates.assign(lite.candidates.begin(), lite.candidates.begin() + lite.candidateCount);
+	r.chosenIndex = lite.chosenIndex;
+	r.chosenQ = lite.chosenQ;
+	return r;
+}
+
+bool ArmKinematics::InverseKinematics(const KinematicsCalib& calib,
+                                      const PoseTarget& target,
+                                      const JointAnglesRad* pQCurrent,
+                                      IkResultLite& r)
+{
+	return InverseKinematics(calib, target, pQCurrent, nullptr, r);
+}
+
+bool ArmKinematics::InverseKinematics(const KinematicsCalib& calib,
+                                      const PoseTarget& target,
+                                      const JointAnglesRad* pQCurrent,
+                                      const IkScoring* pScoring,
+                                      IkResultLite& r)
+{
 	r.ok = false;
-	r.reason.clear();
+	r.error = IkError::None;
+	r.candidateCount = 0;
+	r.chosenIndex = -1;
 
-	const auto& L = kc.Links();
+	const auto& L = calib.Links();
 
 	// 1) base yaw：注意 Y 为前，因此 atan2(x, y)
-	const double q1 = std::atan2(target.x_mm, target.y_mm);
+	// 末端在 J1 轴线上时方位角任意：沿用当前 J1（BaseYaw 滚转由 J5 补偿），避免跳到 atan2(0,0)=0
+	const double r_xy = std::sqrt(Sq(target.x_mm) + Sq(target.y_mm));
+	const double q1 = (r_xy < kEps && pQCurrent) ? pQCurrent->q[1] : std::atan2(target.x_mm, target.y_mm);
 
 	// 2) 将目标投影到平面（r,z'）
-	const double r_xy = std::sqrt(Sq(target.x_mm) + Sq(target.y_mm));
 	const double zp = target.z_mm - L.L_base;
 	const double pitch = DegToRad(target.pitch_deg);
 
@@ -220,9 +278,8 @@ ArmKinematics::IkResult ArmKinematics::InverseKinematics(const KinematicsConfig&
 	const double dMax = (L1 + L2);
 	if (d > dMax + 1e-6 || d < dMin - 1e-6)
 	{
-		r.ok = false;
-		r.reason = L"目标超出可达范围（两连杆无法到达腕中心）。";
-		return r;
+		r.error = IkError::Unreachable;
+		return false;
 	}
 
 	// 4) 求解肘角 q3（两解）
@@ -230,67 +287,94 @@ ArmKinematics::IkResult ArmKinematics::InverseKinematics(const KinematicsConfig&
 	const double q3a = SafeAcos(cos_q3);   // 肘下/肘上取决于坐标系，这里作为候选
 	const double q3b = -q3a;
 
-	auto evalCandidate = [&](double q2, double q3, double q4) -> IkSolution
+	// J5 只取决于 q1 与俯仰，两个肘解共用；Hold 时不参与限位判定（与旧版一致）
+	const double q5 = SolveRollRad(calib, target, q1, pitch, pQCurrent);
+	const int limitJoints = (target.rollMode == RollMode::Hold) ? 4 : 5;
+
+	auto evalCandidate = [&](double q2, double q3, double q4, IkSolution& s)
 	{
-		IkSolution s;
 		for (int i = 0; i <= kJointCount; i++) s.q.q[i] = 0.0;
 		s.q.q[1] = WrapToPi(q1);
 		s.q.q[2] = WrapToPi(q2);
 		s.q.q[3] = WrapToPi(q3);
 		s.q.q[4] = WrapToPi(q4);
-		s.q.q[5] = 0.0; // 默认保持（上层可覆盖）
+		s.q.q[5] = q5;
 
-		// 代价：离当前姿态最近（Jog 最重要）
-		if (pQCurrent)
-		{
-			double sum = 0.0;
-			for (int j = 1; j <= 4; j++)
-			{
-				const double dq = WrapToPi(s.q.q[j] - pQCurrent->q[j]);
-				sum += dq * dq;
-			}
-			s.cost = sum;
-		}
-
-		// 限位：用 MotionConfig 的 pos(min/max) 反解得到角度范围做粗判定
+		// 限位：MotionConfig 的 pos(min/max) 已在编译标定时反解为角度范围，这里只做比较
 		s.withinLimits = true;
-		if (pMc)
+		for (int j = 1; j <= limitJoints; j++)
 		{
-			for (int j = 1; j <= 4; j++)
+			if (!calib.WithinLimits(j, s.q.q[j]))
 			{
-				double mn = 0.0, mx = 0.0;
-				if (GetJointLimitRad(kc, pMc, j, mn, mx))
-				{
-					if (s.q.q[j] < mn - 1e-6 || s.q.q[j] > mx + 1e-6)
-					{
-						s.withinLimits = false;
-						break;
-					}
-				}
+				s.withinLimits = false;
+				break;
 			}
 		}
-		return s;
 	};
 
-	auto solveQ2Q4 = [&](double q3) -> IkSolution
+	auto solveQ2Q4 = [&](double q3, IkSolution& s)
 	{
 		// q2 = atan2(z, r) - atan2(L2*sin(q3), L1 + L2*cos(q3))
 		const double phi = std::atan2(z_wc, r_wc);
 		const double psi = std::atan2(L2 * std::sin(q3), L1 + L2 * std::cos(q3));
 		const double q2 = phi - psi;
 		const double q4 = pitch - (q2 + q3);
-		return evalCandidate(q2, q3, q4);
+		evalCandidate(q2, q3, q4, s);
 	};
 
-	r.candidates.clear();
-	r.candidates.reserve(2);
-	r.candidates.push_back(solveQ2Q4(q3a));
-	r.candidates.push_back(solveQ2Q4(q3b));
+	solveQ2Q4(q3a, r.candidates[0]);
+	solveQ2Q4(q3b, r.candidates[1]);
+	r.candidateCount = 2;
 
-	// 5) 择优：优先 withinLimits，其次 cost 最小
+	// 5) 择优
+	return SelectCandidate(calib, r, pQCurrent, pScoring);
+}
+
+bool ArmKinematics::SelectCandidate(const KinematicsCalib& calib,
+                                    IkResultLite& r,
+                                    const JointAnglesRad* pQCurrent,
+                                    const IkScoring* pScoring)
+{
+	// 代价：离当前姿态最近（Jog 最重要）
+	for (int i = 0; i < r.candidateCount; i++)
+	{
+		auto& s = r.candidates[i];
+		s.cost = 0.0;
+		if (pQCurrent)
+		{
+			double sum = 0.0;
+			for (int j = 1; j <= 4; j++)
+			{
+				const double dq = WrapToPi(s.q.q[j] - pQCurrent->q[j]);
+				sum += dq * dq;
+			}
+			s.cost = sum;
+		}
+	}
+
+	// 评分只在“当前姿态认不出所在分支”时参与（Jog 起步、读回失败后的中位种子、跳变后）：
+	// 连续 Jog 中某个候选紧挨着当前姿态，主动换到另一支本身就是一次翻肘，不如留在原分支直到它真的不可行
+	if (pScoring && pScoring->enabled)
+	{
+		double nearest = std::numeric_limits<double>::infinity();
+		for (int i = 0; i < r.candidateCount; i++)
+		{
+			if (r.candidates[i].withinLimits) nearest = std::min(nearest, r.candidates[i].cost);
+		}
+		if (!pQCurrent || nearest >= pScoring->continuityRad2)
+		{
+			for (int i = 0; i < r.candidateCount; i++)
+			{
+				r.candidates[i].cost += ScoreCandidate(calib, r.candidates[i].q, *pScoring);
+			}
+		}
+	}
+
+	// 优先 withinLimits，其次 cost 最小
+	r.error = IkError::None;
 	int best = -1;
 	double bestScore = std::numeric_limits<double>::infinity();
-	for (int i = 0; i < (int)r.candidates.size(); i++)
+	for (int i = 0; i < r.candidateCount; i++)
 	{
 		const auto& s = r.candidates[i];
 		// withinLimits 作为硬优先级：超限给一个很大惩罚，但仍保留以便用户看到候选
@@ -311,17 +395,465 @@ ArmKinematics::IkResult ArmKinematics::InverseKinematics(const KinematicsConfig&
 		if (!r.candidates[best].withinLimits)
 		{
 			// 仍然返回 ok=true 方便上层展示，但给出原因（上层可选择拒绝发送）
-			r.reason = L"存在可达解，但该解可能超出软限位范围。";
+			r.error = IkError::OutOfLimits;
 		}
 	}
 	else
 	{
 		r.ok = false;
-		r.reason = L"未找到有效解。";
+		r.error = IkError::NoSolution;
 	}
-	return r;
+	return r.ok;
 }
 
+double ArmKinematics::ScoreCandidate(const KinematicsCalib& calib, const JointAnglesRad& q, const IkScoring& scoring)
+{
+	if (!scoring.enabled) return 0.0;
 
+	const double margin = std::max(scoring.limitMarginRad, 1e-6);
+	double score = 0.0;
 
+	// 限位余量（只看 J1..J4；超限的候选已由硬惩罚处理，这里余量按 0 计）
+	for (int j = 1; j <= 4; j++)
+	{
+		const auto& jc = calib.GetJoint(j);
+		if (!jc.hasLimit) continue;
+		const double m = std::max(0.0, std::min(q.q[j] - jc.minRad, jc.maxRad - q.q[j]));
+		if (m < margin) score += scoring.limitWeight * Sq(1.0 - m / margin);
+	}
 
+	// 可操作度
+	if (scoring.manipThreshold > 0.0)
+	{
+		const double w = Manipulability(calib, q);
+		if (w < scoring.manipThreshold) score += scoring.manipWeight * Sq(1.0 - w / scoring.manipThreshold);
+	}
+
+	// 下一步可行性：按当前增量的 DLS 关节速度线性外推，估计还能走多少 tick 才碰到软限位
+	const auto& v = scoring.nextStep;
+	if (scoring.horizonTicks > 0.0 && (v.x_mm != 0.0 || v.y_mm != 0.0 || v.z_mm != 0.0 || v.pitch_deg != 0.0))
+	{
+		JointAnglesRad dq;
+		if (!ResolveRateDls(calib, q, v, scoring.dls, dq))
+		{
+			return score + scoring.stepWeight;
+		}
+		double ticks = scoring.horizonTicks;
+		for (int j = 1; j <= 4; j++)
+		{
+			const auto& jc = calib.GetJoint(j);
+			if (!jc.hasLimit) continue;
+			const double room = dq.q[j] > 0.0 ? jc.maxRad - q.q[j] : q.q[j] - jc.minRad;
+			const double rate = std::fabs(dq.q[j]);
+			if (rate > 1e-12) ticks = std::min(ticks, std::max(0.0, room) / rate);
+		}
+		score += scoring.stepWeight * Sq(1.0 - ticks / scoring.horizonTicks);
+	}
+	return score;
+}
+
+double ArmKinematics::SolveRollRad(const KinematicsCalib& calib,
+                                   const PoseTarget& target,
+                                   double q1,
+                                   double pitchRad,
+                                   const JointAnglesRad* pQCurrent)
+{
+	const double hold = pQCurrent ? pQCurrent->q[5] : 0.0;
+	if (target.rollMode == RollMode::Hold)
+	{
+		return hold;
+	}
+	if (target.rollMode == RollMode::Joint)
+	{
+		return WrapToPi(DegToRad(target.roll_deg));
+	}
+
+	// BaseYaw：法兰 x5 = c5·x - s5·z（见 ForwardKinematicsFrames），x = (c1, -s1, 0)，
+	// z = (-sp·s1, -sp·c1, cp)；目标方向 d = (cosψ, -sinψ, 0)。
+	// x5·d = c5·cos(ψ-q1) - s5·sp·sin(ψ-q1)，最大值在 q5 = atan2(-sp·sin(ψ-q1), cos(ψ-q1))。
+	const double dy = DegToRad(target.roll_deg) - q1;
+	const double a = std::cos(dy);
+	const double b = -std::sin(pitchRad) * std::sin(dy);
+	if (std::sqrt(a * a + b * b) < 1e-6)
+	{
+		// 末端水平且目标方向沿工具轴：滚转不影响夹爪方位，保持不动
+		return hold;
+	}
+	const double q5 = std::atan2(b, a);
+	if (!target.rollSymmetric)
+	{
+		return q5;
+	}
+
+	// 对称夹爪：q5 与 q5±π 等价。优先限位内，其次离当前 J5 最近（无当前值时离 0 最近）
+	const double alt = WrapToPi(q5 + kPi);
+	const bool inA = calib.WithinLimits(5, q5);
+	const bool inB = calib.WithinLimits(5, alt);
+	if (inA != inB)
+	{
+		return inA ? q5 : alt;
+	}
+	return (std::fabs(WrapToPi(alt - hold)) < std::fabs(WrapToPi(q5 - hold))) ? alt : q5;
+}
+
+ArmKinematics::Jacobian ArmKinematics::ComputeJacobian(const KinematicsCalib& calib, const JointAnglesRad& q)
+{
+	const auto& L = calib.Links();
+
+	const double s1 = std::sin(q.q[1]);
+	const double c1 = std::cos(q.q[1]);
+	const double a2 = q.q[2];
+	const double a23 = a2 + q.q[3];
+	const double a234 = a23 + q.q[4];
+
+	const double c2 = std::cos(a2), s2 = std::sin(a2);
+	const double c23 = std::cos(a23), s23 = std::sin(a23);
+	const double c234 = std::cos(a234), s234 = std::sin(a234);
+
+	// 平面半径 r 与高度 h（相对肩）及其对 q2..q4 的偏导：
+	// 每个关节“带动其后所有连杆”，因此偏导是其后各段的累加
+	const double r = L.L_arm1 * c2 + L.L_arm2 * c23 + L.L_wrist * c234;
+	const double dr4 = -L.L_wrist * s234;
+	const double dr3 = dr4 - L.L_arm2 * s23;
+	const double dr2 = dr3 - L.L_arm1 * s2;
+	const double dh4 = L.L_wrist * c234;
+	const double dh3 = dh4 + L.L_arm2 * c23;
+	const double dh2 = dh3 + L.L_arm1 * c2;
+
+	// x = r·sin q1, y = r·cos q1, z = L_base + h, pitch = q2+q3+q4
+	Jacobian J;
+	J.m[0][0] = r * c1;
+	J.m[1][0] = -r * s1;
+	J.m[2][0] = 0.0;
+	J.m[3][0] = 0.0;
+
+	const double dr[3] = { dr2, dr3, dr4 };
+	const double dh[3] = { dh2, dh3, dh4 };
+	for (int k = 0; k < 3; k++)
+	{
+		J.m[0][k + 1] = dr[k] * s1;
+		J.m[1][k + 1] = dr[k] * c1;
+		J.m[2][k + 1] = dh[k];
+		J.m[3][k + 1] = 1.0;
+	}
+	return J;
+}
+
+double ArmKinematics::Manipulability(const KinematicsCalib& calib, const JointAnglesRad& q)
+{
+	const auto& L = calib.Links();
+	const double lsum = L.L_arm1 + L.L_arm2 + L.L_wrist;
+	if (lsum <= kEps) return 0.0;
+
+	const double a2 = q.q[2];
+	const double a23 = a2 + q.q[3];
+	const double a234 = a23 + q.q[4];
+	const double r = L.L_arm1 * std::cos(a2) + L.L_arm2 * std::cos(a23) + L.L_wrist * std::cos(a234);
+	return std::fabs(r * std::sin(q.q[3])) / lsum;
+}
+
+double ArmKinematics::InverseCondition(const KinematicsCalib& calib, const JointAnglesRad& q, double pitchWeightMm)
+{
+	const auto& L = calib.Links();
+	const double wp = (pitchWeightMm > kEps) ? pitchWeightMm : 1.0;
+
+	const double a2 = q.q[2];
+	const double a23 = a2 + q.q[3];
+	const double a234 = a23 + q.q[4];
+	const double c2 = std::cos(a2), s2 = std::sin(a2);
+	const double c23 = std::cos(a23), s23 = std::sin(a23);
+	const double c234 = std::cos(a234), s234 = std::sin(a234);
+
+	const double r = L.L_arm1 * c2 + L.L_arm2 * c23 + L.L_wrist * c234;
+	const double dr4 = -L.L_wrist * s234;
+	const double dr3 = dr4 - L.L_arm2 * s23;
+	const double dr2 = dr3 - L.L_arm1 * s2;
+	const double dh4 = L.L_wrist * c234;
+	const double dh3 = dh4 + L.L_arm2 * c23;
+	const double dh2 = dh3 + L.L_arm1 * c2;
+
+	// 平面雅可比 P（行：∂r, ∂h, 俯仰·wp；列：q2..q4），A = PᵀP 的特征值即 σ²
+	const double P[3][3] = { { dr2, dr3, dr4 }, { dh2, dh3, dh4 }, { wp, wp, wp } };
+	double A[3][3];
+	for (int i = 0; i < 3; i++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			A[i][k] = P[0][i] * P[0][k] + P[1][i] * P[1][k] + P[2][i] * P[2][k];
+		}
+	}
+
+	// 3x3 对称矩阵特征值（三角函数闭式解，Smith 1961）
+	const double p1 = Sq(A[0][1]) + Sq(A[0][2]) + Sq(A[1][2]);
+	const double qm = (A[0][0] + A[1][1] + A[2][2]) / 3.0;
+	const double p2 = Sq(A[0][0] - qm) + Sq(A[1][1] - qm) + Sq(A[2][2] - qm) + 2.0 * p1;
+	double eMin = qm, eMax = qm;
+	if (p2 > kEps)
+	{
+		const double p = std::sqrt(p2 / 6.0);
+		double B[3][3];
+		for (int i = 0; i < 3; i++)
+		{
+			for (int k = 0; k < 3; k++) B[i][k] = (A[i][k] - (i == k ? qm : 0.0)) / p;
+		}
+		const double detB = B[0][0] * (B[1][1] * B[2][2] - B[1][2] * B[2][1])
+			- B[0][1] * (B[1][0] * B[2][2] - B[1][2] * B[2][0])
+			+ B[0][2] * (B[1][0] * B[2][1] - B[1][1] * B[2][0]);
+		const double phi = std::acos(std::max(-1.0, std::min(1.0, 0.5 * detB))) / 3.0;
+		eMax = qm + 2.0 * p * std::cos(phi);
+		eMin = qm + 2.0 * p * std::cos(phi + 2.0 * kPi / 3.0);
+	}
+
+	const double sMin = std::min(std::fabs(r), std::sqrt(std::max(0.0, eMin)));
+	const double sMax = std::max(std::fabs(r), std::sqrt(std::max(0.0, eMax)));
+	return (sMax > kEps) ? sMin / sMax : 0.0;
+}
+
+bool ArmKinematics::ResolveRateDls(const KinematicsCalib& calib,
+                                   const JointAnglesRad& q,
+                                   const PoseVelocity& v,
+                                   const DlsParams& params,
+                                   JointAnglesRad& outQDot)
+{
+	for (int j = 0; j <= kJointCount; j++) outQDot.q[j] = 0.0;
+
+	// 俯仰行乘权重，使 4 个分量量纲一致（mm）
+	Jacobian J = ComputeJacobian(calib, q);
+	const double wp = (params.pitchWeightMm > kEps) ? params.pitchWeightMm : 1.0;
+	for (int k = 0; k < 4; k++) J.m[3][k] *= wp;
+	const double rhs[4] = { v.x_mm, v.y_mm, v.z_mm, DegToRad(v.pitch_deg) * wp };
+
+	// 自适应阻尼：只在接近奇异时介入，正常工作区内与精确逆一致
+	const double w = Manipulability(calib, q);
+	const double w0 = params.manipThreshold;
+	double lambda2 = 0.0;
+	if (w0 > 0.0 && w < w0)
+	{
+		const double t = w / w0;
+		lambda2 = Sq(params.dampingMaxMm) * (1.0 - t * t);
+	}
+
+	// A = J Jᵀ + λ² I（4x4 对称正定）-> Cholesky 解 A y = v
+	auto solve = [&](double l2, double (&y)[4]) -> bool
+	{
+		double A[4][4];
+		for (int i = 0; i < 4; i++)
+		{
+			for (int k = 0; k <= i; k++)
+			{
+				double s = 0.0;
+				for (int c = 0; c < 4; c++) s += J.m[i][c] * J.m[k][c];
+				A[i][k] = s;
+			}
+			A[i][i] += l2;
+		}
+
+		double Lc[4][4] = {};
+		for (int i = 0; i < 4; i++)
+		{
+			for (int k = 0; k <= i; k++)
+			{
+				double s = A[i][k];
+				for (int c = 0; c < k; c++) s -= Lc[i][c] * Lc[k][c];
+				if (i == k)
+				{
+					if (!(s > kEps)) return false;
+					Lc[i][i] = std::sqrt(s);
+				}
+				else
+				{
+					Lc[i][k] = s / Lc[k][k];
+				}
+			}
+		}
+
+		double z[4];
+		for (int i = 0; i < 4; i++)
+		{
+			double s = rhs[i];
+			for (int c = 0; c < i; c++) s -= Lc[i][c] * z[c];
+			z[i] = s / Lc[i][i];
+		}
+		for (int i = 3; i >= 0; i--)
+		{
+			double s = z[i];
+			for (int c = i + 1; c < 4; c++) s -= Lc[c][i] * y[c];
+			y[i] = s / Lc[i][i];
+		}
+		return true;
+	};
+
+	double y[4] = {};
+	if (!solve(lambda2, y))
+	{
+		// 恰好落在奇异点且阻尼为 0（manipThreshold 配成 0）时兜底：给一个小阻尼再解一次
+		const double lMin = std::max(params.dampingMaxMm * 0.1, 1.0);
+		if (!solve(lambda2 + Sq(lMin), y)) return false;
+	}
+
+	// dq = Jᵀ y
+	for (int c = 0; c < 4; c++)
+	{
+		double s = 0.0;
+		for (int i = 0; i < 4; i++) s += J.m[i][c] * y[i];
+		outQDot.q[c + 1] = s;
+	}
+	return true;
+}
+
+bool ArmKinematics::ProjectToReachable(const KinematicsCalib& calib,
+                                       const PoseTarget& target,
+                                       const JointAnglesRad* pQSeed,
+                                       const ProjectParams& params,
+                                       ProjectResult& out)
+{
+	out = ProjectResult();
+	out.pose = target;
+
+	IkResultLite ik;
+	auto feasible = [&](const PoseTarget& p) -> bool
+	{
+		return InverseKinematics(calib, p, pQSeed, ik) && ik.error == IkError::None;
+	};
+	auto finish = [&](ProjectKind kind, const PoseTarget& p, const JointAnglesRad& q) -> bool
+	{
+		out.ok = true;
+		out.kind = kind;
+		out.pose = p;
+		out.q = q;
+		out.distMm = std::sqrt(Sq(p.x_mm - target.x_mm) + Sq(p.y_mm - target.y_mm) + Sq(p.z_mm - target.z_mm));
+		out.pitchDeltaDeg = p.pitch_deg - target.pitch_deg;
+		return true;
+	};
+
+	// 0) 原目标
+	if (feasible(target))
+	{
+		return finish(ProjectKind::Unchanged, target, ik.chosenQ);
+	}
+
+	const auto& L = calib.Links();
+	const double rXy = std::sqrt(Sq(target.x_mm) + Sq(target.y_mm));
+	double phi = 0.0;
+	if (rXy > 1e-6) phi = std::atan2(target.x_mm, target.y_mm);
+	else if (pQSeed) phi = pQSeed->q[1];
+
+	// 改俯仰帮不上忙的情况直接跳过粗扫：离肩距离超出 [dMin - L_wrist, dMax + L_wrist]，或方位角在 J1 限位外
+	const double rhoSh = std::sqrt(Sq(rXy) + Sq(target.z_mm - L.L_base));
+	const bool pitchCanHelp = rhoSh <= (L.L_arm1 + L.L_arm2 + L.L_wrist)
+		&& rhoSh >= std::fabs(L.L_arm1 - L.L_arm2) - L.L_wrist
+		&& calib.WithinLimits(1, phi);
+
+	// 1) 放宽俯仰：从目标俯仰向两侧按步长粗扫，找到可行区后在 [不可行, 可行] 间二分逼近边界
+	if (params.relaxPitch && params.maxPitchRelaxDeg > 0.0 && pitchCanHelp)
+	{
+		const double step = (params.pitchScanStepDeg > 0.1) ? params.pitchScanStepDeg : 0.1;
+		const int steps = static_cast<int>(std::ceil(params.maxPitchRelaxDeg / step));
+		PoseTarget p = target;
+		double bestDelta = std::numeric_limits<double>::infinity();
+		double bestSigned = 0.0;
+		for (int k = 1; k <= steps && !std::isfinite(bestDelta); k++)
+		{
+			const double dk = std::min(k * step, params.maxPitchRelaxDeg);
+			for (int side = -1; side <= 1; side += 2)
+			{
+				p.pitch_deg = target.pitch_deg + side * dk;
+				if (!feasible(p)) continue;
+
+				// 二分：lo 不可行、hi 可行（均为相对目标的偏移量）
+				double lo = (k - 1) * step;
+				double hi = dk;
+				for (int it = 0; it < 12; it++)
+				{
+					const double mid = 0.5 * (lo + hi);
+					p.pitch_deg = target.pitch_deg + side * mid;
+					if (feasible(p)) hi = mid;
+					else lo = mid;
+				}
+				if (hi < bestDelta)
+				{
+					bestDelta = hi;
+					bestSigned = side * hi;
+				}
+			}
+		}
+		if (std::isfinite(bestDelta))
+		{
+			p.pitch_deg = target.pitch_deg + bestSigned;
+			if (feasible(p))
+			{
+				return finish(ProjectKind::PitchRelaxed, p, ik.chosenQ);
+			}
+		}
+	}
+
+	// 2) 位置投影（俯仰不变）
+	// 固定俯仰时，末端可达域 = 以 C = L_wrist·(cos p, sin p) 为圆心、[dMin, dMax] 为半径的圆环（平面 r-z'）；
+	// J1 限位把方位角限制在扇区内，扇区外的点先投影到最近的边界半平面。
+	const double pitch = DegToRad(target.pitch_deg);
+	double rPlane = rXy;
+	const auto& j1 = calib.GetJoint(1);
+	if (j1.hasLimit && (phi < j1.minRad || phi > j1.maxRad))
+	{
+		const double phiC = std::min(std::max(phi, j1.minRad), j1.maxRad);
+		rPlane = std::max(0.0, rXy * std::cos(phi - phiC));
+		phi = phiC;
+	}
+
+	const double cr = L.L_wrist * std::cos(pitch);
+	const double cz = L.L_wrist * std::sin(pitch);
+	double wr = rPlane - cr;
+	double wz = (target.z_mm - L.L_base) - cz;
+	const double d = std::sqrt(Sq(wr) + Sq(wz));
+	const double dMin = std::fabs(L.L_arm1 - L.L_arm2) + params.marginMm;
+	const double dMax = (L.L_arm1 + L.L_arm2) - params.marginMm;
+	if (dMax > dMin)
+	{
+		const double dc = std::min(std::max(d, dMin), dMax);
+		if (d > kEps)
+		{
+			wr *= dc / d;
+			wz *= dc / d;
+		}
+		else
+		{
+			wr = dc; // 恰在圆心：沿前向推出
+			wz = 0.0;
+		}
+
+		const double rNew = cr + wr;
+		if (rNew >= 0.0) // r < 0 表示要越过 J1 轴线到背面，不在此处理，交给兜底
+		{
+			PoseTarget p = target;
+			p.x_mm = rNew * std::sin(phi);
+			p.y_mm = rNew * std::cos(phi);
+			p.z_mm = L.L_base + cz + wz;
+			if (feasible(p))
+			{
+				return finish(ProjectKind::PositionProjected, p, ik.chosenQ);
+			}
+
+			// 3) 兜底：投影点数学可达但超限 -> 择优解逐关节裁剪到限位（含滚转目标给出的 J5），FK 得到实际位姿
+			if (InverseKinematics(calib, p, pQSeed, ik))
+			{
+				JointAnglesRad q = ik.chosenQ;
+				for (int j = 1; j <= kJointCount; j++)
+				{
+					const auto& jc = calib.GetJoint(j);
+					if (jc.hasLimit) q.q[j] = std::min(std::max(q.q[j], jc.minRad), jc.maxRad);
+				}
+				return finish(ProjectKind::JointClamped, ForwardKinematics(calib, q), q);
+			}
+		}
+	}
+
+	// 3') 投影失败（需越过 J1 轴线到背面等）：退回种子姿态（无种子时为零位）裁剪到限位
+	JointAnglesRad q;
+	if (pQSeed) q = *pQSeed;
+	for (int j = 1; j <= kJointCount; j++)
+	{
+		const auto& jc = calib.GetJoint(j);
+		if (jc.hasLimit) q.q[j] = std::min(std::max(q.q[j], jc.minRad), jc.maxRad);
+	}
+	return finish(ProjectKind::JointClamped, ForwardKinematics(calib, q), q);
+}
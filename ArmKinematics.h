@@ -1,9 +1,12 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "KinematicChain.h"
+#include "KinematicsCalib.h"
 #include "KinematicsConfig.h"
 #include "MotionConfig.h"
 
@@ -11,7 +14,7 @@
 // - 坐标系：Base 右手系，Z向上，Y向前，X向右（与 Reference/mechanics.md 对齐）
 // - J1: 绕 Base.Z（水平转台）
 // - J2/J3/J4: 位于同一竖直平面内的 3R（肩/肘/腕俯仰），在数学模型中统一视为绕 +X 旋转
-// - J5: 末端绕自身轴旋转（姿态/滚转用途），本版 IK 默认保持不变
+// - J5: 末端绕自身轴旋转（滚转），IK 按 PoseTarget::rollMode 求解，默认保持当前值
 //
 // 说明：
 // - 真实环境存在误差：本类输出“可解释的失败原因”，并允许通过 KinematicsConfig 的 zeroOffsetDeg 等参数修正。
@@ -20,6 +23,17 @@ class ArmKinematics
 {
 public:
 	static constexpr int kJointCount = KinematicsConfig::kJointCount; // 5
+	static_assert(KinematicChain::Arm5Dof::kDof == kJointCount, "Arm5Dof must describe J1..J5");
+
+	// 末端滚转（J5）目标的含义
+	enum class RollMode : uint8_t
+	{
+		Hold = 0, // 不约束：J5 沿用 pQCurrent 的值（无 pQCurrent 时为 0）
+		Joint,    // roll_deg 即 J5 角度（绕连杆方向，相对俯仰平面）
+		// roll_deg 为夹爪开合方向（法兰 x 轴）在 Base 水平面内的方位角，与 J1 同向度量（0 = +X）。
+		// J1 由位置决定，J5 负责补偿：俯视抓取时 J5 = yaw - J1；一般俯仰下取法兰 x 最接近该方向的 J5。
+		BaseYaw,
+	};
 
 	struct PoseTarget
 	{
@@ -28,6 +42,12 @@ public:
 		double y_mm = 0.0;
 		double z_mm = 0.0;
 		double pitch_deg = 0.0; // 末端俯仰（绕 +X），用于抓取姿态约束
+
+		// 滚转（见 RollMode）；FK 输出时 roll_deg = J5 角度、rollMode 保持 Hold
+		RollMode rollMode = RollMode::Hold;
+		double roll_deg = 0.0;
+		// 两指夹爪对称：BaseYaw 下 yaw 与 yaw+180° 等价，取 J5 限位内、离当前 J5 最近的一个
+		bool rollSymmetric = true;
 	};
 
 	struct JointAnglesRad
@@ -49,6 +69,28 @@ public:
 		bool withinLimits = true; // 是否在软限位范围内（基于 MotionConfig 估算）
 	};
 
+	// 失败/告警原因（热路径只传枚举，UI 需要文字时再调用 IkErrorText）
+	enum class IkError : uint8_t
+	{
+		None = 0,
+		Unreachable,  // 两连杆无法到达腕中心
+		OutOfLimits,  // 有解但所选解超出软限位（ok 仍为 true，仅告警）
+		NoSolution,   // 未找到有效解
+		ServoUnbound, // 关节未绑定 ServoId
+		CalibInvalid, // 两点标定不足或除 0
+	};
+
+	// 固定容量 IK 结果：两个肘解内联存储，无堆分配（Jog 每 tick 使用）
+	struct IkResultLite
+	{
+		bool ok = false;
+		IkError error = IkError::None;
+		std::array<IkSolution, 2> candidates{};
+		int candidateCount = 0;
+		int chosenIndex = -1;
+		JointAnglesRad chosenQ;
+	};
+
 	struct IkResult
 	{
 		bool ok = false;
@@ -64,7 +106,7 @@ public:
 	// FK：关节角 -> 末端位姿（目前返回 x/y/z + pitch）
 	static PoseTarget ForwardKinematics(const KinematicsConfig& kc, const JointAnglesRad& q);
 
-	// IK：末端位姿（x,y,z,pitch） -> 多解 + 择优
+	// IK：末端位姿（x,y,z,pitch[,roll]） -> 多解 + 择优
 	// - mc 可为空：为空时不做限位判定，只做可达性/数学求解；建议传入 MotionConfig 以便更稳。
 	// - qCurrent 可为空：用于“离当前姿态最近”的择优，提升 Jog 调试体验。
 	static IkResult InverseKinematics(const KinematicsConfig& kc,
@@ -91,15 +133,197 @@ public:
 	                                  ServoPos& outPos,
 	                                  std::wstring& outWhy);
 
+	// ---- 预编译标定版本（热路径推荐）----
+	// 上面的 kc/mc 接口每次调用都会临时编译标定；Jog 等周期调用方应缓存 KinematicsCalib，
+	// 在 IsStale() 为真时重新 Compile，再调用下面这组重载。
+	static PoseTarget ForwardKinematics(const KinematicsCalib& calib, const JointAnglesRad& q);
+	static IkResult InverseKinematics(const KinematicsCalib& calib,
+	                                 const PoseTarget& target,
+	                                 const JointAnglesRad* pQCurrent);
+	static bool JointAnglesToServoPos(const KinematicsCalib& calib,
+	                                  const JointAnglesRad& q,
+	                                  ServoPos& outPos,
+	                                  std::wstring& outWhy);
+
+	// ---- 无分配版本（Jog 等周期调用）----
+	// 返回 out.ok；失败原因在 out.error，文字按需用 IkErrorText 获取。
+	static bool InverseKinematics(const KinematicsCalib& calib,
+	                              const PoseTarget& target,
+	                              const JointAnglesRad* pQCurrent,
+	                              IkResultLite& out);
+	// 返回 IkError::None 表示成功
+	static IkError JointAnglesToServoPos(const KinematicsCalib& calib,
+	                                     const JointAnglesRad& q,
+	                                     ServoPos& outPos);
+
+	// 失败原因 -> UI 文本（静态字符串，None 返回空串）
+	static const wchar_t* IkErrorText(IkError e);
+
+	// ---- 全连杆 FK（碰撞检测 / HUD 骨架 / 相机外参的基础）----
+	// 刚体位姿（Base 坐标系）：R 的三列为局部 x/y/z 轴方向，p 为原点（mm）
+	using Frame = KinematicChain::Frame;
+
+	// 各关节坐标系（位于关节轴心，姿态为该关节转动之后）：
+	// - 连杆系：x = 俯仰转轴（右），y = 连杆延伸方向，z = y 与 x 叉出的“顶面”法向；零位时与 Base 同向
+	// - kFlange：J5 处，绕连杆方向 y 转 q5（右手），位置即 ForwardKinematics 返回的末端点
+	// - kCamera：OpenCV 光学系（x 右、y 下、z 视线），= 法兰系 * KinematicsCalib::Camera()（手眼标定结果）；
+	//   未标定时为名义安装：法兰顶面上方 L_cam 处，z = 法兰 y，x = 法兰 x，y = -法兰 z（图像向下）
+	struct LinkFrames
+	{
+		enum Index
+		{
+			kBase = 0,  // 原点在地面，恒为单位阵
+			kTurntable, // J1 转台（原点同 Base，仅 yaw）
+			kShoulder,  // J2
+			kElbow,     // J3
+			kWrist,     // J4
+			kFlange,    // J5
+			kCamera,
+			kCount
+		};
+		std::array<Frame, kCount> f;
+	};
+
+	// J1..J5 的坐标系由 KinematicChain::ForwardFrames<Arm5Dof> 给出，再叠加相机外参
+	static void ForwardKinematicsFrames(const KinematicsCalib& calib, const JointAnglesRad& q, LinkFrames& out);
+
+	// ---- 微分运动学（J1..J4：位置 + 俯仰）----
+	// 解析雅可比：行 0..3 = x, y, z (mm), pitch (rad)；列 0..3 = q1..q4 (rad)
+	struct Jacobian
+	{
+		double m[4][4] = {};
+	};
+
+	// 笛卡尔速度（或每 tick 增量，线性映射，单位随调用方）：mm / deg
+	struct PoseVelocity
+	{
+		double x_mm = 0.0;
+		double y_mm = 0.0;
+		double z_mm = 0.0;
+		double pitch_deg = 0.0;
+	};
+
+	// 阻尼最小二乘（DLS）参数
+	// - pitchWeightMm：俯仰行的权重（1 rad 俯仰误差折算多少 mm），平衡位置与姿态两类量纲
+	// - 阻尼自适应：归一化可操作度 w < manipThreshold 时 λ² = λmax²·(1-(w/w0)²)，远离奇异时为 0（等价于精确逆）
+	struct DlsParams
+	{
+		double pitchWeightMm = 100.0;
+		double dampingMaxMm = 20.0;
+		double manipThreshold = 0.08;
+	};
+
+	static Jacobian ComputeJacobian(const KinematicsCalib& calib, const JointAnglesRad& q);
+
+	// 归一化可操作度 |det J| / (Lsum·L1·L2) = |r·sin(q3)| / Lsum，范围 [0,1]
+	// 两类奇异：末端在 J1 轴线上（r=0）或肘伸直/折叠（sin q3 = 0）
+	static double Manipulability(const KinematicsCalib& calib, const JointAnglesRad& q);
+
+	// 逆条件数 σmin/σmax（俯仰行乘 pitchWeightMm，与 DLS 同一量纲），范围 [0,1]，0 = 奇异。
+	// 与 J1 无关：J 的第 0 列（J1）与其余列正交，σ = {|r|} ∪ 平面 3x3 雅可比 [∂r; ∂h; 1] 的奇异值（闭式特征值）。
+	// 可操作度只看 |det J|，这里还能看出“某个方向特别慢”（例如腕长与小臂共线时的俯仰/径向耦合）。
+	static double InverseCondition(const KinematicsCalib& calib, const JointAnglesRad& q, double pitchWeightMm = 100.0);
+
+	// DLS 速度 IK：dq = Jᵀ (J Jᵀ + λ² I)⁻¹ v，输出 outQDot.q[1..4]（q5 置 0）
+	// 不做候选枚举/分支选择：结果始终在当前肘构型附近连续变化，奇异点附近由阻尼限幅。
+	// 返回 false 仅当线性方程数值失败（outQDot 置 0）。
+	static bool ResolveRateDls(const KinematicsCalib& calib,
+	                           const JointAnglesRad& q,
+	                           const PoseVelocity& v,
+	                           const DlsParams& params,
+	                           JointAnglesRad& outQDot);
+
+	// ---- 候选评分（择优规则扩展）----
+	// 默认规则：超软限位罚 1e6 + 离 pQCurrent 的关节距离平方。它会选中“贴着限位 / 靠近奇异点”的解，
+	// Jog 下一 tick 就失败或被迫翻肘。启用后在默认分数上再加三项（均为闭式，无迭代，每个候选约 200ns，以 DLS 为主）：
+	// - 限位余量：距任一软限位小于 limitMarginRad 时按 (1 - 余量/limitMarginRad)² 扣分；
+	// - 可操作度：Manipulability < manipThreshold 时按 (1 - w/manipThreshold)² 扣分；
+	// - 下一步可行性：按 nextStep（Jog 当前每 tick 增量）用 DLS 求关节速度并线性外推，
+	//   horizonTicks 内就会碰到软限位的按 (1 - 剩余tick/horizonTicks)² 扣分（DLS 失败按满分扣）。
+	// 附加项只在最近的可用候选离 pQCurrent 的距离平方 >= continuityRad2 时计入（Jog 起步、中位种子、跳变后），
+	// 连续 Jog 时仍按默认规则留在当前分支，评分不会主动引入翻肘。
+	struct IkScoring
+	{
+		bool enabled = false;
+		double limitMarginRad = 0.2;
+		double limitWeight = 1.0;
+		double manipThreshold = 0.1;
+		double manipWeight = 1.0;
+		PoseVelocity nextStep;  // 全 0 时不评估下一步
+		double horizonTicks = 20.0;
+		double stepWeight = 10.0;
+		double continuityRad2 = 0.05;  // 约 13° 的关节距离
+		DlsParams dls;
+	};
+
+	// 带评分的 IK（pScoring 为空或未启用时与默认规则完全一致）
+	static bool InverseKinematics(const KinematicsCalib& calib,
+	                              const PoseTarget& target,
+	                              const JointAnglesRad* pQCurrent,
+	                              const IkScoring* pScoring,
+	                              IkResultLite& out);
+
+	// 按 pQCurrent / pScoring 重算候选分数并择优（候选关节角与 withinLimits 不变），规则同 InverseKinematics。
+	// IK 结果被缓存复用（IkCache）时，换了当前姿态只需重新择优，不必重解。返回 r.ok。
+	static bool SelectCandidate(const KinematicsCalib& calib,
+	                            IkResultLite& r,
+	                            const JointAnglesRad* pQCurrent,
+	                            const IkScoring* pScoring = nullptr);
+
+	// 单个候选的附加分（不含限位硬惩罚与关节距离），未启用时为 0
+	static double ScoreCandidate(const KinematicsCalib& calib, const JointAnglesRad& q, const IkScoring& scoring);
+
+	// ---- 最近可达位姿投影（目标越界时“贴边滑动”用）----
+	struct ProjectParams
+	{
+		bool relaxPitch = true;          // 先尝试只改俯仰（位置不变）
+		double maxPitchRelaxDeg = 60.0;  // 俯仰最多放宽多少度
+		double pitchScanStepDeg = 2.0;   // 俯仰粗扫步长（找到可行区后二分细化）
+		double marginMm = 0.05;          // 投影到环形可达域边界时向内收的余量，避免落在 IK 容差边缘
+	};
+
+	enum class ProjectKind : uint8_t
+	{
+		Unchanged = 0,     // 原目标已可达且在限位内
+		PitchRelaxed,      // 位置不变，俯仰改到最近可行值
+		PositionProjected, // 俯仰不变，位置投影到最近可达点（含 J1 限位扇区）
+		JointClamped,      // 兜底：可达解的关节角裁剪到软限位后 FK（位置/俯仰都可能变）
+		Failed,            // 未投影（仅作为初始值；ProjectToReachable 总能退回关节裁剪）
+	};
+
+	struct ProjectResult
+	{
+		bool ok = false;
+		ProjectKind kind = ProjectKind::Failed;
+		PoseTarget pose;      // 投影后的位姿
+		JointAnglesRad q;     // pose 对应的 IK 解（限位内，可直接下发，无需再解一次）
+		double distMm = 0.0;  // 位置改变量
+		double pitchDeltaDeg = 0.0;
+	};
+
+	// 寻找离 target 最近的“可达且在软限位内”的位姿。按代价从低到高依次尝试：
+	// 原目标 -> 放宽俯仰 -> 位置投影 -> 关节裁剪。典型耗时为数次 IK（微秒级），适合 1kHz 控制周期。
+	// pQSeed：当前关节角（择优与 J1 轴线附近的方位角参考），可为空。
+	static bool ProjectToReachable(const KinematicsCalib& calib,
+	                               const PoseTarget& target,
+	                               const JointAnglesRad* pQSeed,
+	                               const ProjectParams& params,
+	                               ProjectResult& out);
+
+	// 俯仰角归一到 [-180, 180)：IK 中俯仰只以 sin/cos 出现，预计算图（可达性 / 灵活度）按此范围采样与查询
+	static double WrapPitchDeg(double pitchDeg);
+
 private:
 	static double DegToRad(double d);
 	static double RadToDeg(double r);
-	static bool GetJointLimitRad(const KinematicsConfig& kc,
-	                             const MotionConfig* pMc,
-	                             int nJoint,
-	                             double& outMinRad,
-	                             double& outMaxRad);
 	static double WrapToPi(double a);
+	// J5：按 target.rollMode 求滚转角（闭式，每 tick 可用），q1 / pitchRad 为已解出的转台角与末端俯仰
+	static double SolveRollRad(const KinematicsCalib& calib,
+	                           const PoseTarget& target,
+	                           double q1,
+	                           double pitchRad,
+	                           const JointAnglesRad* pQCurrent);
+	static PoseTarget ForwardKinematicsLinks(const KinematicsConfig::LinkLengthsMm& L, const JointAnglesRad& q);
 };
 
 
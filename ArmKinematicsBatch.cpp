@@ -0,0 +1,515 @@
+#include "pch.h"
+
+#include "ArmKinematicsBatch.h"
+#include "KinematicsSimd.h"
+
+#if defined(KINEMATICS_SIMD_HAS_AVX2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+	using KinematicsSimd::Atan2;
+	using KinematicsSimd::SinCos;
+	using KinematicsSimd::WrapToPi;
+
+	constexpr double kPi = 3.14159265358979323846;
+	constexpr double kLimitTol = 1e-6;    // 与 KinematicsCalib::WithinLimits 默认容差一致
+	constexpr double kReachTol = 1e-6;    // 与 ArmKinematics::InverseKinematics 一致
+	constexpr double kReachTolFloat = 1e-3; // Float 档：float 下腕心距离的舍入误差约 3e-5 mm，伸直位姿不能因此判为不可达
+
+	// 每次批量调用前从标定表提取的常量（避免内核里反复访问 calib）
+	struct KernelConsts
+	{
+		double L_base = 0.0;
+		double L1 = 0.0;
+		double L2 = 0.0;
+		double L_wrist = 0.0;
+		double dMin = 0.0;
+		double dMax = 0.0;
+		double inv2L1L2 = 0.0;
+		bool hasLimit[5] = {};
+		double minRad[5] = {};
+		double maxRad[5] = {};
+	};
+
+	KernelConsts MakeConsts(const KinematicsCalib& calib, ArmKinematicsBatch::Precision precision)
+	{
+		KernelConsts k;
+		const auto& L = calib.Links();
+		const double reachTol = (precision == ArmKinematicsBatch::Precision::Float) ? kReachTolFloat : kReachTol;
+		k.L_base = L.L_base;
+		k.L1 = L.L_arm1;
+		k.L2 = L.L_arm2;
+		k.L_wrist = L.L_wrist;
+		k.dMin = std::fabs(k.L1 - k.L2) - reachTol;
+		k.dMax = (k.L1 + k.L2) + reachTol;
+		k.inv2L1L2 = 1.0 / (2.0 * k.L1 * k.L2);
+		for (int j = 1; j <= 4; j++)
+		{
+			const auto& jc = calib.GetJoint(j);
+			k.hasLimit[j] = jc.hasLimit;
+			k.minRad[j] = jc.minRad - kLimitTol;
+			k.maxRad[j] = jc.maxRad + kLimitTol;
+		}
+		return k;
+	}
+
+	// 解 [i, i + V::kWidth) 这一组位姿，返回 Ok 数量
+	template <class V>
+	size_t SolveGroup(const KernelConsts& k,
+	                  const ArmKinematicsBatch::PoseSoA& in,
+	                  size_t i,
+	                  const ArmKinematicsBatch::JointsSoA& out,
+	                  uint8_t* outStatus,
+	                  const ArmKinematicsBatch::JointsSoAConst* pSeed)
+	{
+		using Reg = typename V::Reg;
+		using Mask = typename V::Mask;
+
+		const Reg zero = V::Set1(0.0);
+		const Reg x = V::Load(in.x_mm + i);
+		const Reg y = V::Load(in.y_mm + i);
+		const Reg z = V::Load(in.z_mm + i);
+		const Reg pitch = V::Mul(V::Load(in.pitch_deg + i), V::Set1(kPi / 180.0));
+
+		// 1) base yaw：Y 为前，因此 atan2(x, y)；末端在 J1 轴线上时沿用种子 J1（同标量版）
+		const Reg rXy = V::Sqrt(V::Add(V::Mul(x, x), V::Mul(y, y)));
+		Reg q1 = Atan2<V>(x, y);
+		if (pSeed)
+		{
+			q1 = V::Select(V::CmpLt(rXy, V::Set1(1e-9)), V::Load(pSeed->q[1] + i), q1);
+		}
+
+		// 2) 投影到平面 (r, z') 并求腕中心
+		const Reg zp = V::Sub(z, V::Set1(k.L_base));
+		Reg sp, cp;
+		SinCos<V>(pitch, sp, cp);
+		const Reg lw = V::Set1(k.L_wrist);
+		const Reg rWc = V::Sub(rXy, V::Mul(lw, cp));
+		const Reg zWc = V::Sub(zp, V::Mul(lw, sp));
+
+		// 3) 可达性（NaN 输入同样判为不可达）
+		const Reg d2 = V::Add(V::Mul(rWc, rWc), V::Mul(zWc, zWc));
+		const Reg d = V::Sqrt(d2);
+		const Mask reach = V::And(V::CmpLe(d, V::Set1(k.dMax)), V::CmpLe(V::Set1(k.dMin), d));
+
+		// 4) 肘角：q3a = acos(c3) = atan2(s3, c3)，q3b = -q3a
+		const Reg one = V::Set1(1.0);
+		Reg c3 = V::Mul(V::Sub(d2, V::Set1(k.L1 * k.L1 + k.L2 * k.L2)), V::Set1(k.inv2L1L2));
+		c3 = V::Max(V::Set1(-1.0), V::Min(one, c3));
+		const Reg s3 = V::Sqrt(V::Max(zero, V::Sub(one, V::Mul(c3, c3))));
+		const Reg q3a = Atan2<V>(s3, c3);
+
+		// q2 = atan2(z, r) - atan2(L2*sin(q3), L1 + L2*cos(q3))；两解的 psi 互为相反数
+		const Reg phi = Atan2<V>(zWc, rWc);
+		const Reg psiA = Atan2<V>(V::Mul(V::Set1(k.L2), s3), V::Add(V::Set1(k.L1), V::Mul(V::Set1(k.L2), c3)));
+		const Reg q2aRaw = V::Sub(phi, psiA);
+		const Reg q2bRaw = V::Add(phi, psiA);
+
+		Reg qa[5], qb[5];
+		qa[1] = q1;
+		qb[1] = q1;
+		qa[2] = WrapToPi<V>(q2aRaw);
+		qb[2] = WrapToPi<V>(q2bRaw);
+		qa[3] = q3a;
+		qb[3] = V::Sub(zero, q3a);
+		qa[4] = WrapToPi<V>(V::Sub(pitch, V::Add(q2aRaw, q3a)));
+		qb[4] = WrapToPi<V>(V::Sub(pitch, V::Sub(q2bRaw, q3a)));
+
+		// 5) 限位 + 代价择优（与标量版同规则：先看是否在限位内，再比代价，严格更小才换成 B）
+		Mask withinA = V::CmpEq(zero, zero);
+		Mask withinB = withinA;
+		Reg costA = zero;
+		Reg costB = zero;
+		for (int j = 1; j <= 4; j++)
+		{
+			if (k.hasLimit[j])
+			{
+				const Reg mn = V::Set1(k.minRad[j]);
+				const Reg mx = V::Set1(k.maxRad[j]);
+				withinA = V::And(withinA, V::And(V::CmpLe(mn, qa[j]), V::CmpLe(qa[j], mx)));
+				withinB = V::And(withinB, V::And(V::CmpLe(mn, qb[j]), V::CmpLe(qb[j], mx)));
+			}
+			if (pSeed)
+			{
+				const Reg s = V::Load(pSeed->q[j] + i);
+				const Reg da = WrapToPi<V>(V::Sub(qa[j], s));
+				const Reg db = WrapToPi<V>(V::Sub(qb[j], s));
+				costA = V::Add(costA, V::Mul(da, da));
+				costB = V::Add(costB, V::Mul(db, db));
+			}
+		}
+		// 标量版的 1e6 + cost 在 float 下分辨率只有 0.06 rad²，这里用掩码表达同一规则
+		const Mask onlyA = V::And(withinA, V::Not(withinB));
+		const Mask onlyB = V::And(withinB, V::Not(withinA));
+		const Mask pickB = V::Or(onlyB, V::And(V::Not(onlyA), V::CmpLt(costB, costA)));
+		const Mask within = V::SelectMask(pickB, withinB, withinA);
+
+		for (int j = 1; j <= 4; j++)
+		{
+			V::Store(out.q[j] + i, V::Select(reach, V::Select(pickB, qb[j], qa[j]), zero));
+		}
+		if (out.q[5])
+		{
+			// 批量版只支持 RollMode::Hold：有种子时沿用种子 J5，否则 0
+			const Reg q5 = (pSeed && pSeed->q[5]) ? V::Load(pSeed->q[5] + i) : zero;
+			V::Store(out.q[5] + i, V::Select(reach, q5, zero));
+		}
+
+		// 6) 状态码：逐 lane 展开掩码
+		const int reachBits = V::MaskBits(reach);
+		const int withinBits = V::MaskBits(within);
+		size_t okCount = 0;
+		for (int lane = 0; lane < V::kWidth; lane++)
+		{
+			ArmKinematicsBatch::Status st = ArmKinematicsBatch::Status::Unreachable;
+			if (reachBits & (1 << lane))
+			{
+				st = (withinBits & (1 << lane)) ? ArmKinematicsBatch::Status::Ok : ArmKinematicsBatch::Status::OutOfLimits;
+			}
+			if (st == ArmKinematicsBatch::Status::Ok) okCount++;
+			if (outStatus) outStatus[i + lane] = static_cast<uint8_t>(st);
+		}
+		return okCount;
+	}
+
+	// 向量内核 + 同精度的标量尾部内核
+	template <class V, class T>
+	struct Kernels
+	{
+		using Vec = V;
+		using Tail = T;
+	};
+
+	// 按精度档把 Kernels<...> 交给 fn：Vd 为该后端的 double traits，Vf 为 float traits
+	template <class Vd, class Vf, class Fn>
+	auto WithPrecision(ArmKinematicsBatch::Precision precision, Fn fn)
+		-> decltype(fn(Kernels<Vd, KinematicsSimd::ScalarD>()))
+	{
+		using namespace KinematicsSimd;
+		switch (precision)
+		{
+		case ArmKinematicsBatch::Precision::Fast:
+			return fn(Kernels<FastMath<Vd>, FastMath<ScalarD>>());
+		case ArmKinematicsBatch::Precision::Float:
+			return fn(Kernels<Vf, ScalarF>());
+		default:
+			return fn(Kernels<Vd, ScalarD>());
+		}
+	}
+
+	template <class K>
+	size_t SolveRange(const KernelConsts& k,
+	                  const ArmKinematicsBatch::PoseSoA& in,
+	                  size_t count,
+	                  const ArmKinematicsBatch::JointsSoA& out,
+	                  uint8_t* outStatus,
+	                  const ArmKinematicsBatch::JointsSoAConst* pSeed)
+	{
+		using V = typename K::Vec;
+		const size_t w = static_cast<size_t>(V::kWidth);
+		size_t ok = 0;
+		size_t i = 0;
+		for (; i + w <= count; i += w)
+		{
+			ok += SolveGroup<V>(k, in, i, out, outStatus, pSeed);
+		}
+		// 尾部：同精度的标量内核（同一份模板，结果与向量 lane 一致）
+		for (; i < count; i++)
+		{
+			ok += SolveGroup<typename K::Tail>(k, in, i, out, outStatus, pSeed);
+		}
+		return ok;
+	}
+
+	struct FkConsts
+	{
+		double L_base = 0.0;
+		double L1 = 0.0;
+		double L2 = 0.0;
+		double L_wrist = 0.0;
+		double cam[3] = {}; // 相机光心在法兰系中的坐标（KinematicsCalib::Camera().p）
+	};
+
+	template <class V>
+	void StoreIf(double* p, size_t i, typename V::Reg v)
+	{
+		if (p) V::Store(p + i, v);
+	}
+
+	// FK：[i, i + V::kWidth) 这一组关节角；公式与 ArmKinematics::ForwardKinematicsFrames 相同
+	template <class V>
+	void FkGroup(const FkConsts& k,
+	             const ArmKinematicsBatch::JointsSoAConst& in,
+	             size_t i,
+	             const ArmKinematicsBatch::PoseSoAOut& outPose,
+	             const ArmKinematicsBatch::LinkPointsSoA* pPoints)
+	{
+		using Reg = typename V::Reg;
+		using F = ArmKinematics::LinkFrames;
+
+		const Reg zero = V::Set1(0.0);
+		const Reg q1 = V::Load(in.q[1] + i);
+		const Reg a2 = V::Load(in.q[2] + i);
+		const Reg a23 = V::Add(a2, V::Load(in.q[3] + i));
+		const Reg a234 = V::Add(a23, V::Load(in.q[4] + i));
+
+		Reg s1, c1, s2, c2, s23, c23, s234, c234;
+		SinCos<V>(q1, s1, c1);
+		SinCos<V>(a2, s2, c2);
+		SinCos<V>(a23, s23, c23);
+		SinCos<V>(a234, s234, c234);
+
+		// 平面 (前向, 高度)
+		const Reg lBase = V::Set1(k.L_base);
+		const Reg yEl = V::Mul(V::Set1(k.L1), c2);
+		const Reg zEl = V::Add(lBase, V::Mul(V::Set1(k.L1), s2));
+		const Reg yWr = V::Add(yEl, V::Mul(V::Set1(k.L2), c23));
+		const Reg zWr = V::Add(zEl, V::Mul(V::Set1(k.L2), s23));
+		const Reg yEe = V::Add(yWr, V::Mul(V::Set1(k.L_wrist), c234));
+		const Reg zEe = V::Add(zWr, V::Mul(V::Set1(k.L_wrist), s234));
+
+		const Reg xEeB = V::Mul(yEe, s1);
+		const Reg yEeB = V::Mul(yEe, c1);
+		StoreIf<V>(outPose.x_mm, i, xEeB);
+		StoreIf<V>(outPose.y_mm, i, yEeB);
+		StoreIf<V>(outPose.z_mm, i, zEe);
+		StoreIf<V>(outPose.pitch_deg, i, V::Mul(a234, V::Set1(180.0 / kPi)));
+
+		if (!pPoints) return;
+		const auto& P = *pPoints;
+		auto storePlane = [&](int idx, Reg py, Reg pz)
+		{
+			StoreIf<V>(P.x[idx], i, V::Mul(py, s1));
+			StoreIf<V>(P.y[idx], i, V::Mul(py, c1));
+			StoreIf<V>(P.z[idx], i, pz);
+		};
+		storePlane(F::kBase, zero, zero);
+		storePlane(F::kTurntable, zero, zero);
+		storePlane(F::kShoulder, zero, lBase);
+		storePlane(F::kElbow, yEl, zEl);
+		storePlane(F::kWrist, yWr, zWr);
+		StoreIf<V>(P.x[F::kFlange], i, xEeB);
+		StoreIf<V>(P.y[F::kFlange], i, yEeB);
+		StoreIf<V>(P.z[F::kFlange], i, zEe);
+
+		if (P.x[F::kCamera] || P.y[F::kCamera] || P.z[F::kCamera])
+		{
+			// 法兰轴（x = (c1, -s1, 0)，y_link = (c234·s1, c234·c1, s234)，z_link = (-s234·s1, -s234·c1, c234)）：
+			// x_fl = c5·x - s5·z_link，y_fl = y_link，z_fl = s5·x + c5·z_link
+			Reg s5 = zero, c5 = V::Set1(1.0);
+			if (in.q[5]) SinCos<V>(V::Load(in.q[5] + i), s5, c5);
+			const Reg c5s234 = V::Mul(c5, s234);
+			const Reg s5s234 = V::Mul(s5, s234);
+			const Reg zx = V::Sub(V::Mul(s5, c1), V::Mul(c5s234, s1));
+			const Reg zy = V::Sub(zero, V::Add(V::Mul(s5, s1), V::Mul(c5s234, c1)));
+			const Reg zz = V::Mul(c5, c234);
+			const Reg xx = V::Add(V::Mul(c5, c1), V::Mul(s5s234, s1));
+			const Reg xy = V::Sub(V::Mul(s5s234, c1), V::Mul(c5, s1));
+			const Reg xz = V::Sub(zero, V::Mul(s5, c234));
+			const Reg tx = V::Set1(k.cam[0]);
+			const Reg ty = V::Set1(k.cam[1]);
+			const Reg tz = V::Set1(k.cam[2]);
+			StoreIf<V>(P.x[F::kCamera], i, V::Add(xEeB, V::Add(V::Mul(tx, xx), V::Add(V::Mul(ty, V::Mul(c234, s1)), V::Mul(tz, zx)))));
+			StoreIf<V>(P.y[F::kCamera], i, V::Add(yEeB, V::Add(V::Mul(tx, xy), V::Add(V::Mul(ty, V::Mul(c234, c1)), V::Mul(tz, zy)))));
+			StoreIf<V>(P.z[F::kCamera], i, V::Add(zEe, V::Add(V::Mul(tx, xz), V::Add(V::Mul(ty, s234), V::Mul(tz, zz)))));
+		}
+	}
+
+	template <class K>
+	void FkRange(const FkConsts& k,
+	             const ArmKinematicsBatch::JointsSoAConst& in,
+	             size_t count,
+	             const ArmKinematicsBatch::PoseSoAOut& outPose,
+	             const ArmKinematicsBatch::LinkPointsSoA* pPoints)
+	{
+		using V = typename K::Vec;
+		const size_t w = static_cast<size_t>(V::kWidth);
+		size_t i = 0;
+		for (; i + w <= count; i += w)
+		{
+			FkGroup<V>(k, in, i, outPose, pPoints);
+		}
+		for (; i < count; i++)
+		{
+			FkGroup<typename K::Tail>(k, in, i, outPose, pPoints);
+		}
+	}
+
+#if defined(KINEMATICS_SIMD_HAS_AVX2)
+	bool CpuHasAvx2()
+	{
+#if defined(_MSC_VER) && !defined(__AVX2__)
+		// 未开 /arch:AVX2 时运行时检测：CPUID 的 AVX/OSXSAVE/AVX2 位 + XCR0 的 YMM 状态位
+		int r[4] = {};
+		__cpuid(r, 0);
+		if (r[0] < 7) return false;
+		__cpuid(r, 1);
+		const bool osxsave = (r[2] & (1 << 27)) != 0;
+		const bool avx = (r[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx) return false;
+		if ((_xgetbv(0) & 0x6) != 0x6) return false;
+		__cpuidex(r, 7, 0);
+		return (r[1] & (1 << 5)) != 0;
+#else
+		return true; // 编译期已启用 AVX2（-mavx2 / /arch:AVX2）
+#endif
+	}
+#endif
+}
+
+bool ArmKinematicsBatch::IsBackendAvailable(Backend backend)
+{
+	switch (backend)
+	{
+	case Backend::Scalar:
+		return true;
+	case Backend::Avx2:
+#if defined(KINEMATICS_SIMD_HAS_AVX2)
+	{
+		static const bool s_avx2 = CpuHasAvx2();
+		return s_avx2;
+	}
+#else
+		return false;
+#endif
+	case Backend::Neon:
+#if defined(KINEMATICS_SIMD_HAS_NEON)
+		return true;
+#else
+		return false;
+#endif
+	default:
+		return false;
+	}
+}
+
+ArmKinematicsBatch::Backend ArmKinematicsBatch::BestBackend()
+{
+	if (IsBackendAvailable(Backend::Avx2)) return Backend::Avx2;
+	if (IsBackendAvailable(Backend::Neon)) return Backend::Neon;
+	return Backend::Scalar;
+}
+
+const char* ArmKinematicsBatch::BackendName(Backend backend)
+{
+	switch (backend)
+	{
+	case Backend::Scalar: return "scalar";
+	case Backend::Avx2: return "avx2";
+	case Backend::Neon: return "neon";
+	default: return "?";
+	}
+}
+
+const char* ArmKinematicsBatch::PrecisionName(Precision precision)
+{
+	switch (precision)
+	{
+	case Precision::Double: return "double";
+	case Precision::Fast: return "fast";
+	case Precision::Float: return "float";
+	default: return "?";
+	}
+}
+
+const wchar_t* ArmKinematicsBatch::StatusText(Status status)
+{
+	switch (status)
+	{
+	case Status::Ok: return ArmKinematics::IkErrorText(ArmKinematics::IkError::None);
+	case Status::OutOfLimits: return ArmKinematics::IkErrorText(ArmKinematics::IkError::OutOfLimits);
+	case Status::Unreachable: return ArmKinematics::IkErrorText(ArmKinematics::IkError::Unreachable);
+	default: return ArmKinematics::IkErrorText(ArmKinematics::IkError::NoSolution);
+	}
+}
+
+size_t ArmKinematicsBatch::InverseKinematics(const KinematicsCalib& calib,
+                                             const PoseSoA& in,
+                                             size_t count,
+                                             const JointsSoA& out,
+                                             uint8_t* outStatus,
+                                             const JointsSoAConst* pSeed,
+                                             Backend backend,
+                                             Precision precision)
+{
+	if (count == 0) return 0;
+	if (!in.x_mm || !in.y_mm || !in.z_mm || !in.pitch_deg) return 0;
+	for (int j = 1; j <= 4; j++)
+	{
+		if (!out.q[j]) return 0;
+		if (pSeed && !pSeed->q[j]) return 0;
+	}
+
+	const KernelConsts k = MakeConsts(calib, precision);
+	if (!IsBackendAvailable(backend)) backend = Backend::Scalar;
+
+	auto solve = [&](auto kernels)
+	{
+		return SolveRange<decltype(kernels)>(k, in, count, out, outStatus, pSeed);
+	};
+	switch (backend)
+	{
+#if defined(KINEMATICS_SIMD_HAS_AVX2)
+	case Backend::Avx2:
+	{
+		const size_t ok = WithPrecision<KinematicsSimd::Avx2D, KinematicsSimd::Avx2F>(precision, solve);
+		_mm256_zeroupper(); // 避免后续 SSE 代码的 AVX-SSE 切换惩罚
+		return ok;
+	}
+#endif
+#if defined(KINEMATICS_SIMD_HAS_NEON)
+	case Backend::Neon:
+		return WithPrecision<KinematicsSimd::NeonD, KinematicsSimd::NeonF>(precision, solve);
+#endif
+	default:
+		return WithPrecision<KinematicsSimd::ScalarD, KinematicsSimd::ScalarF>(precision, solve);
+	}
+}
+
+void ArmKinematicsBatch::ForwardKinematics(const KinematicsCalib& calib,
+                                           const JointsSoAConst& in,
+                                           size_t count,
+                                           const PoseSoAOut& outPose,
+                                           const LinkPointsSoA* pPoints,
+                                           Backend backend,
+                                           Precision precision)
+{
+	if (count == 0) return;
+	for (int j = 1; j <= 4; j++)
+	{
+		if (!in.q[j]) return;
+	}
+
+	const auto& L = calib.Links();
+	FkConsts k;
+	k.L_base = L.L_base;
+	k.L1 = L.L_arm1;
+	k.L2 = L.L_arm2;
+	k.L_wrist = L.L_wrist;
+	for (int c = 0; c < 3; c++) k.cam[c] = calib.Camera().p[c];
+	if (!IsBackendAvailable(backend)) backend = Backend::Scalar;
+
+	auto fk = [&](auto kernels)
+	{
+		FkRange<decltype(kernels)>(k, in, count, outPose, pPoints);
+	};
+	switch (backend)
+	{
+#if defined(KINEMATICS_SIMD_HAS_AVX2)
+	case Backend::Avx2:
+		WithPrecision<KinematicsSimd::Avx2D, KinematicsSimd::Avx2F>(precision, fk);
+		_mm256_zeroupper();
+		return;
+#endif
+#if defined(KINEMATICS_SIMD_HAS_NEON)
+	case Backend::Neon:
+		WithPrecision<KinematicsSimd::NeonD, KinematicsSimd::NeonF>(precision, fk);
+		return;
+#endif
+	default:
+		WithPrecision<KinematicsSimd::ScalarD, KinematicsSimd::ScalarF>(precision, fk);
+		return;
+	}
+}
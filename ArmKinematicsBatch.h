@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "ArmKinematics.h"
+#include "KinematicsCalib.h"
+
+// 批量接口的默认精度（ArmKinematicsBatch::Precision 的枚举名），可在工程预处理器定义里改成 Fast / Float；
+// 每次调用仍可显式指定。
+#ifndef ARM_KINEMATICS_BATCH_DEFAULT_PRECISION
+#define ARM_KINEMATICS_BATCH_DEFAULT_PRECISION Double
+#endif
+
+// ArmKinematicsBatch：批量 IK / FK（结构体数组 SoA 输入/输出）
+//
+// 适用场景：工作空间扫描、轨迹预求解、抓取候选排序、轨迹碰撞检测等一次要解成千上万个位姿/关节角的场合。
+// - 与 ArmKinematics::InverseKinematics 同一套闭式解（base yaw + 平面两连杆 + 腕俯仰），同样的择优规则：
+//   先软限位内，再离种子姿态（可选）最近；无种子时取肘解 A（q3 >= 0）。
+// - 内核按 SIMD 宽度一次解 1/2/4 个位姿（标量 / NEON / AVX2），尾部用标量内核补齐；
+// - 不分配内存、不产生 wstring：每个位姿只输出一个字节的 Status，文字说明按需 StatusText() 获取；
+// - 精度可选（Precision）：舵机分辨率约 0.24°/位置单位，double + 双精度超越函数远超所需，
+//   Fast / Float 两档用单精度级多项式（Float 再把向量宽度翻倍），误差见 KinematicsBench 的 IK / FK 段。
+class ArmKinematicsBatch
+{
+public:
+	static constexpr int kJointCount = ArmKinematics::kJointCount; // 5
+
+	enum class Status : uint8_t
+	{
+		Ok = 0,          // 有解且在软限位内
+		OutOfLimits = 1, // 有解，但最优候选仍超出软限位（关节角照常输出，上层自行决定是否采用）
+		Unreachable = 2, // 腕中心超出两连杆可达范围（关节角输出 0）
+	};
+
+	enum class Backend : uint8_t
+	{
+		Scalar = 0,
+		Avx2 = 1,
+		Neon = 2,
+	};
+
+	// 计算精度。输入输出始终是 double 数组，只影响内核内部的运算类型与超越函数逼近：
+	// - Double：double + Cephes 双精度逼近，与 ArmKinematics 标量版一致到 1e-12 量级；
+	// - Fast：double + 单精度级多项式（sin/cos/atan 误差 ~1e-7 rad），择优/限位判断仍是双精度；
+	// - Float：float 运算（AVX2 8 路、NEON 4 路）+ 同一套多项式；关节角误差 ~1e-6 rad、末端 ~1e-4 mm 量级，
+	//   均远小于 1 个舵机位置单位。限位 / 可达边界上 1e-5 量级以内的位姿状态可能与 Double 不同。
+	enum class Precision : uint8_t
+	{
+		Double = 0,
+		Fast = 1,
+		Float = 2,
+	};
+
+	static constexpr Precision kDefaultPrecision = Precision::ARM_KINEMATICS_BATCH_DEFAULT_PRECISION;
+
+	// 输入：count 个位姿，每个分量一段连续数组（Base 坐标系，mm / deg）
+	struct PoseSoA
+	{
+		const double* x_mm = nullptr;
+		const double* y_mm = nullptr;
+		const double* z_mm = nullptr;
+		const double* pitch_deg = nullptr;
+	};
+
+	// 输出关节角（弧度），q[1..4] 必填；q[5] 可为空（IK 不解滚转目标：有种子 q[5] 时照抄，否则写 0）
+	struct JointsSoA
+	{
+		std::array<double*, kJointCount + 1> q{};
+	};
+
+	// 种子关节角（可选，用于“离当前/上一解最近”择优），q[1..4] 必填，q[5] 可为空
+	struct JointsSoAConst
+	{
+		std::array<const double*, kJointCount + 1> q{};
+	};
+
+	// 批量 FK 输出：末端位姿（同 ArmKinematics::ForwardKinematics），任一指针为空则不写该分量
+	struct PoseSoAOut
+	{
+		double* x_mm = nullptr;
+		double* y_mm = nullptr;
+		double* z_mm = nullptr;
+		double* pitch_deg = nullptr;
+	};
+
+	// 批量 FK 输出：各关节坐标系原点（Base 坐标系，mm），下标为 ArmKinematics::LinkFrames::Index；
+	// 为空的下标不写。姿态（旋转矩阵）不批量输出——它只由 q1、俯仰和与 q5 决定，需要时逐个调用 ForwardKinematicsFrames。
+	struct LinkPointsSoA
+	{
+		std::array<double*, ArmKinematics::LinkFrames::kCount> x{};
+		std::array<double*, ArmKinematics::LinkFrames::kCount> y{};
+		std::array<double*, ArmKinematics::LinkFrames::kCount> z{};
+	};
+
+public:
+	// 批量求解。backend 不可用时自动退回标量；返回 Status::Ok 的数量。
+	static size_t InverseKinematics(const KinematicsCalib& calib,
+	                                const PoseSoA& in,
+	                                size_t count,
+	                                const JointsSoA& out,
+	                                uint8_t* outStatus,
+	                                const JointsSoAConst* pSeed = nullptr,
+	                                Backend backend = BestBackend(),
+	                                Precision precision = kDefaultPrecision);
+
+	// 批量 FK：in.q[1..4] 必填；in.q[5] 为空视为 0（只影响相机原点）。pPoints 为空则只算末端位姿。
+	static void ForwardKinematics(const KinematicsCalib& calib,
+	                              const JointsSoAConst& in,
+	                              size_t count,
+	                              const PoseSoAOut& outPose,
+	                              const LinkPointsSoA* pPoints = nullptr,
+	                              Backend backend = BestBackend(),
+	                              Precision precision = kDefaultPrecision);
+
+	// 当前进程可用的最快后端（AVX2 需编译期支持 + 运行时 CPU/OS 支持）
+	static Backend BestBackend();
+	static bool IsBackendAvailable(Backend backend);
+	static const char* BackendName(Backend backend);
+	static const char* PrecisionName(Precision precision);
+
+	// 状态码 -> UI 文本（复用 ArmKinematics::IkErrorText）
+	static const wchar_t* StatusText(Status status);
+};
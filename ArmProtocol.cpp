@@ -31,7 +31,14 @@ namespace
 std::vector<uint8_t> ArmProtocol::PackMove(const std::vector<ServoTarget>& servos, uint16_t timeMs)
 {
 	std::vector<uint8_t> out;
-	const uint8_t n = static_cast<uint8_t>(std::min<size_t>(servos.size(), 0xFF));
+	PackMoveInto(servos.data(), servos.size(), timeMs, out);
+	return out;
+}
+
+void ArmProtocol::PackMoveInto(const ServoTarget* servos, size_t count, uint16_t timeMs, std::vector<uint8_t>& out)
+{
+	out.clear();
+	const uint8_t n = static_cast<uint8_t>(std::min<size_t>(servos ? count : 0, 0xFF));
 
 	// len = n*3 + 5 (from the len byte itself to end-of-frame)
 	const uint8_t len = static_cast<uint8_t>(n * 3 + 5);
@@ -49,7 +56,30 @@ std::vector<uint8_t> ArmProtocol::PackMove(const std::vector<ServoTarget>& servo
 		out.push_back(servos[i].id);
 		AppendU16LE(out, servos[i].position);
 	}
-	return out;
+}
+
+bool ArmProtocol::DecodeMove(const uint8_t* bytes, size_t len, uint16_t& timeMs, ServoTarget* servos, size_t maxServos, size_t& count)
+{
+	count = 0;
+	// header2 + len + cmd + count + time(2) + n*(id+pos(2))
+	if (!bytes || len < 7 || !HasHeaderAt(bytes, len, 0) || bytes[3] != static_cast<uint8_t>(Command::Move))
+	{
+		return false;
+	}
+	const size_t frameSize = std::min<size_t>(len, static_cast<size_t>(2 + bytes[2]));
+	timeMs = ReadU16LE(bytes + 5);
+	const size_t entries = std::min<size_t>(bytes[4], (frameSize >= 7) ? (frameSize - 7) / 3 : 0);
+	for (size_t i = 0; i < entries; i++)
+	{
+		const size_t off = 7 + i * 3;
+		if (servos && i < maxServos)
+		{
+			servos[i].id = bytes[off + 0];
+			servos[i].position = ReadU16LE(bytes + off + 1);
+		}
+	}
+	count = entries;
+	return true;
 }
 
 std::vector<uint8_t> ArmProtocol::PackReadPosition(const std::vector<uint8_t>& ids)
@@ -71,6 +101,26 @@ std::vector<uint8_t> ArmProtocol::PackReadPosition(const std::vector<uint8_t>& i
 	return out;
 }
 
+std::vector<uint8_t> ArmProtocol::PackReadResponse(const std::vector<ServoTarget>& servos)
+{
+	std::vector<uint8_t> out;
+	const uint8_t n = static_cast<uint8_t>(std::min<size_t>(servos.size(), 0xFF));
+	const uint8_t len = static_cast<uint8_t>(n * 3 + 3); // read response: len = n*3 + 3
+
+	out.reserve(static_cast<size_t>(2 + len));
+	out.push_back(kHeader0);
+	out.push_back(kHeader1);
+	out.push_back(len);
+	out.push_back(static_cast<uint8_t>(Command::ReadPosition));
+	out.push_back(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		out.push_back(servos[i].id);
+		AppendU16LE(out, servos[i].position);
+	}
+	return out;
+}
+
 bool ArmProtocol::TryParseOne(const uint8_t* buffer, size_t bufferLen, ParsedFrame& out, size_t& consumed)
 {
 	consumed = 0;
@@ -34,9 +34,21 @@ namespace ArmProtocol
 	// Pack: move N servos to target positions within timeMs
 	std::vector<uint8_t> PackMove(const std::vector<ServoTarget>& servos, uint16_t timeMs);
 
+	// Same frame as PackMove, written into a caller-owned buffer (cleared first). Reusing the buffer
+	// (see ArmCommsService::AcquireTxBuffer) keeps periodic senders such as Jog allocation-free.
+	void PackMoveInto(const ServoTarget* servos, size_t count, uint16_t timeMs, std::vector<uint8_t>& out);
+
+	// Decode a complete Move frame without allocating (the TX path feeds ServoStateEstimator with every sent frame).
+	// Writes up to maxServos entries and returns the servo count in the frame; false if bytes is not a Move frame.
+	bool DecodeMove(const uint8_t* bytes, size_t len, uint16_t& timeMs, ServoTarget* servos, size_t maxServos, size_t& count);
+
 	// Pack: read N servo positions
 	std::vector<uint8_t> PackReadPosition(const std::vector<uint8_t>& ids);
 
+	// Pack: read position response (servo -> host), len = n*3 + 3.
+	// Used by the simulators (FakeSerialPort / tools/ArmSimulator) to speak the wire format byte-for-byte.
+	std::vector<uint8_t> PackReadResponse(const std::vector<ServoTarget>& servos);
+
 	// Parse: attempt to parse one frame from a byte stream; supports junk prefix + partial frames.
 	// - consumed: bytes to drop from the front of buffer (may be 0)
 	// - returns true if a full frame was parsed into out
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "KinematicsCalib.h"
+
+// Builds a calibration-derived map (ReachabilityMap, ManipulabilityMap) on a worker thread.
+// - The UI thread calls Start and polls TakeResult from a timer; TakeResult returns null until the build finishes.
+// - Start is a no-op while the requested arm fingerprint (KinematicsCalib::GetArmFingerprint) is unchanged;
+//   a new fingerprint cancels and joins the running build first. The destructor does the same.
+// - Derived builders supply the build call: build(map, calib, params, pCancel) -> false when cancelled or failed.
+template <class Map, class Params>
+class BackgroundMapBuilder
+{
+public:
+	BackgroundMapBuilder() = default;
+	~BackgroundMapBuilder() { StopWorker(); }
+
+	BackgroundMapBuilder(const BackgroundMapBuilder&) = delete;
+	BackgroundMapBuilder& operator=(const BackgroundMapBuilder&) = delete;
+
+	uint64_t RequestedFingerprint() const { return m_requestedFp; }
+
+	std::shared_ptr<const Map> TakeResult()
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		std::shared_ptr<const Map> r = std::move(m_result);
+		m_result.reset();
+		return r;
+	}
+
+protected:
+	template <class BuildFn>
+	void StartBuild(const KinematicsCalib& calib, const Params& params, BuildFn build)
+	{
+		if (m_started && calib.GetArmFingerprint() == m_requestedFp)
+		{
+			return;
+		}
+		StopWorker();
+
+		m_cancel.store(false);
+		m_requestedFp = calib.GetArmFingerprint();
+		m_started = true;
+		m_th = std::thread([this, calib, params, build]()
+		{
+			std::shared_ptr<Map> map = std::make_shared<Map>();
+			if (!build(*map, calib, params, &m_cancel))
+			{
+				return;
+			}
+			std::lock_guard<std::mutex> lock(m_mtx);
+			m_result = map;
+		});
+	}
+
+private:
+	void StopWorker()
+	{
+		m_cancel.store(true);
+		if (m_th.joinable())
+		{
+			m_th.join();
+		}
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_result.reset();
+	}
+
+private:
+	std::thread m_th;
+	std::atomic<bool> m_cancel{ false };
+	std::mutex m_mtx;
+	std::shared_ptr<const Map> m_result;
+	uint64_t m_requestedFp = 0;
+	bool m_started = false;
+};
@@ -0,0 +1,438 @@
+#include "pch.h"
+
+#include "CartesianPlanner.h"
+
+#include "ArmKinematicsBatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	constexpr double kPi = 3.14159265358979323846;
+	constexpr double kDegToRad = kPi / 180.0;
+	constexpr int kTopJoint = 4; // 路径只驱动 J1..J4，J5 保持起始值
+
+	double Lerp(double a, double b, double t) { return a + (b - a) * t; }
+
+	// 加密后的采样点数上限（防止在真正的换分支处无限二分）
+	constexpr size_t kMaxSamples = 20000;
+	constexpr int kMaxRefinePasses = 12;
+	// 设定点流加速度复核：最多重新参数化的次数；判定时对上限留 1% 余量
+	constexpr int kMaxAccPasses = 16;
+	constexpr double kAccSlack = 0.99;
+
+	ArmKinematics::PoseTarget LerpPose(const ArmKinematics::PoseTarget& a, const ArmKinematics::PoseTarget& b, double t)
+	{
+		ArmKinematics::PoseTarget p;
+		p.x_mm = Lerp(a.x_mm, b.x_mm, t);
+		p.y_mm = Lerp(a.y_mm, b.y_mm, t);
+		p.z_mm = Lerp(a.z_mm, b.z_mm, t);
+		p.pitch_deg = Lerp(a.pitch_deg, b.pitch_deg, t);
+		return p;
+	}
+
+	double MaxJointDelta(const ArmKinematics::JointAnglesRad& a, const ArmKinematics::JointAnglesRad& b)
+	{
+		double m = 0.0;
+		for (int j = 1; j <= kTopJoint; j++) m = std::max(m, std::fabs(a.q[j] - b.q[j]));
+		return m;
+	}
+
+	// 路径采样点
+	struct Sample
+	{
+		ArmKinematics::PoseTarget pose{};
+		double s = 0.0;              // 累计路径参数
+		size_t seg = 0;              // 所在路段
+		bool corner = false;         // 中间路点（q'(s) 不连续，须停稳）
+		ArmKinematics::JointAnglesRad q;
+	};
+
+	// 采样点 i 处，给定 u = ṡ² 时可行的 s̈ 区间：对每个关节 |q'·a + q''·u| ≤ amax
+	// 返回 false 表示该 u 下区间为空（u 过大）
+	bool AccelInterval(const double* dq, const double* ddq, const double* amax, double u, double& lo, double& hi)
+	{
+		lo = -std::numeric_limits<double>::infinity();
+		hi = std::numeric_limits<double>::infinity();
+		for (int j = 1; j <= kTopJoint; j++)
+		{
+			const double c = dq[j];
+			const double d = ddq[j] * u;
+			if (std::fabs(c) < 1e-12)
+			{
+				if (std::fabs(d) > amax[j]) return false;
+				continue;
+			}
+			double a0 = (-amax[j] - d) / c;
+			double a1 = (amax[j] - d) / c;
+			if (a0 > a1) std::swap(a0, a1);
+			lo = std::max(lo, a0);
+			hi = std::min(hi, a1);
+		}
+		return lo <= hi;
+	}
+
+	// 区间 [i, e] 内 s̈ = a 恒定，e 端 u_e = u_i + 2·a·Δs（Δs 带符号）：e 端约束 |q'_e·a + q''_e·u_e| ≤ amax
+	// 仍是 a 的线性约束，系数为 q'_e + 2Δs·q''_e。与起点区间求交，使约束在区间两端都成立
+	bool AccelIntervalBothEnds(const double* dq0, const double* ddq0, const double* dqE, const double* ddqE,
+	                           const double* amax, double u, double ds, double& lo, double& hi)
+	{
+		if (!AccelInterval(dq0, ddq0, amax, u, lo, hi)) return false;
+		double c[ArmKinematics::kJointCount + 1] = {};
+		for (int j = 1; j <= kTopJoint; j++) c[j] = dqE[j] + 2.0 * ds * ddqE[j];
+		double loE = 0.0;
+		double hiE = 0.0;
+		if (!AccelInterval(c, ddqE, amax, u, loE, hiE)) return false;
+		lo = std::max(lo, loE);
+		hi = std::min(hi, hiE);
+		return lo <= hi;
+	}
+}
+
+bool CartesianPlanner::Plan(const KinematicsCalib& calib,
+                            const std::vector<ArmKinematics::PoseTarget>& waypoints,
+                            const ArmKinematics::JointAnglesRad* pQStart,
+                            const Params& params,
+                            Result& out,
+                            const CollisionModel* pCollision)
+{
+	out = Result();
+	auto fail = [&](PlanError e, size_t seg)
+	{
+		out.ok = false;
+		out.error = e;
+		out.failedSegment = seg;
+		return false;
+	};
+
+	if (waypoints.size() < 2)
+	{
+		return fail(PlanError::TooFewWaypoints, 0);
+	}
+
+	// 1) 直线插值 + 密采样；s 为累计路径长度（位置 mm 与加权俯仰合成）
+	std::vector<Sample> path;
+	{
+		Sample first;
+		first.pose = waypoints[0];
+		path.push_back(first);
+	}
+	const double stepMm = std::max(params.sampleStepMm, 0.1);
+	const double stepPitch = std::max(params.sampleStepPitchDeg, 0.05);
+	for (size_t w = 0; w + 1 < waypoints.size(); w++)
+	{
+		const auto& a = waypoints[w];
+		const auto& b = waypoints[w + 1];
+		const double dp = std::sqrt((b.x_mm - a.x_mm) * (b.x_mm - a.x_mm) + (b.y_mm - a.y_mm) * (b.y_mm - a.y_mm)
+			+ (b.z_mm - a.z_mm) * (b.z_mm - a.z_mm));
+		const double dPitch = std::fabs(b.pitch_deg - a.pitch_deg);
+		if (dp < 1e-9 && dPitch < 1e-9) continue; // 重复路点
+
+		const int n = std::max(1, static_cast<int>(std::ceil(std::max(dp / stepMm, dPitch / stepPitch))));
+		const double len = std::sqrt(dp * dp + (params.pitchWeightMm * dPitch * kDegToRad) * (params.pitchWeightMm * dPitch * kDegToRad));
+		const double s0 = path.back().s;
+		path.back().corner = (path.size() > 1); // 上一段终点即本段起点：中间路点为拐角
+		for (int k = 1; k <= n; k++)
+		{
+			Sample smp;
+			smp.pose = LerpPose(a, b, static_cast<double>(k) / n);
+			smp.s = s0 + len * k / n;
+			smp.seg = w;
+			path.push_back(smp);
+		}
+	}
+	if (path.size() < 2)
+	{
+		return fail(PlanError::TooFewWaypoints, 0);
+	}
+
+	// 2) 逐点 IK：以上一点为种子，保证沿路径连续（不换肘解）
+	const double q5 = pQStart ? pQStart->q[5] : 0.0;
+	auto solve = [&](Sample& smp, const ArmKinematics::JointAnglesRad* pSeed) -> PlanError
+	{
+		ArmKinematics::IkResultLite ik;
+		if (!ArmKinematics::InverseKinematics(calib, smp.pose, pSeed, ik)) return PlanError::Unreachable;
+		if (ik.error == ArmKinematics::IkError::OutOfLimits) return PlanError::OutOfLimits;
+		smp.q = ik.chosenQ;
+		smp.q.q[5] = q5;
+		return PlanError::None;
+	};
+	for (size_t i = 0; i < path.size(); i++)
+	{
+		const PlanError e = solve(path[i], (i > 0) ? &path[i - 1].q : pQStart);
+		if (e != PlanError::None) return fail(e, path[i].seg);
+	}
+
+	// 奇异点附近 q(s) 弯得很急，固定步长下相邻点之间的关节弦线会严重偏离真实曲线（设定点速度突变）：
+	// 关节变化超过 maxSampleJointDeg 的区间二分加密，直到满足或区间已很短
+	const double maxStep = std::max(params.maxSampleJointDeg, 0.01) * kDegToRad;
+	const double minInterval = stepMm * 1e-3;
+	for (int pass = 0; pass < kMaxRefinePasses; pass++)
+	{
+		std::vector<Sample> refined;
+		refined.reserve(path.size() * 2);
+		refined.push_back(path[0]);
+		bool changed = false;
+		for (size_t i = 1; i < path.size(); i++)
+		{
+			const Sample& a = path[i - 1];
+			const Sample& b = path[i];
+			if (MaxJointDelta(a.q, b.q) > maxStep && b.s - a.s > minInterval && path.size() + refined.size() < kMaxSamples)
+			{
+				Sample mid;
+				mid.pose = LerpPose(a.pose, b.pose, 0.5);
+				mid.s = 0.5 * (a.s + b.s);
+				mid.seg = b.seg;
+				const PlanError e = solve(mid, &a.q);
+				if (e != PlanError::None) return fail(e, mid.seg);
+				refined.push_back(mid);
+				changed = true;
+			}
+			refined.push_back(b);
+		}
+		path.swap(refined);
+		if (!changed) break;
+	}
+
+	// 加密到最短区间仍有关节跳变：q(s) 在此不连续（穿过奇异点/换肘解），直线不可执行
+	for (size_t i = 1; i < path.size(); i++)
+	{
+		if (MaxJointDelta(path[i - 1].q, path[i].q) > maxStep)
+		{
+			return fail(PlanError::BranchFlip, path[i].seg);
+		}
+	}
+
+	const size_t N = path.size();
+	out.sampleCount = N;
+	std::vector<double> s(N);
+	std::array<std::vector<double>, ArmKinematics::kJointCount + 1> q;
+	for (auto& v : q) v.resize(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		s[i] = path[i].s;
+		for (int j = 1; j <= ArmKinematics::kJointCount; j++) q[j][i] = path[i].q.q[j];
+	}
+
+	if (pCollision)
+	{
+		ArmKinematicsBatch::JointsSoAConst in;
+		for (int j = 1; j <= ArmKinematics::kJointCount; j++) in.q[j] = q[j].data();
+		size_t first = N;
+		if (pCollision->CheckBatch(calib, in, N, nullptr, &first) > 0)
+		{
+			return fail(PlanError::Collision, path[first].seg);
+		}
+	}
+
+	// 3) 路径导数 q'(s), q''(s)（非均匀网格中心差分，端点单侧）
+	std::vector<std::array<double, ArmKinematics::kJointCount + 1>> dq(N), ddq(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		for (int j = 1; j <= kTopJoint; j++)
+		{
+			double d1 = 0.0;
+			double d2 = 0.0;
+			if (i == 0)
+			{
+				d1 = (q[j][1] - q[j][0]) / (s[1] - s[0]);
+			}
+			else if (i == N - 1)
+			{
+				d1 = (q[j][i] - q[j][i - 1]) / (s[i] - s[i - 1]);
+			}
+			else
+			{
+				const double h1 = s[i] - s[i - 1];
+				const double h2 = s[i + 1] - s[i];
+				const double den = h1 * h2 * (h1 + h2);
+				d1 = (h1 * h1 * q[j][i + 1] - h2 * h2 * q[j][i - 1] - (h1 * h1 - h2 * h2) * q[j][i]) / den;
+				d2 = 2.0 * (h1 * q[j][i + 1] - (h1 + h2) * q[j][i] + h2 * q[j][i - 1]) / den;
+			}
+			dq[i][j] = d1;
+			ddq[i][j] = d2;
+		}
+	}
+	if (N > 2)
+	{
+		ddq[0] = ddq[1];
+		ddq[N - 1] = ddq[N - 2];
+	}
+
+	double vmax[ArmKinematics::kJointCount + 1] = {};
+	double amax[ArmKinematics::kJointCount + 1] = {};
+	for (int j = 1; j <= kTopJoint; j++)
+	{
+		vmax[j] = std::max(params.maxVelDegPerSec[j], 1e-3) * kDegToRad;
+		amax[j] = std::max(params.maxAccDegPerSec2[j], 1e-3) * kDegToRad;
+	}
+
+	// 4) TOPP：u = ṡ² 的上界曲线（速度约束 + 加速度约束可行性），再前向加速 / 反向减速两遍
+	std::vector<double> uMax(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		double ub = 1e12;
+		for (int j = 1; j <= kTopJoint; j++)
+		{
+			const double c = std::fabs(dq[i][j]);
+			if (c > 1e-12) ub = std::min(ub, (vmax[j] / c) * (vmax[j] / c));
+		}
+		// 加速度约束下 (a, u) 可行域为包含原点的凸集，其在 u 轴上的投影是 [0, uAcc]：二分求 uAcc
+		double lo = 0.0;
+		double hi = 0.0;
+		if (!AccelInterval(dq[i].data(), ddq[i].data(), amax, ub, lo, hi))
+		{
+			double uLo = 0.0;
+			double uHi = ub;
+			for (int it = 0; it < 40; it++)
+			{
+				const double mid = 0.5 * (uLo + uHi);
+				if (AccelInterval(dq[i].data(), ddq[i].data(), amax, mid, lo, hi)) uLo = mid;
+				else uHi = mid;
+			}
+			ub = uLo;
+		}
+		uMax[i] = ub;
+	}
+	// 拐角处 q'(s) 不连续：离散的 q'' 只能把速度压到 O(√h)，设定点仍会有速度突变，因此直接在路点处停稳
+	for (size_t i = 0; i < N; i++)
+	{
+		if (path[i].corner) uMax[i] = 0.0;
+	}
+
+	// 拐角采样点的中心差分跨两条直线，导数不代表任何一侧：区间起点取本区间一侧，终点同理
+	// （前向：起点拐角取 i+1，终点拐角取 i；反向相反）
+	std::vector<bool> isCorner(N, false);
+	for (size_t i = 0; i < N; i++) isCorner[i] = path[i].corner;
+
+	std::vector<double> u(N, 0.0);
+	std::vector<double> t(N, 0.0);
+	auto parameterize = [&]()
+	{
+		std::fill(u.begin(), u.end(), 0.0);
+		for (size_t i = 0; i + 1 < N; i++)
+		{
+			const size_t d = isCorner[i] ? i + 1 : i;
+			const size_t e = isCorner[i + 1] ? i : i + 1;
+			const double ds = s[i + 1] - s[i];
+			double lo = 0.0;
+			double hi = 0.0;
+			if (!AccelIntervalBothEnds(dq[d].data(), ddq[d].data(), dq[e].data(), ddq[e].data(), amax, u[i], ds, lo, hi)) hi = 0.0;
+			u[i + 1] = std::max(0.0, std::min(uMax[i + 1], u[i] + 2.0 * hi * ds));
+		}
+		u[N - 1] = 0.0;
+		for (size_t i = N - 1; i > 0; i--)
+		{
+			const size_t d = isCorner[i] ? i - 1 : i;
+			const size_t e = isCorner[i - 1] ? i : i - 1;
+			const double ds = s[i - 1] - s[i];
+			double lo = 0.0;
+			double hi = 0.0;
+			if (!AccelIntervalBothEnds(dq[d].data(), ddq[d].data(), dq[e].data(), ddq[e].data(), amax, u[i], ds, lo, hi)) lo = 0.0;
+			u[i - 1] = std::max(0.0, std::min(u[i - 1], u[i] + 2.0 * lo * ds));
+		}
+		u[0] = 0.0;
+
+		// 各采样点时刻：段内匀加速，dt = 2h / (√u_i + √u_{i+1})
+		for (size_t i = 0; i + 1 < N; i++)
+		{
+			const double den = std::sqrt(u[i]) + std::sqrt(u[i + 1]);
+			t[i + 1] = t[i] + 2.0 * (s[i + 1] - s[i]) / std::max(den, 1e-9);
+		}
+		out.durationSec = t[N - 1];
+	};
+
+	// 5) 固定周期重采样为设定点流；segOf[k] 为设定点 k 所在的采样区间
+	const double period = std::max(params.setpointPeriodMs, 1) / 1000.0;
+	std::vector<size_t> segOf;
+	auto resample = [&]()
+	{
+		const size_t steps = static_cast<size_t>(std::ceil(out.durationSec / period));
+		out.setpoints.clear();
+		out.setpoints.reserve(steps + 1);
+		segOf.clear();
+		size_t i = 0;
+		for (size_t k = 0; k <= steps; k++)
+		{
+			const double tk = std::min(k * period, out.durationSec);
+			while (i + 2 < N && t[i + 1] <= tk) i++;
+
+			// 段内：ṡ 线性变化（匀加速），由经过时间反求 s 的进度
+			const double h = s[i + 1] - s[i];
+			const double tau = tk - t[i];
+			const double v0 = std::sqrt(u[i]);
+			const double acc = (u[i + 1] - u[i]) / (2.0 * h);
+			const double frac = std::min(1.0, std::max(0.0, (v0 * tau + 0.5 * acc * tau * tau) / h));
+
+			Setpoint sp;
+			sp.tSec = tk;
+			for (int j = 1; j <= ArmKinematics::kJointCount; j++)
+			{
+				sp.q.q[j] = Lerp(q[j][i], q[j][i + 1], frac);
+			}
+			out.setpoints.push_back(sp);
+			segOf.push_back(i);
+		}
+	};
+
+	// 6) 离散模型（采样点间关节线性插值 + 中心差分的 q''）与设定点流并不完全一致：舵机实际执行的加速度是
+	//    设定点的二阶差分。超限处把覆盖该设定点窗口的采样点的 u 上界按超出比例压低，重新参数化，直到不超限
+	const double amaxSp[ArmKinematics::kJointCount + 1] = { 0.0, amax[1] * kAccSlack, amax[2] * kAccSlack,
+	                                                        amax[3] * kAccSlack, amax[4] * kAccSlack, 0.0 };
+	for (int pass = 0;; pass++)
+	{
+		parameterize();
+		resample();
+		if (pass == kMaxAccPasses) break;
+
+		bool over = false;
+		const auto& sp = out.setpoints;
+		for (size_t k = 1; k + 1 < sp.size(); k++)
+		{
+			const double h = sp[k].tSec - sp[k - 1].tSec;
+			const double h2 = sp[k + 1].tSec - sp[k].tSec;
+			if (h <= 1e-9 || std::fabs(h2 - h) > 1e-9) continue; // 末点截到结束时刻，不是整周期
+			double ratio = 0.0;
+			for (int j = 1; j <= kTopJoint; j++)
+			{
+				const double a = std::fabs(sp[k + 1].q.q[j] - 2.0 * sp[k].q.q[j] + sp[k - 1].q.q[j]) / (h * h);
+				ratio = std::max(ratio, a / amaxSp[j]);
+			}
+			if (ratio <= 1.0) continue;
+			over = true;
+			// u ∝ ṡ²，加速度约与 u 成正比；多压 5% 以免在边界上反复
+			const double scale = 1.0 / (1.05 * ratio);
+			for (size_t i = segOf[k - 1]; i <= segOf[k + 1] + 1 && i < N; i++) uMax[i] = std::min(uMax[i], u[i] * scale);
+		}
+		if (!over) break;
+	}
+
+	for (size_t k = 0; k < out.setpoints.size(); k++)
+	{
+		Setpoint& sp = out.setpoints[k];
+		if (ArmKinematics::JointAnglesToServoPos(calib, sp.q, sp.pos) != ArmKinematics::IkError::None)
+		{
+			return fail(PlanError::ServoMapping, path[segOf[k] + 1].seg);
+		}
+	}
+
+	out.ok = true;
+	return true;
+}
+
+const wchar_t* CartesianPlanner::ErrorText(PlanError e)
+{
+	switch (e)
+	{
+	case PlanError::None: return L"";
+	case PlanError::TooFewWaypoints: return L"路点不足（至少 2 个不重合的路点）。";
+	case PlanError::Unreachable: return L"直线路径经过不可达区域。";
+	case PlanError::OutOfLimits: return L"直线路径超出关节软限位。";
+	case PlanError::BranchFlip: return L"直线路径穿过奇异点（关节跳变过大）。";
+	case PlanError::Collision: return L"直线路径会发生碰撞。";
+	case PlanError::ServoMapping: return L"关节角无法换算为舵机位置（检查 ServoId/标定）。";
+	default: return L"轨迹规划失败。";
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ArmKinematics.h"
+#include "CollisionModel.h"
+#include "KinematicsCalib.h"
+
+// CartesianPlanner：笛卡尔直线轨迹规划 + 时间最优路径参数化（TOPP）
+// - 用于抓取/放置的直线接近与撤离：末端沿直线运动，而不是舵机控制板关节插值出的弧线。
+//
+// 流程：
+// 1) 路径：相邻路点（x,y,z,pitch）之间直线插值，按 sampleStepMm / sampleStepPitchDeg 密采样；
+// 2) 逐点 IK（以上一点为种子，保持同一肘构型），关节变化过大的区间自适应加密；
+//    检查可达、软限位、相邻点关节跳变（奇异/换分支）与碰撞（可选）；
+// 3) TOPP：在路径参数 s 上对 u = ṡ² 做离散化的“前向加速 + 反向减速”两遍扫描
+//    （关节速度约束 |q'ṡ| ≤ vmax，加速度约束 |q'·s̈ + q''·ṡ²| ≤ amax，在每个采样区间两端都满足），
+//    得到每段最短用时，起止速度为 0；
+// 4) 按固定周期重采样为舵机设定点流（关节角 + 舵机位置），交给 MotionController::StartStream 播放；
+//    设定点二阶差分仍超加速度上限处局部压低速度后重新参数化。
+//
+// 路点拐角处 q'(s) 不连续，TOPP 会自然在拐角减速到接近 0（直线段之间不做圆角过渡）。
+class CartesianPlanner
+{
+public:
+	struct Params
+	{
+		// 路径采样间距
+		double sampleStepMm = 2.0;
+		double sampleStepPitchDeg = 1.0;
+		// 相邻采样点任一关节变化超过该值时二分加密（奇异点附近）；
+		// 加密到极短区间仍超过，视为 q(s) 不连续（换肘解/穿过奇异点），报 BranchFlip
+		double maxSampleJointDeg = 1.0;
+
+		// 路径参数 s 的度量：ds² = dp² + (pitchWeightMm·dpitch[rad])²
+		double pitchWeightMm = 100.0;
+
+		// 关节速度/加速度上限（deg/s, deg/s²），下标 1..5
+		std::array<double, ArmKinematics::kJointCount + 1> maxVelDegPerSec{ { 0.0, 90.0, 90.0, 90.0, 120.0, 120.0 } };
+		std::array<double, ArmKinematics::kJointCount + 1> maxAccDegPerSec2{ { 0.0, 300.0, 300.0, 300.0, 400.0, 400.0 } };
+
+		// 输出设定点周期（ms）；舵机在每个周期内自行线性插值。
+		// 不应小于串口节流 Throttle\Ms（默认 50），否则设定点会在发送队列里积压。
+		int setpointPeriodMs = 50;
+	};
+
+	enum class PlanError : uint8_t
+	{
+		None = 0,
+		TooFewWaypoints, // 少于 2 个路点（或起点与终点重合）
+		Unreachable,     // 某采样点 IK 无解
+		OutOfLimits,     // 某采样点的解超出软限位
+		BranchFlip,      // 加密后相邻采样点关节仍跳变（路径穿过奇异点/换肘解）
+		Collision,       // 某采样点与 CollisionModel 冲突
+		ServoMapping,    // 关节角无法换算为舵机位置（ServoId/标定缺失）
+	};
+
+	struct Setpoint
+	{
+		double tSec = 0.0;
+		ArmKinematics::JointAnglesRad q;
+		ArmKinematics::ServoPos pos;
+	};
+
+	struct Result
+	{
+		bool ok = false;
+		PlanError error = PlanError::None;
+		size_t failedSegment = 0;    // 出错的路段（路点 i -> i+1 中的 i）
+		size_t sampleCount = 0;      // 路径采样点数（含加密）
+		double durationSec = 0.0;    // 时间最优参数化后的总时长
+		std::vector<Setpoint> setpoints;
+	};
+
+public:
+	// waypoints：Base 坐标系路点（首点通常为当前位姿）；pQStart：当前关节角（首点 IK 择优，J5 保持该值），可为空；
+	// pCollision：可为空（不检查碰撞）。返回 out.ok。
+	static bool Plan(const KinematicsCalib& calib,
+	                 const std::vector<ArmKinematics::PoseTarget>& waypoints,
+	                 const ArmKinematics::JointAnglesRad* pQStart,
+	                 const Params& params,
+	                 Result& out,
+	                 const CollisionModel* pCollision = nullptr);
+
+	static const wchar_t* ErrorText(PlanError e);
+};
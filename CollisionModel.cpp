@@ -0,0 +1,471 @@
+#include "pch.h"
+
+#include "CollisionModel.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Profile 持久化依赖 MFC；无头工具（tools/）编译本文件时只保留检测逻辑。
+#ifdef _WIN32
+#include <afxwin.h>
+#endif
+
+namespace
+{
+	// 不相邻的连杆对（相邻连杆在关节处相交，不检查）
+	const uint8_t kSelfPairs[][2] = {
+		{ CollisionModel::kLinkBase, CollisionModel::kLinkForearm },
+		{ CollisionModel::kLinkBase, CollisionModel::kLinkWrist },
+		{ CollisionModel::kLinkBase, CollisionModel::kLinkGripper },
+		{ CollisionModel::kLinkBase, CollisionModel::kLinkCamera },
+		{ CollisionModel::kLinkUpperArm, CollisionModel::kLinkWrist },
+		{ CollisionModel::kLinkUpperArm, CollisionModel::kLinkGripper },
+		{ CollisionModel::kLinkUpperArm, CollisionModel::kLinkCamera },
+		{ CollisionModel::kLinkForearm, CollisionModel::kLinkGripper },
+		{ CollisionModel::kLinkForearm, CollisionModel::kLinkCamera },
+	};
+
+	double Dot(const double a[3], const double b[3]) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+	double Clamp01(double v) { return (v < 0.0) ? 0.0 : ((v > 1.0) ? 1.0 : v); }
+
+	// 线段 p1q1 与 p2q2 的最近距离平方（Ericson, Real-Time Collision Detection 5.1.9，含退化线段）
+	double SegSegDistSq(const double p1[3], const double q1[3], const double p2[3], const double q2[3])
+	{
+		const double kEps = 1e-12;
+		double d1[3], d2[3], r[3];
+		for (int i = 0; i < 3; i++)
+		{
+			d1[i] = q1[i] - p1[i];
+			d2[i] = q2[i] - p2[i];
+			r[i] = p1[i] - p2[i];
+		}
+		const double a = Dot(d1, d1);
+		const double e = Dot(d2, d2);
+		const double f = Dot(d2, r);
+
+		double s = 0.0;
+		double t = 0.0;
+		if (a <= kEps && e <= kEps)
+		{
+			return Dot(r, r);
+		}
+		if (a <= kEps)
+		{
+			t = Clamp01(f / e);
+		}
+		else
+		{
+			const double c = Dot(d1, r);
+			if (e <= kEps)
+			{
+				s = Clamp01(-c / a);
+			}
+			else
+			{
+				const double b = Dot(d1, d2);
+				const double denom = a * e - b * b;
+				s = (denom > kEps) ? Clamp01((b * f - c * e) / denom) : 0.0; // 平行时任取 s = 0
+				t = (b * s + f) / e;
+				if (t < 0.0)
+				{
+					t = 0.0;
+					s = Clamp01(-c / a);
+				}
+				else if (t > 1.0)
+				{
+					t = 1.0;
+					s = Clamp01((b - c) / a);
+				}
+			}
+		}
+
+		double dsq = 0.0;
+		for (int i = 0; i < 3; i++)
+		{
+			const double d = (p1[i] + d1[i] * s) - (p2[i] + d2[i] * t);
+			dsq += d * d;
+		}
+		return dsq;
+	}
+
+	double PointBoxDistSq(const double p[3], const CollisionModel::Box& box)
+	{
+		double dsq = 0.0;
+		for (int i = 0; i < 3; i++)
+		{
+			if (p[i] < box.min[i]) dsq += (box.min[i] - p[i]) * (box.min[i] - p[i]);
+			else if (p[i] > box.max[i]) dsq += (p[i] - box.max[i]) * (p[i] - box.max[i]);
+		}
+		return dsq;
+	}
+
+	// 线段到盒的距离平方：f(t) = |P(t) - box|² 关于 t 是凸函数，黄金分割搜索。
+	// 24 次迭代后 t 的区间 < 1e-5，对 ~100mm 的连杆误差 < 0.001mm。
+	double SegBoxDistSq(const double a[3], const double b[3], const CollisionModel::Box& box)
+	{
+		auto at = [&](double t)
+		{
+			double p[3];
+			for (int i = 0; i < 3; i++) p[i] = a[i] + (b[i] - a[i]) * t;
+			return PointBoxDistSq(p, box);
+		};
+
+		const double kInvPhi = 0.6180339887498949;
+		double lo = 0.0;
+		double hi = 1.0;
+		double t1 = hi - kInvPhi * (hi - lo);
+		double t2 = lo + kInvPhi * (hi - lo);
+		double f1 = at(t1);
+		double f2 = at(t2);
+		for (int it = 0; it < 24; it++)
+		{
+			if (f1 <= 0.0 || f2 <= 0.0) return 0.0;
+			if (f1 < f2)
+			{
+				hi = t2;
+				t2 = t1;
+				f2 = f1;
+				t1 = hi - kInvPhi * (hi - lo);
+				f1 = at(t1);
+			}
+			else
+			{
+				lo = t1;
+				t1 = t2;
+				f1 = f2;
+				t2 = lo + kInvPhi * (hi - lo);
+				f2 = at(t2);
+			}
+		}
+		return std::min(std::min(f1, f2), std::min(at(0.0), at(1.0)));
+	}
+
+	struct Aabb
+	{
+		double mn[3];
+		double mx[3];
+	};
+
+	Aabb CapsuleAabb(const double a[3], const double b[3], double r)
+	{
+		Aabb box;
+		for (int i = 0; i < 3; i++)
+		{
+			box.mn[i] = std::min(a[i], b[i]) - r;
+			box.mx[i] = std::max(a[i], b[i]) + r;
+		}
+		return box;
+	}
+
+	bool Overlap(const Aabb& x, const double mn[3], const double mx[3])
+	{
+		return x.mn[0] <= mx[0] && mn[0] <= x.mx[0]
+			&& x.mn[1] <= mx[1] && mn[1] <= x.mx[1]
+			&& x.mn[2] <= mx[2] && mn[2] <= x.mx[2];
+	}
+
+	// 批量检测的分块大小：关节点在栈上（6 点 × 3 分量 × 64 × 8 字节 ≈ 9KB）
+	constexpr size_t kBatchChunk = 64;
+}
+
+void CollisionModel::BuildCapsules(const KinematicsCalib& calib,
+                                   const double sh[3], const double el[3], const double wr[3],
+                                   const double fl[3], const double cam[3],
+                                   Capsules& out) const
+{
+	const double wristLen = calib.Links().L_wrist;
+	const double g = (wristLen > 1e-9) ? (m_params.gripperLengthMm / wristLen) : 0.0;
+	for (int i = 0; i < 3; i++)
+	{
+		out.a[kLinkBase][i] = (i == 2) ? 0.0 : sh[i];
+		out.b[kLinkBase][i] = sh[i];
+		out.a[kLinkUpperArm][i] = sh[i];
+		out.b[kLinkUpperArm][i] = el[i];
+		out.a[kLinkForearm][i] = el[i];
+		out.b[kLinkForearm][i] = wr[i];
+		out.a[kLinkWrist][i] = wr[i];
+		out.b[kLinkWrist][i] = fl[i];
+		// 爪子沿腕部连杆方向伸出（J5 滚转不改变该方向）
+		out.a[kLinkGripper][i] = fl[i];
+		out.b[kLinkGripper][i] = fl[i] + (fl[i] - wr[i]) * g;
+		out.a[kLinkCamera][i] = fl[i];
+		out.b[kLinkCamera][i] = cam[i];
+	}
+}
+
+bool CollisionModel::CheckCapsules(const Capsules& c, Result* pOut) const
+{
+	const Params& P = m_params;
+	auto report = [&](Hit hit, int a, int other)
+	{
+		if (pOut)
+		{
+			pOut->hit = hit;
+			pOut->linkA = static_cast<uint8_t>(a);
+			pOut->other = static_cast<uint8_t>(other);
+		}
+		return false;
+	};
+
+	// 1) 桌面：底座立柱本来就立在桌面上，不参与
+	if (P.tableEnabled)
+	{
+		const double floorZ = P.tableZMm + P.marginMm;
+		for (int k = kLinkUpperArm; k < kLinkCount; k++)
+		{
+			if (std::min(c.a[k][2], c.b[k][2]) - P.radiusMm[k] < floorZ)
+			{
+				return report(Hit::Table, k, 0);
+			}
+		}
+	}
+
+	Aabb boxes[kLinkCount];
+	for (int k = 0; k < kLinkCount; k++)
+	{
+		boxes[k] = CapsuleAabb(c.a[k], c.b[k], P.radiusMm[k] + P.marginMm);
+	}
+
+	// 2) 自碰撞：AABB 粗检测后算线段距离
+	for (const auto& pair : kSelfPairs)
+	{
+		const int i = pair[0];
+		const int j = pair[1];
+		if (!Overlap(boxes[i], boxes[j].mn, boxes[j].mx)) continue;
+		const double rr = P.radiusMm[i] + P.radiusMm[j] + P.marginMm;
+		if (SegSegDistSq(c.a[i], c.b[i], c.a[j], c.b[j]) < rr * rr)
+		{
+			return report(Hit::Self, i, j);
+		}
+	}
+
+	// 3) 障碍盒：先与整臂 AABB 比较，再逐连杆
+	if (!P.obstacles.empty())
+	{
+		Aabb arm = boxes[0];
+		for (int k = 1; k < kLinkCount; k++)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				arm.mn[i] = std::min(arm.mn[i], boxes[k].mn[i]);
+				arm.mx[i] = std::max(arm.mx[i], boxes[k].mx[i]);
+			}
+		}
+		for (size_t o = 0; o < P.obstacles.size(); o++)
+		{
+			const Box& ob = P.obstacles[o];
+			if (!Overlap(arm, ob.min, ob.max)) continue;
+			for (int k = 0; k < kLinkCount; k++)
+			{
+				if (!Overlap(boxes[k], ob.min, ob.max)) continue;
+				const double rr = P.radiusMm[k] + P.marginMm;
+				if (SegBoxDistSq(c.a[k], c.b[k], ob) < rr * rr)
+				{
+					return report(Hit::Obstacle, k, static_cast<int>(std::min<size_t>(o, 255)));
+				}
+			}
+		}
+	}
+
+	if (pOut) *pOut = Result();
+	return true;
+}
+
+bool CollisionModel::Check(const KinematicsCalib& calib, const ArmKinematics::JointAnglesRad& q, Result* pOut) const
+{
+	if (!m_params.enabled)
+	{
+		if (pOut) *pOut = Result();
+		return true;
+	}
+
+	using F = ArmKinematics::LinkFrames;
+	F frames;
+	ArmKinematics::ForwardKinematicsFrames(calib, q, frames);
+
+	Capsules c;
+	BuildCapsules(calib, frames.f[F::kShoulder].p, frames.f[F::kElbow].p, frames.f[F::kWrist].p,
+	              frames.f[F::kFlange].p, frames.f[F::kCamera].p, c);
+	return CheckCapsules(c, pOut);
+}
+
+size_t CollisionModel::CheckBatch(const KinematicsCalib& calib,
+                                  const ArmKinematicsBatch::JointsSoAConst& in,
+                                  size_t count,
+                                  uint8_t* outHit,
+                                  size_t* pFirstHit) const
+{
+	if (pFirstHit) *pFirstHit = count;
+	if (!m_params.enabled || count == 0)
+	{
+		if (outHit) std::fill(outHit, outHit + count, static_cast<uint8_t>(Hit::None));
+		return 0;
+	}
+
+	using F = ArmKinematics::LinkFrames;
+	static const int kPts[5] = { F::kShoulder, F::kElbow, F::kWrist, F::kFlange, F::kCamera };
+	double pts[5][3][kBatchChunk];
+	ArmKinematicsBatch::LinkPointsSoA soa;
+	for (int k = 0; k < 5; k++)
+	{
+		soa.x[kPts[k]] = pts[k][0];
+		soa.y[kPts[k]] = pts[k][1];
+		soa.z[kPts[k]] = pts[k][2];
+	}
+
+	size_t hits = 0;
+	for (size_t base = 0; base < count; base += kBatchChunk)
+	{
+		const size_t n = std::min(kBatchChunk, count - base);
+		ArmKinematicsBatch::JointsSoAConst chunk;
+		for (int j = 1; j <= ArmKinematics::kJointCount; j++)
+		{
+			chunk.q[j] = in.q[j] ? in.q[j] + base : nullptr;
+		}
+		ArmKinematicsBatch::ForwardKinematics(calib, chunk, n, ArmKinematicsBatch::PoseSoAOut(), &soa);
+
+		for (size_t i = 0; i < n; i++)
+		{
+			double p[5][3];
+			for (int k = 0; k < 5; k++)
+			{
+				p[k][0] = pts[k][0][i];
+				p[k][1] = pts[k][1][i];
+				p[k][2] = pts[k][2][i];
+			}
+			Capsules c;
+			BuildCapsules(calib, p[0], p[1], p[2], p[3], p[4], c);
+			Result r;
+			const bool free = CheckCapsules(c, &r);
+			if (outHit) outHit[base + i] = static_cast<uint8_t>(r.hit);
+			if (!free)
+			{
+				if (hits == 0 && pFirstHit) *pFirstHit = base + i;
+				hits++;
+			}
+		}
+	}
+	return hits;
+}
+
+const wchar_t* CollisionModel::LinkName(int link)
+{
+	switch (link)
+	{
+	case kLinkBase: return L"底座";
+	case kLinkUpperArm: return L"大臂";
+	case kLinkForearm: return L"小臂";
+	case kLinkWrist: return L"腕部";
+	case kLinkGripper: return L"爪子";
+	case kLinkCamera: return L"相机";
+	default: return L"?";
+	}
+}
+
+std::wstring CollisionModel::ResultText(const Result& r)
+{
+	std::wstring s;
+	switch (r.hit)
+	{
+	case Hit::Table:
+		s = L"碰撞：";
+		s += LinkName(r.linkA);
+		s += L"-桌面";
+		break;
+	case Hit::Self:
+		s = L"碰撞：";
+		s += LinkName(r.linkA);
+		s += L"-";
+		s += LinkName(r.other);
+		break;
+	case Hit::Obstacle:
+		s = L"碰撞：";
+		s += LinkName(r.linkA);
+		s += L"-障碍物#" + std::to_wstring(static_cast<int>(r.other) + 1);
+		break;
+	default:
+		break;
+	}
+	return s;
+}
+
+#ifdef _WIN32
+namespace
+{
+	const wchar_t* const kRadiusKeys[CollisionModel::kLinkCount] = {
+		L"RadiusBase_mm", L"RadiusUpperArm_mm", L"RadiusForearm_mm",
+		L"RadiusWrist_mm", L"RadiusGripper_mm", L"RadiusCamera_mm",
+	};
+	const wchar_t* const kBoxKeys[6] = { L"MinX_mm", L"MinY_mm", L"MinZ_mm", L"MaxX_mm", L"MaxY_mm", L"MaxZ_mm" };
+
+	std::wstring BoxSection(int i)
+	{
+		CString s;
+		s.Format(L"Collision\\Box%d", i);
+		return std::wstring(s.GetString());
+	}
+}
+
+CollisionModel::Params CollisionModel::LoadProfile()
+{
+	// 尺寸以整数 mm 保存（与 Kinematics\Links 一致）
+	Params p;
+	CWinApp* app = AfxGetApp();
+	const wchar_t* sec = L"Collision";
+	p.enabled = app->GetProfileInt(sec, L"Enabled", p.enabled ? 1 : 0) != 0;
+	p.tableEnabled = app->GetProfileInt(sec, L"TableEnabled", p.tableEnabled ? 1 : 0) != 0;
+	p.tableZMm = static_cast<double>(app->GetProfileInt(sec, L"TableZ_mm", static_cast<int>(p.tableZMm)));
+	p.marginMm = static_cast<double>(app->GetProfileInt(sec, L"Margin_mm", static_cast<int>(p.marginMm)));
+	p.gripperLengthMm = static_cast<double>(app->GetProfileInt(sec, L"GripperLength_mm", static_cast<int>(p.gripperLengthMm)));
+	for (int k = 0; k < kLinkCount; k++)
+	{
+		p.radiusMm[k] = static_cast<double>(app->GetProfileInt(sec, kRadiusKeys[k], static_cast<int>(p.radiusMm[k])));
+	}
+
+	const int boxCount = std::min(std::max(app->GetProfileInt(sec, L"BoxCount", 0), 0), kMaxProfileBoxes);
+	for (int i = 1; i <= boxCount; i++)
+	{
+		const std::wstring bs = BoxSection(i);
+		Box b;
+		for (int a = 0; a < 3; a++)
+		{
+			b.min[a] = static_cast<double>(app->GetProfileInt(bs.c_str(), kBoxKeys[a], 0));
+			b.max[a] = static_cast<double>(app->GetProfileInt(bs.c_str(), kBoxKeys[a + 3], 0));
+		}
+		// 空盒（未填写或 min > max）忽略
+		if (b.min[0] < b.max[0] && b.min[1] < b.max[1] && b.min[2] < b.max[2])
+		{
+			p.obstacles.push_back(b);
+		}
+	}
+	return p;
+}
+
+void CollisionModel::SaveProfile(const Params& p)
+{
+	CWinApp* app = AfxGetApp();
+	const wchar_t* sec = L"Collision";
+	app->WriteProfileInt(sec, L"Enabled", p.enabled ? 1 : 0);
+	app->WriteProfileInt(sec, L"TableEnabled", p.tableEnabled ? 1 : 0);
+	app->WriteProfileInt(sec, L"TableZ_mm", static_cast<int>(p.tableZMm));
+	app->WriteProfileInt(sec, L"Margin_mm", static_cast<int>(p.marginMm));
+	app->WriteProfileInt(sec, L"GripperLength_mm", static_cast<int>(p.gripperLengthMm));
+	for (int k = 0; k < kLinkCount; k++)
+	{
+		app->WriteProfileInt(sec, kRadiusKeys[k], static_cast<int>(p.radiusMm[k]));
+	}
+
+	const int boxCount = static_cast<int>(std::min<size_t>(p.obstacles.size(), kMaxProfileBoxes));
+	app->WriteProfileInt(sec, L"BoxCount", boxCount);
+	for (int i = 1; i <= boxCount; i++)
+	{
+		const std::wstring bs = BoxSection(i);
+		const Box& b = p.obstacles[i - 1];
+		for (int a = 0; a < 3; a++)
+		{
+			app->WriteProfileInt(bs.c_str(), kBoxKeys[a], static_cast<int>(b.min[a]));
+			app->WriteProfileInt(bs.c_str(), kBoxKeys[a + 3], static_cast<int>(b.max[a]));
+		}
+	}
+}
+#endif
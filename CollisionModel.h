@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ArmKinematics.h"
+#include "ArmKinematicsBatch.h"
+#include "KinematicsCalib.h"
+
+// CollisionModel：胶囊体自碰撞 + 桌面 + 静态障碍盒检测（Base 坐标系，mm）
+// - 每个连杆是一个胶囊体（线段 + 半径），线段端点取自 ArmKinematics::ForwardKinematicsFrames 的关节原点；
+// - 下发前检查，开销按 Jog 每 tick、插值轨迹每个采样点调用设计。
+//
+// 检测内容：
+// - 自碰撞：只检查不相邻的连杆对（相邻连杆在关节处本来就相交）；
+// - 桌面：z = tableZMm 的水平面，底座以外的连杆最低点（端点 z - 半径）不得低于桌面；
+// - 障碍盒：Base 坐标系下的轴对齐盒（AABB）。
+// 粗检测（broad-phase）：每个胶囊体先求 AABB，AABB 不相交的连杆对/障碍直接跳过，只有重叠时才算线段距离。
+//
+// 连杆尺寸：长度来自 KinematicsConfig::LinkLengthsMm（随标定变化），半径与爪长在 Params 中配置。
+class CollisionModel
+{
+public:
+	enum Link : uint8_t
+	{
+		kLinkBase = 0, // 底座立柱：地面 -> J2
+		kLinkUpperArm, // J2 -> J3
+		kLinkForearm,  // J3 -> J4
+		kLinkWrist,    // J4 -> J5
+		kLinkGripper,  // J5 -> 爪尖（沿连杆方向伸出 gripperLengthMm）
+		kLinkCamera,   // J5 -> 相机（法兰顶面上方 L_cam）
+		kLinkCount
+	};
+
+	// Base 坐标系下的轴对齐障碍盒
+	struct Box
+	{
+		double min[3] = {};
+		double max[3] = {};
+	};
+
+	struct Params
+	{
+		bool enabled = true;
+
+		double radiusMm[kLinkCount] = { 35.0, 20.0, 18.0, 16.0, 18.0, 15.0 };
+		double gripperLengthMm = 60.0;
+
+		bool tableEnabled = true;
+		double tableZMm = 0.0;  // 桌面高度（Base 原点在地面/底板上，默认 0）
+
+		double marginMm = 3.0;  // 安全余量：距离小于 半径和 + margin 即判碰撞
+
+		std::vector<Box> obstacles;
+	};
+
+	enum class Hit : uint8_t
+	{
+		None = 0,
+		Table,
+		Self,
+		Obstacle,
+	};
+
+	struct Result
+	{
+		Hit hit = Hit::None;
+		uint8_t linkA = 0; // 发生碰撞的连杆（Link）
+		uint8_t other = 0; // Self：另一连杆；Obstacle：障碍盒下标
+	};
+
+public:
+	CollisionModel() = default;
+	explicit CollisionModel(const Params& params) : m_params(params) {}
+
+	const Params& GetParams() const { return m_params; }
+
+	// 单个关节角（J5 影响相机与爪子朝向）；返回 true 表示无碰撞，pOut 可为空
+	bool Check(const KinematicsCalib& calib, const ArmKinematics::JointAnglesRad& q, Result* pOut = nullptr) const;
+
+	// 批量：内部分块调用 ArmKinematicsBatch::ForwardKinematics（SIMD）求关节点，再逐样本检测。
+	// outHit 可为空（每样本一个 Hit 字节）；pFirstHit 非空时写入首个碰撞样本下标（无碰撞写 count）。
+	// 返回碰撞样本数。
+	size_t CheckBatch(const KinematicsCalib& calib,
+	                  const ArmKinematicsBatch::JointsSoAConst& in,
+	                  size_t count,
+	                  uint8_t* outHit,
+	                  size_t* pFirstHit = nullptr) const;
+
+	// UI 文本，例如“碰撞：爪子-桌面”
+	static std::wstring ResultText(const Result& r);
+	static const wchar_t* LinkName(int link);
+
+#ifdef _WIN32
+	// Profile（注册表）持久化：Collision 与 Collision\BoxN
+	static Params LoadProfile();
+	static void SaveProfile(const Params& params);
+#endif
+
+	static constexpr int kMaxProfileBoxes = 8;
+
+private:
+	// 胶囊端点：每个连杆 a/b 两点
+	struct Capsules
+	{
+		double a[kLinkCount][3];
+		double b[kLinkCount][3];
+	};
+
+	// 关节点（Base 坐标系）：J2, J3, J4, J5, 相机
+	void BuildCapsules(const KinematicsCalib& calib,
+	                   const double sh[3], const double el[3], const double wr[3],
+	                   const double fl[3], const double cam[3],
+	                   Capsules& out) const;
+	bool CheckCapsules(const Capsules& c, Result* pOut) const;
+
+private:
+	Params m_params;
+};
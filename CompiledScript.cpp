@@ -0,0 +1,117 @@
+#include "pch.h"
+
+#include "CompiledScript.h"
+
+#include <algorithm>
+
+namespace
+{
+	class Fnv64
+	{
+	public:
+		void Add(int v)
+		{
+			const uint32_t u = static_cast<uint32_t>(v);
+			for (int i = 0; i < 4; i++)
+			{
+				m_h ^= static_cast<uint8_t>(u >> (8 * i));
+				m_h *= 1099511628211ULL;
+			}
+		}
+		uint64_t Value() const { return m_h; }
+
+	private:
+		uint64_t m_h = 14695981039346656037ULL;
+	};
+}
+
+uint64_t CompiledScript::ConfigFingerprint(const MotionConfig& cfg)
+{
+	Fnv64 h;
+	for (int joint = 1; joint <= MotionConfig::kJointCount; joint++)
+	{
+		const auto& jc = cfg.Get(joint);
+		h.Add(jc.servoId);
+		h.Add(jc.minPos);
+		h.Add(jc.maxPos);
+	}
+	return h.Value();
+}
+
+size_t CompiledScript::BuildServoTargets(const MotionConfig& cfg, const JointPosArray& jointPos,
+                                         ArmProtocol::ServoTarget (&out)[MotionConfig::kJointCount], size_t* pClamped)
+{
+	size_t n = 0;
+	for (int joint = 1; joint <= MotionConfig::kJointCount; joint++)
+	{
+		const int rawPos = jointPos[joint];
+		if (rawPos < 0) continue;
+
+		const auto& jc = cfg.Get(joint);
+		if (jc.servoId < 1 || jc.servoId > 6) continue;
+
+		const int lo = std::min(jc.minPos, jc.maxPos);
+		const int hi = std::max(jc.minPos, jc.maxPos);
+		const int safePos = std::max(lo, std::min(rawPos, hi));
+		if (pClamped && safePos != rawPos) (*pClamped)++;
+
+		ArmProtocol::ServoTarget st;
+		st.id = static_cast<uint8_t>(jc.servoId);
+		st.position = static_cast<uint16_t>(safePos);
+		out[n++] = st;
+	}
+	return n;
+}
+
+std::shared_ptr<const CompiledScript> CompiledScript::Compile(const MotionConfig& cfg, const std::vector<Keyframe>& frames,
+                                                              size_t loopStart)
+{
+	std::shared_ptr<CompiledScript> script(new CompiledScript());
+	script->m_configFingerprint = ConfigFingerprint(cfg);
+	script->m_loopStart = (loopStart < frames.size()) ? loopStart : 0;
+	script->m_frames.resize(frames.size());
+	// Upper bound (every joint set in every frame), so the arena is allocated once.
+	std::vector<uint8_t> scratch;
+	ArmProtocol::ServoTarget all[MotionConfig::kJointCount];
+	for (size_t i = 0; i < MotionConfig::kJointCount; i++) all[i] = ArmProtocol::ServoTarget{ 1, 0 };
+	ArmProtocol::PackMoveInto(all, MotionConfig::kJointCount, 0, scratch);
+	script->m_arena.reserve(scratch.size() * frames.size());
+
+	Report& rep = script->m_report;
+	rep.frames = frames.size();
+	uint64_t t = 0;
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		const Keyframe& kf = frames[i];
+		FrameRef& f = script->m_frames[i];
+
+		int durationMs = kf.durationMs;
+		if (durationMs < 0)
+		{
+			durationMs = 0;
+			rep.clampedDurations++;
+		}
+		else if (durationMs > kMaxMoveTimeMs)
+		{
+			rep.clampedDurations++; // the deadline keeps the full duration, the servo move is capped
+		}
+		f.durationMs = static_cast<uint32_t>(durationMs);
+		f.startMs = t;
+		t += f.durationMs;
+
+		ArmProtocol::ServoTarget servos[MotionConfig::kJointCount];
+		const size_t n = BuildServoTargets(cfg, kf.jointPos, servos, &rep.clampedTargets);
+		f.offset = static_cast<uint32_t>(script->m_arena.size());
+		if (n == 0)
+		{
+			rep.emptyFrames++;
+			continue;
+		}
+		ArmProtocol::PackMoveInto(servos, n, static_cast<uint16_t>(std::min(durationMs, kMaxMoveTimeMs)), scratch);
+		script->m_arena.insert(script->m_arena.end(), scratch.begin(), scratch.end());
+		f.size = static_cast<uint32_t>(scratch.size());
+	}
+	script->m_totalMs = t;
+	rep.arenaBytes = script->m_arena.size();
+	return script;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ArmProtocol.h"
+#include "MotionConfig.h"
+
+// A keyframe script compiled once for playback.
+// - Every keyframe is validated against MotionConfig (joints without a servo dropped, targets clamped to the
+//   soft limits) and packed as a Move frame into one contiguous byte arena; FrameRef holds its offset/size and
+//   its deadline relative to the start of playback.
+// - Immutable after Compile and shared as shared_ptr<const> between MotionController (legacy Tick path) and the
+//   MotionScheduler thread: playback only copies bytes out by pointer, no clamping, packing or allocation per frame,
+//   however long the script runs or loops.
+// - Compiled against a fingerprint of the config fields that end up in the frames (servo ids, soft limits);
+//   IsStale() tells the owner when the joint configuration changed and the script must be compiled again.
+class CompiledScript
+{
+public:
+	// Joint positions (1..6, index 0 unused). -1 = not set (joint not moved by this keyframe).
+	using JointPosArray = std::array<int, MotionConfig::kJointCount + 1>;
+
+	struct Keyframe
+	{
+		int durationMs = 800;
+		JointPosArray jointPos{};
+	};
+
+	struct FrameRef
+	{
+		uint32_t offset = 0;     // into the arena
+		uint32_t size = 0;       // 0 = no joint maps to a servo: a pause, nothing is sent
+		uint32_t durationMs = 0; // until the next frame's deadline
+		uint64_t startMs = 0;    // deadline relative to the start of playback
+	};
+
+	// What validation did to the source keyframes (for the script log).
+	struct Report
+	{
+		size_t frames = 0;
+		size_t emptyFrames = 0;       // no mapped joint set
+		size_t clampedTargets = 0;    // joint targets moved onto a soft limit
+		size_t clampedDurations = 0;  // negative (played as 0), or Move time capped at kMaxMoveTimeMs
+		size_t arenaBytes = 0;
+	};
+
+	static constexpr int kMaxMoveTimeMs = 60000;
+
+public:
+	// loopStart outside the frame list falls back to 0.
+	static std::shared_ptr<const CompiledScript> Compile(const MotionConfig& cfg, const std::vector<Keyframe>& frames,
+	                                                     size_t loopStart);
+
+	// Joint targets -> servo targets (clamped to the soft limits); returns the number written to out.
+	// pClamped (optional) is incremented for every target that had to be clamped.
+	static size_t BuildServoTargets(const MotionConfig& cfg, const JointPosArray& jointPos,
+	                                ArmProtocol::ServoTarget (&out)[MotionConfig::kJointCount], size_t* pClamped = nullptr);
+
+	// FNV-1a over servo ids and soft limits of all joints.
+	static uint64_t ConfigFingerprint(const MotionConfig& cfg);
+
+	bool IsStale(const MotionConfig& cfg) const { return ConfigFingerprint(cfg) != m_configFingerprint; }
+
+	size_t FrameCount() const { return m_frames.size(); }
+	const FrameRef& Frame(size_t index) const { return m_frames[index]; }
+	const uint8_t* Bytes(const FrameRef& f) const { return m_arena.data() + f.offset; }
+
+	size_t LoopStart() const { return m_loopStart; }
+	uint64_t TotalMs() const { return m_totalMs; }
+	// Wrap period when looping: TotalMs minus the start of the loopStart frame.
+	uint64_t LoopMs() const { return m_totalMs - (m_frames.empty() ? 0 : m_frames[m_loopStart].startMs); }
+
+	const Report& GetReport() const { return m_report; }
+
+private:
+	CompiledScript() = default;
+
+private:
+	std::vector<uint8_t> m_arena;
+	std::vector<FrameRef> m_frames;
+	size_t m_loopStart = 0;
+	uint64_t m_totalMs = 0;
+	uint64_t m_configFingerprint = 0;
+	Report m_report;
+};
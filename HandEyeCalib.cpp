@@ -0,0 +1,346 @@
+#include "pch.h"
+
+#include "HandEyeCalib.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	constexpr double kPi = 3.14159265358979323846;
+
+	using Frame = ArmKinematics::Frame;
+
+	struct Mat3
+	{
+		double m[3][3] = {};
+	};
+
+	Mat3 Mul(const double A[3][3], const double B[3][3])
+	{
+		Mat3 r;
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				r.m[i][j] = A[i][0] * B[0][j] + A[i][1] * B[1][j] + A[i][2] * B[2][j];
+			}
+		}
+		return r;
+	}
+
+	Mat3 Transpose(const double A[3][3])
+	{
+		Mat3 r;
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++) r.m[i][j] = A[j][i];
+		}
+		return r;
+	}
+
+	// a * b
+	Frame Compose(const Frame& a, const Frame& b)
+	{
+		Frame r;
+		const Mat3 R = Mul(a.R, b.R);
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++) r.R[i][j] = R.m[i][j];
+			r.p[i] = a.p[i] + a.R[i][0] * b.p[0] + a.R[i][1] * b.p[1] + a.R[i][2] * b.p[2];
+		}
+		return r;
+	}
+
+	Frame Inverse(const Frame& a)
+	{
+		Frame r;
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++) r.R[i][j] = a.R[j][i];
+		}
+		for (int i = 0; i < 3; i++)
+		{
+			r.p[i] = -(r.R[i][0] * a.p[0] + r.R[i][1] * a.p[1] + r.R[i][2] * a.p[2]);
+		}
+		return r;
+	}
+
+	// 旋转矩阵 -> 旋转向量（轴 * 角）。角接近 π 时 sin 很小，改由对称部分求轴。
+	void LogRotation(const double R[3][3], double w[3])
+	{
+		const double c = std::min(1.0, std::max(-1.0, 0.5 * (R[0][0] + R[1][1] + R[2][2] - 1.0)));
+		const double th = std::acos(c);
+		const double v[3] = { R[2][1] - R[1][2], R[0][2] - R[2][0], R[1][0] - R[0][1] };
+		if (th < 1e-9)
+		{
+			w[0] = 0.5 * v[0];
+			w[1] = 0.5 * v[1];
+			w[2] = 0.5 * v[2];
+			return;
+		}
+		if (th < kPi - 1e-3)
+		{
+			const double k = th / (2.0 * std::sin(th));
+			w[0] = k * v[0];
+			w[1] = k * v[1];
+			w[2] = k * v[2];
+			return;
+		}
+		// R ≈ 2 n nᵀ - I：取对角最大的一列求 n，符号由反对称部分决定
+		int a = 0;
+		if (R[1][1] > R[a][a]) a = 1;
+		if (R[2][2] > R[a][a]) a = 2;
+		double n[3];
+		const double na = std::sqrt(std::max(0.0, 0.5 * (R[a][a] + 1.0)));
+		for (int i = 0; i < 3; i++) n[i] = (i == a) ? na : (R[i][a] + R[a][i]) / (4.0 * na);
+		if (n[0] * v[0] + n[1] * v[1] + n[2] * v[2] < 0.0)
+		{
+			for (double& x : n) x = -x;
+		}
+		for (int i = 0; i < 3; i++) w[i] = th * n[i];
+	}
+
+	// 3x3 对称阵特征分解（循环 Jacobi）：A = V diag(d) Vᵀ
+	void SymEigen3(double A[3][3], double d[3], double V[3][3])
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++) V[i][j] = (i == j) ? 1.0 : 0.0;
+		}
+		for (int sweep = 0; sweep < 50; sweep++)
+		{
+			const double off = A[0][1] * A[0][1] + A[0][2] * A[0][2] + A[1][2] * A[1][2];
+			if (off < 1e-30) break;
+			for (int p = 0; p < 2; p++)
+			{
+				for (int q = p + 1; q < 3; q++)
+				{
+					if (std::fabs(A[p][q]) < 1e-300) continue;
+					const double theta = 0.5 * (A[q][q] - A[p][p]) / A[p][q];
+					const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+					const double c = 1.0 / std::sqrt(t * t + 1.0);
+					const double s = t * c;
+					for (int k = 0; k < 3; k++)
+					{
+						const double akp = A[k][p], akq = A[k][q];
+						A[k][p] = c * akp - s * akq;
+						A[k][q] = s * akp + c * akq;
+					}
+					for (int k = 0; k < 3; k++)
+					{
+						const double apk = A[p][k], aqk = A[q][k];
+						A[p][k] = c * apk - s * aqk;
+						A[q][k] = s * apk + c * aqk;
+					}
+					for (int k = 0; k < 3; k++)
+					{
+						const double vkp = V[k][p], vkq = V[k][q];
+						V[k][p] = c * vkp - s * vkq;
+						V[k][q] = s * vkp + c * vkq;
+					}
+				}
+			}
+		}
+		for (int i = 0; i < 3; i++) d[i] = A[i][i];
+	}
+
+	// (MᵀM)^(-1/2) Mᵀ：M 满秩时为最接近 Mᵀ 的正交阵；最小特征值过小（转轴共面/平行）时失败
+	bool PolarOrthonormalize(const Mat3& M, Mat3& out)
+	{
+		const Mat3 Mt = Transpose(M.m);
+		Mat3 MtM = Mul(Mt.m, M.m);
+		double d[3];
+		double V[3][3];
+		SymEigen3(MtM.m, d, V);
+		const double dMax = std::max(d[0], std::max(d[1], d[2]));
+		const double dMin = std::min(d[0], std::min(d[1], d[2]));
+		if (dMax <= 0.0 || dMin <= dMax * 1e-10)
+		{
+			return false;
+		}
+		Mat3 S; // V diag(1/sqrt(d)) Vᵀ
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				double sum = 0.0;
+				for (int k = 0; k < 3; k++) sum += V[i][k] * V[j][k] / std::sqrt(d[k]);
+				S.m[i][j] = sum;
+			}
+		}
+		out = Mul(S.m, Mt.m);
+		return true;
+	}
+
+	double Det3(const double A[3][3])
+	{
+		return A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1])
+			- A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0])
+			+ A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0]);
+	}
+
+	// 3x3 线性方程（Cramer）；奇异时返回 false
+	bool Solve3(const double A[3][3], const double b[3], double x[3])
+	{
+		const double det = Det3(A);
+		const double scale = std::fabs(A[0][0]) + std::fabs(A[1][1]) + std::fabs(A[2][2]);
+		if (std::fabs(det) <= 1e-12 * scale * scale * scale || scale <= 0.0)
+		{
+			return false;
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			double T[3][3];
+			for (int i = 0; i < 3; i++)
+			{
+				for (int j = 0; j < 3; j++) T[i][j] = (j == c) ? b[i] : A[i][j];
+			}
+			x[c] = Det3(T) / det;
+		}
+		return true;
+	}
+}
+
+bool HandEyeCalib::Solve(const std::vector<Sample>& samples, const Params& params, Result& out)
+{
+	out = Result();
+	const size_t n = samples.size();
+	if (n < 3)
+	{
+		return false;
+	}
+
+	// 所有样本对（标定通常只有几十个姿态，O(n²) 可以接受，且比只用相邻对更稳）
+	struct Pair
+	{
+		Frame A, B;
+	};
+	std::vector<Pair> pairs;
+	pairs.reserve(n * (n - 1) / 2);
+	for (size_t i = 0; i < n; i++)
+	{
+		for (size_t j = i + 1; j < n; j++)
+		{
+			Pair pr;
+			pr.A = Compose(Inverse(samples[j].flange), samples[i].flange);
+			pr.B = Compose(samples[j].marker, Inverse(samples[i].marker));
+			pairs.push_back(pr);
+		}
+	}
+
+	// 1) 旋转：M = Σ β αᵀ，R_X = (MᵀM)^(-1/2) Mᵀ
+	const double minRot = params.minPairRotationDeg * kPi / 180.0;
+	const double maxRot = params.maxPairRotationDeg * kPi / 180.0;
+	Mat3 M;
+	for (const auto& pr : pairs)
+	{
+		double a[3], b[3];
+		LogRotation(pr.A.R, a);
+		LogRotation(pr.B.R, b);
+		const double th = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+		if (th < minRot || th > maxRot)
+		{
+			continue;
+		}
+		for (int r = 0; r < 3; r++)
+		{
+			for (int c = 0; c < 3; c++) M.m[r][c] += b[r] * a[c];
+		}
+		out.pairsUsed++;
+	}
+	Mat3 Rx;
+	if (out.pairsUsed < 2 || !PolarOrthonormalize(M, Rx) || Det3(Rx.m) <= 0.0)
+	{
+		return false;
+	}
+
+	// 2) 平移：Σ (R_A - I)ᵀ (R_A - I) t = Σ (R_A - I)ᵀ (R_X t_B - t_A)
+	double N[3][3] = {};
+	double g[3] = {};
+	for (const auto& pr : pairs)
+	{
+		double C[3][3];
+		double d[3];
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++) C[i][j] = pr.A.R[i][j] - (i == j ? 1.0 : 0.0);
+			d[i] = Rx.m[i][0] * pr.B.p[0] + Rx.m[i][1] * pr.B.p[1] + Rx.m[i][2] * pr.B.p[2] - pr.A.p[i];
+		}
+		for (int r = 0; r < 3; r++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				N[r][c] += C[0][r] * C[0][c] + C[1][r] * C[1][c] + C[2][r] * C[2][c];
+			}
+			g[r] += C[0][r] * d[0] + C[1][r] * d[1] + C[2][r] * d[2];
+		}
+	}
+	double t[3];
+	if (!Solve3(N, g, t))
+	{
+		return false;
+	}
+
+	Frame X;
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++) X.R[i][j] = Rx.m[i][j];
+		X.p[i] = t[i];
+	}
+
+	// 3) 自洽性：每个样本反推 marker 在 Base 中的位姿，统计离散度
+	std::vector<Frame> inBase(n);
+	Mat3 Rsum;
+	for (size_t i = 0; i < n; i++)
+	{
+		inBase[i] = Compose(Compose(samples[i].flange, X), samples[i].marker);
+		for (int r = 0; r < 3; r++)
+		{
+			for (int c = 0; c < 3; c++) Rsum.m[r][c] += inBase[i].R[r][c];
+			out.markerInBase.p[r] += inBase[i].p[r] / static_cast<double>(n);
+		}
+	}
+	// 旋转均值：Σ R 的正交化（弦距离意义下的均值）
+	Mat3 RsumT = Transpose(Rsum.m);
+	Mat3 Rmean;
+	if (PolarOrthonormalize(RsumT, Rmean))
+	{
+		for (int r = 0; r < 3; r++)
+		{
+			for (int c = 0; c < 3; c++) out.markerInBase.R[r][c] = Rmean.m[r][c];
+		}
+	}
+	double sumPos = 0.0, sumRot = 0.0;
+	for (size_t i = 0; i < n; i++)
+	{
+		double d2 = 0.0;
+		for (int r = 0; r < 3; r++)
+		{
+			const double e = inBase[i].p[r] - out.markerInBase.p[r];
+			d2 += e * e;
+		}
+		sumPos += d2;
+		out.maxPosMm = std::max(out.maxPosMm, std::sqrt(d2));
+
+		const Mat3 Rt = Transpose(out.markerInBase.R);
+		const Mat3 dR = Mul(Rt.m, inBase[i].R);
+		double w[3];
+		LogRotation(dR.m, w);
+		sumRot += w[0] * w[0] + w[1] * w[1] + w[2] * w[2];
+	}
+	out.rmsPosMm = std::sqrt(sumPos / static_cast<double>(n));
+	out.rmsRotDeg = std::sqrt(sumRot / static_cast<double>(n)) * 180.0 / kPi;
+
+	out.mount.valid = true;
+	LogRotation(X.R, out.mount.rotVec);
+	for (int i = 0; i < 3; i++) out.mount.transMm[i] = X.p[i];
+	out.ok = true;
+	return true;
+}
+
+void HandEyeCalib::Apply(const Result& r, KinematicsConfig& kc)
+{
+	if (!r.ok) return;
+	kc.Camera() = r.mount;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "ArmKinematics.h"
+#include "KinematicsConfig.h"
+
+// HandEyeCalib：腕部相机手眼标定（eye-in-hand，AX = XB，Park & Martin 闭式解）
+// - 求相机在法兰上的安装外参 X：相机位姿 = FK(q) 的法兰系 * X，任何姿态下像素/相机坐标都能换到 Base。
+//
+// 标定方法：桌面固定一块 ArUco marker，机械臂换若干姿态（转台、俯仰、J5 滚转都要有变化），
+// 每个姿态记录一组（法兰位姿 = ForwardKinematicsFrames(q).f[kFlange]，marker 位姿 = estimatePoseSingleMarkers 的 R/t）。
+// marker 在 Base 中固定：F_i X M_i = F_j X M_j，于是对每对样本
+//   A = F_j⁻¹ F_i（法兰相对运动），B = M_j M_i⁻¹（相机相对运动），A X = X B。
+// 旋转：α = log(R_A)，β = log(R_B)，α = R_X β；R_X = (MᵀM)^(-1/2) Mᵀ，M = Σ β αᵀ（Park & Martin 1994）。
+// 平移：(R_A - I) t_X = R_X t_B - t_A，所有样本对堆叠后最小二乘。
+//
+// 纯 C++（无 MFC/OpenCV），无头工具可直接编译。
+class HandEyeCalib
+{
+public:
+	struct Sample
+	{
+		ArmKinematics::Frame flange;   // 法兰在 Base 中的位姿（FK，mm）
+		ArmKinematics::Frame marker;   // marker 在相机光学系中的位姿（R = marker->cam，p = marker 原点，mm）
+	};
+
+	struct Params
+	{
+		// 旋转轴估计只使用相对转角 >= 该值的样本对（转角太小时 log(R) 的轴方向被噪声主导）
+		double minPairRotationDeg = 5.0;
+
+		// 相对转角接近 180° 的样本对也不用：log(R) 在 π 处轴向正负都成立，噪声会让 A、B 取到相反的符号
+		double maxPairRotationDeg = 150.0;
+	};
+
+	struct Result
+	{
+		bool ok = false;
+		size_t pairsUsed = 0;
+
+		// 相机系 -> 法兰系（写回 KinematicsConfig::CameraMount）
+		KinematicsConfig::CameraMount mount;
+
+		// 由各样本反推的 marker 在 Base 中的位姿：均值与离散度（离散度小说明 X 与 FK、marker 位姿自洽）
+		ArmKinematics::Frame markerInBase;
+		double rmsPosMm = 0.0;
+		double maxPosMm = 0.0;
+		double rmsRotDeg = 0.0;
+	};
+
+public:
+	// 至少 3 个样本，且需要至少两个不平行的相对转轴；否则返回 false（out.ok=false）。
+	static bool Solve(const std::vector<Sample>& samples, const Params& params, Result& out);
+
+	// 写回配置（valid=true）
+	static void Apply(const Result& r, KinematicsConfig& kc);
+};
@@ -0,0 +1,215 @@
+#include "pch.h"
+
+#include "IkCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+IkCache::IkCache()
+	: IkCache(Params())
+{
+}
+
+IkCache::IkCache(const Params& params)
+	: m_params(params)
+{
+	m_params.quantMm = std::max(m_params.quantMm, 1e-6);
+	m_params.quantDeg = std::max(m_params.quantDeg, 1e-6);
+
+	// 每分片槽数取 2 的幂，按掩码定位
+	const size_t perShard = std::max<size_t>(1, (m_params.capacity + kShardCount - 1) / kShardCount);
+	size_t slots = 1;
+	while (slots < perShard) slots <<= 1;
+	m_slotMask = slots - 1;
+	m_params.capacity = slots * kShardCount;
+
+	m_shards.reset(new Shard[kShardCount]);
+	for (size_t i = 0; i < kShardCount; i++)
+	{
+		m_shards[i].slots.resize(slots);
+	}
+}
+
+uint64_t IkCache::Hash(const Key& k)
+{
+	// splitmix64 逐字段混合
+	auto mix = [](uint64_t h, uint64_t v)
+	{
+		h ^= v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+		h ^= h >> 30;
+		h *= 0xBF58476D1CE4E5B9ull;
+		h ^= h >> 27;
+		h *= 0x94D049BB133111EBull;
+		h ^= h >> 31;
+		return h;
+	};
+	uint64_t h = k.calibFp;
+	h = mix(h, static_cast<uint64_t>(k.x));
+	h = mix(h, static_cast<uint64_t>(k.y));
+	h = mix(h, static_cast<uint64_t>(k.z));
+	h = mix(h, static_cast<uint64_t>(k.pitch));
+	h = mix(h, static_cast<uint64_t>(k.roll));
+	h = mix(h, k.rollMode);
+	return h;
+}
+
+void IkCache::CheckFingerprint(uint64_t fp)
+{
+	uint64_t seen = m_calibFp.load(std::memory_order_acquire);
+	if (seen == fp) return;
+	if (m_calibFp.compare_exchange_strong(seen, fp, std::memory_order_acq_rel))
+	{
+		// 旧指纹的条目已不可能命中，清掉只是为了把槽位让给新标定
+		Invalidate();
+	}
+}
+
+void IkCache::Invalidate()
+{
+	for (size_t i = 0; i < kShardCount; i++)
+	{
+		std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+		for (auto& e : m_shards[i].slots) e.used = false;
+	}
+	m_invalidations.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool IkCache::Solve(const KinematicsCalib& calib,
+                    const ArmKinematics::PoseTarget& target,
+                    const ArmKinematics::JointAnglesRad* pQCurrent,
+                    ArmKinematics::IkResultLite& out,
+                    ArmKinematics::ServoPos* pServo,
+                    ArmKinematics::IkError* pServoErr,
+                    const ArmKinematics::IkScoring* pScoring)
+{
+	Key k;
+	k.x = std::llround(target.x_mm / m_params.quantMm);
+	k.y = std::llround(target.y_mm / m_params.quantMm);
+	k.z = std::llround(target.z_mm / m_params.quantMm);
+	k.pitch = std::llround(target.pitch_deg / m_params.quantDeg);
+	k.rollMode = static_cast<uint8_t>(target.rollMode);
+	k.roll = (target.rollMode == ArmKinematics::RollMode::Hold) ? 0 : std::llround(target.roll_deg / m_params.quantDeg);
+	k.calibFp = calib.GetArmFingerprint();
+
+	// 吸附后的 x = y = 0 即末端在 J1 轴线上（吸附前 r_xy <= quantMm·√2/2），J1 取决于种子
+	if (target.rollMode == ArmKinematics::RollMode::BaseYaw || (k.x == 0 && k.y == 0))
+	{
+		m_bypassed.fetch_add(1, std::memory_order_relaxed);
+		ArmKinematics::InverseKinematics(calib, target, pQCurrent, pScoring, out);
+		if (pServo)
+		{
+			const ArmKinematics::IkError e = out.ok ? ArmKinematics::JointAnglesToServoPos(calib, out.chosenQ, *pServo)
+			                                        : out.error;
+			if (pServoErr) *pServoErr = e;
+		}
+		return out.ok;
+	}
+
+	CheckFingerprint(k.calibFp);
+
+	const uint64_t h = Hash(k);
+	Shard& shard = m_shards[h % kShardCount];
+	const size_t slot = static_cast<size_t>(h / kShardCount) & m_slotMask;
+
+	Entry e;
+	bool hit = false;
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		const Entry& s = shard.slots[slot];
+		if (s.used && s.key == k)
+		{
+			e = s;
+			hit = true;
+		}
+	}
+
+	if (hit)
+	{
+		m_hits.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		m_misses.fetch_add(1, std::memory_order_relaxed);
+
+		// 在锁外对格点位姿求解（无种子：候选与种子无关，择优留到 Finish）
+		ArmKinematics::PoseTarget t = target;
+		t.x_mm = k.x * m_params.quantMm;
+		t.y_mm = k.y * m_params.quantMm;
+		t.z_mm = k.z * m_params.quantMm;
+		t.pitch_deg = k.pitch * m_params.quantDeg;
+		t.roll_deg = k.roll * m_params.quantDeg;
+
+		e.used = true;
+		e.key = k;
+		ArmKinematics::InverseKinematics(calib, t, nullptr, e.ik);
+		for (int i = 0; i < e.ik.candidateCount; i++)
+		{
+			e.servoErr[i] = ArmKinematics::JointAnglesToServoPos(calib, e.ik.candidates[i].q, e.servo[i]);
+		}
+
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		Entry& s = shard.slots[slot];
+		if (s.used && !(s.key == k)) m_evictions.fetch_add(1, std::memory_order_relaxed);
+		s = e;
+	}
+
+	Finish(calib, target, pQCurrent, pScoring, e, out, pServo, pServoErr);
+	return out.ok;
+}
+
+void IkCache::Finish(const KinematicsCalib& calib,
+                     const ArmKinematics::PoseTarget& target,
+                     const ArmKinematics::JointAnglesRad* pQCurrent,
+                     const ArmKinematics::IkScoring* pScoring,
+                     const Entry& e,
+                     ArmKinematics::IkResultLite& out,
+                     ArmKinematics::ServoPos* pServo,
+                     ArmKinematics::IkError* pServoErr) const
+{
+	out = e.ik;
+	if (out.candidateCount == 0)
+	{
+		// 不可达：保留求解时的失败原因
+		if (pServoErr) *pServoErr = out.error;
+		return;
+	}
+
+	const bool hold = (target.rollMode == ArmKinematics::RollMode::Hold);
+	const double q5 = pQCurrent ? pQCurrent->q[5] : 0.0;
+	if (hold)
+	{
+		for (int i = 0; i < out.candidateCount; i++) out.candidates[i].q.q[5] = q5;
+	}
+	ArmKinematics::SelectCandidate(calib, out, pQCurrent, pScoring);
+
+	if (!pServo) return;
+	*pServo = e.servo[out.chosenIndex];
+	ArmKinematics::IkError err = e.servoErr[out.chosenIndex];
+	if (hold && err == ArmKinematics::IkError::None)
+	{
+		int pos = 0;
+		if (KinematicsCalib::JointRadToPos(calib.GetJoint(5), q5, pos)) pServo->pos[5] = pos;
+		else err = ArmKinematics::IkError::CalibInvalid;
+	}
+	if (pServoErr) *pServoErr = err;
+}
+
+IkCache::Stats IkCache::GetStats() const
+{
+	Stats s;
+	s.hits = m_hits.load(std::memory_order_relaxed);
+	s.misses = m_misses.load(std::memory_order_relaxed);
+	s.bypassed = m_bypassed.load(std::memory_order_relaxed);
+	s.evictions = m_evictions.load(std::memory_order_relaxed);
+	s.invalidations = m_invalidations.load(std::memory_order_relaxed);
+	return s;
+}
+
+void IkCache::ResetStats()
+{
+	m_hits.store(0, std::memory_order_relaxed);
+	m_misses.store(0, std::memory_order_relaxed);
+	m_bypassed.store(0, std::memory_order_relaxed);
+	m_evictions.store(0, std::memory_order_relaxed);
+	m_invalidations.store(0, std::memory_order_relaxed);
+}
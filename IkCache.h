@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ArmKinematics.h"
+#include "KinematicsCalib.h"
+
+// IkCache：按量化位姿缓存闭式 IK 结果（并发安全，可选）
+// - 用于视觉跟随悬停、脚本回放等反复请求几乎相同位姿的场景；
+// - 键为量化位姿（x/y/z/pitch/roll）+ 标定指纹，命中时只剩一次查表和“按当前姿态重新择优”。
+//
+// 语义：
+// - 目标先吸附到量化格点再求解，所以命中与未命中返回完全相同的结果（与调用顺序无关），
+//   代价是结果对应格点位姿，位置误差 <= quantMm·√3/2（默认 0.05mm，远小于舵机 1 个位置单位对应的末端位移）；
+// - 缓存的是两个肘解候选（与种子无关），命中后用 ArmKinematics::SelectCandidate 按本次 pQCurrent 择优，
+//   RollMode::Hold 的 J5 取本次 pQCurrent，因此择优规则与直接调用 InverseKinematics 一致；
+// - 结果依赖种子的情况直接求解、不进缓存（计入 bypassed）：末端在 J1 轴线上（J1 取当前值），
+//   以及 RollMode::BaseYaw（对称夹爪按当前 J5 取舍 q5 / q5+π，退化方向时保持当前 J5）。
+//
+// 失效：键里含 KinematicsCalib::ArmFingerprint，连杆 / 关节标定 / MotionConfig 改变后旧条目不会再命中（手眼外参不影响 IK）；
+// 首次见到新指纹时整表清空（计入 invalidations），也可手动 Invalidate()。
+//
+// 并发：按键哈希分 16 个分片，各自一把锁；每个分片是固定大小的直接映射表（冲突即覆盖，计入 evictions），
+// 构造后不再分配内存，可在 Jog tick / 视觉线程中直接使用。
+class IkCache
+{
+public:
+	struct Params
+	{
+		double quantMm = 0.05;   // 位置量化步长
+		double quantDeg = 0.05;  // 俯仰 / 滚转量化步长
+		size_t capacity = 4096;  // 总条目数（均分到各分片，向上取 2 的幂）
+	};
+
+	struct Stats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t bypassed = 0;      // 结果依赖种子，未走缓存
+		uint64_t evictions = 0;     // 插入时覆盖了另一个键
+		uint64_t invalidations = 0; // 整表清空次数（标定指纹变化或手动）
+
+		double HitRate() const
+		{
+			const uint64_t n = hits + misses;
+			return n ? static_cast<double>(hits) / static_cast<double>(n) : 0.0;
+		}
+	};
+
+public:
+	IkCache();
+	explicit IkCache(const Params& params);
+	IkCache(const IkCache&) = delete;
+	IkCache& operator=(const IkCache&) = delete;
+
+	const Params& GetParams() const { return m_params; }
+
+	// 同 ArmKinematics::InverseKinematics（无分配版本），返回 out.ok。
+	// pServo 非空时同时给出所选解的舵机位置（*pServoErr 为换算结果，IkError::None 表示成功）。
+	// pScoring：择优评分（见 ArmKinematics::IkScoring），只影响命中后的择优，不参与键。
+	bool Solve(const KinematicsCalib& calib,
+	           const ArmKinematics::PoseTarget& target,
+	           const ArmKinematics::JointAnglesRad* pQCurrent,
+	           ArmKinematics::IkResultLite& out,
+	           ArmKinematics::ServoPos* pServo = nullptr,
+	           ArmKinematics::IkError* pServoErr = nullptr,
+	           const ArmKinematics::IkScoring* pScoring = nullptr);
+
+	void Invalidate();
+
+	Stats GetStats() const;
+	void ResetStats();
+
+private:
+	struct Key
+	{
+		int64_t x = 0;
+		int64_t y = 0;
+		int64_t z = 0;
+		int64_t pitch = 0;
+		int64_t roll = 0;
+		uint8_t rollMode = 0;
+		uint64_t calibFp = 0;
+
+		bool operator==(const Key& o) const
+		{
+			return x == o.x && y == o.y && z == o.z && pitch == o.pitch && roll == o.roll
+				&& rollMode == o.rollMode && calibFp == o.calibFp;
+		}
+	};
+
+	// 两个候选各自的舵机位置（Hold 时 J5 按调用方当前值另算）
+	struct Entry
+	{
+		bool used = false;
+		Key key;
+		ArmKinematics::IkResultLite ik;
+		std::array<ArmKinematics::ServoPos, 2> servo{};
+		std::array<ArmKinematics::IkError, 2> servoErr{};
+	};
+
+	struct Shard
+	{
+		std::mutex mutex;
+		std::vector<Entry> slots;
+	};
+
+	static constexpr size_t kShardCount = 16;
+
+	static uint64_t Hash(const Key& k);
+	void Finish(const KinematicsCalib& calib,
+	            const ArmKinematics::PoseTarget& target,
+	            const ArmKinematics::JointAnglesRad* pQCurrent,
+	            const ArmKinematics::IkScoring* pScoring,
+	            const Entry& e,
+	            ArmKinematics::IkResultLite& out,
+	            ArmKinematics::ServoPos* pServo,
+	            ArmKinematics::IkError* pServoErr) const;
+	void CheckFingerprint(uint64_t fp);
+
+private:
+	Params m_params;
+	size_t m_slotMask = 0;
+	std::unique_ptr<Shard[]> m_shards;
+
+	std::atomic<uint64_t> m_calibFp{ 0 };
+	std::atomic<uint64_t> m_hits{ 0 };
+	std::atomic<uint64_t> m_misses{ 0 };
+	std::atomic<uint64_t> m_bypassed{ 0 };
+	std::atomic<uint64_t> m_evictions{ 0 };
+	std::atomic<uint64_t> m_invalidations{ 0 };
+};
@@ -35,12 +35,22 @@ void JogController::Bind(MotionController* pMotion, KinematicsConfig* pKc)
 	m_pKc = pKc;
 }
 
+const KinematicsCalib& JogController::RefreshCalib()
+{
+	const MotionConfig& mc = m_pMotion->Config();
+	if (m_calib.IsStale(*m_pKc, &mc))
+	{
+		m_calib = KinematicsCalib::Compile(*m_pKc, &mc);
+		m_qCmdValid = false; // 角度<->舵机换算已变，积分状态需重新播种
+	}
+	return m_calib;
+}
+
 bool JogController::BuildCurrentJointEstimate(const MotionConfig& mc,
-                                              const KinematicsConfig& kc,
                                               ArmKinematics::JointAnglesRad& outQ)
 {
-	// 说明：为了让 Jog 的“择优解”更稳定，我们尽量从回读缓存估算当前关节角。
-	// 若没有回读缓存，则退化为 homePos。
+	// 说明：为了让 Jog 的“择优解”更稳定，我们尽量用舵机状态估计（已发送的运动指令 + 回读融合，见 ServoStateEstimator）
+	// 给出当前关节角；运动中也不会像回读缓存那样滞后。连接后尚无任何指令/回读时，退化为 homePos。
 	for (int j = 0; j <= ArmKinematics::kJointCount; j++)
 	{
 		outQ.q[j] = 0.0;
@@ -52,15 +62,15 @@ bool JogController::BuildCurrentJointEstimate(const MotionConfig& mc,
 		int pos = jc.homePos;
 		if (jc.servoId >= 1 && jc.servoId <= 6)
 		{
-			uint16_t rb = 0;
-			if (ArmCommsService::Instance().GetLastReadPos((uint8_t)jc.servoId, rb))
+			ServoStateEstimator::State est;
+			if (ArmCommsService::Instance().GetServoEstimate((uint8_t)jc.servoId, est))
 			{
-				pos = (int)rb;
+				pos = (int)std::lround(est.pos);
 			}
 		}
 
 		double rad = 0.0;
-		if (!ArmKinematics::ServoPosToJointRad(kc, &mc, j, pos, rad))
+		if (!m_calib.ServoPosToJointRad(j, pos, rad))
 		{
 			// 标定不足时给 0，后续 IK 仍可跑，但会更不稳定
 			rad = 0.0;
@@ -87,10 +97,13 @@ bool JogController::Tick(std::wstring& outWhy)
 		return true; // 未到周期
 	}
 	m_lastTick = now;
+	m_lastCollision = CollisionModel::Result();
 
-	// deadman 未按住则不发送
+	// deadman 未按住则不发送（ResolvedRate 下次按住时从回读重新播种）
 	if (!m_input.active)
 	{
+		m_qCmdValid = false;
+		m_lastSpeedScale = 1.0;
 		return true;
 	}
 
@@ -99,58 +112,260 @@ bool JogController::Tick(std::wstring& outWhy)
 	const double vy = Clamp(m_input.y, -1.0, 1.0) * m_params.speedMmPerSec;
 	const double vz = Clamp(m_input.z, -1.0, 1.0) * m_params.speedMmPerSec;
 	const double vp = Clamp(m_input.pitch, -1.0, 1.0) * m_params.pitchDegPerSec;
+	const double vr = Clamp(m_input.roll, -1.0, 1.0) * m_params.rollDegPerSec;
 
 	const double dt = (double)periodMs / 1000.0;
 	double dx = vx * dt;
 	double dy = vy * dt;
 	double dz = vz * dt;
 	double dp = vp * dt;
+	double dr = vr * dt;
 
 	// 步长限制（每tick）
 	dx = ClampStep(dx, m_params.maxStepMm);
 	dy = ClampStep(dy, m_params.maxStepMm);
 	dz = ClampStep(dz, m_params.maxStepMm);
 	dp = ClampStep(dp, m_params.maxStepPitchDeg);
+	dr = ClampStep(dr, m_params.maxStepRollDeg);
+
+	const KinematicsCalib& calib = RefreshCalib();
+
+	// 奇异点附近降速：按当前目标所在位置的灵活度缩放（整体缩放，方向不变）
+	m_lastSpeedScale = 1.0;
+	if (m_params.singularSlowdown && m_manip && m_manip->IsValid() && m_manip->GetCalibFingerprint() == calib.GetArmFingerprint())
+	{
+		m_lastSpeedScale = m_manip->SpeedScale(m_target, m_params.slowdown);
+		dx *= m_lastSpeedScale;
+		dy *= m_lastSpeedScale;
+		dz *= m_lastSpeedScale;
+		dp *= m_lastSpeedScale;
+	}
+
+	const int timeMs = (int)std::max<ULONGLONG>(periodMs, 30ULL); // 稍大于节拍，避免舵机抖动
 
-	m_target.x_mm += dx;
-	m_target.y_mm += dy;
-	m_target.z_mm += dz;
-	m_target.pitch_deg += dp;
+	if (m_params.mode == Mode::ResolvedRate)
+	{
+		ArmKinematics::PoseVelocity step;
+		step.x_mm = dx;
+		step.y_mm = dy;
+		step.z_mm = dz;
+		step.pitch_deg = dp;
+		m_lastProject = ArmKinematics::ProjectKind::Unchanged;
+		if (!StepResolvedRate(calib, step, dr, outWhy))
+		{
+			return false;
+		}
+		return SendJointAngles(calib, m_qCmd, timeMs, outWhy);
+	}
 
-	// 读取当前关节角估算，用于 IK 择优
+	// 读取当前关节角估算，用于 IK 择优（也是 J5 保持/滚转的起点）
 	ArmKinematics::JointAnglesRad qCur;
-	BuildCurrentJointEstimate(m_pMotion->Config(), *m_pKc, qCur);
+	BuildCurrentJointEstimate(m_pMotion->Config(), qCur);
+
+	ArmKinematics::PoseTarget next = m_target;
+	next.x_mm += dx;
+	next.y_mm += dy;
+	next.z_mm += dz;
+	next.pitch_deg += dp;
+	if (dr != 0.0)
+	{
+		if (next.rollMode == ArmKinematics::RollMode::Hold)
+		{
+			next.rollMode = ArmKinematics::RollMode::Joint;
+			next.roll_deg = qCur.q[5] * (180.0 / 3.14159265358979323846);
+		}
+		next.roll_deg += dr;
+	}
+	const bool mapFeasible = FilterByReachability(calib, next);
+
+	ArmKinematics::IkScoring scoring = m_params.scoring;
+	scoring.nextStep.x_mm = dx;
+	scoring.nextStep.y_mm = dy;
+	scoring.nextStep.z_mm = dz;
+	scoring.nextStep.pitch_deg = dp;
+	const ArmKinematics::IkScoring* pScoring = scoring.enabled ? &scoring : nullptr;
+
+	// IK（无分配版本：结果内联存储，失败原因为枚举，只有出错时才生成文字）
+	// 可达性图已判定不可行时跳过 IK，直接投影；有 IK 缓存时连同舵机位置一起查表
+	ArmKinematics::IkResultLite ik;
+	ArmKinematics::ServoPos sp;
+	ArmKinematics::IkError spErr = ArmKinematics::IkError::None;
+	const bool solved = mapFeasible
+		&& (m_ikCache ? m_ikCache->Solve(calib, next, &qCur, ik, &sp, &spErr, pScoring)
+		              : ArmKinematics::InverseKinematics(calib, next, &qCur, pScoring, ik));
+	if (solved && ik.error == ArmKinematics::IkError::None)
+	{
+		if (!CheckCollision(calib, qCur, ik.chosenQ, outWhy))
+		{
+			return false;
+		}
+		m_target = next;
+		m_lastProject = ArmKinematics::ProjectKind::Unchanged;
+		if (!m_ikCache)
+		{
+			return SendJointAngles(calib, ik.chosenQ, timeMs, outWhy);
+		}
+		if (spErr != ArmKinematics::IkError::None)
+		{
+			outWhy = ArmKinematics::IkErrorText(spErr);
+			return false;
+		}
+		return SendServoPos(sp, timeMs, outWhy);
+	}
+
+	// 越界（不可达或超软限位）：投影到最近的可行位姿，沿工作空间边界滑动而不是停下。
+	// 投影失败时 m_target 保持上一个可行值，不会被推到范围外。
+	ArmKinematics::ProjectResult pr;
+	if (!ArmKinematics::ProjectToReachable(calib, next, &qCur, m_params.project, pr))
+	{
+		const ArmKinematics::IkError e = (ik.error != ArmKinematics::IkError::None) ? ik.error : ArmKinematics::IkError::Unreachable;
+		outWhy = ArmKinematics::IkErrorText(e);
+		m_lastProject = ArmKinematics::ProjectKind::Failed;
+		return false;
+	}
+	if (!CheckCollision(calib, qCur, pr.q, outWhy))
+	{
+		return false;
+	}
+	m_target = pr.pose;
+	m_lastProject = pr.kind;
+	return SendJointAngles(calib, pr.q, timeMs, outWhy);
+}
+
+bool JogController::FilterByReachability(const KinematicsCalib& calib, ArmKinematics::PoseTarget& next) const
+{
+	if (!m_reach || !m_reach->IsValid() || m_reach->GetCalibFingerprint() != calib.GetArmFingerprint())
+	{
+		return true; // 地图未就绪或已过期：保持原行为（由 IK 判定）
+	}
 
-	// IK
-	const auto ik = ArmKinematics::InverseKinematics(*m_pKc, &m_pMotion->Config(), m_target, &qCur);
-	if (!ik.ok)
+	switch (m_reach->Classify(next))
 	{
-		outWhy = ik.reason.empty() ? L"IK 失败。" : ik.reason;
+	case ReachabilityMap::Verdict::PitchOutOfRange:
+		m_reach->ClampPitch(next);
+		return true;
+	case ReachabilityMap::Verdict::OutOfLimits:
+	case ReachabilityMap::Verdict::Unreachable:
+		return false;
+	default:
+		return true;
+	}
+}
+
+bool JogController::StepResolvedRate(const KinematicsCalib& calib,
+                                     const ArmKinematics::PoseVelocity& step,
+                                     double rollStepDeg,
+                                     std::wstring& outWhy)
+{
+	if (!m_qCmdValid)
+	{
+		// 播种：对当前目标位姿做一次闭式 IK（以回读/home 估算择优），与上次下发的位姿连续；
+		// 目标不可达时退化为估算值本身。J5 不参与 DLS：沿用估算值，滚转输入直接积分到 J5。
+		ArmKinematics::JointAnglesRad qCur;
+		BuildCurrentJointEstimate(m_pMotion->Config(), qCur);
+		ArmKinematics::IkScoring scoring = m_params.scoring;
+		scoring.nextStep = step;
+		ArmKinematics::IkResultLite ik;
+		m_qCmd = qCur;
+		if (ArmKinematics::InverseKinematics(calib, m_target, &qCur, scoring.enabled ? &scoring : nullptr, ik))
+		{
+			for (int j = 1; j <= 4; j++) m_qCmd.q[j] = ik.chosenQ.q[j];
+		}
+		m_qCmdValid = true;
+	}
+
+	// 每 tick 的笛卡尔增量直接映射为关节增量（DLS 线性，速度/增量同一公式）
+	ArmKinematics::JointAnglesRad dq;
+	if (!ArmKinematics::ResolveRateDls(calib, m_qCmd, step, m_params.dls, dq))
+	{
+		outWhy = ArmKinematics::IkErrorText(ArmKinematics::IkError::NoSolution);
 		return false;
 	}
 
+	// 单关节步长限制：保持增量方向不变整体缩放（逐关节截断会扭曲末端运动方向）
+	const double maxStep = std::max(m_params.maxStepJointDeg, 0.1) * (3.14159265358979323846 / 180.0);
+	double peak = 0.0;
+	for (int j = 1; j <= 4; j++) peak = std::max(peak, std::fabs(dq.q[j]));
+	const double scale = (peak > maxStep) ? (maxStep / peak) : 1.0;
+
+	// 积分 + 软限位：到限位的关节停在边界，其余关节继续（末端沿可行方向滑动）
+	ArmKinematics::JointAnglesRad qNext = m_qCmd;
+	for (int j = 1; j <= 4; j++)
+	{
+		double qj = m_qCmd.q[j] + dq.q[j] * scale;
+		const auto& jc = calib.GetJoint(j);
+		if (jc.hasLimit)
+		{
+			qj = Clamp(qj, jc.minRad, jc.maxRad);
+		}
+		qNext.q[j] = qj;
+	}
+	const auto& j5 = calib.GetJoint(5);
+	qNext.q[5] = m_qCmd.q[5] + rollStepDeg * (3.14159265358979323846 / 180.0);
+	if (j5.hasLimit)
+	{
+		qNext.q[5] = Clamp(qNext.q[5], j5.minRad, j5.maxRad);
+	}
+
+	// 会碰撞则不积分：下一 tick 仍从安全姿态出发，用户换方向即可离开
+	if (!CheckCollision(calib, m_qCmd, qNext, outWhy))
+	{
+		return false;
+	}
+	m_qCmd = qNext;
+
+	// 目标位姿跟随关节指令：UI 显示/切回 ClosedFormIk 时都从这里接续
+	m_target = ArmKinematics::ForwardKinematics(calib, m_qCmd);
+	return true;
+}
+
+bool JogController::CheckCollision(const KinematicsCalib& calib,
+                                   const ArmKinematics::JointAnglesRad& qFrom,
+                                   const ArmKinematics::JointAnglesRad& qTo,
+                                   std::wstring& outWhy)
+{
+	m_lastCollision = CollisionModel::Result();
+	if (!m_collision || m_collision->Check(calib, qTo, &m_lastCollision))
+	{
+		return true;
+	}
+	if (!m_collision->Check(calib, qFrom))
+	{
+		return true; // 已在碰撞中：放行（m_lastCollision 保留，UI 仍可提示）
+	}
+	outWhy = CollisionModel::ResultText(m_lastCollision);
+	return false;
+}
+
+bool JogController::SendJointAngles(const KinematicsCalib& calib,
+                                    const ArmKinematics::JointAnglesRad& q,
+                                    int timeMs,
+                                    std::wstring& outWhy)
+{
 	// 关节角 -> 舵机位置
 	ArmKinematics::ServoPos sp;
-	std::wstring why;
-	if (!ArmKinematics::JointAnglesToServoPos(*m_pKc, &m_pMotion->Config(), ik.chosenQ, sp, why))
+	const ArmKinematics::IkError convErr = ArmKinematics::JointAnglesToServoPos(calib, q, sp);
+	if (convErr != ArmKinematics::IkError::None)
 	{
-		outWhy = why.empty() ? L"角度转舵机位置失败。" : why;
+		outWhy = ArmKinematics::IkErrorText(convErr);
 		return false;
 	}
+	return SendServoPos(sp, timeMs, outWhy);
+}
 
+bool JogController::SendServoPos(const ArmKinematics::ServoPos& sp, int timeMs, std::wstring& outWhy)
+{
 	// “最新指令优先”：清理旧队列后再发（避免积压造成延迟）
 	ArmCommsService::Instance().ClearTxQueue();
 
-	std::vector<std::pair<int, int>> jointToPos;
-	jointToPos.reserve(ArmKinematics::kJointCount);
+	MotionController::JointPosArray jointPos;
+	jointPos.fill(-1);
 	for (int j = 1; j <= ArmKinematics::kJointCount; j++)
 	{
-		if (sp.pos[j] < 0) continue;
-		jointToPos.push_back({ j, sp.pos[j] });
+		jointPos[j] = sp.pos[j]; // 未输出的关节为 -1，MotionController 会忽略
 	}
 
-	const int timeMs = (int)std::max<ULONGLONG>(periodMs, 30ULL); // 稍大于节拍，避免舵机抖动
-	if (!m_pMotion->MoveJointsAbs(jointToPos, timeMs))
+	if (!m_pMotion->MoveJointsAbs(jointPos, timeMs))
 	{
 		outWhy = L"下发失败：未配置 ServoId 或无有效关节目标。";
 		return false;
@@ -158,6 +373,3 @@ bool JogController::Tick(std::wstring& outWhy)
 
 	return true;
 }
-
-
-
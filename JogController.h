@@ -1,35 +1,72 @@
 #pragma once
 
 #include <Windows.h>
+#include <cstdint>
+#include <memory>
 #include <string>
 
 #include "ArmKinematics.h"
+#include "CollisionModel.h"
+#include "IkCache.h"
+#include "KinematicsCalib.h"
 #include "KinematicsConfig.h"
+#include "ManipulabilityMap.h"
 #include "MotionController.h"
+#include "ReachabilityMap.h"
 
 // JogController：主界面“按住持续移动”的摇杆式控制逻辑（Base 笛卡尔空间）
 //
 // 设计要点：
 // - 按住移动、松开即停（deadman）
 // - 固定频率 Tick（例如 20Hz）对目标 Pose 积分
-// - 每次 Tick：PoseTarget -> IK -> ServoPos -> 下发
+// - 每次 Tick：PoseTarget -> IK -> ServoPos -> 下发（Mode::ClosedFormIk）
+//   或：笛卡尔速度 -> 雅可比 DLS -> 关节增量积分 -> ServoPos -> 下发（Mode::ResolvedRate）
 // - “最新指令优先”：避免队列堆积导致的严重延迟（通过清理 Jog 队列实现）
+// - 目标越界时投影到最近可行位姿（ArmKinematics::ProjectToReachable），沿边界滑动而不是停止
+// - 下发前做碰撞检测（CollisionModel，可选）：会碰撞的一步不下发，目标保持在上一个安全位姿
+// - IK 缓存（IkCache，可选）：悬停/微动时重复的位姿直接查表
 // - 错误可解释：IK 失败/超限时，返回 reason，UI 可展示并停止继续发送
 class JogController
 {
 public:
+	enum class Mode : uint8_t
+	{
+		// 每 tick 对积分后的目标位姿做闭式 IK（两肘解择优）；奇异点附近可能在两个分支间跳变
+		ClosedFormIk = 0,
+		// 速度级 IK：输入直接映射为关节速度（阻尼最小二乘），不换分支，奇异点附近平滑减速
+		ResolvedRate = 1,
+	};
+
 	struct Params
 	{
+		Mode mode = Mode::ClosedFormIk;
+
 		// 发送频率（Hz）。实际发送仍会受 ArmCommsService Throttle 影响。
 		int sendHz = 20;
 
 		// 最大步长限制（每 tick），防止数值抖动导致跳变过大
 		double maxStepMm = 3.0;     // mm/tick
 		double maxStepPitchDeg = 2.0; // deg/tick
+		double maxStepRollDeg = 3.0;  // deg/tick（J5）
 
 		// 速度（由 UI 滑条给出）
 		double speedMmPerSec = 50.0;
 		double pitchDegPerSec = 30.0;
+		double rollDegPerSec = 45.0;
+
+		// ResolvedRate：每 tick 单关节最大转角，以及 DLS 参数
+		double maxStepJointDeg = 3.0;
+		ArmKinematics::DlsParams dls;
+
+		// ClosedFormIk：目标越界时的投影策略（先放宽俯仰，再投影位置）
+		ArmKinematics::ProjectParams project;
+
+		// 两个肘解的择优评分（限位余量 / 可操作度 / 沿当前输入方向的可行 tick 数）；nextStep 由 Tick 按本 tick 增量填写
+		ArmKinematics::IkScoring scoring;
+
+		// 奇异点附近自动降速（需 SetManipulabilityMap）：按当前目标处的可操作度 / 逆条件数缩放 x/y/z/俯仰增量，J5 不受影响
+		bool singularSlowdown = true;
+		ManipulabilityMap::SpeedParams slowdown;
 	};
 
 	struct InputState
@@ -42,10 +79,12 @@ public:
 		// - y: 前为 +Y
 		// - z: 上为 +Z
 		// - pitch: 末端俯仰（+为抬头/向上）
+		// - roll: 末端滚转（J5，+为绕连杆方向右手转）；目标 rollMode 为 Hold 时首次输入切换为 Joint
 		double x = 0.0;
 		double y = 0.0;
 		double z = 0.0;
 		double pitch = 0.0;
+		double roll = 0.0;
 	};
 
 public:
@@ -58,20 +97,68 @@ public:
 	InputState GetInputState() const { return m_input; }
 
 	// 设置当前目标（通常在启动 Jog 或收到外部定位结果时调用）
-	void SetTargetPose(const ArmKinematics::PoseTarget& pose) { m_target = pose; }
+	void SetTargetPose(const ArmKinematics::PoseTarget& pose) { m_target = pose; m_qCmdValid = false; }
 	ArmKinematics::PoseTarget GetTargetPose() const { return m_target; }
 
 	// 绑定依赖（由主界面提供单例/成员）
 	void Bind(MotionController* pMotion, KinematicsConfig* pKc);
 
+	// 可达性图（可选，后台构建完成后设置）：ClosedFormIk 模式下先查表再求 IK，
+	// 俯仰超出可行范围时钳位，位置越界时跳过 IK 直接投影。标定指纹不一致时自动忽略。
+	void SetReachabilityMap(std::shared_ptr<const ReachabilityMap> map) { m_reach = std::move(map); }
+
+	// 碰撞模型（可选）：设置后每 tick 下发前检查，碰撞时 Tick 返回 false 并给出“碰撞：xx-yy”
+	void SetCollisionModel(std::shared_ptr<const CollisionModel> model) { m_collision = std::move(model); }
+	CollisionModel::Hit GetLastCollision() const { return m_lastCollision.hit; }
+
+	// IK 缓存（可选）：ClosedFormIk 模式下按量化位姿复用 IK + 舵机换算结果（悬停/微动时几乎都命中）
+	void SetIkCache(std::shared_ptr<IkCache> cache) { m_ikCache = std::move(cache); }
+	const IkCache* GetIkCache() const { return m_ikCache.get(); }
+
+	// 灵活度图（可选，后台构建完成后设置）：两种模式都按它降速，标定指纹不一致时忽略
+	void SetManipulabilityMap(std::shared_ptr<const ManipulabilityMap> map) { m_manip = std::move(map); }
+	std::shared_ptr<const ManipulabilityMap> GetManipulabilityMap() const { return m_manip; }
+
+	// 最近一次 tick 的速度倍率（1 = 未降速），供 UI / HUD 显示
+	double GetLastSpeedScale() const { return m_lastSpeedScale; }
+
 	// 定时调用：负责积分 + 下发
 	bool Tick(std::wstring& outWhy);
 
+	// 最近一次下发是否经过投影（Unchanged 以外即“贴边滑动”中），供 UI / 视觉跟随提示
+	ArmKinematics::ProjectKind GetLastProjectKind() const { return m_lastProject; }
+
 	// 停止 Jog（不再发送），但不做急停（急停由 UI 单独触发）
-	void Stop() { m_input.active = false; }
+	void Stop() { m_input.active = false; m_qCmdValid = false; }
 
 private:
-	bool BuildCurrentJointEstimate(const MotionConfig& mc, const KinematicsConfig& kc, ArmKinematics::JointAnglesRad& outQ);
+	bool BuildCurrentJointEstimate(const MotionConfig& mc, ArmKinematics::JointAnglesRad& outQ);
+
+	// 标定配置变化（指纹不一致）时重新编译，返回当前可用的标定表
+	const KinematicsCalib& RefreshCalib();
+
+	// 用可达性图修正下一目标（钳位俯仰）；返回 false 表示地图判定位置不可行
+	bool FilterByReachability(const KinematicsCalib& calib, ArmKinematics::PoseTarget& next) const;
+
+	// ResolvedRate：按笛卡尔增量推进 m_qCmd，并让 m_target 跟随 FK(m_qCmd)
+	bool StepResolvedRate(const KinematicsCalib& calib,
+	                      const ArmKinematics::PoseVelocity& step,
+	                      double rollStepDeg,
+	                      std::wstring& outWhy);
+
+	// 碰撞检测：返回 true 表示允许从 qFrom 走到 qTo（未设置模型时恒为 true），否则写 outWhy。
+	// 只阻止“安全 -> 碰撞”；qFrom 本身已在碰撞中（例如上电姿态压在桌面上）时放行，让用户能退出来。
+	bool CheckCollision(const KinematicsCalib& calib,
+	                    const ArmKinematics::JointAnglesRad& qFrom,
+	                    const ArmKinematics::JointAnglesRad& qTo,
+	                    std::wstring& outWhy);
+
+	// 关节角 -> 舵机位置 -> 清队列后下发（两种模式共用）
+	bool SendJointAngles(const KinematicsCalib& calib,
+	                     const ArmKinematics::JointAnglesRad& q,
+	                     int timeMs,
+	                     std::wstring& outWhy);
+	bool SendServoPos(const ArmKinematics::ServoPos& sp, int timeMs, std::wstring& outWhy);
 
 private:
 	Params m_params;
@@ -81,6 +168,22 @@ private:
 	MotionController* m_pMotion = nullptr;
 	KinematicsConfig* m_pKc = nullptr;
 
+	// 预编译标定（每 tick 复用，配置变化时由 RefreshCalib 重建）
+	KinematicsCalib m_calib;
+
+	std::shared_ptr<const ReachabilityMap> m_reach;
+	ArmKinematics::ProjectKind m_lastProject = ArmKinematics::ProjectKind::Unchanged;
+
+	std::shared_ptr<const CollisionModel> m_collision;
+	std::shared_ptr<IkCache> m_ikCache;
+	std::shared_ptr<const ManipulabilityMap> m_manip;
+	double m_lastSpeedScale = 1.0;
+	CollisionModel::Result m_lastCollision;
+
+	// ResolvedRate 的关节指令（积分状态）。松开/停止/标定变化后失效，下次从回读重新播种。
+	ArmKinematics::JointAnglesRad m_qCmd{};
+	bool m_qCmdValid = false;
+
 	ULONGLONG m_lastTick = 0;
 };
 
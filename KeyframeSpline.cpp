@@ -0,0 +1,346 @@
+#include "pch.h"
+
+#include "KeyframeSpline.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Solves a tridiagonal system in place (Thomas algorithm). sub[0] and sup[n-1] are unused.
+	void SolveTridiagonal(std::vector<double> sub, std::vector<double> diag, std::vector<double> sup,
+	                      std::vector<double>& rhs)
+	{
+		const size_t n = diag.size();
+		for (size_t i = 1; i < n; i++)
+		{
+			const double m = sub[i] / diag[i - 1];
+			diag[i] -= m * sup[i - 1];
+			rhs[i] -= m * rhs[i - 1];
+		}
+		rhs[n - 1] /= diag[n - 1];
+		for (size_t i = n - 1; i-- > 0;)
+		{
+			rhs[i] = (rhs[i] - sup[i] * rhs[i + 1]) / diag[i];
+		}
+	}
+
+	// Quintic Hermite segment normalized to h = 1, p0 = 0, p1 = 1, with alpha = v0 h / dp and A = a0 h^2 / dp:
+	//   x'(s) = 30 s^2 (1-s)^2 + alpha P(s) + A G(s) + (end terms),
+	//   P(s) = 1 - 18 s^2 + 32 s^3 - 15 s^4,  G(s) = s (1-s)^2 (1 - 2.5 s).
+	// The segment is split into a start half (half of the 30 s^2 (1-s)^2 term plus the start terms) and its mirror
+	// image; if both halves are >= 0 on [0, 1] the segment is monotone. Each half only involves one knot, so every
+	// knot gets an acceleration range of its own. Returns false if no A keeps the start half >= 0 (alpha too large).
+	bool QuinticStartAccelRange(double alpha, double& lo, double& hi)
+	{
+		// 10% of the shared term is kept back so the half also holds between the sampled s.
+		const double kBase = 0.9 * 15.0;
+		const int kSamples = 64;
+		lo = -1e300;
+		hi = 1e300;
+		// Asymptotes at the ends: x' ~ alpha + A s at s -> 0; ~ (kBase - 12 alpha - 1.5 A) (1-s)^2 at s -> 1.
+		if (alpha <= 0.0) lo = 0.0;
+		hi = (kBase - 12.0 * alpha) / 1.5;
+		for (int k = 1; k < kSamples; k++)
+		{
+			const double s = static_cast<double>(k) / kSamples;
+			const double s2 = s * s;
+			const double base = kBase * s2 * (1.0 - s) * (1.0 - s) + alpha * (1.0 - 18.0 * s2 + 32.0 * s2 * s - 15.0 * s2 * s2);
+			const double g = s * (1.0 - s) * (1.0 - s) * (1.0 - 2.5 * s);
+			if (g > 1e-12) lo = std::max(lo, -base / g);
+			else if (g < -1e-12) hi = std::min(hi, -base / g);
+			else if (base < 0.0) return false;
+		}
+		return lo <= hi;
+	}
+}
+
+bool KeyframeSpline::Build(const std::vector<Knot>& knots, Kind kind, bool closed)
+{
+	m_kind = kind;
+	m_closed = closed;
+	m_t.clear();
+	m_durationMs = 0;
+	for (auto& v : m_p) v.clear();
+	m_used.fill(false);
+
+	// Merge zero-duration knots and forward-fill unset joints.
+	std::vector<Knot> k;
+	k.reserve(knots.size() + 1);
+	for (size_t i = 0; i < knots.size(); i++)
+	{
+		Knot cur = knots[i];
+		for (int j = 1; j <= MotionConfig::kJointCount; j++)
+		{
+			if (cur.pos[j] >= 0) m_used[j] = true;
+			if (cur.pos[j] < 0 && !k.empty()) cur.pos[j] = k.back().pos[j];
+		}
+		if (!k.empty() && cur.durationMs <= 0)
+		{
+			k.back().pos = cur.pos;
+			continue;
+		}
+		k.push_back(cur);
+	}
+	// Leading unset values take the first set value.
+	for (int j = 1; j <= MotionConfig::kJointCount; j++)
+	{
+		if (!m_used[j]) continue;
+		size_t first = 0;
+		while (k[first].pos[j] < 0) first++;
+		for (size_t i = 0; i < first; i++) k[i].pos[j] = k[first].pos[j];
+	}
+	if (closed && !k.empty())
+	{
+		Knot wrap = k.front();
+		wrap.durationMs = std::max(k.front().durationMs, 1);
+		k.push_back(wrap);
+	}
+	if (k.size() < 2)
+	{
+		return false;
+	}
+
+	const size_t n = k.size();
+	m_t.resize(n);
+	m_t[0] = 0.0;
+	for (size_t i = 1; i < n; i++) m_t[i] = m_t[i - 1] + k[i].durationMs;
+	m_durationMs = static_cast<int>(m_t.back());
+
+	for (int j = 1; j <= MotionConfig::kJointCount; j++)
+	{
+		m_p[j].assign(n, 0.0);
+		m_v[j].assign(n, 0.0);
+		m_a[j].assign(n, 0.0);
+		if (!m_used[j]) continue;
+		for (size_t i = 0; i < n; i++) m_p[j][i] = k[i].pos[j];
+		if (kind == Kind::Cubic) SolveCubicVelocities(j);
+		else ShapePreservingDerivatives(j);
+	}
+	return true;
+}
+
+// C2 cubic: knot velocities from h_k v_{k-1} + 2(h_{k-1}+h_k) v_k + h_{k-1} v_{k+1} = 3(h_k d_{k-1} + h_{k-1} d_k),
+// with v = 0 at both ends (open) or cyclic indices (closed, solved via Sherman-Morrison).
+void KeyframeSpline::SolveCubicVelocities(int joint)
+{
+	const auto& p = m_p[joint];
+	auto& v = m_v[joint];
+	const size_t n = m_t.size();
+	auto h = [&](size_t i) { return m_t[i + 1] - m_t[i]; };
+	auto d = [&](size_t i) { return (p[i + 1] - p[i]) / h(i); };
+
+	if (!m_closed)
+	{
+		if (n < 3) return; // single segment: rest-to-rest
+		const size_t m = n - 2; // interior knots 1..n-2
+		std::vector<double> sub(m), diag(m), sup(m), rhs(m);
+		for (size_t r = 0; r < m; r++)
+		{
+			const size_t i = r + 1;
+			sub[r] = h(i);
+			diag[r] = 2.0 * (h(i - 1) + h(i));
+			sup[r] = h(i - 1);
+			rhs[r] = 3.0 * (h(i) * d(i - 1) + h(i - 1) * d(i));
+		}
+		SolveTridiagonal(sub, diag, sup, rhs);
+		for (size_t r = 0; r < m; r++) v[r + 1] = rhs[r];
+		return;
+	}
+
+	// Closed: unknowns v_0..v_{m-1}, m = n - 1 (knot n-1 duplicates knot 0).
+	const size_t m = n - 1;
+	auto hc = [&](size_t i) { return h(i % m); };
+	auto dc = [&](size_t i) { return d(i % m); };
+	if (m < 2)
+	{
+		return;
+	}
+	std::vector<double> sub(m), diag(m), sup(m), rhs(m);
+	for (size_t i = 0; i < m; i++)
+	{
+		const double hPrev = hc(i + m - 1);
+		const double hCur = hc(i);
+		sub[i] = hCur;
+		diag[i] = 2.0 * (hPrev + hCur);
+		sup[i] = hPrev;
+		rhs[i] = 3.0 * (hCur * dc(i + m - 1) + hPrev * dc(i));
+	}
+	if (m == 2)
+	{
+		// Both off-diagonal terms couple the same two unknowns.
+		const double a00 = diag[0], a01 = sub[0] + sup[0];
+		const double a10 = sub[1] + sup[1], a11 = diag[1];
+		const double det = a00 * a11 - a01 * a10;
+		v[0] = (rhs[0] * a11 - a01 * rhs[1]) / det;
+		v[1] = (a00 * rhs[1] - a10 * rhs[0]) / det;
+		v[2] = v[0];
+		return;
+	}
+
+	// Sherman-Morrison on the corner terms alpha = A[m-1][0] = sup[m-1], beta = A[0][m-1] = sub[0].
+	const double alpha = sup[m - 1];
+	const double beta = sub[0];
+	const double gamma = -diag[0];
+	std::vector<double> diagT = diag;
+	diagT[0] -= gamma;
+	diagT[m - 1] -= alpha * beta / gamma;
+	std::vector<double> x = rhs;
+	SolveTridiagonal(sub, diagT, sup, x);
+	std::vector<double> z(m, 0.0);
+	z[0] = gamma;
+	z[m - 1] = alpha;
+	SolveTridiagonal(sub, diagT, sup, z);
+	const double fact = (x[0] + beta * x[m - 1] / gamma) / (1.0 + z[0] + beta * z[m - 1] / gamma);
+	for (size_t i = 0; i < m; i++) v[i] = x[i] - fact * z[i];
+	v[m] = v[0];
+}
+
+// Quintic: weighted-harmonic knot velocities (Fritsch-Butland), zero where the slope changes sign or is flat,
+// and central-difference knot accelerations. Both are then limited per knot (QuinticStartAccelRange on the two
+// adjacent segments) so every segment stays monotone between its end values; velocities are only reduced where
+// no acceleration satisfies both sides (very uneven durations). Continuous across knots by construction.
+void KeyframeSpline::ShapePreservingDerivatives(int joint)
+{
+	const auto& p = m_p[joint];
+	auto& v = m_v[joint];
+	auto& a = m_a[joint];
+	const size_t n = m_t.size();
+	auto h = [&](size_t i) { return m_t[i + 1] - m_t[i]; };
+	auto d = [&](size_t i) { return (p[i + 1] - p[i]) / h(i); };
+
+	auto knotVelocity = [&](double hPrev, double dPrev, double hCur, double dCur)
+	{
+		if (dPrev * dCur <= 0.0) return 0.0;
+		const double w1 = 2.0 * hCur + hPrev;
+		const double w2 = hCur + 2.0 * hPrev;
+		return (w1 + w2) / (w1 / dPrev + w2 / dCur);
+	};
+	for (size_t i = 1; i + 1 < n; i++)
+	{
+		v[i] = knotVelocity(h(i - 1), d(i - 1), h(i), d(i));
+	}
+	if (m_closed && n >= 3)
+	{
+		v[0] = knotVelocity(h(n - 2), d(n - 2), h(0), d(0));
+		v[n - 1] = v[0];
+	}
+
+	// Acceleration range at a knot with velocity vk, between segments segIn (ends here) and segOut (starts here).
+	auto knotAccelRange = [&](size_t segIn, size_t segOut, double vk, double& lo, double& hi)
+	{
+		lo = -1e300;
+		hi = 1e300;
+		const size_t segs[2] = { segIn, segOut };
+		for (int side = 0; side < 2; side++)
+		{
+			const size_t sg = segs[side];
+			const double hs = h(sg);
+			const double dp = p[sg + 1] - p[sg];
+			if (dp == 0.0)
+			{
+				// Flat segment: any velocity or acceleration at its ends would leave the held value.
+				if (vk != 0.0) return false;
+				lo = std::max(lo, 0.0);
+				hi = std::min(hi, 0.0);
+				continue;
+			}
+			double sLo, sHi;
+			if (!QuinticStartAccelRange(std::max(0.0, vk * hs / dp), sLo, sHi)) return false;
+			// The end half of segIn is the mirror image of a start half: A -> -A.
+			if (side == 0)
+			{
+				const double t = sLo;
+				sLo = -sHi;
+				sHi = -t;
+			}
+			const double k = dp / (hs * hs);
+			lo = std::max(lo, std::min(sLo * k, sHi * k));
+			hi = std::min(hi, std::max(sLo * k, sHi * k));
+		}
+		return lo <= hi;
+	};
+
+	std::vector<size_t> knots;
+	for (size_t i = 1; i + 1 < n; i++) knots.push_back(i);
+	if (m_closed && n >= 3) knots.push_back(0);
+	auto segIn = [&](size_t i) { return (i == 0) ? n - 2 : i - 1; };
+
+	for (size_t i : knots)
+	{
+		double lo, hi;
+		if (knotAccelRange(segIn(i), i, v[i], lo, hi)) continue;
+		// v = 0 (a = 0) is always feasible: keep the largest feasible fraction of the Fritsch-Butland velocity.
+		double ok = 0.0, bad = 1.0;
+		for (int it = 0; it < 20; it++)
+		{
+			const double mid = 0.5 * (ok + bad);
+			if (knotAccelRange(segIn(i), i, v[i] * mid, lo, hi)) ok = mid;
+			else bad = mid;
+		}
+		v[i] *= ok;
+	}
+	if (m_closed && n >= 3) v[n - 1] = v[0];
+
+	for (size_t i : knots)
+	{
+		const size_t in = segIn(i);
+		const size_t next = (i == 0) ? 1 : i + 1;
+		const double central = (v[next] - v[in]) / (h(in) + h(i));
+		double lo, hi;
+		a[i] = knotAccelRange(in, i, v[i], lo, hi) ? std::min(std::max(central, lo), hi) : 0.0;
+	}
+	if (m_closed && n >= 3) a[n - 1] = a[0];
+}
+
+void KeyframeSpline::Evaluate(double tMs, JointPosArray& out) const
+{
+	out.fill(-1);
+	if (m_t.size() < 2) return;
+
+	tMs = std::min(std::max(tMs, 0.0), m_t.back());
+	const size_t seg = std::min<size_t>(
+		static_cast<size_t>(std::upper_bound(m_t.begin(), m_t.end(), tMs) - m_t.begin()), m_t.size() - 1) - 1;
+	const double h = m_t[seg + 1] - m_t[seg];
+	const double s = (tMs - m_t[seg]) / h;
+	const double s2 = s * s;
+	const double s3 = s2 * s;
+
+	for (int j = 1; j <= MotionConfig::kJointCount; j++)
+	{
+		if (!m_used[j]) continue;
+		const double p0 = m_p[j][seg], p1 = m_p[j][seg + 1];
+		const double v0 = m_v[j][seg] * h, v1 = m_v[j][seg + 1] * h;
+		double x;
+		if (m_kind == Kind::Cubic)
+		{
+			x = (2.0 * s3 - 3.0 * s2 + 1.0) * p0 + (s3 - 2.0 * s2 + s) * v0 + (-2.0 * s3 + 3.0 * s2) * p1 + (s3 - s2) * v1;
+		}
+		else
+		{
+			const double s4 = s3 * s;
+			const double s5 = s4 * s;
+			const double a0 = m_a[j][seg] * h * h, a1 = m_a[j][seg + 1] * h * h;
+			x = (1.0 - 10.0 * s3 + 15.0 * s4 - 6.0 * s5) * p0
+				+ (s - 6.0 * s3 + 8.0 * s4 - 3.0 * s5) * v0
+				+ (0.5 * s2 - 1.5 * s3 + 1.5 * s4 - 0.5 * s5) * a0
+				+ (0.5 * s3 - s4 + 0.5 * s5) * a1
+				+ (-4.0 * s3 + 7.0 * s4 - 3.0 * s5) * v1
+				+ (10.0 * s3 - 15.0 * s4 + 6.0 * s5) * p1;
+		}
+		out[j] = std::min(1000, std::max(0, static_cast<int>(std::lround(x))));
+	}
+}
+
+void KeyframeSpline::Sample(int periodMs, std::vector<JointPosArray>& out) const
+{
+	out.clear();
+	if (m_t.size() < 2) return;
+	periodMs = std::max(periodMs, 1);
+	const int steps = (m_durationMs + periodMs - 1) / periodMs;
+	out.resize(static_cast<size_t>(steps));
+	for (int i = 1; i <= steps; i++)
+	{
+		Evaluate(std::min(static_cast<double>(i) * periodMs, static_cast<double>(m_durationMs)), out[i - 1]);
+	}
+}
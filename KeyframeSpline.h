@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MotionConfig.h"
+
+// Joint-space spline through keyframe script positions (servo units, per joint).
+//
+// Keyframe playback used to send one PackMove per keyframe and wait durationMs, so every joint
+// came to rest at every keyframe. This interpolator passes through the same keyframe positions at
+// the same times, but with continuous velocity (and acceleration), and is sampled into a setpoint
+// stream that MotionController plays one PackMove per period.
+//
+// - Knot k is reached at t_k = sum of durationMs of knots 1..k (knot 0 is at t = 0).
+// - Joints set to -1 hold the previous knot value; leading -1 take the first set value;
+//   joints never set stay -1 in every sample (MotionController ignores them).
+// - Open splines start and end at rest. Closed splines (looping scripts) wrap from the last
+//   knot back to knot 0 over knot 0's durationMs with periodic velocity.
+// Pure C++ (no MFC), so headless tools can use it.
+class KeyframeSpline
+{
+public:
+	using JointPosArray = std::array<int, MotionConfig::kJointCount + 1>;
+
+	enum class Kind : uint8_t
+	{
+		// C2 cubic spline (global solve): smoothest, but overshoots keyframes where the motion
+		// reverses, by a lot when neighbouring durations are very uneven.
+		Cubic = 1,
+		// Quintic Hermite segments, still C2: shape-preserving knot velocities (zero at reversals)
+		// and knot accelerations limited so each segment stays between its two keyframe values.
+		Quintic = 2,
+	};
+
+	struct Knot
+	{
+		int durationMs = 0; // time to reach this knot from the previous one (ignored for knot 0 of open splines)
+		JointPosArray pos{};
+	};
+
+public:
+	// Returns false if there are fewer than two usable knots (zero-duration knots replace the previous one).
+	bool Build(const std::vector<Knot>& knots, Kind kind, bool closed);
+
+	int DurationMs() const { return m_durationMs; }
+
+	// Position at time tMs (clamped to [0, DurationMs()]), rounded to servo units.
+	void Evaluate(double tMs, JointPosArray& out) const;
+
+	// Samples at periodMs, 2*periodMs, ... up to and including DurationMs() (the last sample
+	// lands exactly on the final knot). t = 0 is not emitted: the caller is already there.
+	void Sample(int periodMs, std::vector<JointPosArray>& out) const;
+
+private:
+	void SolveCubicVelocities(int joint);
+	void ShapePreservingDerivatives(int joint);
+
+private:
+	// Knot times (ms) and per-joint knot values/derivatives; closed splines repeat knot 0 at the end.
+	std::vector<double> m_t;
+	std::array<std::vector<double>, MotionConfig::kJointCount + 1> m_p, m_v, m_a;
+	std::array<bool, MotionConfig::kJointCount + 1> m_used{};
+	Kind m_kind = Kind::Cubic;
+	bool m_closed = false;
+	int m_durationMs = 0;
+};
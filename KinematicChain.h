@@ -0,0 +1,513 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "KinematicsCalib.h"
+#include "KinematicsConfig.h"
+
+// 展开用的小函数必须内联进调用方：否则闭包按引用传出，编译器无法证明输出数组与局部坐标系不重叠，每步都要回读内存
+#if defined(_MSC_VER)
+#define KINEMATIC_CHAIN_INLINE __forceinline
+#else
+#define KINEMATIC_CHAIN_INLINE inline __attribute__((always_inline))
+#endif
+
+// KinematicChain：编译期运动链描述，以及由描述生成的 FK / 几何雅可比 / 舵机换算 / DLS 迭代 IK
+// - 拓扑写成类型：每个关节一个 Joint<...>（类型、运动轴及方向、定位它的连杆段及平移方向、舵机轴向符号）；
+// - 算法写成模板，按关节逐个展开（ForEachJoint，编译期下标，无运行期的轴向分支），生成定长直线代码，
+//   关节量用 std::array<double, kDof>；换拓扑（如 6 自由度）只需换一个链类型。
+//
+// 约定：
+// - 关节下标 0..kDof-1（Arm5Dof 的下标 i 即 ArmKinematics 的 J(i+1)）；转动关节 rad，移动关节 mm；
+// - 关节 i 的坐标系 = 关节 i-1 的坐标系（i=0 时为 Base）沿其 OffsetAxis 轴平移连杆段 Offset，再绕（沿）自身 Axis 按 Dir 运动 q；
+//   运动之后的坐标系即 ArmKinematics::LinkFrames 中该关节的坐标系，最后一个关节的坐标系即法兰；
+// - 编译期只确定“用哪一段连杆”（LinkId），长度数值运行期取自 KinematicsConfig::LinkLengthsMm（标定会改它）；
+// - Arm5Dof 与 ArmKinematics 的模型逐项一致（ForwardKinematicsFrames 由它生成，AxisSignForJoint 取它的舵机符号）；
+//   闭式 IK 仍是 5 关节专用，其它拓扑用 SolveIk（DLS 迭代）。
+//
+// 纯 C++14、仅头文件（无 MFC/OpenCV），无头工具可直接使用。
+namespace KinematicChain
+{
+	enum class JointType : uint8_t
+	{
+		Revolute = 0,
+		Prismatic,
+	};
+
+	// 关节自身坐标系的轴：x = 俯仰转轴（右），y = 连杆延伸方向，z = 顶面法向（见 ArmKinematics::LinkFrames）
+	enum class Axis : uint8_t
+	{
+		X = 0,
+		Y = 1,
+		Z = 2,
+	};
+
+	// 连杆段（长度见 KinematicsConfig::LinkLengthsMm）
+	enum class LinkId : uint8_t
+	{
+		None = 0,
+		Base,  // L_base
+		Arm1,  // L_arm1
+		Arm2,  // L_arm2
+		Wrist, // L_wrist
+	};
+
+	// 刚体位姿（Base 坐标系）：R 的三列为局部 x/y/z 轴方向，p 为原点（mm）
+	struct Frame
+	{
+		double R[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+		double p[3] = {};
+	};
+
+	// 单个关节的描述：
+	// - Dir：q 增大时绕 MotionAxis 右手转（+1）还是反转（-1）——模型层的方向，与舵机无关；
+	// - ServoSign：舵机正向与模型 q 正向是否一致（KinematicsCalib 编入 posPerRad）
+	template <JointType Type, Axis MotionAxis, int Dir, LinkId Offset, Axis OffsetAxis, int ServoSign>
+	struct Joint
+	{
+		static_assert(Dir == 1 || Dir == -1, "Dir must be +1 or -1");
+		static_assert(ServoSign == 1 || ServoSign == -1, "ServoSign must be +1 or -1");
+
+		static constexpr JointType kType = Type;
+		static constexpr Axis kAxis = MotionAxis;
+		static constexpr int kDir = Dir;
+		static constexpr LinkId kOffset = Offset;
+		static constexpr Axis kOffsetAxis = OffsetAxis;
+		static constexpr int kServoSign = ServoSign;
+	};
+
+	template <class... Joints>
+	struct Chain
+	{
+		static constexpr int kDof = static_cast<int>(sizeof...(Joints));
+
+		using JointList = std::tuple<Joints...>;
+		template <int I>
+		using JointAt = typename std::tuple_element<I, JointList>::type;
+
+		using Q = std::array<double, kDof>;
+		using ServoPos = std::array<int, kDof>;
+		using Frames = std::array<Frame, kDof>;
+
+		// 几何雅可比：行 0..2 = 法兰原点线速度（mm / 单位关节量），行 3..5 = 角速度（rad / 单位关节量），均在 Base 系
+		using Jacobian = std::array<std::array<double, kDof>, 6>;
+	};
+
+	// 当前的 5 关节臂（Reference/mechanics.md）
+	using Arm5Dof = Chain<
+		Joint<JointType::Revolute, Axis::Z, -1, LinkId::None, Axis::Z, +1>,   // J1 转台：q>0 把前向 Y 转向 +X
+		Joint<JointType::Revolute, Axis::X, +1, LinkId::Base, Axis::Z, +1>,   // J2 肩俯仰（地面上方 L_base）
+		Joint<JointType::Revolute, Axis::X, +1, LinkId::Arm1, Axis::Y, -1>,   // J3 肘俯仰（舵机反装）
+		Joint<JointType::Revolute, Axis::X, +1, LinkId::Arm2, Axis::Y, +1>,   // J4 腕俯仰
+		Joint<JointType::Revolute, Axis::Y, +1, LinkId::Wrist, Axis::Y, +1>>; // J5 绕连杆方向滚转（法兰）
+
+	// 6 关节变体：J4 改为小臂滚转，J5 腕俯仰，J6 法兰滚转；J4/J5/J6 三轴交于腕心（球腕），
+	// 连杆段沿用 5 关节臂的四段。舵机符号按新硬件的装配填写。
+	using Arm6Dof = Chain<
+		Joint<JointType::Revolute, Axis::Z, -1, LinkId::None, Axis::Z, +1>,   // J1 转台
+		Joint<JointType::Revolute, Axis::X, +1, LinkId::Base, Axis::Z, +1>,   // J2 肩俯仰
+		Joint<JointType::Revolute, Axis::X, +1, LinkId::Arm1, Axis::Y, -1>,   // J3 肘俯仰
+		Joint<JointType::Revolute, Axis::Y, +1, LinkId::Arm2, Axis::Y, +1>,   // J4 小臂滚转（腕心）
+		Joint<JointType::Revolute, Axis::X, +1, LinkId::None, Axis::Y, +1>,   // J5 腕俯仰（腕心）
+		Joint<JointType::Revolute, Axis::Y, +1, LinkId::Wrist, Axis::Y, +1>>; // J6 法兰滚转
+
+	namespace detail
+	{
+		template <int I, int N>
+		struct Unroll
+		{
+			template <class Fn>
+			static KINEMATIC_CHAIN_INLINE void Run(Fn& fn)
+			{
+				fn(std::integral_constant<int, I>());
+				Unroll<I + 1, N>::Run(fn);
+			}
+		};
+
+		template <int N>
+		struct Unroll<N, N>
+		{
+			template <class Fn>
+			static KINEMATIC_CHAIN_INLINE void Run(Fn&)
+			{
+			}
+		};
+
+		inline double LinkLength(const KinematicsConfig::LinkLengthsMm&, std::integral_constant<LinkId, LinkId::None>) { return 0.0; }
+		inline double LinkLength(const KinematicsConfig::LinkLengthsMm& L, std::integral_constant<LinkId, LinkId::Base>) { return L.L_base; }
+		inline double LinkLength(const KinematicsConfig::LinkLengthsMm& L, std::integral_constant<LinkId, LinkId::Arm1>) { return L.L_arm1; }
+		inline double LinkLength(const KinematicsConfig::LinkLengthsMm& L, std::integral_constant<LinkId, LinkId::Arm2>) { return L.L_arm2; }
+		inline double LinkLength(const KinematicsConfig::LinkLengthsMm& L, std::integral_constant<LinkId, LinkId::Wrist>) { return L.L_wrist; }
+
+		// 沿坐标系自身的 A 轴平移 d
+		template <Axis A>
+		KINEMATIC_CHAIN_INLINE void Translate(Frame& f, double d)
+		{
+			const int a = static_cast<int>(A);
+			f.p[0] += f.R[0][a] * d;
+			f.p[1] += f.R[1][a] * d;
+			f.p[2] += f.R[2][a] * d;
+		}
+
+		// 绕坐标系自身的 A 轴右手转（c, s）：只有另外两列变化（A=X: y,z；A=Y: z,x；A=Z: x,y）
+		template <Axis A>
+		KINEMATIC_CHAIN_INLINE void RotateRow(double (&row)[3], double c, double s)
+		{
+			const int b = (static_cast<int>(A) + 1) % 3;
+			const int d = (static_cast<int>(A) + 2) % 3;
+			const double u = row[b];
+			const double v = row[d];
+			row[b] = c * u + s * v;
+			row[d] = c * v - s * u;
+		}
+
+		template <Axis A>
+		KINEMATIC_CHAIN_INLINE void Rotate(Frame& f, double c, double s)
+		{
+			RotateRow<A>(f.R[0], c, s);
+			RotateRow<A>(f.R[1], c, s);
+			RotateRow<A>(f.R[2], c, s);
+		}
+
+		// 从单位阵出发绕 A 轴转（首个关节用，省去与单位阵的乘法）
+		template <Axis A>
+		KINEMATIC_CHAIN_INLINE void SetRotation(Frame& f, double c, double s)
+		{
+			const int b = (static_cast<int>(A) + 1) % 3;
+			const int d = (static_cast<int>(A) + 2) % 3;
+			f.R[b][b] = c;
+			f.R[d][b] = s;
+			f.R[b][d] = -s;
+			f.R[d][d] = c;
+		}
+
+		template <Axis A>
+		KINEMATIC_CHAIN_INLINE void Offset(Frame&, const KinematicsConfig::LinkLengthsMm&, std::integral_constant<LinkId, LinkId::None>)
+		{
+		}
+
+		template <Axis A, LinkId K>
+		KINEMATIC_CHAIN_INLINE void Offset(Frame& f, const KinematicsConfig::LinkLengthsMm& L, std::integral_constant<LinkId, K> link)
+		{
+			Translate<A>(f, LinkLength(L, link));
+		}
+
+		template <class J>
+		KINEMATIC_CHAIN_INLINE void Move(Frame& f, double q, std::integral_constant<JointType, JointType::Revolute>, std::false_type)
+		{
+			Rotate<J::kAxis>(f, std::cos(q), J::kDir * std::sin(q));
+		}
+
+		template <class J>
+		KINEMATIC_CHAIN_INLINE void Move(Frame& f, double q, std::integral_constant<JointType, JointType::Revolute>, std::true_type)
+		{
+			SetRotation<J::kAxis>(f, std::cos(q), J::kDir * std::sin(q));
+		}
+
+		template <class J, class First>
+		KINEMATIC_CHAIN_INLINE void Move(Frame& f, double q, std::integral_constant<JointType, JointType::Prismatic>, First)
+		{
+			Translate<J::kAxis>(f, J::kDir * q);
+		}
+
+		// 关节 I 的一步：前一坐标系 -> 关节运动之后的坐标系（I = 0 时 f 为单位阵）
+		template <class C, int I>
+		KINEMATIC_CHAIN_INLINE void Advance(Frame& f, const KinematicsConfig::LinkLengthsMm& L, double q)
+		{
+			using J = typename C::template JointAt<I>;
+			Offset<J::kOffsetAxis>(f, L, std::integral_constant<LinkId, J::kOffset>());
+			Move<J>(f, q, std::integral_constant<JointType, J::kType>(), std::integral_constant<bool, I == 0>());
+		}
+
+		// 关节 J 的雅可比列：a = 运动轴（Base 系，含 Dir），o = 关节原点，pe = 法兰原点
+		template <class J, class Jac>
+		KINEMATIC_CHAIN_INLINE void JacobianColumn(Jac& out, int col, const double* a, const double* o, const double* pe,
+		                           std::integral_constant<JointType, JointType::Revolute>)
+		{
+			const double dx = pe[0] - o[0];
+			const double dy = pe[1] - o[1];
+			const double dz = pe[2] - o[2];
+			out[0][col] = a[1] * dz - a[2] * dy;
+			out[1][col] = a[2] * dx - a[0] * dz;
+			out[2][col] = a[0] * dy - a[1] * dx;
+			out[3][col] = a[0];
+			out[4][col] = a[1];
+			out[5][col] = a[2];
+		}
+
+		template <class J, class Jac>
+		KINEMATIC_CHAIN_INLINE void JacobianColumn(Jac& out, int col, const double* a, const double*, const double*,
+		                           std::integral_constant<JointType, JointType::Prismatic>)
+		{
+			out[0][col] = a[0];
+			out[1][col] = a[1];
+			out[2][col] = a[2];
+			out[3][col] = 0.0;
+			out[4][col] = 0.0;
+			out[5][col] = 0.0;
+		}
+
+		// N x N 对称正定 A x = b（Cholesky，A 只用下三角）；主元不正时返回 false
+		template <int N>
+		inline bool CholeskySolve(double (&A)[N][N], const double (&b)[N], double (&x)[N])
+		{
+			for (int i = 0; i < N; i++)
+			{
+				for (int k = 0; k <= i; k++)
+				{
+					double s = A[i][k];
+					for (int c = 0; c < k; c++) s -= A[i][c] * A[k][c];
+					if (i == k)
+					{
+						if (!(s > 1e-12)) return false;
+						A[i][i] = std::sqrt(s);
+					}
+					else
+					{
+						A[i][k] = s / A[k][k];
+					}
+				}
+			}
+			double z[N];
+			for (int i = 0; i < N; i++)
+			{
+				double s = b[i];
+				for (int c = 0; c < i; c++) s -= A[i][c] * z[c];
+				z[i] = s / A[i][i];
+			}
+			for (int i = N - 1; i >= 0; i--)
+			{
+				double s = z[i];
+				for (int c = i + 1; c < N; c++) s -= A[c][i] * x[c];
+				x[i] = s / A[i][i];
+			}
+			return true;
+		}
+	}
+
+	// 按关节展开：fn(std::integral_constant<int, I>) 依次以 I = 0..kDof-1 调用（编译期下标）
+	template <class C, class Fn>
+	KINEMATIC_CHAIN_INLINE void ForEachJoint(Fn&& fn)
+	{
+		detail::Unroll<0, C::kDof>::Run(fn);
+	}
+
+	// 舵机轴向符号（运行期下标 0..kDof-1）
+	template <class C>
+	inline int ServoSign(int i)
+	{
+		int sign = 1;
+		ForEachJoint<C>([&](auto idx)
+		{
+			if (decltype(idx)::value == i) sign = C::template JointAt<decltype(idx)::value>::kServoSign;
+		});
+		return sign;
+	}
+
+	// 各关节坐标系（关节运动之后），out[kDof-1] 即法兰；out 指向 kDof 个连续的 Frame（可直接写进调用方的数组）
+	template <class C>
+	KINEMATIC_CHAIN_INLINE void ForwardFrames(const KinematicsConfig::LinkLengthsMm& L, const typename C::Q& q, Frame* out)
+	{
+		Frame f;
+		ForEachJoint<C>([&](auto idx)
+		{
+			constexpr int I = decltype(idx)::value;
+			detail::Advance<C, I>(f, L, q[I]);
+			out[I] = f;
+		});
+	}
+
+	template <class C>
+	inline void ForwardFrames(const KinematicsConfig::LinkLengthsMm& L, const typename C::Q& q, typename C::Frames& out)
+	{
+		ForwardFrames<C>(L, q, out.data());
+	}
+
+	// 法兰位姿
+	template <class C>
+	KINEMATIC_CHAIN_INLINE Frame Forward(const KinematicsConfig::LinkLengthsMm& L, const typename C::Q& q)
+	{
+		Frame f;
+		ForEachJoint<C>([&](auto idx)
+		{
+			constexpr int I = decltype(idx)::value;
+			detail::Advance<C, I>(f, L, q[I]);
+		});
+		return f;
+	}
+
+	// 几何雅可比（Base 系，见 Chain::Jacobian），pFlange 非空时顺带给出法兰位姿
+	template <class C>
+	inline void ComputeJacobian(const KinematicsConfig::LinkLengthsMm& L, const typename C::Q& q,
+	                            typename C::Jacobian& out, Frame* pFlange = nullptr)
+	{
+		double axis[C::kDof][3];
+		double origin[C::kDof][3];
+		Frame f;
+		ForEachJoint<C>([&](auto idx)
+		{
+			constexpr int I = decltype(idx)::value;
+			using J = typename C::template JointAt<I>;
+			detail::Advance<C, I>(f, L, q[I]);
+			// 运动轴在自身运动后不变；原点取运动后的（移动关节只用轴向）
+			const int a = static_cast<int>(J::kAxis);
+			for (int r = 0; r < 3; r++)
+			{
+				axis[I][r] = J::kDir * f.R[r][a];
+				origin[I][r] = f.p[r];
+			}
+		});
+		ForEachJoint<C>([&](auto idx)
+		{
+			constexpr int I = decltype(idx)::value;
+			using J = typename C::template JointAt<I>;
+			detail::JacobianColumn<J>(out, I, axis[I], origin[I], f.p, std::integral_constant<JointType, J::kType>());
+		});
+		if (pFlange) *pFlange = f;
+	}
+
+	// ---- 舵机换算（joints 指向 kDof 个连续的已编译关节；5 关节臂用 JointsOf(calib)）----
+	inline const KinematicsCalib::Joint* JointsOf(const KinematicsCalib& calib)
+	{
+		return &calib.GetJoint(1);
+	}
+
+	// 关节量 -> 舵机位置；任一关节未标定时返回 false（其余关节照常换算）
+	template <class C>
+	inline bool ToServo(const KinematicsCalib::Joint* joints, const typename C::Q& q, typename C::ServoPos& out)
+	{
+		bool ok = true;
+		for (int i = 0; i < C::kDof; i++)
+		{
+			ok = KinematicsCalib::JointRadToPos(joints[i], q[i], out[i]) && ok;
+		}
+		return ok;
+	}
+
+	template <class C>
+	inline bool FromServo(const KinematicsCalib::Joint* joints, const typename C::ServoPos& pos, typename C::Q& out)
+	{
+		bool ok = true;
+		for (int i = 0; i < C::kDof; i++)
+		{
+			ok = KinematicsCalib::JointServoPosToRad(joints[i], pos[i], out[i]) && ok;
+		}
+		return ok;
+	}
+
+	template <class C>
+	inline bool WithinLimits(const KinematicsCalib::Joint* joints, const typename C::Q& q, double tol = 1e-6)
+	{
+		for (int i = 0; i < C::kDof; i++)
+		{
+			const auto& j = joints[i];
+			if (j.hasLimit && (q[i] < j.minRad - tol || q[i] > j.maxRad + tol)) return false;
+		}
+		return true;
+	}
+
+	// ---- DLS 迭代 IK（任意拓扑；5 关节臂在线路径仍用 ArmKinematics 的闭式解）----
+	// 误差：位置 pt - p，姿态 ½ Σ x_k × xt_k（小角度下即旋转向量）；姿态行乘 rotWeightMm 折算成 mm（同 DlsParams::pitchWeightMm）。
+	// 每步 dq = Jᵀ (J Jᵀ + λ² I)⁻¹ e，按 maxStep 整体限幅；joints 非空时每步后裁剪到软限位。
+	// 少于 6 个关节时姿态只能最小二乘逼近：目标须来自本链 FK（或 rotWeightMm = 0 只约束位置）。
+	struct IkParams
+	{
+		int maxIterations = 100;
+		double tolMm = 0.01;
+		double tolRad = 1e-4;
+		double rotWeightMm = 100.0;
+		double dampingMm = 1.0;
+		double maxStep = 0.2; // rad（移动关节 mm）
+	};
+
+	struct IkResult
+	{
+		bool ok = false;
+		int iterations = 0;
+		double posErrMm = 0.0;
+		double rotErrRad = 0.0;
+	};
+
+	template <class C>
+	inline IkResult SolveIk(const KinematicsConfig::LinkLengthsMm& L,
+	                        const Frame& target,
+	                        typename C::Q& q,
+	                        const IkParams& params,
+	                        const KinematicsCalib::Joint* joints = nullptr)
+	{
+		IkResult res;
+		const double wr = params.rotWeightMm;
+		for (int it = 0; ; it++)
+		{
+			typename C::Jacobian J;
+			Frame f;
+			ComputeJacobian<C>(L, q, J, &f);
+
+			double e[6];
+			for (int r = 0; r < 3; r++) e[r] = target.p[r] - f.p[r];
+			double w[3] = {};
+			for (int k = 0; k < 3; k++)
+			{
+				const double ax = f.R[0][k], ay = f.R[1][k], az = f.R[2][k];
+				const double bx = target.R[0][k], by = target.R[1][k], bz = target.R[2][k];
+				w[0] += 0.5 * (ay * bz - az * by);
+				w[1] += 0.5 * (az * bx - ax * bz);
+				w[2] += 0.5 * (ax * by - ay * bx);
+			}
+			res.iterations = it;
+			res.posErrMm = std::sqrt(e[0] * e[0] + e[1] * e[1] + e[2] * e[2]);
+			res.rotErrRad = (wr > 0.0) ? std::asin(std::min(1.0, std::sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]))) : 0.0;
+			if (res.posErrMm <= params.tolMm && res.rotErrRad <= params.tolRad)
+			{
+				res.ok = true;
+				return res;
+			}
+			if (it >= params.maxIterations) return res;
+
+			for (int r = 0; r < 3; r++)
+			{
+				e[3 + r] = w[r] * wr;
+				for (int c = 0; c < C::kDof; c++) J[3 + r][c] *= wr;
+			}
+
+			double A[6][6];
+			for (int i = 0; i < 6; i++)
+			{
+				for (int k = 0; k <= i; k++)
+				{
+					double s = 0.0;
+					for (int c = 0; c < C::kDof; c++) s += J[i][c] * J[k][c];
+					A[i][k] = s;
+				}
+				A[i][i] += params.dampingMm * params.dampingMm;
+			}
+			double y[6];
+			if (!detail::CholeskySolve<6>(A, e, y)) return res;
+
+			double dq[C::kDof];
+			double maxAbs = 0.0;
+			for (int c = 0; c < C::kDof; c++)
+			{
+				double s = 0.0;
+				for (int r = 0; r < 6; r++) s += J[r][c] * y[r];
+				dq[c] = s;
+				maxAbs = std::max(maxAbs, std::fabs(s));
+			}
+			const double scale = (maxAbs > params.maxStep) ? params.maxStep / maxAbs : 1.0;
+			for (int c = 0; c < C::kDof; c++)
+			{
+				q[c] += dq[c] * scale;
+				if (joints && joints[c].hasLimit)
+				{
+					q[c] = std::min(std::max(q[c], joints[c].minRad), joints[c].maxRad);
+				}
+			}
+		}
+	}
+}
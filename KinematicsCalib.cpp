@@ -0,0 +1,174 @@
+#include "pch.h"
+
+#include "KinematicsCalib.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	constexpr double kPi = 3.14159265358979323846;
+	constexpr double kEps = 1e-9;
+
+	// FNV-1a 64：对标定输入逐字段哈希（double 按位参与，足以区分任何一次手动修改）
+	class Fnv64
+	{
+	public:
+		void AddBytes(const void* p, size_t n)
+		{
+			const unsigned char* b = static_cast<const unsigned char*>(p);
+			for (size_t i = 0; i < n; i++)
+			{
+				m_h ^= b[i];
+				m_h *= 1099511628211ULL;
+			}
+		}
+		void Add(double v)
+		{
+			if (v == 0.0) v = 0.0; // -0.0 与 +0.0 视为相同
+			uint64_t bits = 0;
+			std::memcpy(&bits, &v, sizeof(bits));
+			AddBytes(&bits, sizeof(bits));
+		}
+		void Add(int v) { AddBytes(&v, sizeof(v)); }
+		uint64_t Value() const { return m_h; }
+
+	private:
+		uint64_t m_h = 1469598103934665603ULL;
+	};
+}
+
+KinematicsCalib::Joint KinematicsCalib::CompileJoint(const KinematicsConfig& kc, const MotionConfig* pMc, int nJoint)
+{
+	Joint j;
+	if (nJoint < 1 || nJoint > kJointCount) return j;
+
+	const auto& c = kc.GetJoint(nJoint);
+	if (c.plusDeg == 0) return j;
+	const double posPerDeg = static_cast<double>(c.posAtPlusDeg - c.posAt0Deg) / static_cast<double>(c.plusDeg);
+	if (std::fabs(posPerDeg) < kEps) return j;
+
+	// 轴向符号 +（可选）MotionConfig::invert 叠加修正
+	int sign = KinematicsConfig::AxisSignForJoint(nJoint);
+	if (pMc && pMc->Get(nJoint).invert) sign = -sign;
+
+	// pos = posAt0 + (deg(q)*sign + zeroOffset) * posPerDeg
+	j.valid = true;
+	j.posOffset = static_cast<double>(c.posAt0Deg) + c.zeroOffsetDeg * posPerDeg;
+	j.posPerRad = posPerDeg * (180.0 / kPi) * static_cast<double>(sign);
+	j.radPerPos = 1.0 / j.posPerRad;
+
+	if (pMc)
+	{
+		const auto& jc = pMc->Get(nJoint);
+		j.servoId = jc.servoId;
+
+		// min/max 都为 0 视为“未配置限位”（与 IK 旧逻辑一致）
+		if (!(jc.minPos == 0 && jc.maxPos == 0))
+		{
+			double rMin = 0.0, rMax = 0.0;
+			JointServoPosToRad(j, jc.minPos, rMin);
+			JointServoPosToRad(j, jc.maxPos, rMax);
+			// pos->rad 可能单调递减（posPerDeg 为负），因此要做 min/max 交换
+			if (rMin > rMax) std::swap(rMin, rMax);
+			j.hasLimit = true;
+			j.minRad = rMin;
+			j.maxRad = rMax;
+		}
+	}
+	return j;
+}
+
+KinematicsCalib KinematicsCalib::Compile(const KinematicsConfig& kc, const MotionConfig* pMc)
+{
+	KinematicsCalib out;
+	out.m_links = kc.Links();
+	out.m_hasMc = (pMc != nullptr);
+	for (int n = 1; n <= kJointCount; n++)
+	{
+		out.m_joints[n] = CompileJoint(kc, pMc, n);
+	}
+
+	// 相机外参：旋转向量 -> 矩阵（Rodrigues）；无标定结果时用名义安装
+	const auto& cam = kc.Camera();
+	out.m_camera.valid = cam.valid;
+	if (cam.valid)
+	{
+		const double* w = cam.rotVec;
+		const double th = std::sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+		const double k[3] = { th > kEps ? w[0] / th : 0.0, th > kEps ? w[1] / th : 0.0, th > kEps ? w[2] / th : 0.0 };
+		const double c = std::cos(th), s = std::sin(th), v = 1.0 - c;
+		auto& R = out.m_camera.R;
+		R[0][0] = c + k[0] * k[0] * v;        R[0][1] = k[0] * k[1] * v - k[2] * s; R[0][2] = k[0] * k[2] * v + k[1] * s;
+		R[1][0] = k[1] * k[0] * v + k[2] * s; R[1][1] = c + k[1] * k[1] * v;        R[1][2] = k[1] * k[2] * v - k[0] * s;
+		R[2][0] = k[2] * k[0] * v - k[1] * s; R[2][1] = k[2] * k[1] * v + k[0] * s; R[2][2] = c + k[2] * k[2] * v;
+		for (int i = 0; i < 3; i++) out.m_camera.p[i] = cam.transMm[i];
+	}
+	else
+	{
+		// 名义安装：光学系 (x, y, z) = (法兰 x, -法兰 z, 法兰 y)，光心在顶面上方 L_cam
+		auto& R = out.m_camera.R;
+		R[0][0] = 1.0; R[0][1] = 0.0;  R[0][2] = 0.0;
+		R[1][0] = 0.0; R[1][1] = 0.0;  R[1][2] = 1.0;
+		R[2][0] = 0.0; R[2][1] = -1.0; R[2][2] = 0.0;
+		out.m_camera.p[0] = 0.0;
+		out.m_camera.p[1] = 0.0;
+		out.m_camera.p[2] = out.m_links.L_cam;
+	}
+
+	out.m_armFingerprint = ArmFingerprint(kc, pMc);
+	out.m_fingerprint = Fingerprint(kc, pMc);
+	out.m_compiled = true;
+	return out;
+}
+
+uint64_t KinematicsCalib::ArmFingerprint(const KinematicsConfig& kc, const MotionConfig* pMc)
+{
+	Fnv64 h;
+	const auto& L = kc.Links();
+	h.Add(L.L_base);
+	h.Add(L.L_arm1);
+	h.Add(L.L_arm2);
+	h.Add(L.L_wrist);
+	h.Add(L.L_cam);
+	for (int n = 1; n <= kJointCount; n++)
+	{
+		const auto& c = kc.GetJoint(n);
+		h.Add(c.posAt0Deg);
+		h.Add(c.posAtPlusDeg);
+		h.Add(c.plusDeg);
+		h.Add(c.zeroOffsetDeg);
+	}
+	h.Add(pMc ? 1 : 0);
+	if (pMc)
+	{
+		for (int n = 1; n <= kJointCount; n++)
+		{
+			const auto& jc = pMc->Get(n);
+			h.Add(jc.servoId);
+			h.Add(jc.minPos);
+			h.Add(jc.maxPos);
+			h.Add(jc.invert ? 1 : 0);
+		}
+	}
+	return h.Value();
+}
+
+uint64_t KinematicsCalib::Fingerprint(const KinematicsConfig& kc, const MotionConfig* pMc)
+{
+	Fnv64 h;
+	const uint64_t arm = ArmFingerprint(kc, pMc);
+	h.AddBytes(&arm, sizeof(arm));
+	const auto& cam = kc.Camera();
+	h.Add(cam.valid ? 1 : 0);
+	if (cam.valid)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			h.Add(cam.rotVec[i]);
+			h.Add(cam.transMm[i]);
+		}
+	}
+	return h.Value();
+}
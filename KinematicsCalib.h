@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "KinematicsConfig.h"
+#include "MotionConfig.h"
+
+// KinematicsCalib：由 KinematicsConfig + MotionConfig “编译”得到的只读标定表（运动学热路径专用）
+// - 配置变化时重新 Compile；换算系数与弧度软限位预先算好，角度/舵机换算只做乘加，IK 判限位不再反解舵机位置。
+//
+// 每关节的线性模型（轴向符号、invert、零位偏置已全部折叠进系数）：
+//   pos = posOffset + q * posPerRad
+//   q   = (pos - posOffset) * radPerPos
+class KinematicsCalib
+{
+public:
+	static constexpr int kJointCount = KinematicsConfig::kJointCount; // 5
+
+	struct Joint
+	{
+		bool valid = false;      // 两点标定有效（plusDeg != 0 且斜率非 0）
+		double posOffset = 0.0;  // q=0 时对应的舵机位置（含零位偏置）
+		double posPerRad = 0.0;  // 含轴向符号与 invert
+		double radPerPos = 0.0;  // posPerRad 的倒数
+
+		// 软限位（来自 MotionConfig 的 min/max，已换算成弧度且保证 minRad <= maxRad）
+		bool hasLimit = false;
+		double minRad = 0.0;
+		double maxRad = 0.0;
+
+		// MotionConfig 中绑定的 ServoId（无 MotionConfig 时为 0）
+		int servoId = 0;
+	};
+
+	// 相机安装外参（旋转向量已展开为矩阵）：相机系 -> 法兰系，R 的三列为相机 x/y/z 轴在法兰系中的方向，p 为光心。
+	// 配置中没有手眼标定结果（valid=false）时这里填名义安装（顶面上方 L_cam，光轴沿法兰 y），FK 统一按 R/p 计算。
+	struct CameraMount
+	{
+		bool valid = false; // true = 来自手眼标定
+		double R[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+		double p[3] = {};
+	};
+
+public:
+	KinematicsCalib() = default;
+
+	// 编译：mc 可为空（为空时不做限位、不检查 ServoId，与旧接口语义一致）
+	static KinematicsCalib Compile(const KinematicsConfig& kc, const MotionConfig* pMc);
+
+	// 单关节编译（旧的逐关节换算接口用它，避免为一次换算编译整张表）
+	static Joint CompileJoint(const KinematicsConfig& kc, const MotionConfig* pMc, int nJoint);
+
+	// 标定输入指纹（连杆长度、两点标定、零位偏置、相机外参、invert、min/max、ServoId）。
+	// 用到相机外参的上层缓存（视觉伺服的相机姿态等）用它判断是否需要重建。
+	static uint64_t Fingerprint(const KinematicsConfig& kc, const MotionConfig* pMc);
+	// 同上但不含相机外参：只依赖机械臂本身的缓存（可达性图、灵活度图、IK 缓存）用它，手眼重标定不会让它们失效。
+	static uint64_t ArmFingerprint(const KinematicsConfig& kc, const MotionConfig* pMc);
+
+	bool IsStale(const KinematicsConfig& kc, const MotionConfig* pMc) const
+	{
+		return !m_compiled || Fingerprint(kc, pMc) != m_fingerprint;
+	}
+
+	bool IsCompiled() const { return m_compiled; }
+	uint64_t GetFingerprint() const { return m_fingerprint; }
+	uint64_t GetArmFingerprint() const { return m_armFingerprint; }
+	bool HasMotionConfig() const { return m_hasMc; }
+
+	const KinematicsConfig::LinkLengthsMm& Links() const { return m_links; }
+	const Joint& GetJoint(int nJoint) const { return m_joints[nJoint]; } // 1..5
+	const CameraMount& Camera() const { return m_camera; }
+
+	// 舵机位置 -> 关节角（弧度）
+	bool ServoPosToJointRad(int nJoint, int pos, double& outQRad) const
+	{
+		if (nJoint < 1 || nJoint > kJointCount) return false;
+		return JointServoPosToRad(m_joints[nJoint], pos, outQRad);
+	}
+
+	// 关节角（弧度）-> 舵机位置（四舍五入并裁剪到 0..1000；最终仍由 MotionController 做 min/max 裁剪）
+	bool JointRadToServoPos(int nJoint, double qRad, int& outPos) const
+	{
+		if (nJoint < 1 || nJoint > kJointCount) return false;
+		return JointRadToPos(m_joints[nJoint], qRad, outPos);
+	}
+
+	// 软限位判定（该关节无限位时恒为 true）
+	bool WithinLimits(int nJoint, double qRad, double tol = 1e-6) const
+	{
+		const Joint& j = m_joints[nJoint];
+		return !j.hasLimit || (qRad >= j.minRad - tol && qRad <= j.maxRad + tol);
+	}
+
+	static bool JointServoPosToRad(const Joint& j, int pos, double& outQRad)
+	{
+		if (!j.valid) return false;
+		outQRad = (static_cast<double>(pos) - j.posOffset) * j.radPerPos;
+		return true;
+	}
+
+	static bool JointRadToPos(const Joint& j, double qRad, int& outPos)
+	{
+		if (!j.valid) return false;
+		const double posF = j.posOffset + qRad * j.posPerRad;
+		// 与 std::lround 一致的“远离 0 取整”，但不走 errno/库调用
+		int pos = static_cast<int>(posF >= 0.0 ? posF + 0.5 : posF - 0.5);
+		if (pos < 0) pos = 0;
+		if (pos > 1000) pos = 1000;
+		outPos = pos;
+		return true;
+	}
+
+private:
+	KinematicsConfig::LinkLengthsMm m_links{};
+	std::array<Joint, kJointCount + 1> m_joints{}; // 0 unused
+	CameraMount m_camera{};
+	bool m_hasMc = false;
+	bool m_compiled = false;
+	uint64_t m_fingerprint = 0;
+	uint64_t m_armFingerprint = 0;
+};
@@ -0,0 +1,513 @@
+#include "pch.h"
+
+#include "KinematicsCalibSolver.h"
+
+#include "ArmKinematics.h"
+#include "KinematicsCalib.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	constexpr double kPi = 3.14159265358979323846;
+	constexpr double kDegToRad = kPi / 180.0;
+	constexpr int kP = KinematicsCalibSolver::kParamCount;
+	constexpr int kJ = KinematicsCalibSolver::kFitJoints;
+
+	// 每块样本数：块内串行累加，块间并行；块数与线程数无关，保证归约顺序固定
+	constexpr size_t kChunk = 256;
+
+	// 关节换算常量（来自初值配置，拟合过程中不变）
+	struct JointModel
+	{
+		double posAt0 = 0.0;
+		double degPerPos = 0.0; // 1 / posPerDeg
+		double sign = 1.0;
+	};
+
+	// 法方程累加器（只用到 A 的上三角）
+	struct Accum
+	{
+		double A[kP][kP];
+		double g[kP];
+		double cost;
+		double sumSq;
+		size_t residuals;
+
+		void Clear()
+		{
+			for (int i = 0; i < kP; i++)
+			{
+				g[i] = 0.0;
+				for (int k = 0; k < kP; k++) A[i][k] = 0.0;
+			}
+			cost = 0.0;
+			sumSq = 0.0;
+			residuals = 0;
+		}
+	};
+
+	struct Problem
+	{
+		const std::vector<KinematicsCalibSolver::Sample>* samples = nullptr;
+		JointModel joints[kJ + 1];
+		double pitchWeight = 100.0;
+		double huber = 0.0;
+	};
+
+	// 单样本残差与雅可比（行数 3 或 4）。x：参数向量。
+	int Residual(const Problem& pr, const KinematicsCalibSolver::Sample& s, const double* x, double r[4], double J[4][kP])
+	{
+		double q[kJ + 1] = {};
+		double dqdZero[kJ + 1] = {};
+		double dqdScale[kJ + 1] = {};
+		for (int j = 1; j <= kJ; j++)
+		{
+			const JointModel& m = pr.joints[j];
+			const double u = (static_cast<double>(s.servoPos[j]) - m.posAt0) * m.degPerPos;
+			const double scale = x[KinematicsCalibSolver::kScale1 + j - 1];
+			const double zero = x[KinematicsCalibSolver::kZero1 + j - 1];
+			q[j] = m.sign * (scale * u - zero) * kDegToRad;
+			dqdZero[j] = -m.sign * kDegToRad;
+			dqdScale[j] = m.sign * u * kDegToRad;
+		}
+
+		const double Lb = x[KinematicsCalibSolver::kLBase];
+		const double L1 = x[KinematicsCalibSolver::kLArm1];
+		const double L2 = x[KinematicsCalibSolver::kLArm2];
+		const double Lw = x[KinematicsCalibSolver::kLWrist];
+		const double a2 = q[2];
+		const double a23 = q[2] + q[3];
+		const double a234 = a23 + q[4];
+		const double c2 = std::cos(a2), s2 = std::sin(a2);
+		const double c23 = std::cos(a23), s23 = std::sin(a23);
+		const double c234 = std::cos(a234), s234 = std::sin(a234);
+		const double c1 = std::cos(q[1]), s1 = std::sin(q[1]);
+
+		// 与 ArmKinematics::ForwardKinematicsLinks 相同的平面链
+		const double rad = L1 * c2 + L2 * c23 + Lw * c234;
+		const double z = Lb + L1 * s2 + L2 * s23 + Lw * s234;
+		r[0] = rad * s1 - s.x_mm;
+		r[1] = rad * c1 - s.y_mm;
+		r[2] = z - s.z_mm;
+
+		// 对关节角的偏导：dr/dq, dz/dq（q2 影响后面所有连杆，q3 影响小臂+腕，q4 只影响腕）
+		const double drdq[kJ + 1] = { 0.0, 0.0, -(L1 * s2 + L2 * s23 + Lw * s234), -(L2 * s23 + Lw * s234), -Lw * s234 };
+		const double dzdq[kJ + 1] = { 0.0, 0.0, L1 * c2 + L2 * c23 + Lw * c234, L2 * c23 + Lw * c234, Lw * c234 };
+
+		const int rows = s.hasPitch ? 4 : 3;
+		for (int i = 0; i < rows; i++)
+		{
+			for (int k = 0; k < kP; k++) J[i][k] = 0.0;
+		}
+
+		auto addJoint = [&](int j, int col, double dq)
+		{
+			if (j == 1)
+			{
+				J[0][col] += rad * c1 * dq;
+				J[1][col] += -rad * s1 * dq;
+				return;
+			}
+			J[0][col] += drdq[j] * s1 * dq;
+			J[1][col] += drdq[j] * c1 * dq;
+			J[2][col] += dzdq[j] * dq;
+			if (rows == 4) J[3][col] += pr.pitchWeight * dq;
+		};
+		for (int j = 1; j <= kJ; j++)
+		{
+			addJoint(j, KinematicsCalibSolver::kZero1 + j - 1, dqdZero[j]);
+			addJoint(j, KinematicsCalibSolver::kScale1 + j - 1, dqdScale[j]);
+		}
+
+		J[2][KinematicsCalibSolver::kLBase] = 1.0;
+		J[0][KinematicsCalibSolver::kLArm1] = c2 * s1;
+		J[1][KinematicsCalibSolver::kLArm1] = c2 * c1;
+		J[2][KinematicsCalibSolver::kLArm1] = s2;
+		J[0][KinematicsCalibSolver::kLArm2] = c23 * s1;
+		J[1][KinematicsCalibSolver::kLArm2] = c23 * c1;
+		J[2][KinematicsCalibSolver::kLArm2] = s23;
+		J[0][KinematicsCalibSolver::kLWrist] = c234 * s1;
+		J[1][KinematicsCalibSolver::kLWrist] = c234 * c1;
+		J[2][KinematicsCalibSolver::kLWrist] = s234;
+
+		if (rows == 4)
+		{
+			r[3] = pr.pitchWeight * (a234 - s.pitch_deg * kDegToRad);
+		}
+		return rows;
+	}
+
+	// 按块并行累加 JᵀWJ、JᵀWr 与代价（Huber 时为鲁棒代价）
+	void Accumulate(const Problem& pr, const double* x, unsigned threads, std::vector<Accum>& chunks, Accum& total)
+	{
+		const auto& samples = *pr.samples;
+		const size_t chunkCount = (samples.size() + kChunk - 1) / kChunk;
+		chunks.resize(chunkCount);
+		ParallelFor(chunkCount, [&](size_t c)
+		{
+			Accum& acc = chunks[c];
+			acc.Clear();
+			const size_t end = std::min(samples.size(), (c + 1) * kChunk);
+			double r[4];
+			double J[4][kP];
+			for (size_t i = c * kChunk; i < end; i++)
+			{
+				const int rows = Residual(pr, samples[i], x, r, J);
+				double n2 = 0.0;
+				for (int k = 0; k < rows; k++) n2 += r[k] * r[k];
+				const double n = std::sqrt(n2);
+
+				// Huber：|r| <= δ 为二次，之外线性（IRLS 权重 δ/|r|）
+				double w = 1.0;
+				double rho = 0.5 * n2;
+				if (pr.huber > 0.0 && n > pr.huber)
+				{
+					w = pr.huber / n;
+					rho = pr.huber * (n - 0.5 * pr.huber);
+				}
+				acc.cost += rho;
+				acc.sumSq += w * n2;
+				acc.residuals += static_cast<size_t>(rows);
+
+				for (int k = 0; k < rows; k++)
+				{
+					for (int a = 0; a < kP; a++)
+					{
+						const double ja = J[k][a];
+						if (ja == 0.0) continue;
+						acc.g[a] += w * ja * r[k];
+						for (int b = a; b < kP; b++) acc.A[a][b] += w * ja * J[k][b];
+					}
+				}
+			}
+		}, threads);
+
+		total.Clear();
+		for (const Accum& acc : chunks)
+		{
+			for (int a = 0; a < kP; a++)
+			{
+				total.g[a] += acc.g[a];
+				for (int b = a; b < kP; b++) total.A[a][b] += acc.A[a][b];
+			}
+			total.cost += acc.cost;
+			total.sumSq += acc.sumSq;
+			total.residuals += acc.residuals;
+		}
+		for (int a = 0; a < kP; a++)
+		{
+			for (int b = 0; b < a; b++) total.A[a][b] = total.A[b][a];
+		}
+	}
+
+	// 只计算代价（LM 试探步）
+	double Cost(const Problem& pr, const double* x, unsigned threads, std::vector<double>& chunkCost)
+	{
+		const auto& samples = *pr.samples;
+		const size_t chunkCount = (samples.size() + kChunk - 1) / kChunk;
+		chunkCost.assign(chunkCount, 0.0);
+		ParallelFor(chunkCount, [&](size_t c)
+		{
+			const size_t end = std::min(samples.size(), (c + 1) * kChunk);
+			double r[4];
+			double J[4][kP];
+			double cost = 0.0;
+			for (size_t i = c * kChunk; i < end; i++)
+			{
+				const int rows = Residual(pr, samples[i], x, r, J);
+				double n2 = 0.0;
+				for (int k = 0; k < rows; k++) n2 += r[k] * r[k];
+				const double n = std::sqrt(n2);
+				cost += (pr.huber > 0.0 && n > pr.huber) ? pr.huber * (n - 0.5 * pr.huber) : 0.5 * n2;
+			}
+			chunkCost[c] = cost;
+		}, threads);
+		double total = 0.0;
+		for (double c : chunkCost) total += c;
+		return total;
+	}
+
+	// 对称正定 n×n（行主序，步长 kP）就地 Cholesky；失败返回 false
+	bool Cholesky(double (&M)[kP][kP], int n)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			for (int k = 0; k <= i; k++)
+			{
+				double sum = M[i][k];
+				for (int t = 0; t < k; t++) sum -= M[i][t] * M[k][t];
+				if (i == k)
+				{
+					if (sum <= 0.0) return false;
+					M[i][i] = std::sqrt(sum);
+				}
+				else
+				{
+					M[i][k] = sum / M[k][k];
+				}
+			}
+		}
+		return true;
+	}
+
+	void CholeskySolve(const double (&L)[kP][kP], int n, double* b)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			double sum = b[i];
+			for (int t = 0; t < i; t++) sum -= L[i][t] * b[t];
+			b[i] = sum / L[i][i];
+		}
+		for (int i = n - 1; i >= 0; i--)
+		{
+			double sum = b[i];
+			for (int t = i + 1; t < n; t++) sum -= L[t][i] * b[t];
+			b[i] = sum / L[i][i];
+		}
+	}
+}
+
+bool KinematicsCalibSolver::Solve(const KinematicsConfig& initial,
+                                  const MotionConfig* pMc,
+                                  const std::vector<Sample>& samples,
+                                  const Params& params,
+                                  Result& out)
+{
+	out = Result();
+
+	Problem pr;
+	pr.samples = &samples;
+	pr.pitchWeight = params.pitchWeightMm;
+	pr.huber = params.huberMm;
+	for (int j = 1; j <= kJ; j++)
+	{
+		const auto& c = initial.GetJoint(j);
+		JointModel& m = pr.joints[j];
+		if (c.plusDeg == 0 || c.posAtPlusDeg == c.posAt0Deg) return false; // 两点标定无效，无法换算
+		const double posPerDeg = static_cast<double>(c.posAtPlusDeg - c.posAt0Deg) / static_cast<double>(c.plusDeg);
+		m.posAt0 = c.posAt0Deg;
+		m.degPerPos = 1.0 / posPerDeg;
+		int sign = KinematicsConfig::AxisSignForJoint(j);
+		if (pMc && pMc->Get(j).invert) sign = -sign;
+		m.sign = static_cast<double>(sign);
+	}
+
+	double x[kP] = {};
+	for (int j = 1; j <= kJ; j++)
+	{
+		x[kZero1 + j - 1] = initial.GetJoint(j).zeroOffsetDeg;
+		x[kScale1 + j - 1] = 1.0;
+	}
+	const auto& L = initial.Links();
+	x[kLBase] = L.L_base;
+	x[kLArm1] = L.L_arm1;
+	x[kLArm2] = L.L_arm2;
+	x[kLWrist] = L.L_wrist;
+
+	// 参与拟合的参数下标
+	int idx[kP];
+	int n = 0;
+	for (int p = 0; p < kP; p++)
+	{
+		if (params.fitMask & (1u << p)) idx[n++] = p;
+	}
+	if (n == 0 || samples.size() * 3 < static_cast<size_t>(n))
+	{
+		return false;
+	}
+
+	std::vector<Accum> chunks;
+	std::vector<double> chunkCost;
+	Accum acc;
+	Accumulate(pr, x, params.threads, chunks, acc);
+	out.rmsBeforeMm = EvaluateRms(initial, pMc, samples);
+
+	double lambda = -1.0;
+	for (int it = 0; it < params.maxIterations; it++)
+	{
+		out.iterations = it + 1;
+		if (lambda < 0.0)
+		{
+			double maxDiag = 0.0;
+			for (int a = 0; a < n; a++) maxDiag = std::max(maxDiag, acc.A[idx[a]][idx[a]]);
+			lambda = 1e-4 * std::max(maxDiag, 1e-12);
+		}
+
+		bool stepped = false;
+		bool tiny = false;
+		for (int tries = 0; tries < 12; tries++)
+		{
+			// (A + λ·diag(A)) δ = -g（Marquardt 缩放，各参数量纲不同也能一致收敛）
+			double M[kP][kP];
+			double d[kP];
+			for (int a = 0; a < n; a++)
+			{
+				for (int b = 0; b < n; b++) M[a][b] = acc.A[idx[a]][idx[b]];
+				M[a][a] += lambda * std::max(acc.A[idx[a]][idx[a]], 1e-12);
+				d[a] = -acc.g[idx[a]];
+			}
+			if (!Cholesky(M, n))
+			{
+				lambda *= 10.0;
+				continue;
+			}
+			CholeskySolve(M, n, d);
+
+			double xNew[kP];
+			std::copy(x, x + kP, xNew);
+			double stepNorm = 0.0;
+			double xNorm = 0.0;
+			for (int a = 0; a < n; a++)
+			{
+				xNew[idx[a]] += d[a];
+				stepNorm += d[a] * d[a];
+				xNorm += x[idx[a]] * x[idx[a]];
+			}
+			stepNorm = std::sqrt(stepNorm);
+			xNorm = std::sqrt(xNorm);
+
+			const double newCost = Cost(pr, xNew, params.threads, chunkCost);
+			if (newCost < acc.cost)
+			{
+				const double rel = (acc.cost - newCost) / std::max(acc.cost, 1e-300);
+				std::copy(xNew, xNew + kP, x);
+				lambda = std::max(lambda / 3.0, 1e-12);
+				stepped = true;
+				tiny = rel < params.tolCost || stepNorm < params.tolStep * (xNorm + params.tolStep);
+				break;
+			}
+			if (stepNorm < params.tolStep * (xNorm + params.tolStep))
+			{
+				tiny = true;
+				break;
+			}
+			lambda *= 4.0;
+		}
+
+		if (stepped)
+		{
+			Accumulate(pr, x, params.threads, chunks, acc);
+		}
+		if (tiny || !stepped)
+		{
+			out.converged = tiny;
+			break;
+		}
+	}
+
+	// 协方差：σ² (JᵀWJ)⁻¹，σ² 由加权残差平方和 / 自由度估计
+	out.residualCount = acc.residuals;
+	{
+		double M[kP][kP];
+		for (int a = 0; a < n; a++)
+		{
+			for (int b = 0; b < n; b++) M[a][b] = acc.A[idx[a]][idx[b]];
+		}
+		const double dof = static_cast<double>(acc.residuals) - n;
+		const double sigma2 = (dof > 0.0) ? acc.sumSq / dof : 0.0;
+		if (Cholesky(M, n))
+		{
+			for (int a = 0; a < n; a++)
+			{
+				double e[kP] = {};
+				e[a] = 1.0;
+				CholeskySolve(M, n, e);
+				out.stddev[idx[a]] = std::sqrt(std::max(e[a], 0.0) * sigma2);
+			}
+		}
+	}
+
+	std::copy(x, x + kP, out.value.begin());
+	out.ok = true;
+
+	// 拟合后 RMS 用连续模型评估（Apply 写回 posAtPlusDeg 时的整数舍入另由 EvaluateRms 评估）
+	{
+		double sum = 0.0;
+		double mx = 0.0;
+		double r[4];
+		double J[4][kP];
+		for (const auto& s : samples)
+		{
+			Sample posOnly = s;
+			posOnly.hasPitch = false;
+			Residual(pr, posOnly, x, r, J);
+			const double d2 = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+			sum += d2;
+			mx = std::max(mx, std::sqrt(d2));
+		}
+		out.rmsAfterMm = std::sqrt(sum / static_cast<double>(samples.size()));
+		out.maxAfterMm = mx;
+	}
+	return true;
+}
+
+void KinematicsCalibSolver::Apply(const Result& r, KinematicsConfig& kc)
+{
+	if (!r.ok) return;
+	for (int j = 1; j <= kJ; j++)
+	{
+		auto& c = kc.GetJoint(j);
+		c.zeroOffsetDeg = r.value[kZero1 + j - 1];
+		const double scale = r.value[kScale1 + j - 1];
+		if (c.plusDeg != 0 && scale > 1e-6)
+		{
+			// posPerDeg' = posPerDeg / scale
+			const double span = static_cast<double>(c.posAtPlusDeg - c.posAt0Deg) / scale;
+			c.posAtPlusDeg = c.posAt0Deg + static_cast<int>(std::lround(span));
+		}
+	}
+	auto& L = kc.Links();
+	L.L_base = r.value[kLBase];
+	L.L_arm1 = r.value[kLArm1];
+	L.L_arm2 = r.value[kLArm2];
+	L.L_wrist = r.value[kLWrist];
+}
+
+double KinematicsCalibSolver::EvaluateRms(const KinematicsConfig& kc,
+                                          const MotionConfig* pMc,
+                                          const std::vector<Sample>& samples,
+                                          double* pMax)
+{
+	const KinematicsCalib calib = KinematicsCalib::Compile(kc, pMc);
+
+	double sum = 0.0;
+	double mx = 0.0;
+	for (const auto& s : samples)
+	{
+		ArmKinematics::JointAnglesRad q;
+		for (int j = 1; j <= kJ; j++)
+		{
+			calib.ServoPosToJointRad(j, s.servoPos[j], q.q[j]);
+		}
+		const auto p = ArmKinematics::ForwardKinematics(calib, q);
+		const double d2 = (p.x_mm - s.x_mm) * (p.x_mm - s.x_mm) + (p.y_mm - s.y_mm) * (p.y_mm - s.y_mm)
+			+ (p.z_mm - s.z_mm) * (p.z_mm - s.z_mm);
+		sum += d2;
+		mx = std::max(mx, std::sqrt(d2));
+	}
+	if (pMax) *pMax = mx;
+	return samples.empty() ? 0.0 : std::sqrt(sum / static_cast<double>(samples.size()));
+}
+
+const wchar_t* KinematicsCalibSolver::ParamName(int p)
+{
+	switch (p)
+	{
+	case kZero1: return L"J1 零位偏置 (deg)";
+	case kZero2: return L"J2 零位偏置 (deg)";
+	case kZero3: return L"J3 零位偏置 (deg)";
+	case kZero4: return L"J4 零位偏置 (deg)";
+	case kScale1: return L"J1 舵机比例";
+	case kScale2: return L"J2 舵机比例";
+	case kScale3: return L"J3 舵机比例";
+	case kScale4: return L"J4 舵机比例";
+	case kLBase: return L"L_base (mm)";
+	case kLArm1: return L"L_arm1 (mm)";
+	case kLArm2: return L"L_arm2 (mm)";
+	case kLWrist: return L"L_wrist (mm)";
+	default: return L"?";
+	}
+}
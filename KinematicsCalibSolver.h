@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "KinematicsConfig.h"
+#include "MotionConfig.h"
+
+// KinematicsCalibSolver：由“舵机位置 + 实测末端位置”样本拟合运动学标定（最小二乘）
+// - 拟合参数：J1..J4 零位偏置、J1..J4 舵机比例（两点标定的斜率修正）、L_base/L_arm1/L_arm2/L_wrist。
+//
+// 模型（与 KinematicsCalib::CompileJoint 一致）：
+//   deg(q_j) * sign_j + zero_j = scale_j * (pos_j - posAt0_j) / posPerDeg_j
+//   末端 = ArmKinematics::ForwardKinematics(links, q)；样本可带俯仰（按 pitchWeightMm 折算成 mm 参与残差）。
+// 求解：Levenberg-Marquardt，解析雅可比；法方程 JᵀJ / Jᵀr 按样本分块用 ParallelFor 并行累加，
+// 分块结果按块序归约（结果与线程数无关）。可选 Huber 鲁棒核抑制视觉误检样本。
+//
+// 参数只有 12 个，法方程 12x12 手写 Cholesky，不依赖 Eigen/Ceres，headless 工具（KinematicsBench）可直接编译。
+class KinematicsCalibSolver
+{
+public:
+	static constexpr int kFitJoints = 4; // J5 不影响末端位置
+
+	enum Param : uint8_t
+	{
+		kZero1 = 0, kZero2, kZero3, kZero4,     // 零位偏置（deg）
+		kScale1, kScale2, kScale3, kScale4,     // 舵机比例（无量纲，名义值 1）
+		kLBase, kLArm1, kLArm2, kLWrist,        // 连杆长度（mm）
+		kParamCount
+	};
+
+	struct Sample
+	{
+		// 记录时的舵机位置（关节 1..5，0 不用）
+		std::array<int, KinematicsConfig::kJointCount + 1> servoPos{};
+
+		// 实测末端位置（Base 坐标系，mm）
+		double x_mm = 0.0;
+		double y_mm = 0.0;
+		double z_mm = 0.0;
+
+		// 可选：实测俯仰（deg）
+		bool hasPitch = false;
+		double pitch_deg = 0.0;
+	};
+
+	struct Params
+	{
+		// 参与拟合的参数（位掩码，bit = Param）；默认全部
+		uint32_t fitMask = (1u << kParamCount) - 1u;
+
+		int maxIterations = 50;
+
+		// 俯仰残差权重：1 rad 俯仰误差折算为多少 mm
+		double pitchWeightMm = 100.0;
+
+		// Huber 阈值（mm，按样本残差范数）；<= 0 表示普通最小二乘
+		double huberMm = 0.0;
+
+		// 收敛：相对代价下降或步长（参数空间范数）小于阈值
+		double tolCost = 1e-12;
+		double tolStep = 1e-9;
+
+		// 并行线程数（0 = 全部核心）
+		unsigned threads = 0;
+	};
+
+	struct Result
+	{
+		bool ok = false;
+		bool converged = false;
+		int iterations = 0;
+		size_t residualCount = 0;
+
+		double rmsBeforeMm = 0.0;  // 初值下的位置 RMS（每样本欧氏距离）
+		double rmsAfterMm = 0.0;   // 拟合后
+		double maxAfterMm = 0.0;
+
+		// 拟合值与 1σ 标准差（由 (JᵀJ)⁻¹ 与残差方差估计；未参与拟合的参数 stddev 为 0）
+		std::array<double, kParamCount> value{};
+		std::array<double, kParamCount> stddev{};
+	};
+
+public:
+	// initial：初值（通常是当前配置）；pMc：提供 invert（可为空）。样本少于可拟合参数数时返回 false。
+	static bool Solve(const KinematicsConfig& initial,
+	                  const MotionConfig* pMc,
+	                  const std::vector<Sample>& samples,
+	                  const Params& params,
+	                  Result& out);
+
+	// 写回配置：零位偏置、连杆长度，以及按比例修正后的 posAtPlusDeg（整数，会有舍入）。
+	static void Apply(const Result& r, KinematicsConfig& kc);
+
+	// 在给定配置下评估样本位置误差（mm）：返回 RMS，pMax 可为空
+	static double EvaluateRms(const KinematicsConfig& kc,
+	                          const MotionConfig* pMc,
+	                          const std::vector<Sample>& samples,
+	                          double* pMax = nullptr);
+
+	static const wchar_t* ParamName(int p);
+};
@@ -2,6 +2,10 @@
 
 #include "KinematicsConfig.h"
 
+#include "KinematicChain.h"
+
+// Profile 持久化依赖 MFC（AfxGetApp/CString）；无头工具（tools/）编译本文件时只保留默认参数与轴向约定。
+#ifdef _WIN32
 #include <afxwin.h>
 
 namespace
@@ -31,6 +35,7 @@ namespace
 		WriteScaledInt(sec, key, iv);
 	}
 }
+#endif
 
 KinematicsConfig::KinematicsConfig()
 {
@@ -49,6 +54,7 @@ KinematicsConfig::KinematicsConfig()
 	m_joints[5] = JointCalib{ 500, 900, 90, 0.0 };
 }
 
+#ifdef _WIN32
 std::wstring KinematicsConfig::SectionLinks()
 {
 	// 注意：使用与 MotionConfig 类似的“带反斜杠的 section”，便于 SettingsIo 导入导出统一处理。
@@ -62,6 +68,12 @@ std::wstring KinematicsConfig::SectionForJoint(int nJoint)
 	return std::wstring(s.GetString());
 }
 
+std::wstring KinematicsConfig::SectionCamera()
+{
+	return L"Kinematics\\Camera";
+}
+#endif
+
 int KinematicsConfig::AxisSignForJoint(int nJoint)
 {
 	// 与 Reference/mechanics.md 的轴向说明保持一致：
@@ -70,17 +82,12 @@ int KinematicsConfig::AxisSignForJoint(int nJoint)
 	// - J3 绕局部 X 反向（与 J2 平行但方向相反）
 	// - J4 绕局部 X 正向
 	// - J5 绕局部 Z 正向（末端绕自身轴旋转，运动学位置通常不使用）
-	switch (nJoint)
-	{
-	case 1: return +1;
-	case 2: return +1;
-	case 3: return -1;
-	case 4: return +1;
-	case 5: return +1;
-	default: return +1;
-	}
+	// 符号表在 KinematicChain::Arm5Dof（每个关节的 ServoSign），这里只做 1..5 -> 0..4 的下标换算。
+	if (nJoint < 1 || nJoint > kJointCount) return +1;
+	return KinematicChain::ServoSign<KinematicChain::Arm5Dof>(nJoint - 1);
 }
 
+#ifdef _WIN32
 void KinematicsConfig::LoadAll()
 {
 	// 1) 连杆长度（mm）：用整数保存即可，满足大多数标定精度。
@@ -109,6 +116,19 @@ void KinematicsConfig::LoadAll()
 
 		m_joints[j] = c;
 	}
+
+	// 3) 相机安装外参：旋转向量以 micro-rad、平移以 um 存储
+	{
+		const std::wstring sec = SectionCamera();
+		static const wchar_t* const kRot[3] = { L"Rx_urad", L"Ry_urad", L"Rz_urad" };
+		static const wchar_t* const kTrans[3] = { L"Tx_um", L"Ty_um", L"Tz_um" };
+		m_camera.valid = ReadScaledInt(sec, L"Valid", m_camera.valid ? 1 : 0) != 0;
+		for (int i = 0; i < 3; i++)
+		{
+			m_camera.rotVec[i] = ReadScaledDouble(sec, kRot[i], m_camera.rotVec[i], 1000000);
+			m_camera.transMm[i] = ReadScaledDouble(sec, kTrans[i], m_camera.transMm[i], 1000);
+		}
+	}
 }
 
 void KinematicsConfig::SaveAll() const
@@ -133,7 +153,18 @@ void KinematicsConfig::SaveAll() const
 		AfxGetApp()->WriteProfileInt(sec.c_str(), L"PlusDeg", c.plusDeg);
 		WriteScaledDouble(sec, L"ZeroOffset_mdeg", c.zeroOffsetDeg, 1000);
 	}
-}
-
-
 
+	// 3) 相机安装外参
+	{
+		const std::wstring sec = SectionCamera();
+		static const wchar_t* const kRot[3] = { L"Rx_urad", L"Ry_urad", L"Rz_urad" };
+		static const wchar_t* const kTrans[3] = { L"Tx_um", L"Ty_um", L"Tz_um" };
+		WriteScaledInt(sec, L"Valid", m_camera.valid ? 1 : 0);
+		for (int i = 0; i < 3; i++)
+		{
+			WriteScaledDouble(sec, kRot[i], m_camera.rotVec[i], 1000000);
+			WriteScaledDouble(sec, kTrans[i], m_camera.transMm[i], 1000);
+		}
+	}
+}
+#endif
@@ -38,6 +38,15 @@ public:
 		double zeroOffsetDeg = 0.0;
 	};
 
+	// 相机安装外参（手眼标定结果）：相机光学系在法兰系（ArmKinematics::LinkFrames::kFlange）中的位姿。
+	// valid=false 时沿用名义安装（法兰顶面上方 L_cam、光轴沿连杆方向，见 ArmKinematics::LinkFrames）。
+	struct CameraMount
+	{
+		bool valid = false;
+		double rotVec[3] = {};   // 旋转向量（轴 * 角，rad）：相机系 -> 法兰系
+		double transMm[3] = {};  // 相机光心在法兰系中的坐标（mm）
+	};
+
 	KinematicsConfig();
 
 	// 从 Profile（注册表）加载/保存
@@ -50,21 +59,27 @@ public:
 	const JointCalib& GetJoint(int nJoint) const { return m_joints[nJoint]; } // 1..5
 	JointCalib& GetJoint(int nJoint) { return m_joints[nJoint]; }
 
+	const CameraMount& Camera() const { return m_camera; }
+	CameraMount& Camera() { return m_camera; }
+
 	// 关节轴符号约定（与 mechanics.md 对齐）：
 	// - J1: +Z
 	// - J2: +X
 	// - J3: -X（反向）
 	// - J4: +X
 	// - J5: +Z
+	// 取自 KinematicChain::Arm5Dof 的 ServoSign
 	static int AxisSignForJoint(int nJoint);
 
 private:
 	static std::wstring SectionLinks();
 	static std::wstring SectionForJoint(int nJoint);
+	static std::wstring SectionCamera();
 
 private:
 	LinkLengthsMm m_links{};
 	std::array<JointCalib, kJointCount + 1> m_joints{}; // 0 unused
+	CameraMount m_camera{};
 };
 
 
@@ -43,6 +43,17 @@ void KinematicsOverlayService::UpdateVisualServo(bool enabled, bool applied, boo
 	m_s.vsWhy = why;
 }
 
+void KinematicsOverlayService::UpdateManipulability(std::shared_ptr<const ManipulabilityMap> map,
+                                                    bool valid, double manip, double invCond, double speedScale)
+{
+	std::lock_guard<std::mutex> lk(m_mu);
+	m_s.manipMap = std::move(map);
+	m_s.manipValid = valid;
+	m_s.manip = manip;
+	m_s.invCond = invCond;
+	m_s.speedScale = speedScale;
+}
+
 KinematicsOverlayService::Snapshot KinematicsOverlayService::GetSnapshot() const
 {
 	std::lock_guard<std::mutex> lk(m_mu);
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <memory>
 #include <mutex>
 #include <string>
 
 #include "ArmKinematics.h"
+#include "ManipulabilityMap.h"
 
 // KinematicsOverlayService：为“相机画面 HUD 叠加”提供线程安全的状态快照。
 // - UI/Jog 线程更新状态（目标Pose、输入、IK状态等）
@@ -34,6 +36,13 @@ public:
 		double vsErrV = 0.0;    // px
 		double vsAdvance = 0.0; // [-1,1]
 		std::wstring vsWhy;
+
+		// 灵活度（可操作度 / 逆条件数）：当前目标处的值、Jog 速度倍率，以及热图切片所用的地图（未就绪时为空）
+		std::shared_ptr<const ManipulabilityMap> manipMap;
+		bool manipValid = false;
+		double manip = 0.0;
+		double invCond = 0.0;
+		double speedScale = 1.0;
 	};
 
 	static KinematicsOverlayService& Instance();
@@ -48,6 +57,9 @@ public:
 	                      double errU, double errV, double advance,
 	                      const std::wstring& why);
 
+	void UpdateManipulability(std::shared_ptr<const ManipulabilityMap> map,
+	                          bool valid, double manip, double invCond, double speedScale);
+
 	Snapshot GetSnapshot() const;
 
 private:
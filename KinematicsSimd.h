@@ -0,0 +1,486 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+// KinematicsSimd：运动学批量计算用的极简 SIMD 抽象（double / float）
+//
+// 设计：
+// - 每个后端是一个“traits”结构体（Reg/Mask 类型 + 静态内联运算），算法核写成模板，三种后端共用一份代码；
+// - 标量后端 ScalarD 始终可用，也用于批量尾部（不足一个向量宽度的剩余元素），保证结果一致；
+// - AVX2：GCC/Clang 需 -mavx2（定义 __AVX2__）；MSVC x64 下 intrinsics 无需 /arch 即可编译，
+//   是否真正启用由调用方在运行时检测 CPU（见 ArmKinematicsBatch::BestBackend）；
+// - NEON：仅 AArch64（float64x2_t 需要 A64 指令）。
+//
+// 超越函数采用 Cephes 的多项式/有理逼近（误差 ~1e-16 量级），不依赖 SVML 等向量数学库。
+//
+// 精度档（traits 的 kFastMath 决定超越函数用哪套系数）：
+// - ScalarD / Avx2D / NeonD：double 运算 + 双精度逼近（参考结果）；
+// - FastMath<ScalarD/Avx2D/NeonD>：double 运算 + 单精度级多项式（Cephes sinf/cosf/atanf，误差 ~1e-7 rad），
+//   atan 少一次除法、sin/cos 各少 3 项；
+// - ScalarF / Avx2F / NeonF：float 运算（AVX2 8 路、NEON 4 路）+ 同一套单精度多项式。
+//   Load/Store 直接读写 double 数组（就地转换），算法核与 double 版共用一份代码。
+
+#if defined(__AVX2__) || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64)))
+#define KINEMATICS_SIMD_HAS_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define KINEMATICS_SIMD_HAS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace KinematicsSimd
+{
+	// ============================
+	// 后端：标量（参考实现）
+	// ============================
+	struct ScalarD
+	{
+		using Reg = double;
+		using Mask = bool;
+		static constexpr int kWidth = 1;
+
+		static Reg Load(const double* p) { return *p; }
+		static void Store(double* p, Reg v) { *p = v; }
+		static Reg Set1(double v) { return v; }
+
+		static Reg Add(Reg a, Reg b) { return a + b; }
+		static Reg Sub(Reg a, Reg b) { return a - b; }
+		static Reg Mul(Reg a, Reg b) { return a * b; }
+		static Reg Div(Reg a, Reg b) { return a / b; }
+		static Reg Sqrt(Reg a) { return std::sqrt(a); }
+		static Reg Min(Reg a, Reg b) { return (b < a) ? b : a; }
+		static Reg Max(Reg a, Reg b) { return (a < b) ? b : a; }
+		static Reg Abs(Reg a) { return std::fabs(a); }
+		static Reg Round(Reg a) { return std::nearbyint(a); }
+		static Reg Floor(Reg a) { return std::floor(a); }
+
+		static Mask CmpLt(Reg a, Reg b) { return a < b; }
+		static Mask CmpLe(Reg a, Reg b) { return a <= b; }
+		static Mask CmpGt(Reg a, Reg b) { return a > b; }
+		static Mask CmpEq(Reg a, Reg b) { return a == b; }
+		static Mask And(Mask a, Mask b) { return a && b; }
+		static Mask Or(Mask a, Mask b) { return a || b; }
+		static Mask Not(Mask a) { return !a; }
+		static Reg Select(Mask m, Reg a, Reg b) { return m ? a : b; }
+		static Mask SelectMask(Mask m, Mask a, Mask b) { return m ? a : b; }
+		static int MaskBits(Mask m) { return m ? 1 : 0; }
+
+		static constexpr bool kFastMath = false;
+	};
+
+	// ============================
+	// 后端：标量 float（float 各档的尾部内核）
+	// ============================
+	struct ScalarF
+	{
+		using Reg = float;
+		using Mask = bool;
+		static constexpr int kWidth = 1;
+
+		static Reg Load(const double* p) { return static_cast<float>(*p); }
+		static void Store(double* p, Reg v) { *p = v; }
+		static Reg Set1(double v) { return static_cast<float>(v); }
+
+		static Reg Add(Reg a, Reg b) { return a + b; }
+		static Reg Sub(Reg a, Reg b) { return a - b; }
+		static Reg Mul(Reg a, Reg b) { return a * b; }
+		static Reg Div(Reg a, Reg b) { return a / b; }
+		static Reg Sqrt(Reg a) { return std::sqrt(a); }
+		static Reg Min(Reg a, Reg b) { return (b < a) ? b : a; }
+		static Reg Max(Reg a, Reg b) { return (a < b) ? b : a; }
+		static Reg Abs(Reg a) { return std::fabs(a); }
+		static Reg Round(Reg a) { return std::nearbyint(a); }
+		static Reg Floor(Reg a) { return std::floor(a); }
+
+		static Mask CmpLt(Reg a, Reg b) { return a < b; }
+		static Mask CmpLe(Reg a, Reg b) { return a <= b; }
+		static Mask CmpGt(Reg a, Reg b) { return a > b; }
+		static Mask CmpEq(Reg a, Reg b) { return a == b; }
+		static Mask And(Mask a, Mask b) { return a && b; }
+		static Mask Or(Mask a, Mask b) { return a || b; }
+		static Mask Not(Mask a) { return !a; }
+		static Reg Select(Mask m, Reg a, Reg b) { return m ? a : b; }
+		static Mask SelectMask(Mask m, Mask a, Mask b) { return m ? a : b; }
+		static int MaskBits(Mask m) { return m ? 1 : 0; }
+
+		static constexpr bool kFastMath = true;
+	};
+
+	// double 运算 + 单精度级超越函数
+	template <class V>
+	struct FastMath : V
+	{
+		static constexpr bool kFastMath = true;
+	};
+
+#if defined(KINEMATICS_SIMD_HAS_AVX2)
+	// ============================
+	// 后端：AVX2（4 x double）
+	// ============================
+	struct Avx2D
+	{
+		using Reg = __m256d;
+		using Mask = __m256d;
+		static constexpr int kWidth = 4;
+
+		static Reg Load(const double* p) { return _mm256_loadu_pd(p); }
+		static void Store(double* p, Reg v) { _mm256_storeu_pd(p, v); }
+		static Reg Set1(double v) { return _mm256_set1_pd(v); }
+
+		static Reg Add(Reg a, Reg b) { return _mm256_add_pd(a, b); }
+		static Reg Sub(Reg a, Reg b) { return _mm256_sub_pd(a, b); }
+		static Reg Mul(Reg a, Reg b) { return _mm256_mul_pd(a, b); }
+		static Reg Div(Reg a, Reg b) { return _mm256_div_pd(a, b); }
+		static Reg Sqrt(Reg a) { return _mm256_sqrt_pd(a); }
+		static Reg Min(Reg a, Reg b) { return _mm256_min_pd(a, b); }
+		static Reg Max(Reg a, Reg b) { return _mm256_max_pd(a, b); }
+		static Reg Abs(Reg a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+		static Reg Round(Reg a) { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+		static Reg Floor(Reg a) { return _mm256_floor_pd(a); }
+
+		static Mask CmpLt(Reg a, Reg b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+		static Mask CmpLe(Reg a, Reg b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+		static Mask CmpGt(Reg a, Reg b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+		static Mask CmpEq(Reg a, Reg b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+		static Mask And(Mask a, Mask b) { return _mm256_and_pd(a, b); }
+		static Mask Or(Mask a, Mask b) { return _mm256_or_pd(a, b); }
+		static Mask Not(Mask a) { return _mm256_xor_pd(a, _mm256_castsi256_pd(_mm256_set1_epi64x(-1))); }
+		static Reg Select(Mask m, Reg a, Reg b) { return _mm256_blendv_pd(b, a, m); }
+		static Mask SelectMask(Mask m, Mask a, Mask b) { return _mm256_blendv_pd(b, a, m); }
+		static int MaskBits(Mask m) { return _mm256_movemask_pd(m); }
+
+		static constexpr bool kFastMath = false;
+	};
+
+	// ============================
+	// 后端：AVX2（8 x float，读写 double 数组时两次 cvtpd_ps / cvtps_pd）
+	// ============================
+	struct Avx2F
+	{
+		using Reg = __m256;
+		using Mask = __m256;
+		static constexpr int kWidth = 8;
+
+		static Reg Load(const double* p)
+		{
+			return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(_mm256_loadu_pd(p))),
+				_mm256_cvtpd_ps(_mm256_loadu_pd(p + 4)), 1);
+		}
+		static void Store(double* p, Reg v)
+		{
+			_mm256_storeu_pd(p, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+			_mm256_storeu_pd(p + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+		}
+		static Reg Set1(double v) { return _mm256_set1_ps(static_cast<float>(v)); }
+
+		static Reg Add(Reg a, Reg b) { return _mm256_add_ps(a, b); }
+		static Reg Sub(Reg a, Reg b) { return _mm256_sub_ps(a, b); }
+		static Reg Mul(Reg a, Reg b) { return _mm256_mul_ps(a, b); }
+		static Reg Div(Reg a, Reg b) { return _mm256_div_ps(a, b); }
+		static Reg Sqrt(Reg a) { return _mm256_sqrt_ps(a); }
+		static Reg Min(Reg a, Reg b) { return _mm256_min_ps(a, b); }
+		static Reg Max(Reg a, Reg b) { return _mm256_max_ps(a, b); }
+		static Reg Abs(Reg a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+		static Reg Round(Reg a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+		static Reg Floor(Reg a) { return _mm256_floor_ps(a); }
+
+		static Mask CmpLt(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		static Mask CmpLe(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+		static Mask CmpGt(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+		static Mask CmpEq(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+		static Mask And(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+		static Mask Or(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+		static Mask Not(Mask a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+		static Reg Select(Mask m, Reg a, Reg b) { return _mm256_blendv_ps(b, a, m); }
+		static Mask SelectMask(Mask m, Mask a, Mask b) { return _mm256_blendv_ps(b, a, m); }
+		static int MaskBits(Mask m) { return _mm256_movemask_ps(m); }
+
+		static constexpr bool kFastMath = true;
+	};
+#endif
+
+#if defined(KINEMATICS_SIMD_HAS_NEON)
+	// ============================
+	// 后端：NEON（2 x double，AArch64）
+	// ============================
+	struct NeonD
+	{
+		using Reg = float64x2_t;
+		using Mask = uint64x2_t;
+		static constexpr int kWidth = 2;
+
+		static Reg Load(const double* p) { return vld1q_f64(p); }
+		static void Store(double* p, Reg v) { vst1q_f64(p, v); }
+		static Reg Set1(double v) { return vdupq_n_f64(v); }
+
+		static Reg Add(Reg a, Reg b) { return vaddq_f64(a, b); }
+		static Reg Sub(Reg a, Reg b) { return vsubq_f64(a, b); }
+		static Reg Mul(Reg a, Reg b) { return vmulq_f64(a, b); }
+		static Reg Div(Reg a, Reg b) { return vdivq_f64(a, b); }
+		static Reg Sqrt(Reg a) { return vsqrtq_f64(a); }
+		static Reg Min(Reg a, Reg b) { return vminq_f64(a, b); }
+		static Reg Max(Reg a, Reg b) { return vmaxq_f64(a, b); }
+		static Reg Abs(Reg a) { return vabsq_f64(a); }
+		static Reg Round(Reg a) { return vrndnq_f64(a); }
+		static Reg Floor(Reg a) { return vrndmq_f64(a); }
+
+		static Mask CmpLt(Reg a, Reg b) { return vcltq_f64(a, b); }
+		static Mask CmpLe(Reg a, Reg b) { return vcleq_f64(a, b); }
+		static Mask CmpGt(Reg a, Reg b) { return vcgtq_f64(a, b); }
+		static Mask CmpEq(Reg a, Reg b) { return vceqq_f64(a, b); }
+		static Mask And(Mask a, Mask b) { return vandq_u64(a, b); }
+		static Mask Or(Mask a, Mask b) { return vorrq_u64(a, b); }
+		static Mask Not(Mask a) { return veorq_u64(a, vdupq_n_u64(~0ULL)); }
+		static Reg Select(Mask m, Reg a, Reg b) { return vbslq_f64(m, a, b); }
+		static Mask SelectMask(Mask m, Mask a, Mask b) { return vbslq_u64(m, a, b); }
+		static int MaskBits(Mask m)
+		{
+			return static_cast<int>((vgetq_lane_u64(m, 0) & 1ULL) | ((vgetq_lane_u64(m, 1) & 1ULL) << 1));
+		}
+
+		static constexpr bool kFastMath = false;
+	};
+
+	// ============================
+	// 后端：NEON（4 x float）
+	// ============================
+	struct NeonF
+	{
+		using Reg = float32x4_t;
+		using Mask = uint32x4_t;
+		static constexpr int kWidth = 4;
+
+		static Reg Load(const double* p)
+		{
+			return vcombine_f32(vcvt_f32_f64(vld1q_f64(p)), vcvt_f32_f64(vld1q_f64(p + 2)));
+		}
+		static void Store(double* p, Reg v)
+		{
+			vst1q_f64(p, vcvt_f64_f32(vget_low_f32(v)));
+			vst1q_f64(p + 2, vcvt_high_f64_f32(v));
+		}
+		static Reg Set1(double v) { return vdupq_n_f32(static_cast<float>(v)); }
+
+		static Reg Add(Reg a, Reg b) { return vaddq_f32(a, b); }
+		static Reg Sub(Reg a, Reg b) { return vsubq_f32(a, b); }
+		static Reg Mul(Reg a, Reg b) { return vmulq_f32(a, b); }
+		static Reg Div(Reg a, Reg b) { return vdivq_f32(a, b); }
+		static Reg Sqrt(Reg a) { return vsqrtq_f32(a); }
+		static Reg Min(Reg a, Reg b) { return vminq_f32(a, b); }
+		static Reg Max(Reg a, Reg b) { return vmaxq_f32(a, b); }
+		static Reg Abs(Reg a) { return vabsq_f32(a); }
+		static Reg Round(Reg a) { return vrndnq_f32(a); }
+		static Reg Floor(Reg a) { return vrndmq_f32(a); }
+
+		static Mask CmpLt(Reg a, Reg b) { return vcltq_f32(a, b); }
+		static Mask CmpLe(Reg a, Reg b) { return vcleq_f32(a, b); }
+		static Mask CmpGt(Reg a, Reg b) { return vcgtq_f32(a, b); }
+		static Mask CmpEq(Reg a, Reg b) { return vceqq_f32(a, b); }
+		static Mask And(Mask a, Mask b) { return vandq_u32(a, b); }
+		static Mask Or(Mask a, Mask b) { return vorrq_u32(a, b); }
+		static Mask Not(Mask a) { return vmvnq_u32(a); }
+		static Reg Select(Mask m, Reg a, Reg b) { return vbslq_f32(m, a, b); }
+		static Mask SelectMask(Mask m, Mask a, Mask b) { return vbslq_u32(m, a, b); }
+		static int MaskBits(Mask m)
+		{
+			static const int32_t kShift[4] = { 0, 1, 2, 3 };
+			const uint32x4_t bits = vshlq_u32(vandq_u32(m, vdupq_n_u32(1)), vld1q_s32(kShift));
+			return static_cast<int>(vaddvq_u32(bits));
+		}
+
+		static constexpr bool kFastMath = true;
+	};
+#endif
+
+	// ============================
+	// 模板数学核
+	// ============================
+	namespace detail
+	{
+		constexpr double kPi = 3.14159265358979323846;
+		constexpr double kPiO2 = 1.57079632679489661923;
+		constexpr double kPiO4 = 0.78539816339744830962;
+		constexpr double kMoreBits = 6.123233995736765886130E-17; // pi/2 的低位补偿（Cephes）
+
+		// Horner：c[0]*x^N + ... + c[N]
+		template <class V, int N>
+		typename V::Reg PolyEval(typename V::Reg x, const double (&c)[N + 1])
+		{
+			typename V::Reg y = V::Set1(c[0]);
+			for (int i = 1; i <= N; i++)
+			{
+				y = V::Add(V::Mul(y, x), V::Set1(c[i]));
+			}
+			return y;
+		}
+
+		// 首项系数为 1 的 Horner：x^N + c[0]*x^(N-1) + ... + c[N-1]
+		template <class V, int N>
+		typename V::Reg Poly1Eval(typename V::Reg x, const double (&c)[N])
+		{
+			typename V::Reg y = V::Add(x, V::Set1(c[0]));
+			for (int i = 1; i < N; i++)
+			{
+				y = V::Add(V::Mul(y, x), V::Set1(c[i]));
+			}
+			return y;
+		}
+
+		using ExactTag = std::false_type;
+		using FastTag = std::true_type;
+
+		template <class V>
+		using MathTag = std::integral_constant<bool, V::kFastMath>;
+	}
+
+	namespace detail
+	{
+		// Cephes atan：t>0.66 时用 (t-1)/(t+1) 归约到 pi/4 附近，再用 4/5 阶有理逼近
+		template <class V>
+		typename V::Reg AtanUnit(typename V::Reg t, ExactTag)
+		{
+			static const double P[5] = {
+				-8.750608600031904122785E-1, -1.615753718733365076637E1, -7.500855792314704667340E1,
+				-1.228866684490136173410E2, -6.485021904942025371773E1 };
+			static const double Q[5] = {
+				2.485846490142306297962E1, 1.650270098316988542046E2, 4.328810604912902668951E2,
+				4.853903996359136964868E2, 1.945506571482613964425E2 };
+
+			const typename V::Mask big = V::CmpGt(t, V::Set1(0.66));
+			const typename V::Reg one = V::Set1(1.0);
+			const typename V::Reg x = V::Select(big, V::Div(V::Sub(t, one), V::Add(t, one)), t);
+			const typename V::Reg base = V::Select(big, V::Set1(kPiO4), V::Set1(0.0));
+			const typename V::Reg extra = V::Select(big, V::Set1(0.5 * kMoreBits), V::Set1(0.0));
+
+			const typename V::Reg z = V::Mul(x, x);
+			const typename V::Reg r = V::Div(V::Mul(z, PolyEval<V, 4>(z, P)), Poly1Eval<V, 5>(z, Q));
+			const typename V::Reg a = V::Add(V::Mul(x, r), x);
+			return V::Add(base, V::Add(a, extra));
+		}
+
+		// Cephes atanf：t>tan(pi/8) 时归约到 |x| <= tan(pi/8)，3 阶多项式（无除法），误差 ~1e-7
+		template <class V>
+		typename V::Reg AtanUnit(typename V::Reg t, FastTag)
+		{
+			static const double P[4] = {
+				8.05374449538E-2, -1.38776856032E-1, 1.99777106478E-1, -3.33329491539E-1 };
+
+			const typename V::Mask big = V::CmpGt(t, V::Set1(0.4142135623730950));
+			const typename V::Reg one = V::Set1(1.0);
+			const typename V::Reg x = V::Select(big, V::Div(V::Sub(t, one), V::Add(t, one)), t);
+			const typename V::Reg base = V::Select(big, V::Set1(kPiO4), V::Set1(0.0));
+
+			const typename V::Reg z = V::Mul(x, x);
+			const typename V::Reg a = V::Add(V::Mul(V::Mul(z, x), PolyEval<V, 3>(z, P)), x);
+			return V::Add(base, a);
+		}
+
+		// r ∈ [-pi/4, pi/4] 上的 sin/cos（Cephes sin/cos，6 项）
+		template <class V>
+		void SinCosKernel(typename V::Reg r, typename V::Reg& s, typename V::Reg& c, ExactTag)
+		{
+			static const double kSin[6] = {
+				1.58962301576546568060E-10, -2.50507477628578072866E-8, 2.75573136213857245213E-6,
+				-1.98412698295895385996E-4, 8.33333333332211858878E-3, -1.66666666666666307295E-1 };
+			static const double kCos[6] = {
+				-1.13585365213876817300E-11, 2.08757008419747316778E-9, -2.75573141792967388112E-7,
+				2.48015872888517045348E-5, -1.38888888888730564116E-3, 4.16666666666665929218E-2 };
+
+			const typename V::Reg z = V::Mul(r, r);
+			s = V::Add(r, V::Mul(V::Mul(r, z), PolyEval<V, 5>(z, kSin)));
+			c = V::Add(V::Sub(V::Set1(1.0), V::Mul(V::Set1(0.5), z)), V::Mul(V::Mul(z, z), PolyEval<V, 5>(z, kCos)));
+		}
+
+		// Cephes sinf/cosf，3 项
+		template <class V>
+		void SinCosKernel(typename V::Reg r, typename V::Reg& s, typename V::Reg& c, FastTag)
+		{
+			static const double kSin[3] = { -1.9515295891E-4, 8.3321608736E-3, -1.6666654611E-1 };
+			static const double kCos[3] = { 2.443315711809948E-5, -1.388731625493765E-3, 4.166664568298827E-2 };
+
+			const typename V::Reg z = V::Mul(r, r);
+			s = V::Add(r, V::Mul(V::Mul(r, z), PolyEval<V, 2>(z, kSin)));
+			c = V::Add(V::Sub(V::Set1(1.0), V::Mul(V::Set1(0.5), z)), V::Mul(V::Mul(z, z), PolyEval<V, 2>(z, kCos)));
+		}
+
+		// pi/2 = DP1 + DP2 + DP3：双精度档用 Cephes sin 的拆分；单精度档用 sinf 的拆分（DP1 只有 8 位有效位，float 下 k*DP1 仍精确）
+		inline const double* PiO2Split(ExactTag)
+		{
+			static const double kDp[3] = { 1.57079625129699707031E0, 7.54978941586159635336E-8, 5.39030285815811905290E-15 };
+			return kDp;
+		}
+
+		inline const double* PiO2Split(FastTag)
+		{
+			static const double kDp[3] = { 1.5703125, 4.837512969970703125E-4, 7.54978995489188216E-8 };
+			return kDp;
+		}
+	}
+
+	// atan(t)，要求 t ∈ [0,1]（由 Atan2 保证）。
+	template <class V>
+	typename V::Reg AtanUnit(typename V::Reg t)
+	{
+		return detail::AtanUnit<V>(t, detail::MathTag<V>());
+	}
+
+	// atan2(y, x)：先在第一象限用 min/max 比值求 atan（t ∈ [0,1]），再按符号/大小关系还原象限。
+	// x=y=0 时返回 0（与 std::atan2(+0,+0) 一致）。
+	template <class V>
+	typename V::Reg Atan2(typename V::Reg y, typename V::Reg x)
+	{
+		using namespace detail;
+		const typename V::Reg zero = V::Set1(0.0);
+		const typename V::Reg ax = V::Abs(x);
+		const typename V::Reg ay = V::Abs(y);
+		const typename V::Reg num = V::Min(ax, ay);
+		const typename V::Reg den = V::Max(ax, ay);
+		const typename V::Mask denZero = V::CmpEq(den, zero);
+		const typename V::Reg t = V::Select(denZero, zero, V::Div(num, V::Select(denZero, V::Set1(1.0), den)));
+
+		typename V::Reg a = AtanUnit<V>(t);
+		a = V::Select(V::CmpGt(ay, ax), V::Sub(V::Set1(kPiO2), a), a);
+		a = V::Select(V::CmpLt(x, zero), V::Sub(V::Set1(kPi), a), a);
+		a = V::Select(V::CmpLt(y, zero), V::Sub(zero, a), a);
+		return a;
+	}
+
+	// sin/cos：按 pi/2 做 Cody-Waite 三段归约到 [-pi/4, pi/4]，再按象限交换/取反。
+	// 适用于 |x| < 1e6 左右（运动学角度远小于此；float 档 |x| < 1e3 左右）。
+	template <class V>
+	void SinCos(typename V::Reg x, typename V::Reg& outSin, typename V::Reg& outCos)
+	{
+		const double* dp = detail::PiO2Split(detail::MathTag<V>());
+		const typename V::Reg k = V::Round(V::Mul(x, V::Set1(2.0 / detail::kPi)));
+		typename V::Reg r = V::Sub(x, V::Mul(k, V::Set1(dp[0])));
+		r = V::Sub(r, V::Mul(k, V::Set1(dp[1])));
+		r = V::Sub(r, V::Mul(k, V::Set1(dp[2])));
+
+		typename V::Reg s, c;
+		detail::SinCosKernel<V>(r, s, c, detail::MathTag<V>());
+
+		// 象限 q = k mod 4（用浮点实现，避免各后端整数指令差异）
+		const typename V::Reg q = V::Sub(k, V::Mul(V::Set1(4.0), V::Floor(V::Mul(k, V::Set1(0.25)))));
+		const typename V::Mask swap = V::Or(V::CmpEq(q, V::Set1(1.0)), V::CmpEq(q, V::Set1(3.0)));
+		const typename V::Mask negSin = V::CmpGt(q, V::Set1(1.5));                       // q = 2,3
+		const typename V::Mask negCos = V::Or(V::CmpEq(q, V::Set1(1.0)), V::CmpEq(q, V::Set1(2.0))); // q = 1,2
+
+		const typename V::Reg zero = V::Set1(0.0);
+		typename V::Reg sv = V::Select(swap, c, s);
+		typename V::Reg cv = V::Select(swap, s, c);
+		outSin = V::Select(negSin, V::Sub(zero, sv), sv);
+		outCos = V::Select(negCos, V::Sub(zero, cv), cv);
+	}
+
+	// 角度归一化到 [-pi, pi]（a - 2pi*round(a/2pi)）
+	template <class V>
+	typename V::Reg WrapToPi(typename V::Reg a)
+	{
+		const typename V::Reg k = V::Round(V::Mul(a, V::Set1(0.5 / detail::kPi)));
+		return V::Sub(a, V::Mul(k, V::Set1(2.0 * detail::kPi)));
+	}
+}
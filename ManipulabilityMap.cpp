@@ -0,0 +1,169 @@
+#include "pch.h"
+
+#include "ManipulabilityMap.h"
+
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// J2..J4 是否在软限位内（J1 与本图无关，见头文件）
+	bool PlanarWithinLimits(const KinematicsCalib& calib, const ArmKinematics::JointAnglesRad& q)
+	{
+		for (int j = 2; j <= 4; j++)
+		{
+			const auto& jc = calib.GetJoint(j);
+			if (jc.hasLimit && (q.q[j] < jc.minRad || q.q[j] > jc.maxRad)) return false;
+		}
+		return true;
+	}
+}
+
+bool ManipulabilityMap::Build(const KinematicsCalib& calib, const GridParams& params, const std::atomic<bool>* pCancel)
+{
+	m_cells.clear();
+
+	const auto& L = calib.Links();
+	const double reach = L.L_arm1 + L.L_arm2 + L.L_wrist;
+
+	m_cellMm = (params.cellMm > 0.5) ? params.cellMm : 0.5;
+	m_invCell = 1.0 / m_cellMm;
+	m_nr = static_cast<int>(std::ceil(reach / m_cellMm)) + 1;
+	m_nz = 2 * (m_nr - 1) + 1;
+	m_originZ = L.L_base - (m_nr - 1) * m_cellMm;
+
+	m_pitchStepDeg = (params.pitchStepDeg > 0.1) ? params.pitchStepDeg : 0.1;
+	m_pitchMinDeg = params.pitchMinDeg;
+	const double span = std::max(0.0, params.pitchMaxDeg - params.pitchMinDeg);
+	m_pitchCount = static_cast<int>(std::floor(span / m_pitchStepDeg + 1e-9)) + 1;
+
+	std::vector<Cell> cells(static_cast<size_t>(m_nr) * m_nz * m_pitchCount);
+	std::atomic<bool> cancelled(false);
+
+	// 每个 (俯仰, z) 行一个任务：行内沿 r 逐点闭式 IK + 两个指标
+	ParallelFor(static_cast<size_t>(m_pitchCount) * m_nz, [&](size_t row)
+	{
+		if (pCancel && pCancel->load(std::memory_order_relaxed))
+		{
+			cancelled.store(true, std::memory_order_relaxed);
+		}
+		if (cancelled.load(std::memory_order_relaxed)) return;
+
+		const int ip = static_cast<int>(row / m_nz);
+		const int iz = static_cast<int>(row % m_nz);
+		ArmKinematics::PoseTarget target;
+		target.z_mm = m_originZ + iz * m_cellMm;
+		target.pitch_deg = m_pitchMinDeg + ip * m_pitchStepDeg;
+
+		Cell* out = &cells[row * m_nr];
+		for (int ir = 0; ir < m_nr; ir++)
+		{
+			target.y_mm = ir * m_cellMm;
+
+			ArmKinematics::IkResultLite ik;
+			if (!ArmKinematics::InverseKinematics(calib, target, nullptr, ik)) continue;
+
+			// 取限位内候选中较差的值：不论当前在哪个肘解上，降速都不会不足
+			float manip = -1.0f;
+			float invCond = 0.0f;
+			for (int c = 0; c < ik.candidateCount; c++)
+			{
+				const auto& q = ik.candidates[c].q;
+				if (!PlanarWithinLimits(calib, q)) continue;
+				const float w = static_cast<float>(ArmKinematics::Manipulability(calib, q));
+				const float k = static_cast<float>(ArmKinematics::InverseCondition(calib, q, params.pitchWeightMm));
+				if (manip < 0.0f)
+				{
+					manip = w;
+					invCond = k;
+				}
+				else
+				{
+					manip = std::min(manip, w);
+					invCond = std::min(invCond, k);
+				}
+			}
+			out[ir].manip = manip;
+			out[ir].invCond = invCond;
+		}
+	}, params.threads);
+
+	if (cancelled.load(std::memory_order_relaxed))
+	{
+		return false;
+	}
+
+	m_cells.swap(cells);
+	m_calibFp = calib.GetArmFingerprint();
+	return true;
+}
+
+bool ManipulabilityMap::Query(double x_mm, double y_mm, double z_mm, double pitchDeg, Sample& out) const
+{
+	return QueryPlanar(std::sqrt(x_mm * x_mm + y_mm * y_mm), z_mm, pitchDeg, out);
+}
+
+bool ManipulabilityMap::QueryPlanar(double r_mm, double z_mm, double pitchDeg, Sample& out) const
+{
+	if (m_cells.empty()) return false;
+
+	const double fr = r_mm * m_invCell;
+	const double fz = (z_mm - m_originZ) * m_invCell;
+	const double fp = (ArmKinematics::WrapPitchDeg(pitchDeg) - m_pitchMinDeg) / m_pitchStepDeg;
+	// 双线性插值：最后一个格点本身也可查询（<= n - 1）；NaN 使比较不成立，同样返回 false
+	if (!(fr >= 0.0 && fr <= m_nr - 1 && fz >= 0.0 && fz <= m_nz - 1 && fp >= 0.0 && fp <= m_pitchCount - 1))
+	{
+		return false;
+	}
+
+	const int ir = std::min(static_cast<int>(fr), std::max(m_nr - 2, 0));
+	const int iz = std::min(static_cast<int>(fz), std::max(m_nz - 2, 0));
+	const int ip = std::min(static_cast<int>(fp), std::max(m_pitchCount - 2, 0));
+	const double tr = fr - ir;
+	const double tz = fz - iz;
+	const double tp = fp - ip;
+
+	double wsum = 0.0, valid = 0.0, manip = 0.0, invCond = 0.0;
+	for (int k = 0; k < 8; k++)
+	{
+		const int dr = k & 1;
+		const int dz = (k >> 1) & 1;
+		const int dp = (k >> 2) & 1;
+		if (ir + dr >= m_nr || iz + dz >= m_nz || ip + dp >= m_pitchCount) continue;
+
+		const Cell& c = At(ir + dr, iz + dz, ip + dp);
+		const double w = (dr ? tr : 1.0 - tr) * (dz ? tz : 1.0 - tz) * (dp ? tp : 1.0 - tp);
+		wsum += w;
+		if (c.manip < 0.0f) continue; // 无解角点按 0 计（外边界即伸直奇异），只影响边界附近的格子
+		valid += w;
+		manip += w * c.manip;
+		invCond += w * c.invCond;
+	}
+	if (!(valid > 1e-9))
+	{
+		return false;
+	}
+	out.manip = manip / wsum;
+	out.invCond = invCond / wsum;
+	return true;
+}
+
+double ManipulabilityMap::Dexterity(const Sample& s, const SpeedParams& params)
+{
+	double d = 1.0;
+	if (params.manipThreshold > 0.0) d = std::min(d, s.manip / params.manipThreshold);
+	if (params.invCondThreshold > 0.0) d = std::min(d, s.invCond / params.invCondThreshold);
+	return std::max(0.0, d);
+}
+
+double ManipulabilityMap::SpeedScale(const ArmKinematics::PoseTarget& pose, const SpeedParams& params) const
+{
+	Sample s;
+	if (!Query(pose.x_mm, pose.y_mm, pose.z_mm, pose.pitch_deg, s))
+	{
+		return 1.0;
+	}
+	return std::max(params.minScale, Dexterity(s, params));
+}
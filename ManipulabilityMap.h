@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ArmKinematics.h"
+#include "BackgroundMapBuilder.h"
+#include "KinematicsCalib.h"
+
+// ManipulabilityMap：工作空间“灵活度”热图（可操作度 + 逆条件数），供 Jog 自动降速与 HUD 叠加
+// - 接近伸直、折叠或末端靠近 J1 轴线时灵活度低（同样的笛卡尔速度需要很大的关节速度）；
+// - Jog 每 tick O(1) 查表按灵活度缩放速度，HUD 画出当前俯仰下的热图切片。
+//
+// 网格：两个指标都与 J1 无关（见 ArmKinematics::InverseCondition），所以只在 (r, z, pitch) 上采样：
+// - r = 末端到 J1 轴线的水平距离 [0, 臂展]，z 覆盖肩高 ± 臂展，俯仰默认 -90..+90°；
+// - 每个格点对 (x=0, y=r, z, pitch) 求闭式 IK，取 J2..J4 在软限位内的候选中较差的值（两个肘解的可操作度相同、条件数不同）；
+//   J1 限位由 ReachabilityMap 负责，这里不看；
+// - 按 (俯仰, z) 行用 ParallelFor 并行；默认参数约 50 万格点，单核 0.1s 量级（见 KinematicsBench），因此不做磁盘缓存。
+//
+// 查询：三线性插值；无解的角点按 0 计（外边界就是伸直奇异，所以边界附近的格子偏保守地降速），
+// 8 个角点全无解或超出网格时返回 false。
+class ManipulabilityMap
+{
+public:
+	struct GridParams
+	{
+		double cellMm = 5.0;
+		double pitchMinDeg = -90.0;
+		double pitchMaxDeg = 90.0;
+		double pitchStepDeg = 5.0;
+		double pitchWeightMm = 100.0; // 条件数的俯仰行权重（与 DlsParams 一致）
+
+		// 构建线程数（0=CPU 核数）
+		unsigned threads = 0;
+	};
+
+	// 每格点 8 字节；manip < 0 表示 J2..J4 无限位内解
+	struct Cell
+	{
+		float manip = -1.0f;
+		float invCond = 0.0f;
+	};
+
+	struct Sample
+	{
+		double manip = 0.0;   // 归一化可操作度 [0,1]
+		double invCond = 0.0; // 逆条件数 [0,1]
+	};
+
+	// 速度缩放：两个指标各自低于阈值时按比例降速，取较小者，下限 minScale。
+	// 默认 manipThreshold 与 DlsParams 的阻尼起点一致；逆条件数在限位内关节空间的中位数约 0.09，0.02 约为最差的 10%。
+	struct SpeedParams
+	{
+		double manipThreshold = 0.08;
+		double invCondThreshold = 0.02;
+		double minScale = 0.2;
+	};
+
+public:
+	ManipulabilityMap() = default;
+	ManipulabilityMap(const ManipulabilityMap&) = delete;
+	ManipulabilityMap& operator=(const ManipulabilityMap&) = delete;
+
+	// 并行计算整张图。pCancel 非空且置 true 时尽快返回 false。
+	bool Build(const KinematicsCalib& calib, const GridParams& params, const std::atomic<bool>* pCancel = nullptr);
+
+	bool IsValid() const { return !m_cells.empty(); }
+	uint64_t GetCalibFingerprint() const { return m_calibFp; }
+
+	// 网格范围（HUD 画切片用）
+	double RMaxMm() const { return (m_nr - 1) * m_cellMm; }
+	double ZMinMm() const { return m_originZ; }
+	double ZMaxMm() const { return m_originZ + (m_nz - 1) * m_cellMm; }
+
+	bool Query(double x_mm, double y_mm, double z_mm, double pitchDeg, Sample& out) const;
+	bool QueryPlanar(double r_mm, double z_mm, double pitchDeg, Sample& out) const;
+
+	// 0..1 的“灵活度”：min(w/manipThreshold, 1/κ / invCondThreshold)，截到 [0,1]（HUD 着色用）
+	static double Dexterity(const Sample& s, const SpeedParams& params);
+
+	// Jog 速度倍率 [minScale, 1]；查不到（地图未就绪、不可达）时返回 1，由 IK / 可达性图处理
+	double SpeedScale(const ArmKinematics::PoseTarget& pose, const SpeedParams& params) const;
+
+private:
+	const Cell& At(int ir, int iz, int ip) const { return m_cells[(static_cast<size_t>(ip) * m_nz + iz) * m_nr + ir]; }
+
+private:
+	double m_cellMm = 5.0;
+	double m_invCell = 0.2;
+	double m_originZ = 0.0;
+	int m_nr = 0;
+	int m_nz = 0;
+
+	double m_pitchMinDeg = 0.0;
+	double m_pitchStepDeg = 5.0;
+	int m_pitchCount = 0;
+
+	uint64_t m_calibFp = 0;
+	std::vector<Cell> m_cells;
+};
+
+// 后台构建（见 BackgroundMapBuilder）。
+class ManipulabilityMapBuilder : public BackgroundMapBuilder<ManipulabilityMap, ManipulabilityMap::GridParams>
+{
+public:
+	void Start(const KinematicsCalib& calib, const ManipulabilityMap::GridParams& params)
+	{
+		StartBuild(calib, params, [](ManipulabilityMap& map, const KinematicsCalib& c,
+		                             const ManipulabilityMap::GridParams& p, const std::atomic<bool>* pCancel)
+		{
+			return map.Build(c, p, pCancel);
+		});
+	}
+};
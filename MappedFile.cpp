@@ -0,0 +1,233 @@
+#include "pch.h"
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+namespace
+{
+	// wchar_t (UTF-32 on POSIX) -> UTF-8 for open()/rename()
+	std::string ToUtf8(const std::wstring& ws)
+	{
+		std::string out;
+		out.reserve(ws.size());
+		for (wchar_t wc : ws)
+		{
+			const uint32_t c = static_cast<uint32_t>(wc);
+			if (c < 0x80)
+			{
+				out.push_back(static_cast<char>(c));
+			}
+			else if (c < 0x800)
+			{
+				out.push_back(static_cast<char>(0xC0 | (c >> 6)));
+				out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+			}
+			else if (c < 0x10000)
+			{
+				out.push_back(static_cast<char>(0xE0 | (c >> 12)));
+				out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+			}
+			else
+			{
+				out.push_back(static_cast<char>(0xF0 | (c >> 18)));
+				out.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+			}
+		}
+		return out;
+	}
+}
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::OpenRead(const std::wstring& path)
+{
+	Close();
+
+	HANDLE hFile = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER sz = {};
+	if (!::GetFileSizeEx(hFile, &sz) || sz.QuadPart <= 0)
+	{
+		::CloseHandle(hFile);
+		return false;
+	}
+
+	HANDLE hMap = ::CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!hMap)
+	{
+		::CloseHandle(hFile);
+		return false;
+	}
+
+	const void* view = ::MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+	if (!view)
+	{
+		::CloseHandle(hMap);
+		::CloseHandle(hFile);
+		return false;
+	}
+
+	m_hFile = hFile;
+	m_hMap = hMap;
+	m_data = static_cast<const uint8_t*>(view);
+	m_size = static_cast<size_t>(sz.QuadPart);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data)
+	{
+		::UnmapViewOfFile(m_data);
+	}
+	if (m_hMap)
+	{
+		::CloseHandle(static_cast<HANDLE>(m_hMap));
+	}
+	if (m_hFile)
+	{
+		::CloseHandle(static_cast<HANDLE>(m_hFile));
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_hMap = nullptr;
+	m_hFile = nullptr;
+}
+
+bool MappedFile::WriteAtomic(const std::wstring& path, const void* data, size_t size)
+{
+	const std::wstring tmp = path + L".tmp";
+	HANDLE h = ::CreateFileW(tmp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (h == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+	size_t left = size;
+	bool ok = true;
+	while (left > 0)
+	{
+		const DWORD chunk = static_cast<DWORD>(left > 0x40000000u ? 0x40000000u : left);
+		DWORD written = 0;
+		if (!::WriteFile(h, p, chunk, &written, nullptr) || written != chunk)
+		{
+			ok = false;
+			break;
+		}
+		p += written;
+		left -= written;
+	}
+	::CloseHandle(h);
+
+	if (!ok || !::MoveFileExW(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		::DeleteFileW(tmp.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool MappedFile::EnsureDirectory(const std::wstring& dir)
+{
+	if (::CreateDirectoryW(dir.c_str(), nullptr))
+	{
+		return true;
+	}
+	return ::GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+#else
+
+bool MappedFile::OpenRead(const std::wstring& path)
+{
+	Close();
+
+	const int fd = ::open(ToUtf8(path).c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat st = {};
+	if (::fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* view = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // the mapping keeps its own reference
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+
+	m_data = static_cast<const uint8_t*>(view);
+	m_size = static_cast<size_t>(st.st_size);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data)
+	{
+		::munmap(const_cast<uint8_t*>(m_data), m_size);
+	}
+	m_data = nullptr;
+	m_size = 0;
+}
+
+bool MappedFile::WriteAtomic(const std::wstring& path, const void* data, size_t size)
+{
+	const std::string dst = ToUtf8(path);
+	const std::string tmp = dst + ".tmp";
+	FILE* f = std::fopen(tmp.c_str(), "wb");
+	if (!f)
+	{
+		return false;
+	}
+	const bool ok = (std::fwrite(data, 1, size, f) == size);
+	if (std::fclose(f) != 0 || !ok || std::rename(tmp.c_str(), dst.c_str()) != 0)
+	{
+		std::remove(tmp.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool MappedFile::EnsureDirectory(const std::wstring& dir)
+{
+	struct stat st = {};
+	const std::string d = ToUtf8(dir);
+	if (::stat(d.c_str(), &st) == 0)
+	{
+		return S_ISDIR(st.st_mode);
+	}
+	return ::mkdir(d.c_str(), 0755) == 0;
+}
+
+#endif
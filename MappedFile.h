@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory-mapped file (Win32 file mapping; POSIX mmap in headless tool builds).
+// Used for precomputed caches that are large enough that copying them into the heap on
+// every start would be wasteful; the OS pages data in on first touch.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool OpenRead(const std::wstring& path);
+	void Close();
+	bool IsOpen() const { return m_data != nullptr; }
+
+	const uint8_t* Data() const { return m_data; }
+	size_t Size() const { return m_size; }
+
+	// Write a whole file via "<path>.tmp" + rename so readers never map a half-written cache.
+	static bool WriteAtomic(const std::wstring& path, const void* data, size_t size);
+
+	// Create a directory if it does not exist yet (single level).
+	static bool EnsureDirectory(const std::wstring& dir);
+
+private:
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+#ifdef _WIN32
+	void* m_hFile = nullptr;
+	void* m_hMap = nullptr;
+#endif
+};
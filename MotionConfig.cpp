@@ -2,7 +2,10 @@
 
 #include "MotionConfig.h"
 
+// Profile persistence needs MFC (AfxGetApp/CString); headless tools (tools/) only use defaults.
+#ifdef _WIN32
 #include <afxwin.h>
+#endif
 
 MotionConfig::MotionConfig()
 {
@@ -17,12 +20,14 @@ void MotionConfig::ResetDefaults()
 	}
 }
 
+#ifdef _WIN32
 std::wstring MotionConfig::SectionForJoint(int jointIndex)
 {
 	CString s;
 	s.Format(L"Motion\\J%d", jointIndex);
 	return std::wstring(s.GetString());
 }
+#endif
 
 std::wstring MotionConfig::JointName(int jointIndex)
 {
@@ -38,6 +43,7 @@ std::wstring MotionConfig::JointName(int jointIndex)
 	}
 }
 
+#ifdef _WIN32
 void MotionConfig::LoadAll()
 {
 	for (int j = 1; j <= kJointCount; j++)
@@ -80,5 +86,4 @@ void MotionConfig::ImportLegacyServoLimitsForAssignedJoints()
 		d.maxPos = AfxGetApp()->GetProfileInt(L"ServoLimits", keyMax, d.maxPos);
 	}
 }
-
-
+#endif
@@ -4,8 +4,10 @@
 
 #include "ArmCommsService.h"
 #include "ArmProtocol.h"
+#include "KeyframeSpline.h"
 
 #include <algorithm>
+#include <cwchar>
 
 MotionController::MotionController()
 {
@@ -15,11 +17,21 @@ MotionController::MotionController()
 void MotionController::LoadConfig()
 {
 	m_cfg.LoadAll();
+
+	const int interp = AfxGetApp()->GetProfileInt(L"Script", L"Interp", static_cast<int>(ScriptInterp::Cubic));
+	m_playback.interp = (interp >= 0 && interp <= static_cast<int>(ScriptInterp::Quintic))
+		? static_cast<ScriptInterp>(interp) : ScriptInterp::Cubic;
+	m_playback.streamPeriodMs = AfxGetApp()->GetProfileInt(L"Script", L"StreamMs", 50);
+	m_playback.highResScheduler = AfxGetApp()->GetProfileInt(L"Script", L"Scheduler", 1) != 0;
 }
 
 void MotionController::SaveConfig() const
 {
 	m_cfg.SaveAll();
+
+	AfxGetApp()->WriteProfileInt(L"Script", L"Interp", static_cast<int>(m_playback.interp));
+	AfxGetApp()->WriteProfileInt(L"Script", L"StreamMs", m_playback.streamPeriodMs);
+	AfxGetApp()->WriteProfileInt(L"Script", L"Scheduler", m_playback.highResScheduler ? 1 : 0);
 }
 
 void MotionController::ResetDefaults()
@@ -32,35 +44,10 @@ void MotionController::ImportLegacyServoLimitsForAssignedJoints()
 	m_cfg.ImportLegacyServoLimitsForAssignedJoints();
 }
 
-int MotionController::ClampPos(int v, int minV, int maxV)
-{
-	if (minV > maxV) std::swap(minV, maxV);
-	if (v < minV) return minV;
-	if (v > maxV) return maxV;
-	return v;
-}
-
-bool MotionController::BuildServoTargetsFromJoints(const std::vector<std::pair<int, int>>& jointToPos,
-                                                   std::vector<ArmProtocol::ServoTarget>& out)
+size_t MotionController::BuildServoTargetsFromJoints(const JointPosArray& jointPos,
+                                                     ArmProtocol::ServoTarget (&out)[MotionConfig::kJointCount]) const
 {
-	out.clear();
-	out.reserve(jointToPos.size());
-	for (const auto& jp : jointToPos)
-	{
-		const int joint = jp.first;
-		const int rawPos = jp.second;
-		if (joint < 1 || joint > MotionConfig::kJointCount) continue;
-
-		const auto& jc = m_cfg.Get(joint);
-		if (jc.servoId < 1 || jc.servoId > 6) continue;
-
-		const int safePos = ClampPos(rawPos, jc.minPos, jc.maxPos);
-		ArmProtocol::ServoTarget st;
-		st.id = static_cast<uint8_t>(jc.servoId);
-		st.position = static_cast<uint16_t>(safePos);
-		out.push_back(st);
-	}
-	return !out.empty();
+	return CompiledScript::BuildServoTargets(m_cfg, jointPos, out);
 }
 
 bool MotionController::MoveJointAbs(int jointIndex, int pos, int timeMs)
@@ -72,14 +59,42 @@ bool MotionController::MoveJointAbs(int jointIndex, int pos, int timeMs)
 
 bool MotionController::MoveJointsAbs(const std::vector<std::pair<int, int>>& jointToPos, int timeMs)
 {
-	std::vector<ArmProtocol::ServoTarget> servos;
-	if (!BuildServoTargetsFromJoints(jointToPos, servos))
+	// Joint-indexed: a later entry for the same joint wins.
+	JointPosArray jointPos;
+	jointPos.fill(-1);
+	for (const auto& jp : jointToPos)
+	{
+		if (jp.first < 1 || jp.first > MotionConfig::kJointCount) continue;
+		jointPos[jp.first] = jp.second;
+	}
+	return MoveJointsAbs(jointPos, timeMs);
+}
+
+bool MotionController::PackJoints(const JointPosArray& jointPos, int timeMs, std::vector<uint8_t>& out) const
+{
+	out.clear();
+	ArmProtocol::ServoTarget servos[MotionConfig::kJointCount];
+	const size_t n = BuildServoTargetsFromJoints(jointPos, servos);
+	if (n == 0)
 	{
 		return false;
 	}
 	if (timeMs < 0) timeMs = 0;
-	if (timeMs > 60000) timeMs = 60000;
-	ArmCommsService::Instance().EnqueueTx(ArmProtocol::PackMove(servos, static_cast<uint16_t>(timeMs)));
+	if (timeMs > CompiledScript::kMaxMoveTimeMs) timeMs = CompiledScript::kMaxMoveTimeMs;
+	ArmProtocol::PackMoveInto(servos, n, static_cast<uint16_t>(timeMs), out);
+	return true;
+}
+
+bool MotionController::MoveJointsAbs(const JointPosArray& jointPos, int timeMs)
+{
+	// Pack into a recycled TX buffer (capacity survives the queue round-trip).
+	auto& comms = ArmCommsService::Instance();
+	std::vector<uint8_t> bytes = comms.AcquireTxBuffer();
+	if (!PackJoints(jointPos, timeMs, bytes))
+	{
+		return false;
+	}
+	comms.EnqueueTx(std::move(bytes));
 	return true;
 }
 
@@ -119,17 +134,253 @@ void MotionController::RequestReadAllAssigned()
 
 void MotionController::StartScript(std::vector<Keyframe> frames, bool loop)
 {
+	size_t loopStart = 0;
+	if (m_playback.interp != ScriptInterp::Keyframe && ExpandSpline(frames, loop))
+	{
+		// The closed spline ends on the first keyframe; wrap past the approach move.
+		loopStart = 1;
+	}
+	StartFrames(std::move(frames), loop, loopStart);
+}
+
+void MotionController::StartFrames(std::vector<Keyframe> frames, bool loop, size_t loopStart)
+{
+	m_scheduler.Stop();
+	m_program.reset();
 	m_frames = std::move(frames);
+	m_compiled = CompiledScript::Compile(m_cfg, m_frames, loopStart);
 	m_loop = loop;
 	m_frameIndex = 0;
 	m_playing = !m_frames.empty();
 	m_nextDue = ::GetTickCount64();
+	m_scheduled = m_playing && m_playback.highResScheduler;
+	if (m_scheduled)
+	{
+		StartScheduled();
+	}
+}
+
+void MotionController::StartScheduled()
+{
+	// The scheduler thread only reads the compiled arena: it never touches MotionConfig or allocates per frame.
+	m_scheduler.Start(m_compiled, m_loop, BeginTimedSend());
+}
+
+MotionScheduler::SendFn MotionController::BeginTimedSend()
+{
+	m_session = ArmCommsService::Instance().BeginTimedSession();
+	const uint32_t session = m_session;
+	return [session](const uint8_t* bytes, size_t len) {
+		return ArmCommsService::Instance().SendTimed(session, bytes, len);
+	};
+}
+
+bool MotionController::StartProgram(std::unique_ptr<MotionScriptReader> reader, bool loop, std::wstring& outErr)
+{
+	StopScript();
+	if (!reader || !reader->IsOpen())
+	{
+		outErr = L"No program loaded.";
+		return false;
+	}
+	if (reader->CartesianCount() > 0 && !m_pKc)
+	{
+		outErr = L"The program has Cartesian keyframes but no kinematics is bound.";
+		return false;
+	}
+
+	m_programError.clear();
+	if (reader->CartesianCount() > 0)
+	{
+		// Every Cartesian keyframe must have an IK solution before the arm moves: one pass over the mapped file
+		// (IK only, nothing kept), solved along the path exactly as playback will.
+		if (m_calib.IsStale(*m_pKc, &m_cfg))
+		{
+			m_calib = KinematicsCalib::Compile(*m_pKc, &m_cfg);
+		}
+		MotionScriptResolver check;
+		MotionScript::Keyframe in;
+		Keyframe out;
+		reader->Rewind();
+		while (reader->Next(in))
+		{
+			if (!check.Resolve(m_calib, in, out))
+			{
+				outErr = UnreachableText(reader->Position() - 1, in);
+				return false;
+			}
+		}
+	}
+
+	m_program = std::move(reader);
+	m_program->Rewind();
+	m_resolver.Reset();
+	m_programStats = ProgramStats{};
+	m_programEnded = false;
+	m_programFailed = false;
+	m_programMsSinceWrap = 0;
+	m_loop = loop;
+	m_frames.reserve(kProgramWindow);
+	if (!LoadProgramWindow())
+	{
+		StopScript();
+		outErr = L"The program has no keyframes.";
+		return false;
+	}
+
+	m_frameIndex = 0;
+	m_playing = true;
+	m_nextDue = ::GetTickCount64();
+	m_scheduled = m_playback.highResScheduler;
+	if (m_scheduled)
+	{
+		m_scheduler.StartStream(m_compiled, BeginTimedSend());
+		QueueProgramWindow();
+	}
+	return true;
+}
+
+std::wstring MotionController::UnreachableText(size_t index, const MotionScript::Keyframe& kf)
+{
+	wchar_t buf[160];
+	std::swprintf(buf, sizeof(buf) / sizeof(buf[0]), L"Keyframe %zu: no IK solution for x=%.1f y=%.1f z=%.1f pitch=%.1f.", index, kf.x_mm, kf.y_mm,
+		kf.z_mm, kf.pitch_deg);
+	return buf;
+}
+
+bool MotionController::LoadProgramWindow()
+{
+	if (m_programFailed)
+	{
+		return false;
+	}
+	if (m_pKc && m_calib.IsStale(*m_pKc, &m_cfg))
+	{
+		m_calib = KinematicsCalib::Compile(*m_pKc, &m_cfg);
+	}
+
+	// m_frames keeps the previous window until a new keyframe is read (the scheduler may still be playing it).
+	MotionScript::Keyframe in;
+	Keyframe out;
+	size_t count = 0;
+	while (count < kProgramWindow)
+	{
+		if (!m_program->Next(in))
+		{
+			// A loop of zero-length keyframes would flood the link: it ends instead of wrapping again.
+			if (!m_loop || m_programMsSinceWrap == 0)
+			{
+				break;
+			}
+			m_program->RewindToLoopStart();
+			m_programMsSinceWrap = 0;
+			continue;
+		}
+		if (!m_resolver.Resolve(m_calib, in, out))
+		{
+			// Skipping it would drive the next segment from the wrong pose: play up to here, then stop.
+			m_programError = UnreachableText(m_program->Position() - 1, in);
+			m_programFailed = true;
+			break;
+		}
+		if (count++ == 0) m_frames.clear();
+		m_frames.push_back(out);
+		m_programMsSinceWrap += static_cast<uint64_t>(std::max(out.durationMs, 0));
+		m_programStats.keyframes++;
+	}
+	if (count == 0)
+	{
+		return false;
+	}
+	m_compiled = CompiledScript::Compile(m_cfg, m_frames, 0);
+	m_programStats.windows++;
+	return true;
+}
+
+void MotionController::QueueProgramWindow()
+{
+	if (m_programEnded || m_scheduler.Queued() > 0)
+	{
+		return;
+	}
+	if (LoadProgramWindow())
+	{
+		m_scheduler.Append(m_compiled);
+	}
+	else
+	{
+		m_programEnded = true;
+		m_scheduler.CloseStream();
+	}
+}
+
+bool MotionController::ExpandSpline(std::vector<Keyframe>& frames, bool loop) const
+{
+	std::vector<KeyframeSpline::Knot> knots;
+	knots.reserve(frames.size());
+	for (const auto& kf : frames)
+	{
+		KeyframeSpline::Knot k;
+		k.durationMs = kf.durationMs;
+		k.pos = kf.jointPos;
+		knots.push_back(k);
+	}
+
+	KeyframeSpline spline;
+	const auto kind = (m_playback.interp == ScriptInterp::Quintic) ? KeyframeSpline::Kind::Quintic : KeyframeSpline::Kind::Cubic;
+	if (!spline.Build(knots, kind, loop))
+	{
+		return false;
+	}
+
+	const int periodMs = std::max(m_playback.streamPeriodMs, ArmCommsService::Instance().GetThrottleMs());
+	std::vector<KeyframeSpline::JointPosArray> samples;
+	spline.Sample(periodMs, samples);
+	if (samples.empty())
+	{
+		return false;
+	}
+
+	// Approach: the first keyframe as a plain move, then one setpoint per period. The last
+	// sample may be shorter than a period (it lands exactly on the final keyframe time).
+	std::vector<Keyframe> out;
+	out.reserve(samples.size() + 1);
+	out.push_back(frames.front());
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		Keyframe kf;
+		const int t = static_cast<int>(i + 1) * periodMs;
+		kf.durationMs = (t <= spline.DurationMs()) ? periodMs : spline.DurationMs() - static_cast<int>(i) * periodMs;
+		kf.jointPos = samples[i];
+		out.push_back(kf);
+	}
+	frames.swap(out);
+	return true;
+}
+
+void MotionController::StartStream(const std::vector<JointPosArray>& setpoints, int periodMs)
+{
+	std::vector<Keyframe> frames;
+	frames.reserve(setpoints.size());
+	for (const auto& sp : setpoints)
+	{
+		Keyframe kf;
+		kf.durationMs = (periodMs > 0) ? periodMs : 1;
+		kf.jointPos = sp;
+		frames.push_back(kf);
+	}
+	StartFrames(std::move(frames), false, 0);
 }
 
 void MotionController::StopScript()
 {
+	m_scheduler.Stop();
+	m_scheduled = false;
 	m_playing = false;
 	m_frames.clear();
+	m_compiled.reset();
+	m_program.reset();
+	m_programEnded = false;
 	m_frameIndex = 0;
 	m_nextDue = 0;
 }
@@ -142,29 +393,68 @@ void MotionController::Tick()
 		m_playing = false;
 		return;
 	}
+	// Limits or servo mapping edited while playing: compile again from the source keyframes. A scheduled program
+	// has its queued windows already handed over; the next window read picks up the change.
+	if (m_compiled->IsStale(m_cfg) && !(m_program && m_scheduled))
+	{
+		m_compiled = CompiledScript::Compile(m_cfg, m_frames, m_compiled->LoopStart());
+		if (m_scheduled)
+		{
+			m_scheduler.Replace(m_compiled);
+		}
+	}
+	if (m_scheduled)
+	{
+		if (m_program)
+		{
+			QueueProgramWindow();
+		}
+		// Frames are sent by the scheduler thread; only notice the end of playback or an emergency stop.
+		if (!m_scheduler.IsRunning() || !ArmCommsService::Instance().IsTimedSessionCurrent(m_session))
+		{
+			StopScript();
+		}
+		return;
+	}
 	const ULONGLONG now = ::GetTickCount64();
 	if (now < m_nextDue) return;
 
-	const Keyframe& kf = m_frames[m_frameIndex];
-	std::vector<std::pair<int, int>> joints;
-	for (int j = 1; j <= MotionConfig::kJointCount; j++)
+	const CompiledScript::FrameRef& f = m_compiled->Frame(m_frameIndex);
+	if (f.size > 0)
 	{
-		const int p = kf.jointPos[j];
-		if (p < 0) continue;
-		joints.push_back({ j, p });
+		// Copy the packed frame into a recycled TX buffer (capacity survives the queue round-trip).
+		auto& comms = ArmCommsService::Instance();
+		std::vector<uint8_t> bytes = comms.AcquireTxBuffer();
+		bytes.assign(m_compiled->Bytes(f), m_compiled->Bytes(f) + f.size);
+		comms.EnqueueTx(std::move(bytes));
 	}
-	(void)MoveJointsAbs(joints, kf.durationMs);
 
-	// schedule next
-	ULONGLONG delta = (kf.durationMs > 0) ? static_cast<ULONGLONG>(kf.durationMs) : 0ULL;
-	m_nextDue = now + delta;
+	// schedule next: advance from the previous due time so timer jitter does not accumulate
+	// over a long stream; if we fell more than one frame behind (UI stall), resync to now.
+	const ULONGLONG delta = static_cast<ULONGLONG>(f.durationMs);
+	m_nextDue += delta;
+	if (m_nextDue + delta < now)
+	{
+		m_nextDue = now + delta;
+	}
 
 	m_frameIndex++;
 	if (m_frameIndex >= m_frames.size())
 	{
-		if (m_loop)
+		if (m_program)
+		{
+			if (LoadProgramWindow())
+			{
+				m_frameIndex = 0;
+			}
+			else
+			{
+				StopScript();
+			}
+		}
+		else if (m_loop)
 		{
-			m_frameIndex = 0;
+			m_frameIndex = m_compiled->LoopStart();
 		}
 		else
 		{
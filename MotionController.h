@@ -3,22 +3,57 @@
 #include <Windows.h>
 #include <array>
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "ArmProtocol.h"
+#include "CompiledScript.h"
+#include "KinematicsCalib.h"
+#include "KinematicsConfig.h"
 #include "MotionConfig.h"
+#include "MotionScheduler.h"
+#include "MotionScript.h"
 
 // High-level motion controller:
 // - Joint-level API -> servo targets -> ArmProtocol::PackMove -> ArmCommsService queue
-// - Simple keyframe script playback (V1: one PackMove per keyframe)
+// - Keyframe script playback: either one PackMove per keyframe (servo board interpolates, joints
+//   stop at every keyframe) or a joint-space spline through the keyframes streamed at a fixed
+//   period (KeyframeSpline; continuous velocity, no stop at intermediate keyframes)
+// - Playback timing: by default frames are sent by a MotionScheduler thread at absolute deadlines
+//   (sub-ms jitter); the legacy path sends from Tick() and is bound to the UI timer period.
+// - Both paths replay a CompiledScript (validated, clamped and packed once at start); it is compiled
+//   again only when the joint configuration changes during playback.
+// - Program files (MotionScript) are streamed: read, resolved and compiled a window at a time.
 class MotionController
 {
 public:
-	struct Keyframe
+	// Joint positions (1..6, index 0 unused). Use -1 to keep "not set" (ignored).
+	using JointPosArray = CompiledScript::JointPosArray;
+	using Keyframe = CompiledScript::Keyframe;
+
+	enum class ScriptInterp : uint8_t
+	{
+		Keyframe = 0, // one PackMove per keyframe (V1 behaviour)
+		Cubic = 1,    // C2 cubic spline (KeyframeSpline::Kind::Cubic)
+		Quintic = 2,  // shape-preserving quintic (KeyframeSpline::Kind::Quintic), no overshoot
+	};
+
+	// Persisted in the Script profile section (Interp, StreamMs).
+	struct PlaybackParams
+	{
+		ScriptInterp interp = ScriptInterp::Cubic;
+		// Spline setpoint period. Never shorter than the ArmCommsService throttle (Throttle\Ms):
+		// the TX queue would grow faster than the link drains it.
+		int streamPeriodMs = 50;
+		// Play on the MotionScheduler thread (Script\Scheduler=1). 0 = send from Tick() on the UI timer.
+		bool highResScheduler = true;
+	};
+
+	struct ProgramStats
 	{
-		int durationMs = 800;
-		// Joint positions (1..6). Use -1 to keep \"not set\" (ignored).
-		std::array<int, MotionConfig::kJointCount + 1> jointPos{};
+		size_t keyframes = 0;  // played so far (loops count again)
+		size_t windows = 0;    // compiled windows
 	};
 
 	MotionController();
@@ -31,24 +66,70 @@ public:
 	void ResetDefaults();
 	void ImportLegacyServoLimitsForAssignedJoints();
 
+	// Kinematics for the Cartesian keyframes of program files (owned by the caller; null = joint programs only).
+	void BindKinematics(const KinematicsConfig* pKc) { m_pKc = pKc; }
+
+	PlaybackParams GetPlaybackParams() const { return m_playback; }
+	void SetPlaybackParams(const PlaybackParams& p) { m_playback = p; }
+
 	// Direct control
 	bool MoveJointAbs(int jointIndex, int pos, int timeMs);
 	bool MoveJointsAbs(const std::vector<std::pair<int, int>>& jointToPos, int timeMs);
+	// Fixed-size variant (no heap allocation in steady state): used by Jog and script playback.
+	bool MoveJointsAbs(const JointPosArray& jointPos, int timeMs);
 	bool MoveHome(int timeMs);
 
 	// Readback request (optional)
 	void RequestReadAllAssigned();
 
-	// Script playback
+	// Script playback (interpolation per GetPlaybackParams(); the first keyframe is always a plain
+	// move from wherever the arm is, since the current position is not known here)
 	void StartScript(std::vector<Keyframe> frames, bool loop);
+	// Setpoint stream (e.g. from CartesianPlanner): one PackMove per setpoint, each with
+	// time = periodMs so the servo board interpolates linearly between consecutive setpoints.
+	// periodMs should not be shorter than the ArmCommsService throttle, or the TX queue backs up.
+	void StartStream(const std::vector<JointPosArray>& setpoints, int periodMs);
+	// Program file playback, one move per keyframe (a spline needs the whole script, so Script\Interp does not apply).
+	// Keyframes are read, resolved and compiled kProgramWindow at a time, with at most one window queued behind the
+	// one playing: memory does not depend on the program length. The first window is solved against the current
+	// MotionConfig; a config change applies from the next window read. Fails (outErr) for an unopened reader,
+	// Cartesian keyframes without BindKinematics, or a Cartesian keyframe without an IK solution (checked over the
+	// whole program before anything is sent). A keyframe that becomes unreachable while playing (config changed)
+	// ends the program after the keyframe before it, see GetProgramError; it is never skipped.
+	bool StartProgram(std::unique_ptr<MotionScriptReader> reader, bool loop, std::wstring& outErr);
+	// Counters of the current/last program.
+	ProgramStats GetProgramStats() const { return m_programStats; }
+	// Why the current/last program stopped early; empty if it played to the end (or was stopped).
+	const std::wstring& GetProgramError() const { return m_programError; }
 	void StopScript();
 	bool IsPlaying() const { return m_playing; }
 	void Tick(); // call from a UI timer
+	// Send-time lateness of the current/last scheduled playback (empty for the legacy path).
+	MotionScheduler::Stats GetSchedulerStats() const { return m_scheduler.GetStats(); }
+	// Validation summary of the script being played (null when idle).
+	std::shared_ptr<const CompiledScript> GetCompiledScript() const { return m_compiled; }
 
 private:
-	static int ClampPos(int v, int minV, int maxV);
-	bool BuildServoTargetsFromJoints(const std::vector<std::pair<int, int>>& jointToPos,
-	                                std::vector<ArmProtocol::ServoTarget>& out);
+	static constexpr size_t kProgramWindow = 128;
+
+	// Plays frames as-is; when looping, playback wraps to loopStart instead of 0.
+	void StartFrames(std::vector<Keyframe> frames, bool loop, size_t loopStart);
+	// Expands keyframes into [first keyframe] + spline setpoints; returns false if the script
+	// cannot be splined (fewer than two keyframes), frames are left untouched then.
+	bool ExpandSpline(std::vector<Keyframe>& frames, bool loop) const;
+	// Joint targets -> Move frame in out (cleared first); false if no joint maps to a servo.
+	bool PackJoints(const JointPosArray& jointPos, int timeMs, std::vector<uint8_t>& out) const;
+	void StartScheduled();
+	MotionScheduler::SendFn BeginTimedSend();
+	// Next program window -> m_frames / m_compiled (wraps to the loop start when looping); false at the end.
+	// An unreachable Cartesian keyframe ends the window before it and the program after it (m_programError).
+	bool LoadProgramWindow();
+	static std::wstring UnreachableText(size_t index, const MotionScript::Keyframe& kf);
+	// Scheduled program: keeps one window queued behind the one playing, closes the stream at the end.
+	void QueueProgramWindow();
+	// Returns the number of targets written to out (at most kJointCount).
+	size_t BuildServoTargetsFromJoints(const JointPosArray& jointPos,
+	                                   ArmProtocol::ServoTarget (&out)[MotionConfig::kJointCount]) const;
 
 private:
 	MotionConfig m_cfg;
@@ -57,7 +138,26 @@ private:
 	bool m_loop = false;
 	std::vector<Keyframe> m_frames;
 	size_t m_frameIndex = 0;
-	ULONGLONG m_nextDue = 0; // GetTickCount64
+	PlaybackParams m_playback;
+	ULONGLONG m_nextDue = 0; // GetTickCount64; advanced by frame duration (not from 'now') to avoid drift
+	// m_frames packed against m_cfg; recompiled from m_frames when m_cfg changes.
+	std::shared_ptr<const CompiledScript> m_compiled;
+
+	// High-resolution path: m_compiled is shared with the scheduler thread; Tick() only watches for the end.
+	MotionScheduler m_scheduler;
+	bool m_scheduled = false;
+	uint32_t m_session = 0; // ArmCommsService timed-send session (invalidated by EmergencyStop)
+
+	// Program playback: m_frames / m_compiled hold the newest window only.
+	const KinematicsConfig* m_pKc = nullptr;
+	KinematicsCalib m_calib; // from *m_pKc + m_cfg, recompiled when stale
+	std::unique_ptr<MotionScriptReader> m_program;
+	MotionScriptResolver m_resolver;
+	bool m_programEnded = false;
+	bool m_programFailed = false;
+	uint64_t m_programMsSinceWrap = 0;
+	ProgramStats m_programStats;
+	std::wstring m_programError;
 };
 
 
@@ -127,6 +127,8 @@ BEGIN_MESSAGE_MAP(CMotionDiagPage, CPropertyPage)
 
 	ON_BN_CLICKED(IDC_MOTION_BTN_DEMO_PLAY, &CMotionDiagPage::OnBnClickedDemoPlay)
 	ON_BN_CLICKED(IDC_MOTION_BTN_STOP, &CMotionDiagPage::OnBnClickedStop)
+	ON_BN_CLICKED(IDC_MOTION_BTN_PLAY_FILE, &CMotionDiagPage::OnBnClickedPlayFile)
+	ON_BN_CLICKED(IDC_MOTION_BTN_EXPORT_DEMO, &CMotionDiagPage::OnBnClickedExportDemo)
 
 	ON_WM_TIMER()
 	ON_WM_DESTROY()
@@ -151,6 +153,8 @@ BOOL CMotionDiagPage::OnInitDialog()
 	m_comboJoint.SetCurSel(0);
 
 	m_motion.LoadConfig();
+	m_kc.LoadAll();
+	m_motion.BindKinematics(&m_kc);
 	LoadSelectedJointToUi();
 
 	SetIntToEdit(m_editTime, 800);
@@ -189,6 +193,7 @@ LRESULT CMotionDiagPage::OnSettingsImported(WPARAM /*wParam*/, LPARAM /*lParam*/
 		return 0;
 	}
 	m_motion.LoadConfig();
+	m_kc.LoadAll();
 	LoadSelectedJointToUi();
 	AppendLogLine(L"[INFO] Settings imported: Motion config reloaded.");
 	return 0;
@@ -200,6 +205,13 @@ void CMotionDiagPage::OnTimer(UINT_PTR nIDEvent)
 	{
 		ArmCommsService::Instance().Tick();
 		m_motion.Tick();
+		if (m_wasPlaying && !m_motion.IsPlaying())
+		{
+			AppendLogLine(L"[INFO] Script finished.");
+			LogScriptTiming();
+			LogProgramStats();
+		}
+		m_wasPlaying = m_motion.IsPlaying();
 	}
 	CPropertyPage::OnTimer(nIDEvent);
 }
@@ -437,12 +449,124 @@ void CMotionDiagPage::OnBnClickedDemoPlay()
 	const bool loop = (m_checkLoop.GetCheck() == BST_CHECKED);
 	auto frames = BuildDemoScript();
 	m_motion.StartScript(std::move(frames), loop);
-	AppendLogLine(loop ? L"[INFO] Demo script started (loop)." : L"[INFO] Demo script started.");
+	m_playingProgram = false;
+
+	static const wchar_t* const kInterpNames[] = { L"per keyframe", L"cubic spline", L"quintic spline" };
+	const auto pb = m_motion.GetPlaybackParams();
+	CString line;
+	line.Format(L"[INFO] Demo script started (%s%s%s).", kInterpNames[static_cast<int>(pb.interp)], loop ? L", loop" : L"",
+		pb.highResScheduler ? L", scheduler thread" : L"");
+	AppendLogLine(line);
+	if (const auto script = m_motion.GetCompiledScript())
+	{
+		const auto& rep = script->GetReport();
+		if (rep.clampedTargets > 0 || rep.emptyFrames > 0)
+		{
+			line.Format(L"[WARN] Script: %zu of %zu frames without a mapped joint, %zu targets clamped to the soft limits.",
+				rep.emptyFrames, rep.frames, rep.clampedTargets);
+			AppendLogLine(line);
+		}
+	}
+	m_wasPlaying = m_motion.IsPlaying();
+}
+
+void CMotionDiagPage::LogScriptTiming()
+{
+	if (!m_motion.GetPlaybackParams().highResScheduler) return;
+	const auto st = m_motion.GetSchedulerStats();
+	if (st.sent + st.sendFailures == 0) return;
+	CString line;
+	line.Format(L"[INFO] Timing: sent %llu (failed %llu), late mean %.0f us, p99 %.0f us, max %.0f us, >1 ms %llu, resyncs %llu.",
+		(unsigned long long)st.sent, (unsigned long long)st.sendFailures, st.meanLateUs, st.p99LateUs, st.maxLateUs,
+		(unsigned long long)st.lateOver1ms, (unsigned long long)st.resyncs);
+	AppendLogLine(line);
 }
 
 void CMotionDiagPage::OnBnClickedStop()
 {
+	const bool wasPlaying = m_motion.IsPlaying();
 	m_motion.StopScript();
 	ArmCommsService::Instance().EmergencyStop();
 	AppendLogLine(L"[INFO] Script stopped.");
+	if (wasPlaying)
+	{
+		LogScriptTiming();
+		LogProgramStats();
+	}
+	m_wasPlaying = false;
+}
+
+void CMotionDiagPage::LogProgramStats()
+{
+	if (!m_playingProgram) return;
+	const auto st = m_motion.GetProgramStats();
+	CString line;
+	line.Format(L"[INFO] Program: %zu keyframes in %zu windows.", st.keyframes, st.windows);
+	AppendLogLine(line);
+	if (!m_motion.GetProgramError().empty())
+	{
+		AppendLogLine(CString(L"[ERR] Program stopped early: ") + m_motion.GetProgramError().c_str());
+	}
+}
+
+void CMotionDiagPage::OnBnClickedPlayFile()
+{
+	CFileDialog dlg(TRUE, L"armt", nullptr, OFN_HIDEREADONLY | OFN_FILEMUSTEXIST,
+		L"Motion Programs (*.armt;*.arms)|*.armt;*.arms|All Files (*.*)|*.*||", this);
+	if (dlg.DoModal() != IDOK)
+	{
+		return;
+	}
+
+	SaveSelectedJointFromUi();
+	const std::wstring path(dlg.GetPathName().GetString());
+	std::unique_ptr<MotionScriptReader> reader(new MotionScriptReader());
+	std::wstring err;
+	if (!reader->Open(path, err))
+	{
+		AppendLogLine(CString(L"[ERR] Program not loaded: ") + err.c_str());
+		return;
+	}
+	const bool binary = reader->IsBinary();
+	const size_t count = reader->Count();
+	const size_t cartesian = reader->CartesianCount();
+	const double seconds = static_cast<double>(reader->TotalMs()) / 1000.0;
+
+	const bool loop = (m_checkLoop.GetCheck() == BST_CHECKED);
+	if (!m_motion.StartProgram(std::move(reader), loop, err))
+	{
+		AppendLogLine(CString(L"[ERR] Program not started: ") + err.c_str());
+		return;
+	}
+	CString line;
+	line.Format(L"[INFO] Program started (%s): %zu keyframes, %zu Cartesian, %.1f s%s.", binary ? L"binary" : L"text",
+		count, cartesian, seconds, loop ? L", loop" : L"");
+	AppendLogLine(line);
+	m_playingProgram = true;
+	m_wasPlaying = m_motion.IsPlaying();
+}
+
+void CMotionDiagPage::OnBnClickedExportDemo()
+{
+	CFileDialog dlg(FALSE, L"armt", L"demo.armt", OFN_HIDEREADONLY | OFN_OVERWRITEPROMPT,
+		L"Motion Program, text (*.armt)|*.armt|Motion Program, binary (*.arms)|*.arms||", this);
+	if (dlg.DoModal() != IDOK)
+	{
+		return;
+	}
+
+	SaveSelectedJointFromUi();
+	const auto demo = BuildDemoScript();
+	std::vector<MotionScript::Keyframe> frames;
+	frames.reserve(demo.size());
+	for (const auto& kf : demo)
+	{
+		frames.push_back(MotionScript::FromJoints(kf));
+	}
+
+	const std::wstring path(dlg.GetPathName().GetString());
+	const bool binary = dlg.GetFileExt().CompareNoCase(L"arms") == 0;
+	std::wstring err;
+	const bool ok = binary ? MotionScript::SaveBinary(path, frames, 0, err) : MotionScript::SaveText(path, frames, 0, err);
+	AppendLogLine(ok ? CString(L"[INFO] Demo script exported: ") + path.c_str() : CString(L"[ERR] ") + err.c_str());
 }
@@ -5,13 +5,14 @@
 
 #include <vector>
 
+#include "KinematicsConfig.h"
 #include "MotionController.h"
 
 // Motion diagnostics / control page:
 // - joint calibration (servoId/min/max/home/invert)
 // - joint move + Home
 // - ReadAll (0x15)
-// - demo keyframe script playback
+// - demo keyframe script playback, program files (MotionScript) play / demo export
 // - shows shared comms logs
 class CMotionDiagPage : public CPropertyPage
 {
@@ -40,6 +41,8 @@ protected:
 
 	afx_msg void OnBnClickedDemoPlay();
 	afx_msg void OnBnClickedStop();
+	afx_msg void OnBnClickedPlayFile();
+	afx_msg void OnBnClickedExportDemo();
 	afx_msg void OnTimer(UINT_PTR nIDEvent);
 	afx_msg void OnDestroy();
 	afx_msg LRESULT OnSettingsImported(WPARAM wParam, LPARAM lParam);
@@ -57,6 +60,10 @@ private:
 	void SetIntToEdit(CEdit& edit, int v);
 
 	std::vector<MotionController::Keyframe> BuildDemoScript() const;
+	// One log line with the scheduler's send-time lateness (when the script ran on the scheduler thread).
+	void LogScriptTiming();
+	// Keyframe / IK counters after a program file (MotionController::GetProgramStats).
+	void LogProgramStats();
 
 private:
 	CComboBox m_comboCom;
@@ -79,8 +86,11 @@ private:
 	bool m_useSim = true;
 	int m_logToken = 0;
 	UINT_PTR m_timerId = 0;
+	bool m_wasPlaying = false;
+	bool m_playingProgram = false; // last start was a program file (not the demo script)
 
 	MotionController m_motion;
+	KinematicsConfig m_kc; // Cartesian keyframes of program files
 	std::vector<CString> m_logLines;
 };
 
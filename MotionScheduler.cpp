@@ -0,0 +1,261 @@
+#include "pch.h"
+
+#include "MotionScheduler.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+MotionScheduler::~MotionScheduler()
+{
+	Stop();
+}
+
+void MotionScheduler::Start(ScriptPtr script, bool loop, SendFn send)
+{
+	Launch(std::move(script), loop, false, std::move(send));
+}
+
+void MotionScheduler::Launch(ScriptPtr script, bool loop, bool stream, SendFn send)
+{
+	Stop();
+
+	m_script = std::move(script);
+	m_loop = loop && m_script && m_script->LoopMs() > 0;
+	m_send = std::move(send);
+	{
+		std::lock_guard<std::mutex> lock(m_statsMu);
+		m_stats = Stats{};
+		m_lateSumUs = 0.0;
+		m_lateCount = 0;
+		m_hist.fill(0);
+	}
+	const bool playable = m_script && m_script->FrameCount() > 0 && m_send;
+	{
+		std::lock_guard<std::mutex> lock(m_waitMu);
+		m_stop = false;
+		m_replacement.reset();
+		m_queue.clear();
+		m_streamOpen = stream && playable;
+	}
+	if (!playable)
+	{
+		return;
+	}
+	m_running.store(true, std::memory_order_release);
+	m_th = std::thread([this]() { Run(); });
+}
+
+void MotionScheduler::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_waitMu);
+		m_stop = true;
+	}
+	m_waitCv.notify_all();
+	if (m_th.joinable())
+	{
+		m_th.join();
+	}
+	m_running.store(false, std::memory_order_release);
+}
+
+void MotionScheduler::Replace(ScriptPtr script)
+{
+	std::lock_guard<std::mutex> lock(m_waitMu);
+	if (m_script && script && script->FrameCount() == m_script->FrameCount())
+	{
+		m_replacement = std::move(script);
+	}
+}
+
+void MotionScheduler::StartStream(ScriptPtr first, SendFn send)
+{
+	Launch(std::move(first), false, true, std::move(send));
+}
+
+void MotionScheduler::Append(ScriptPtr next)
+{
+	if (!next || next->FrameCount() == 0)
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_waitMu);
+		if (!m_streamOpen) return;
+		m_queue.push_back(std::move(next));
+	}
+	m_waitCv.notify_all();
+}
+
+void MotionScheduler::CloseStream()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_waitMu);
+		m_streamOpen = false;
+	}
+	m_waitCv.notify_all();
+}
+
+size_t MotionScheduler::Queued() const
+{
+	std::lock_guard<std::mutex> lock(m_waitMu);
+	return m_queue.size();
+}
+
+bool MotionScheduler::NextQueued(ScriptPtr& out)
+{
+	std::unique_lock<std::mutex> lock(m_waitMu);
+	if (m_queue.empty() && m_streamOpen && !m_stop)
+	{
+		{
+			std::lock_guard<std::mutex> statsLock(m_statsMu);
+			m_stats.underruns++;
+		}
+		m_waitCv.wait(lock, [this]() { return m_stop || !m_queue.empty() || !m_streamOpen; });
+	}
+	if (m_stop || m_queue.empty())
+	{
+		return false;
+	}
+	out = std::move(m_queue.front());
+	m_queue.pop_front();
+	return true;
+}
+
+bool MotionScheduler::WaitUntil(Clock::time_point deadline)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_waitMu);
+		if (m_waitCv.wait_until(lock, deadline - std::chrono::microseconds(m_params.spinUs), [this]() { return m_stop; }))
+		{
+			return false;
+		}
+	}
+	// Last stretch: the sleep above may wake up to a timer tick late, a yield loop does not.
+	while (Clock::now() < deadline)
+	{
+		std::this_thread::yield();
+	}
+	std::lock_guard<std::mutex> lock(m_waitMu);
+	return !m_stop;
+}
+
+void MotionScheduler::Record(double lateUs, bool sent, bool ok)
+{
+	std::lock_guard<std::mutex> lock(m_statsMu);
+	if (sent)
+	{
+		if (ok) m_stats.sent++;
+		else m_stats.sendFailures++;
+	}
+	m_lateSumUs += lateUs;
+	m_lateCount++;
+	if (lateUs > 1000.0) m_stats.lateOver1ms++;
+	m_stats.maxLateUs = std::max(m_stats.maxLateUs, lateUs);
+	const size_t bin = std::min(kBins - 1, static_cast<size_t>(std::max(0.0, lateUs) / kBinUs));
+	m_hist[bin]++;
+}
+
+MotionScheduler::Stats MotionScheduler::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_statsMu);
+	Stats s = m_stats;
+	if (m_lateCount > 0)
+	{
+		s.meanLateUs = m_lateSumUs / static_cast<double>(m_lateCount);
+		const uint64_t rank = m_lateCount - m_lateCount / 100; // smallest bin holding 99% of the samples
+		uint64_t acc = 0;
+		for (size_t i = 0; i < kBins; i++)
+		{
+			if (acc + m_hist[i] >= rank)
+			{
+				// Linear inside the bin, never above the measured maximum (the bin's upper edge can be).
+				const double frac = static_cast<double>(rank - acc) / static_cast<double>(m_hist[i]);
+				s.p99LateUs = std::min((static_cast<double>(i) + frac) * kBinUs, s.maxLateUs);
+				break;
+			}
+			acc += m_hist[i];
+		}
+	}
+	return s;
+}
+
+void MotionScheduler::Run()
+{
+#ifdef _WIN32
+	// 1 ms scheduler tick while playing (the default 15.6 ms would make every wait end up in the spin loop).
+	timeBeginPeriod(1);
+	if (m_params.raisePriority)
+	{
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+	}
+#endif
+
+	// The thread keeps its own reference: Start/Replace never free a script that is being played.
+	ScriptPtr script = m_script;
+	Clock::time_point base = Clock::now(); // deadline of frame k = base + startMs(k)
+	size_t index = 0;
+	for (;;)
+	{
+		const CompiledScript::FrameRef& f = script->Frame(index);
+		const Clock::time_point due = base + std::chrono::milliseconds(f.startMs);
+		if (!WaitUntil(due))
+		{
+			break;
+		}
+
+		const Clock::time_point sendAt = Clock::now();
+		const bool hasBytes = f.size > 0;
+		const bool ok = hasBytes ? m_send(script->Bytes(f), f.size) : true;
+		Record(std::chrono::duration<double, std::micro>(sendAt - due).count(), hasBytes, ok);
+
+		const Clock::duration delta = std::chrono::milliseconds(f.durationMs);
+		if (++index >= script->FrameCount())
+		{
+			if (m_loop)
+			{
+				index = script->LoopStart();
+				base += std::chrono::milliseconds(script->LoopMs());
+				std::lock_guard<std::mutex> lock(m_statsMu);
+				m_stats.loops++;
+			}
+			else
+			{
+				// Streamed: the next script starts where this one ends (after an underrun the resync below applies).
+				const Clock::duration length = std::chrono::milliseconds(script->TotalMs());
+				if (!NextQueued(script))
+				{
+					break;
+				}
+				index = 0;
+				base += length;
+			}
+		}
+
+		// Deadlines come from the precompiled offsets, never from 'now': lateness does not accumulate.
+		const Clock::time_point next = base + std::chrono::milliseconds(script->Frame(index).startMs);
+		const Clock::time_point now = Clock::now();
+		if (delta > Clock::duration::zero() && now - next > delta)
+		{
+			// Stalled for more than a frame (debugger, suspend): play on from now instead of bursting.
+			base += now - next;
+			std::lock_guard<std::mutex> lock(m_statsMu);
+			m_stats.resyncs++;
+		}
+
+		std::lock_guard<std::mutex> lock(m_waitMu);
+		if (m_replacement)
+		{
+			script = std::move(m_replacement);
+		}
+	}
+
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+	m_running.store(false, std::memory_order_release);
+}
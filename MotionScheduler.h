@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "CompiledScript.h"
+
+// High-resolution playback of a CompiledScript on a dedicated thread.
+// - Deadlines are absolute: frame k is due at start + its precompiled startMs (steady_clock, QPC on MSVC),
+//   so a late send never shifts the frames after it; a loop wrap moves the base by LoopMs(). Only a stall
+//   longer than one frame resyncs to now (counted in Stats::resyncs), like the UI-timer playback did.
+// - Waits on a condition variable until spinUs before the deadline (1 ms timer resolution on Windows while running),
+//   then yields in a loop until the deadline; Stop() wakes the wait immediately.
+// - Frames are already packed in the script arena; the thread only calls send(pointer, size), which must be
+//   thread-safe (ArmCommsService::SendTimed). An empty frame is a pause: nothing is sent, its duration still counts.
+// - Replace() swaps in a recompiled script (same frames, new MotionConfig) at the next frame boundary.
+// - Streamed playback (long programs): StartStream plays the first script, Append queues the next ones, each
+//   starting where the previous one ends. If the queue runs dry before CloseStream, the thread waits for the
+//   next Append (Stats::underruns) and resumes from then on.
+// - Lateness (actual send - deadline) goes into a fixed histogram, so GetStats can report p99 without the
+//   thread allocating.
+class MotionScheduler
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	using SendFn = std::function<bool(const uint8_t* bytes, size_t len)>;
+	using ScriptPtr = std::shared_ptr<const CompiledScript>;
+
+	struct Params
+	{
+		int spinUs = 1500;          // busy-wait window before each deadline (covers the sleep wake-up error)
+		bool raisePriority = true;  // THREAD_PRIORITY_HIGHEST on Windows
+	};
+
+	struct Stats
+	{
+		uint64_t sent = 0;
+		uint64_t sendFailures = 0;  // send() returned false (not connected, write error)
+		uint64_t loops = 0;         // wraps to loopStart
+		uint64_t resyncs = 0;       // fell more than one frame behind, deadline moved to now
+		uint64_t underruns = 0;     // streamed playback ran out of queued scripts
+		uint64_t lateOver1ms = 0;
+		double meanLateUs = 0.0;
+		double p99LateUs = 0.0;     // histogram resolution kBinUs
+		double maxLateUs = 0.0;
+	};
+
+public:
+	MotionScheduler() = default;
+	explicit MotionScheduler(const Params& params) : m_params(params) {}
+	~MotionScheduler();
+
+	MotionScheduler(const MotionScheduler&) = delete;
+	MotionScheduler& operator=(const MotionScheduler&) = delete;
+
+	// Stops any running playback, resets the statistics and starts at once (the first frame is due now).
+	// Looping playback wraps to script->LoopStart() after the last frame (a loop of zero length plays once).
+	void Start(ScriptPtr script, bool loop, SendFn send);
+	// Recompiled version of the running script (same frame count, else ignored); taken at the next frame.
+	void Replace(ScriptPtr script);
+	// Streamed playback: no looping, the scripts play back to back until the queue is empty after CloseStream.
+	void StartStream(ScriptPtr first, SendFn send);
+	void Append(ScriptPtr next);
+	void CloseStream();
+	// Scripts queued behind the one playing (the producer keeps this small to bound memory).
+	size_t Queued() const;
+	// Returns after the thread has exited; no send happens after Stop returns.
+	void Stop();
+	// False once a non-looping list has been played out (or after Stop).
+	bool IsRunning() const { return m_running.load(std::memory_order_acquire); }
+
+	Stats GetStats() const;
+
+private:
+	static constexpr int kBinUs = 50;
+	static constexpr size_t kBins = 2000; // 0..100 ms; later sends land in the last bin
+
+	void Launch(ScriptPtr script, bool loop, bool stream, SendFn send);
+	void Run();
+	bool WaitUntil(Clock::time_point deadline); // false if stopped
+	bool NextQueued(ScriptPtr& out);            // false if stopped, or the stream is closed and drained
+	void Record(double lateUs, bool sent, bool ok);
+
+private:
+	Params m_params;
+
+	std::thread m_th;
+	std::atomic<bool> m_running{ false };
+
+	// Playback program: written by Start before the thread starts, read-only while it runs.
+	ScriptPtr m_script;
+	bool m_loop = false;
+	SendFn m_send;
+
+	mutable std::mutex m_waitMu;
+	std::condition_variable m_waitCv;
+	bool m_stop = false;
+	ScriptPtr m_replacement; // m_waitMu
+	std::deque<ScriptPtr> m_queue; // m_waitMu
+	bool m_streamOpen = false;     // m_waitMu
+
+	mutable std::mutex m_statsMu;
+	Stats m_stats;
+	double m_lateSumUs = 0.0;
+	uint64_t m_lateCount = 0;
+	std::array<uint32_t, kBins> m_hist{};
+};
@@ -0,0 +1,573 @@
+#include "pch.h"
+
+#include "MotionScript.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	// Binary format version: bump when FileHeader/Record layout or meaning changes.
+	constexpr uint32_t kFileVersion = 1;
+	constexpr char kMagic[8] = { 'A', 'R', 'M', 'S', 'C', 'R', 'P', 'T' };
+	constexpr char kTextMagic[] = "ARMSCRIPT";
+
+	// Little-endian, like every target this builds for (x86/x64, ARM).
+	struct FileHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t headerBytes;
+		uint32_t recordBytes;
+		uint32_t reserved;
+		uint64_t count;
+		uint64_t loopStart;
+	};
+	static_assert(sizeof(FileHeader) == 40, "FileHeader layout must stay fixed");
+
+	struct Record
+	{
+		uint8_t kind;      // MotionScript::Kind
+		uint8_t jointMask; // bit j-1: pos[j-1] is set
+		uint16_t reserved;
+		int32_t durationMs;
+		int16_t pos[6];
+		float pose[4];     // x, y, z (mm), pitch (deg); Cartesian only
+	};
+	static_assert(sizeof(Record) == 36, "Record layout must stay fixed");
+	static_assert(MotionConfig::kJointCount == 6, "Record stores six joints");
+
+	constexpr int kMaxPos = 1000;
+
+	enum class LineType
+	{
+		Blank,
+		Header,
+		Loop,
+		Keyframe,
+		Error,
+	};
+
+	// Copies one line (without '\r\n' and comment) into buf; returns the offset of the next line.
+	size_t ReadLine(const uint8_t* data, size_t size, size_t from, char (&buf)[MotionScript::kMaxTextLine + 1], bool& tooLong)
+	{
+		const void* nl = std::memchr(data + from, '\n', size - from);
+		const size_t end = nl ? static_cast<size_t>(static_cast<const uint8_t*>(nl) - data) : size;
+		size_t len = end - from;
+		const char* p = reinterpret_cast<const char*>(data + from);
+		if (const void* hash = std::memchr(p, '#', len))
+		{
+			len = static_cast<size_t>(static_cast<const char*>(hash) - p);
+		}
+		while (len > 0 && (p[len - 1] == '\r' || p[len - 1] == ' ' || p[len - 1] == '\t')) len--;
+		tooLong = len > MotionScript::kMaxTextLine;
+		if (tooLong) len = 0;
+		std::memcpy(buf, p, len);
+		buf[len] = '\0';
+		return nl ? end + 1 : size;
+	}
+
+	const char* NextToken(const char*& p)
+	{
+		while (*p == ' ' || *p == '\t') p++;
+		return *p ? p : nullptr;
+	}
+
+	bool ParseInt(const char*& p, long minV, long maxV, long& out)
+	{
+		if (!NextToken(p)) return false;
+		char* end = nullptr;
+		out = std::strtol(p, &end, 10);
+		if (end == p || (*end != '\0' && *end != ' ' && *end != '\t')) return false;
+		p = end;
+		return out >= minV && out <= maxV;
+	}
+
+	bool ParseDouble(const char*& p, double& out)
+	{
+		if (!NextToken(p)) return false;
+		char* end = nullptr;
+		out = std::strtod(p, &end);
+		if (end == p || (*end != '\0' && *end != ' ' && *end != '\t')) return false;
+		p = end;
+		return std::isfinite(out);
+	}
+
+	// '-' = not set, else 0..kMaxPos
+	bool ParseJoint(const char*& p, int& out)
+	{
+		if (!NextToken(p)) return false;
+		if (p[0] == '-' && (p[1] == '\0' || p[1] == ' ' || p[1] == '\t'))
+		{
+			p++;
+			out = -1;
+			return true;
+		}
+		long v = 0;
+		if (!ParseInt(p, 0, kMaxPos, v)) return false;
+		out = static_cast<int>(v);
+		return true;
+	}
+
+	bool StartsWithWord(const char* p, const char* word)
+	{
+		const size_t n = std::strlen(word);
+		return std::strncmp(p, word, n) == 0 && (p[n] == '\0' || p[n] == ' ' || p[n] == '\t');
+	}
+
+	// value: version (Header) or loop index (Loop)
+	LineType ParseLine(const char* line, MotionScript::Keyframe& kf, long& value, const wchar_t*& err)
+	{
+		const char* p = line;
+		if (!NextToken(p)) return LineType::Blank;
+
+		if (StartsWithWord(p, kTextMagic))
+		{
+			p += sizeof(kTextMagic) - 1;
+			if (!ParseInt(p, 1, 1000000, value) || NextToken(p))
+			{
+				err = L"expected \"ARMSCRIPT <version>\"";
+				return LineType::Error;
+			}
+			return LineType::Header;
+		}
+		if (StartsWithWord(p, "loop"))
+		{
+			p += 4;
+			if (!ParseInt(p, 0, 0x7FFFFFFF, value) || NextToken(p))
+			{
+				err = L"expected \"loop <keyframe index>\"";
+				return LineType::Error;
+			}
+			return LineType::Loop;
+		}
+
+		const char type = *p++;
+		if ((type != 'J' && type != 'C') || (*p != ' ' && *p != '\t' && *p != '\0'))
+		{
+			err = L"unknown line (expected J, C, loop or a comment)";
+			return LineType::Error;
+		}
+		kf = MotionScript::Keyframe();
+		long ms = 0;
+		if (!ParseInt(p, 0, 0x7FFFFFFF, ms))
+		{
+			err = L"bad duration (ms, >= 0)";
+			return LineType::Error;
+		}
+		kf.durationMs = static_cast<int>(ms);
+
+		if (type == 'C')
+		{
+			kf.kind = MotionScript::Kind::Cartesian;
+			if (!ParseDouble(p, kf.x_mm) || !ParseDouble(p, kf.y_mm) || !ParseDouble(p, kf.z_mm) || !ParseDouble(p, kf.pitch_deg))
+			{
+				err = L"expected <x> <y> <z> <pitch> after the duration";
+				return LineType::Error;
+			}
+			if (!NextToken(p))
+			{
+				return LineType::Keyframe;
+			}
+		}
+		for (int j = 1; j <= MotionConfig::kJointCount; j++)
+		{
+			if (!ParseJoint(p, kf.jointPos[j]))
+			{
+				err = L"expected 6 joint fields (0..1000 or '-')";
+				return LineType::Error;
+			}
+		}
+		if (NextToken(p))
+		{
+			err = L"unexpected text after the keyframe";
+			return LineType::Error;
+		}
+		return LineType::Keyframe;
+	}
+
+	std::wstring LineError(size_t lineNo, const wchar_t* what)
+	{
+		return L"Line " + std::to_wstring(lineNo) + L": " + what;
+	}
+
+	// Atomic (via MappedFile::WriteAtomic), with the error text the page logs.
+	bool WriteWholeFile(const std::wstring& path, const void* data, size_t size, std::wstring& outErr)
+	{
+		if (!MappedFile::WriteAtomic(path, data, size))
+		{
+			outErr = L"Cannot write " + path;
+			return false;
+		}
+		return true;
+	}
+}
+
+bool MotionScript::SaveBinary(const std::wstring& path, const std::vector<Keyframe>& frames, size_t loopStart, std::wstring& outErr)
+{
+	FileHeader h = {};
+	std::memcpy(h.magic, kMagic, sizeof(kMagic));
+	h.version = kFileVersion;
+	h.headerBytes = sizeof(FileHeader);
+	h.recordBytes = sizeof(Record);
+	h.count = frames.size();
+	h.loopStart = (loopStart < frames.size()) ? loopStart : 0;
+
+	std::vector<uint8_t> buf(sizeof(FileHeader) + frames.size() * sizeof(Record));
+	std::memcpy(buf.data(), &h, sizeof(h));
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		const Keyframe& kf = frames[i];
+		Record r = {};
+		r.kind = static_cast<uint8_t>(kf.kind);
+		r.durationMs = (kf.durationMs > 0) ? kf.durationMs : 0;
+		for (int j = 1; j <= MotionConfig::kJointCount; j++)
+		{
+			if (kf.jointPos[j] < 0) continue;
+			r.jointMask |= static_cast<uint8_t>(1u << (j - 1));
+			r.pos[j - 1] = static_cast<int16_t>((kf.jointPos[j] < kMaxPos) ? kf.jointPos[j] : kMaxPos);
+		}
+		if (kf.kind == Kind::Cartesian)
+		{
+			r.pose[0] = static_cast<float>(kf.x_mm);
+			r.pose[1] = static_cast<float>(kf.y_mm);
+			r.pose[2] = static_cast<float>(kf.z_mm);
+			r.pose[3] = static_cast<float>(kf.pitch_deg);
+		}
+		std::memcpy(buf.data() + sizeof(FileHeader) + i * sizeof(Record), &r, sizeof(r));
+	}
+	return WriteWholeFile(path, buf.data(), buf.size(), outErr);
+}
+
+bool MotionScript::SaveText(const std::wstring& path, const std::vector<Keyframe>& frames, size_t loopStart, std::wstring& outErr)
+{
+	std::string text;
+	text.reserve(64 + frames.size() * 48);
+	char line[kMaxTextLine + 1];
+	std::snprintf(line, sizeof(line), "%s %d\n", kTextMagic, kTextVersion);
+	text += line;
+	if (loopStart > 0 && loopStart < frames.size())
+	{
+		std::snprintf(line, sizeof(line), "loop %zu\n", loopStart);
+		text += line;
+	}
+	for (const Keyframe& kf : frames)
+	{
+		const int ms = (kf.durationMs > 0) ? kf.durationMs : 0;
+		if (kf.kind == Kind::Cartesian)
+		{
+			std::snprintf(line, sizeof(line), "C %d %.3f %.3f %.3f %.3f", ms, kf.x_mm, kf.y_mm, kf.z_mm, kf.pitch_deg);
+		}
+		else
+		{
+			std::snprintf(line, sizeof(line), "J %d", ms);
+		}
+		text += line;
+
+		bool anyJoint = kf.kind == Kind::Joint;
+		for (int j = 1; j <= MotionConfig::kJointCount; j++) anyJoint = anyJoint || kf.jointPos[j] >= 0;
+		if (anyJoint)
+		{
+			for (int j = 1; j <= MotionConfig::kJointCount; j++)
+			{
+				if (kf.jointPos[j] < 0)
+				{
+					text += " -";
+					continue;
+				}
+				std::snprintf(line, sizeof(line), " %d", (kf.jointPos[j] < kMaxPos) ? kf.jointPos[j] : kMaxPos);
+				text += line;
+			}
+		}
+		text += '\n';
+	}
+	return WriteWholeFile(path, text.data(), text.size(), outErr);
+}
+
+MotionScript::Keyframe MotionScript::FromJoints(const CompiledScript::Keyframe& kf)
+{
+	Keyframe out;
+	out.kind = Kind::Joint;
+	out.durationMs = kf.durationMs;
+	out.jointPos = kf.jointPos;
+	return out;
+}
+
+bool MotionScriptReader::Open(const std::wstring& path, std::wstring& outErr)
+{
+	Close();
+	if (!m_file.OpenRead(path))
+	{
+		outErr = L"Cannot open " + path + L" (missing or empty).";
+		return false;
+	}
+	m_data = m_file.Data();
+	m_size = m_file.Size();
+	if (!Validate(outErr))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool MotionScriptReader::OpenMemory(const uint8_t* data, size_t size, std::wstring& outErr)
+{
+	Close();
+	if (!data || size == 0)
+	{
+		outErr = L"Empty program.";
+		return false;
+	}
+	m_data = data;
+	m_size = size;
+	if (!Validate(outErr))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MotionScriptReader::Close()
+{
+	m_file.Close();
+	m_data = nullptr;
+	m_size = 0;
+	m_binary = false;
+	m_count = m_cartesianCount = m_loopStart = 0;
+	m_totalMs = 0;
+	m_index = m_cursor = m_firstOffset = m_loopOffset = 0;
+}
+
+bool MotionScriptReader::Validate(std::wstring& outErr)
+{
+	m_binary = m_size >= sizeof(kMagic) && std::memcmp(m_data, kMagic, sizeof(kMagic)) == 0;
+	if (m_binary)
+	{
+		FileHeader h;
+		if (m_size < sizeof(FileHeader))
+		{
+			outErr = L"Truncated header.";
+			return false;
+		}
+		std::memcpy(&h, m_data, sizeof(h));
+		if (h.version != kFileVersion || h.headerBytes != sizeof(FileHeader) || h.recordBytes != sizeof(Record))
+		{
+			outErr = L"Unsupported binary version " + std::to_wstring(h.version) + L".";
+			return false;
+		}
+		if (h.count > (m_size - sizeof(FileHeader)) / sizeof(Record) || m_size != sizeof(FileHeader) + h.count * sizeof(Record))
+		{
+			outErr = L"File size does not match the keyframe count (truncated?).";
+			return false;
+		}
+		m_count = static_cast<size_t>(h.count);
+		if (m_count > 0 && h.loopStart >= h.count)
+		{
+			outErr = L"Loop start beyond the last keyframe.";
+			return false;
+		}
+		m_loopStart = static_cast<size_t>(h.loopStart);
+		for (size_t i = 0; i < m_count; i++)
+		{
+			Record r;
+			std::memcpy(&r, m_data + sizeof(FileHeader) + i * sizeof(Record), sizeof(r));
+			bool ok = r.kind <= static_cast<uint8_t>(MotionScript::Kind::Cartesian) && r.durationMs >= 0;
+			for (int j = 0; ok && j < MotionConfig::kJointCount; j++)
+			{
+				ok = !(r.jointMask & (1u << j)) || (r.pos[j] >= 0 && r.pos[j] <= kMaxPos);
+			}
+			for (int k = 0; ok && k < 4; k++) ok = std::isfinite(r.pose[k]);
+			if (!ok)
+			{
+				outErr = L"Keyframe " + std::to_wstring(i) + L": invalid record.";
+				return false;
+			}
+			if (r.kind == static_cast<uint8_t>(MotionScript::Kind::Cartesian)) m_cartesianCount++;
+			m_totalMs += static_cast<uint64_t>(r.durationMs);
+		}
+	}
+	else
+	{
+		size_t offset = 0;
+		if (m_size >= 3 && m_data[0] == 0xEF && m_data[1] == 0xBB && m_data[2] == 0xBF) offset = 3; // UTF-8 BOM
+		char buf[MotionScript::kMaxTextLine + 1];
+		bool header = false;
+		bool loopSet = false;
+		size_t lineNo = 0;
+		while (offset < m_size)
+		{
+			const size_t lineStart = offset;
+			bool tooLong = false;
+			offset = ReadLine(m_data, m_size, offset, buf, tooLong);
+			lineNo++;
+			if (tooLong)
+			{
+				outErr = LineError(lineNo, L"line too long");
+				return false;
+			}
+			Keyframe kf;
+			long value = 0;
+			const wchar_t* err = L"";
+			const LineType type = ParseLine(buf, kf, value, err);
+			if (type == LineType::Blank) continue;
+			if (type == LineType::Error)
+			{
+				outErr = LineError(lineNo, err);
+				return false;
+			}
+			if (!header)
+			{
+				if (type != LineType::Header)
+				{
+					outErr = LineError(lineNo, L"not a motion script (expected \"ARMSCRIPT 1\")");
+					return false;
+				}
+				if (value != MotionScript::kTextVersion)
+				{
+					outErr = LineError(lineNo, L"unsupported script version");
+					return false;
+				}
+				header = true;
+				continue;
+			}
+			if (type == LineType::Header)
+			{
+				outErr = LineError(lineNo, L"duplicate header");
+				return false;
+			}
+			if (type == LineType::Loop)
+			{
+				if (loopSet || m_count > 0)
+				{
+					outErr = LineError(lineNo, L"\"loop\" must come once, before the first keyframe");
+					return false;
+				}
+				m_loopStart = static_cast<size_t>(value);
+				loopSet = true;
+				continue;
+			}
+			if (m_count == 0) m_firstOffset = lineStart;
+			if (m_count == m_loopStart) m_loopOffset = lineStart;
+			if (kf.kind == MotionScript::Kind::Cartesian) m_cartesianCount++;
+			m_totalMs += static_cast<uint64_t>(kf.durationMs);
+			m_count++;
+		}
+		if (!header)
+		{
+			outErr = L"Not a motion script (no \"ARMSCRIPT 1\" header).";
+			return false;
+		}
+		if (m_count > 0 && m_loopStart >= m_count)
+		{
+			outErr = L"Loop start beyond the last keyframe.";
+			return false;
+		}
+	}
+	if (m_count == 0)
+	{
+		outErr = L"The program has no keyframes.";
+		return false;
+	}
+	Rewind();
+	return true;
+}
+
+void MotionScriptReader::Rewind()
+{
+	m_index = 0;
+	m_cursor = m_firstOffset;
+}
+
+void MotionScriptReader::RewindToLoopStart()
+{
+	m_index = m_loopStart;
+	m_cursor = m_loopOffset;
+}
+
+void MotionScriptReader::DecodeRecord(size_t index, Keyframe& out) const
+{
+	Record r;
+	std::memcpy(&r, m_data + sizeof(FileHeader) + index * sizeof(Record), sizeof(r));
+	out = Keyframe();
+	out.kind = static_cast<MotionScript::Kind>(r.kind);
+	out.durationMs = r.durationMs;
+	for (int j = 1; j <= MotionConfig::kJointCount; j++)
+	{
+		if (r.jointMask & (1u << (j - 1))) out.jointPos[j] = r.pos[j - 1];
+	}
+	if (out.kind == MotionScript::Kind::Cartesian)
+	{
+		out.x_mm = r.pose[0];
+		out.y_mm = r.pose[1];
+		out.z_mm = r.pose[2];
+		out.pitch_deg = r.pose[3];
+	}
+}
+
+bool MotionScriptReader::NextText(Keyframe& out)
+{
+	char buf[MotionScript::kMaxTextLine + 1];
+	while (m_cursor < m_size)
+	{
+		bool tooLong = false;
+		m_cursor = ReadLine(m_data, m_size, m_cursor, buf, tooLong);
+		long value = 0;
+		const wchar_t* err = L"";
+		if (ParseLine(buf, out, value, err) == LineType::Keyframe)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool MotionScriptReader::Next(Keyframe& out)
+{
+	if (!m_data || m_index >= m_count)
+	{
+		return false;
+	}
+	if (m_binary)
+	{
+		DecodeRecord(m_index, out);
+	}
+	else if (!NextText(out))
+	{
+		return false;
+	}
+	m_index++;
+	return true;
+}
+
+bool MotionScriptResolver::Resolve(const KinematicsCalib& calib, const MotionScript::Keyframe& in, CompiledScript::Keyframe& out)
+{
+	out.durationMs = in.durationMs;
+	out.jointPos = in.jointPos;
+	if (in.kind != MotionScript::Kind::Cartesian)
+	{
+		return true;
+	}
+
+	// J1..J5 come from IK only; the file's joint fields are kept for the joints IK does not solve.
+	for (int j = 1; j <= ArmKinematics::kJointCount; j++) out.jointPos[j] = -1;
+	ArmKinematics::PoseTarget target;
+	target.x_mm = in.x_mm;
+	target.y_mm = in.y_mm;
+	target.z_mm = in.z_mm;
+	target.pitch_deg = in.pitch_deg;
+	ArmKinematics::ServoPos sp;
+	if (!ArmKinematics::InverseKinematics(calib, target, m_hasSeed ? &m_seed : nullptr, m_ik)
+		|| ArmKinematics::JointAnglesToServoPos(calib, m_ik.chosenQ, sp) != ArmKinematics::IkError::None)
+	{
+		out.jointPos.fill(-1);
+		return false;
+	}
+	for (int j = 1; j <= ArmKinematics::kJointCount; j++) out.jointPos[j] = sp.pos[j];
+	m_seed = m_ik.chosenQ;
+	m_hasSeed = true;
+	return true;
+}
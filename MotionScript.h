@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ArmKinematics.h"
+#include "CompiledScript.h"
+#include "KinematicsCalib.h"
+#include "MappedFile.h"
+
+// On-disk motion programs (shareable, any length) and their streaming reader.
+//
+// Keyframes are either joint targets (servo positions, as in the demo script) or Cartesian targets
+// (x/y/z in mm + pitch in deg in the Base frame, solved by IK at playback time).
+//
+// Binary (.arms): FileHeader + Record[count], fixed-size little-endian records, so a keyframe is found by
+// index without an index table. Text (.armt), one keyframe per line:
+//   ARMSCRIPT 1                                  first line (after comments)
+//   loop <index>                                 optional, before the first keyframe: where looping wraps to
+//   J <ms> <p1> <p2> <p3> <p4> <p5> <p6>         joint keyframe, '-' = joint not moved
+//   C <ms> <x> <y> <z> <pitch> [<p1> .. <p6>]    Cartesian keyframe; optional joint fields only for joints
+//                                                IK does not solve (J6, the gripper)
+//   # comment (also after a keyframe), blank lines ignored
+class MotionScript
+{
+public:
+	enum class Kind : uint8_t
+	{
+		Joint = 0,
+		Cartesian = 1,
+	};
+
+	struct Keyframe
+	{
+		Kind kind = Kind::Joint;
+		int durationMs = 800;
+		// Joint keyframe: targets 1..6 (-1 = not set). Cartesian: only joints IK leaves unset are used.
+		CompiledScript::JointPosArray jointPos;
+		// Cartesian keyframe (Base frame)
+		double x_mm = 0.0;
+		double y_mm = 0.0;
+		double z_mm = 0.0;
+		double pitch_deg = 0.0;
+
+		Keyframe() { jointPos.fill(-1); }
+	};
+
+	static constexpr int kTextVersion = 1;
+	static constexpr size_t kMaxTextLine = 256;
+
+	// Whole program in memory -> file (export of built-in scripts; written via "<path>.tmp" + rename).
+	static bool SaveBinary(const std::wstring& path, const std::vector<Keyframe>& frames, size_t loopStart, std::wstring& outErr);
+	static bool SaveText(const std::wstring& path, const std::vector<Keyframe>& frames, size_t loopStart, std::wstring& outErr);
+
+	// Joint keyframe from a playback keyframe (demo script export).
+	static Keyframe FromJoints(const CompiledScript::Keyframe& kf);
+};
+
+// Streaming reader over a memory-mapped program file: only the pages being played are resident, so memory does
+// not grow with the program length. Open() validates the whole file in one pass (syntax, counts, loop index)
+// without storing keyframes, so a broken program is rejected before the arm moves and Next() cannot fail halfway.
+class MotionScriptReader
+{
+public:
+	using Keyframe = MotionScript::Keyframe;
+
+	MotionScriptReader() = default;
+	MotionScriptReader(const MotionScriptReader&) = delete;
+	MotionScriptReader& operator=(const MotionScriptReader&) = delete;
+
+	// Detects binary / text by the header. On failure outErr names the problem (text: with the line number).
+	bool Open(const std::wstring& path, std::wstring& outErr);
+	// Same over caller-owned bytes (kept alive while the reader is open).
+	bool OpenMemory(const uint8_t* data, size_t size, std::wstring& outErr);
+	void Close();
+	bool IsOpen() const { return m_data != nullptr; }
+	bool IsBinary() const { return m_binary; }
+
+	size_t Count() const { return m_count; }
+	size_t CartesianCount() const { return m_cartesianCount; }
+	size_t LoopStart() const { return m_loopStart; }
+	uint64_t TotalMs() const { return m_totalMs; }
+
+	// Index of the keyframe the next Next() returns.
+	size_t Position() const { return m_index; }
+	void Rewind();
+	void RewindToLoopStart();
+	// False at the end of the program.
+	bool Next(Keyframe& out);
+
+private:
+	bool Validate(std::wstring& outErr);
+	// One text keyframe starting at m_cursor (skips directives and comments); false at the end.
+	bool NextText(Keyframe& out);
+	void DecodeRecord(size_t index, Keyframe& out) const;
+
+private:
+	MappedFile m_file;
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+	bool m_binary = false;
+
+	size_t m_count = 0;
+	size_t m_cartesianCount = 0;
+	size_t m_loopStart = 0;
+	uint64_t m_totalMs = 0;
+
+	size_t m_index = 0;
+	size_t m_cursor = 0;        // text: byte offset of the next line
+	size_t m_firstOffset = 0;   // text: line of keyframe 0
+	size_t m_loopOffset = 0;    // text: line of keyframe m_loopStart
+};
+
+// Cartesian keyframes -> servo targets at playback time. IK is seeded with the previous Cartesian solution,
+// so consecutive poses along a path stay on the same elbow branch.
+class MotionScriptResolver
+{
+public:
+	void Reset() { m_hasSeed = false; }
+	// False if a Cartesian target has no IK solution (or a joint is not bound): out has no joint set then and
+	// must not be played (the arm would reach the next keyframe from the wrong pose).
+	bool Resolve(const KinematicsCalib& calib, const MotionScript::Keyframe& in, CompiledScript::Keyframe& out);
+
+private:
+	bool m_hasSeed = false;
+	ArmKinematics::JointAnglesRad m_seed;
+	ArmKinematics::IkResultLite m_ik;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Minimal blocking parallel loop for CPU-bound precomputation (workspace maps, batch solves).
+// - Runs fn(i) for every i in [0, count); indices are handed out one at a time from an atomic
+//   counter, so uneven work per index balances itself.
+// - The calling thread participates; threads == 0 means std::thread::hardware_concurrency().
+// - fn must not throw (there is no exception transport across workers).
+template <class Fn>
+inline void ParallelFor(size_t count, Fn fn, unsigned threads = 0)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (threads == 0)
+	{
+		threads = std::thread::hardware_concurrency();
+	}
+	threads = static_cast<unsigned>(std::min<size_t>(std::max(threads, 1u), count));
+
+	if (threads == 1)
+	{
+		for (size_t i = 0; i < count; i++) fn(i);
+		return;
+	}
+
+	std::atomic<size_t> next(0);
+	auto worker = [&]()
+	{
+		for (;;)
+		{
+			const size_t i = next.fetch_add(1, std::memory_order_relaxed);
+			if (i >= count) break;
+			fn(i);
+		}
+	};
+
+	std::vector<std::thread> pool;
+	pool.reserve(threads - 1);
+	for (unsigned t = 1; t < threads; t++)
+	{
+		pool.emplace_back(worker);
+	}
+	worker();
+	for (auto& th : pool)
+	{
+		th.join();
+	}
+}
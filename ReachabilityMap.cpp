@@ -0,0 +1,456 @@
+#include "pch.h"
+
+#include "ReachabilityMap.h"
+
+#include "ArmKinematicsBatch.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	// 缓存文件格式版本：Cell/FileHeader 布局或构建规则变化时递增
+	constexpr uint32_t kFileVersion = 1;
+	constexpr char kMagic[8] = { 'A', 'R', 'M', 'R', 'E', 'A', 'C', 'H' };
+
+	// 文件头（本机字节序；缓存只在本机生成、本机使用）
+	struct FileHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t headerBytes;
+		uint64_t calibFingerprint;
+		uint64_t gridHash;
+		double originX;
+		double originY;
+		double originZ;
+		double voxelMm;
+		double pitchMinDeg;
+		double pitchStepDeg;
+		int32_t nx;
+		int32_t ny;
+		int32_t nz;
+		int32_t pitchCount;
+		uint64_t cellCount;
+	};
+	static_assert(sizeof(FileHeader) == 104, "FileHeader layout must stay fixed");
+	static_assert(sizeof(ReachabilityMap::Cell) == 4, "Cell layout must stay fixed");
+
+	// 网格参数哈希（FNV-1a 64），与标定指纹一起构成缓存键
+	uint64_t GridHash(const ReachabilityMap::GridParams& p)
+	{
+		uint64_t h = 1469598103934665603ULL;
+		auto add = [&h](double v)
+		{
+			unsigned char b[sizeof(double)];
+			std::memcpy(b, &v, sizeof(b));
+			for (unsigned char c : b)
+			{
+				h ^= c;
+				h *= 1099511628211ULL;
+			}
+		};
+		add(p.voxelMm);
+		add(p.pitchMinDeg);
+		add(p.pitchMaxDeg);
+		add(p.pitchStepDeg);
+		add(static_cast<double>(kFileVersion));
+		return h;
+	}
+
+	std::wstring JoinPath(const std::wstring& dir, const std::wstring& name)
+	{
+		if (dir.empty()) return name;
+		const wchar_t last = dir[dir.size() - 1];
+		if (last == L'\\' || last == L'/') return dir + name;
+#ifdef _WIN32
+		return dir + L"\\" + name;
+#else
+		return dir + L"/" + name;
+#endif
+	}
+}
+
+void ReachabilityMap::SetupGrid(const KinematicsCalib& calib, const GridParams& params)
+{
+	const auto& L = calib.Links();
+	const double reach = L.L_arm1 + L.L_arm2 + L.L_wrist;
+
+	m_voxelMm = (params.voxelMm > 1.0) ? params.voxelMm : 1.0;
+	m_invVoxel = 1.0 / m_voxelMm;
+
+	// 以肩（0,0,L_base）为中心、臂展为半边长的立方体
+	const int n = static_cast<int>(std::ceil(2.0 * reach / m_voxelMm));
+	m_nx = n;
+	m_ny = n;
+	m_nz = n;
+	const double half = 0.5 * n * m_voxelMm;
+	m_originX = -half;
+	m_originY = -half;
+	m_originZ = L.L_base - half;
+
+	m_pitchStepDeg = (params.pitchStepDeg > 0.1) ? params.pitchStepDeg : 0.1;
+	m_pitchMinDeg = params.pitchMinDeg;
+	const double span = std::max(0.0, params.pitchMaxDeg - params.pitchMinDeg);
+	m_pitchCount = static_cast<int>(std::floor(span / m_pitchStepDeg + 1e-9)) + 1;
+	if (m_pitchCount > 256) m_pitchCount = 256; // 下标存 uint8_t
+}
+
+bool ReachabilityMap::Build(const KinematicsCalib& calib, const GridParams& params, const std::atomic<bool>* pCancel)
+{
+	m_file.Close();
+	m_cells = nullptr;
+	m_source = Source::None;
+
+	SetupGrid(calib, params);
+
+	const auto& L = calib.Links();
+	const double reach = L.L_arm1 + L.L_arm2 + L.L_wrist;
+	const int P = m_pitchCount;
+	const int lx = m_nx + 1;
+	const int ly = m_ny + 1;
+	const int lz = m_nz + 1;
+	const ArmKinematicsBatch::Backend backend = ArmKinematicsBatch::BestBackend();
+
+	std::atomic<bool> cancelled(false);
+	auto isCancelled = [&]() -> bool
+	{
+		if (pCancel && pCancel->load(std::memory_order_relaxed))
+		{
+			cancelled.store(true, std::memory_order_relaxed);
+		}
+		return cancelled.load(std::memory_order_relaxed);
+	};
+
+	// 1) 在体素角点（(n+1)^3 格点）上求解：每个 z 平面一个任务，平面内逐行把格点 × 俯仰采样拼成一批 SoA
+	std::vector<Cell> lattice(static_cast<size_t>(lx) * ly * lz);
+	ParallelFor(static_cast<size_t>(lz), [&](size_t iz)
+	{
+		if (isCancelled()) return;
+
+		const size_t cap = static_cast<size_t>(lx) * P;
+		std::vector<double> px(cap), py(cap), pz(cap), pp(cap);
+		std::vector<double> q1(cap), q2(cap), q3(cap), q4(cap);
+		std::vector<uint8_t> status(cap);
+		std::vector<int> cols;
+		cols.reserve(lx);
+
+		ArmKinematicsBatch::PoseSoA in;
+		in.x_mm = px.data();
+		in.y_mm = py.data();
+		in.z_mm = pz.data();
+		in.pitch_deg = pp.data();
+		ArmKinematicsBatch::JointsSoA out;
+		out.q[1] = q1.data();
+		out.q[2] = q2.data();
+		out.q[3] = q3.data();
+		out.q[4] = q4.data();
+
+		const double z = m_originZ + iz * m_voxelMm;
+		const double dz = z - L.L_base;
+		for (int iy = 0; iy < ly; iy++)
+		{
+			const double y = m_originY + iy * m_voxelMm;
+
+			cols.clear();
+			size_t n = 0;
+			for (int ix = 0; ix < lx; ix++)
+			{
+				const double x = m_originX + ix * m_voxelMm;
+				if (x * x + y * y + dz * dz > reach * reach) continue; // 超出臂展必不可达
+				cols.push_back(ix);
+				for (int p = 0; p < P; p++)
+				{
+					px[n] = x;
+					py[n] = y;
+					pz[n] = z;
+					pp[n] = PitchAt(p);
+					n++;
+				}
+			}
+			if (n == 0) continue;
+
+			ArmKinematicsBatch::InverseKinematics(calib, in, n, out, status.data(), nullptr, backend);
+
+			Cell* row = &lattice[(static_cast<size_t>(iz) * ly + iy) * lx];
+			for (size_t c = 0; c < cols.size(); c++)
+			{
+				const uint8_t* st = &status[c * P];
+				int okLo = -1, okHi = -1, reLo = -1, reHi = -1;
+				for (int p = 0; p < P; p++)
+				{
+					const auto s = static_cast<ArmKinematicsBatch::Status>(st[p]);
+					if (s == ArmKinematicsBatch::Status::Unreachable) continue;
+					if (reLo < 0) reLo = p;
+					reHi = p;
+					if (s == ArmKinematicsBatch::Status::Ok)
+					{
+						if (okLo < 0) okLo = p;
+						okHi = p;
+					}
+				}
+
+				Cell& cell = row[cols[c]];
+				if (okLo >= 0)
+				{
+					cell.flags = kReachable | kWithinLimits;
+					cell.pitchLo = static_cast<uint8_t>(okLo);
+					cell.pitchHi = static_cast<uint8_t>(okHi);
+				}
+				else if (reLo >= 0)
+				{
+					cell.flags = kReachable;
+					cell.pitchLo = static_cast<uint8_t>(reLo);
+					cell.pitchHi = static_cast<uint8_t>(reHi);
+				}
+			}
+		}
+	}, params.threads);
+
+	if (isCancelled())
+	{
+		return false;
+	}
+
+	// 2) 体素 = 8 个角点的并集（偏乐观：体素内只要有角点可行即视为可行，俯仰范围取并集）
+	m_owned.assign(CellCount(), Cell{});
+	ParallelFor(static_cast<size_t>(m_nz), [&](size_t iz)
+	{
+		for (int iy = 0; iy < m_ny; iy++)
+		{
+			for (int ix = 0; ix < m_nx; ix++)
+			{
+				uint8_t flags = 0;
+				int okLo = 255, okHi = -1, reLo = 255, reHi = -1;
+				for (int k = 0; k < 8; k++)
+				{
+					const size_t cz = iz + ((k >> 2) & 1);
+					const size_t cy = static_cast<size_t>(iy) + ((k >> 1) & 1);
+					const size_t cx = static_cast<size_t>(ix) + (k & 1);
+					const Cell& c = lattice[(cz * ly + cy) * lx + cx];
+					flags |= c.flags;
+					if (c.flags & kWithinLimits)
+					{
+						okLo = std::min<int>(okLo, c.pitchLo);
+						okHi = std::max<int>(okHi, c.pitchHi);
+					}
+					else if (c.flags & kReachable)
+					{
+						reLo = std::min<int>(reLo, c.pitchLo);
+						reHi = std::max<int>(reHi, c.pitchHi);
+					}
+				}
+
+				Cell& cell = m_owned[(iz * m_ny + iy) * m_nx + ix];
+				cell.flags = flags;
+				if (flags & kWithinLimits)
+				{
+					cell.pitchLo = static_cast<uint8_t>(okLo);
+					cell.pitchHi = static_cast<uint8_t>(okHi);
+				}
+				else if (flags & kReachable)
+				{
+					cell.pitchLo = static_cast<uint8_t>(reLo);
+					cell.pitchHi = static_cast<uint8_t>(reHi);
+				}
+			}
+		}
+	}, params.threads);
+
+	m_calibFp = calib.GetArmFingerprint();
+	m_gridHash = GridHash(params);
+	m_cells = m_owned.data();
+	m_source = Source::Built;
+	return true;
+}
+
+bool ReachabilityMap::Load(const std::wstring& path, const KinematicsCalib& calib, const GridParams& params)
+{
+	m_owned.clear();
+	m_cells = nullptr;
+	m_source = Source::None;
+
+	if (!m_file.OpenRead(path))
+	{
+		return false;
+	}
+
+	SetupGrid(calib, params);
+	const size_t count = CellCount();
+
+	FileHeader h;
+	bool ok = m_file.Size() >= sizeof(FileHeader);
+	if (ok)
+	{
+		std::memcpy(&h, m_file.Data(), sizeof(h));
+		ok = std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0
+			&& h.version == kFileVersion
+			&& h.headerBytes == sizeof(FileHeader)
+			&& h.calibFingerprint == calib.GetArmFingerprint()
+			&& h.gridHash == GridHash(params)
+			&& h.nx == m_nx && h.ny == m_ny && h.nz == m_nz
+			&& h.pitchCount == m_pitchCount
+			&& h.cellCount == count
+			&& m_file.Size() == sizeof(FileHeader) + count * sizeof(Cell);
+	}
+	if (!ok)
+	{
+		m_file.Close();
+		return false;
+	}
+
+	// 网格几何以文件为准（与 SetupGrid 结果一致，防止浮点差异导致查询偏一格）
+	m_originX = h.originX;
+	m_originY = h.originY;
+	m_originZ = h.originZ;
+	m_voxelMm = h.voxelMm;
+	m_invVoxel = 1.0 / m_voxelMm;
+	m_pitchMinDeg = h.pitchMinDeg;
+	m_pitchStepDeg = h.pitchStepDeg;
+
+	m_calibFp = h.calibFingerprint;
+	m_gridHash = h.gridHash;
+	m_cells = reinterpret_cast<const Cell*>(m_file.Data() + sizeof(FileHeader));
+	m_source = Source::Loaded;
+	return true;
+}
+
+bool ReachabilityMap::Save(const std::wstring& path) const
+{
+	if (!IsValid())
+	{
+		return false;
+	}
+
+	FileHeader h;
+	std::memset(&h, 0, sizeof(h));
+	std::memcpy(h.magic, kMagic, sizeof(kMagic));
+	h.version = kFileVersion;
+	h.headerBytes = sizeof(FileHeader);
+	h.calibFingerprint = m_calibFp;
+	h.gridHash = m_gridHash;
+	h.originX = m_originX;
+	h.originY = m_originY;
+	h.originZ = m_originZ;
+	h.voxelMm = m_voxelMm;
+	h.pitchMinDeg = m_pitchMinDeg;
+	h.pitchStepDeg = m_pitchStepDeg;
+	h.nx = m_nx;
+	h.ny = m_ny;
+	h.nz = m_nz;
+	h.pitchCount = m_pitchCount;
+	h.cellCount = CellCount();
+
+	std::vector<uint8_t> buf(sizeof(FileHeader) + CellCount() * sizeof(Cell));
+	std::memcpy(buf.data(), &h, sizeof(h));
+	std::memcpy(buf.data() + sizeof(h), m_cells, CellCount() * sizeof(Cell));
+	return MappedFile::WriteAtomic(path, buf.data(), buf.size());
+}
+
+ReachabilityMap::Source ReachabilityMap::LoadOrBuild(const KinematicsCalib& calib,
+                                                     const GridParams& params,
+                                                     const std::wstring& cacheDir,
+                                                     const std::atomic<bool>* pCancel)
+{
+	const std::wstring path = cacheDir.empty()
+		? std::wstring()
+		: JoinPath(cacheDir, CacheFileName(calib.GetArmFingerprint(), params));
+
+	if (!path.empty() && Load(path, calib, params))
+	{
+		return Source::Loaded;
+	}
+	if (!Build(calib, params, pCancel))
+	{
+		return Source::None;
+	}
+	if (!path.empty() && MappedFile::EnsureDirectory(cacheDir))
+	{
+		// 写缓存失败不影响本次使用
+		Save(path);
+	}
+	return Source::Built;
+}
+
+std::wstring ReachabilityMap::CacheFileName(uint64_t calibFingerprint, const GridParams& params)
+{
+	wchar_t buf[64] = {};
+	std::swprintf(buf, sizeof(buf) / sizeof(buf[0]), L"reach_%016llx_%08x.bin",
+	              static_cast<unsigned long long>(calibFingerprint),
+	              static_cast<unsigned>(GridHash(params) & 0xFFFFFFFFu));
+	return buf;
+}
+
+const ReachabilityMap::Cell* ReachabilityMap::Lookup(double x_mm, double y_mm, double z_mm) const
+{
+	if (!m_cells) return nullptr;
+	const double fx = (x_mm - m_originX) * m_invVoxel;
+	const double fy = (y_mm - m_originY) * m_invVoxel;
+	const double fz = (z_mm - m_originZ) * m_invVoxel;
+	// 先做浮点范围判断（同时排除 NaN），再转整数
+	if (!(fx >= 0.0 && fx < m_nx && fy >= 0.0 && fy < m_ny && fz >= 0.0 && fz < m_nz))
+	{
+		return nullptr;
+	}
+	const size_t ix = static_cast<size_t>(fx);
+	const size_t iy = static_cast<size_t>(fy);
+	const size_t iz = static_cast<size_t>(fz);
+	return &m_cells[(iz * m_ny + iy) * m_nx + ix];
+}
+
+ReachabilityMap::Verdict ReachabilityMap::Classify(const ArmKinematics::PoseTarget& pose) const
+{
+	if (!m_cells)
+	{
+		return Verdict::Unknown;
+	}
+	const double pitch = ArmKinematics::WrapPitchDeg(pose.pitch_deg);
+
+	if (pitch < m_pitchMinDeg || pitch > PitchAt(m_pitchCount - 1))
+	{
+		return Verdict::Unknown;
+	}
+
+	const Cell* c = Lookup(pose.x_mm, pose.y_mm, pose.z_mm);
+	if (!c || !(c->flags & kReachable))
+	{
+		return Verdict::Unreachable;
+	}
+	if (!(c->flags & kWithinLimits))
+	{
+		return Verdict::OutOfLimits;
+	}
+	// 真实边界在“最后一个可行采样”与“下一个不可行采样”之间：外扩一个步长
+	if (pitch < PitchAt(c->pitchLo) - m_pitchStepDeg || pitch > PitchAt(c->pitchHi) + m_pitchStepDeg)
+	{
+		return Verdict::PitchOutOfRange;
+	}
+	return Verdict::Ok;
+}
+
+bool ReachabilityMap::PitchRange(double x_mm, double y_mm, double z_mm, double& outMinDeg, double& outMaxDeg) const
+{
+	const Cell* c = Lookup(x_mm, y_mm, z_mm);
+	if (!c || !(c->flags & kWithinLimits))
+	{
+		return false;
+	}
+	outMinDeg = PitchAt(c->pitchLo);
+	outMaxDeg = PitchAt(c->pitchHi);
+	return true;
+}
+
+bool ReachabilityMap::ClampPitch(ArmKinematics::PoseTarget& pose) const
+{
+	double lo = 0.0, hi = 0.0;
+	if (!PitchRange(pose.x_mm, pose.y_mm, pose.z_mm, lo, hi))
+	{
+		return false;
+	}
+	if (pose.pitch_deg < lo) pose.pitch_deg = lo;
+	if (pose.pitch_deg > hi) pose.pitch_deg = hi;
+	return true;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ArmKinematics.h"
+#include "BackgroundMapBuilder.h"
+#include "KinematicsCalib.h"
+#include "MappedFile.h"
+
+// ReachabilityMap：工作空间可达性体素图（Base 坐标系，每个体素记录“可达/限位内”与可行俯仰范围）
+// - 用途：Jog / 视觉跟随 / 抓取候选筛选在求 IK 之前 O(1) 查表，拒绝或修正（钳位俯仰）目标。
+//
+// 构建：
+// - 体素角点 × 俯仰采样（默认 -90..+90°，步长 5°）逐一求闭式 IK（ArmKinematicsBatch，SIMD），
+//   按 z 平面分片多线程并行（ParallelFor）；体素取 8 个角点的并集；
+// - 结果按机械臂标定指纹（KinematicsCalib::ArmFingerprint，不含相机外参）+ 网格参数缓存为二进制文件，下次启动直接内存映射。
+//
+// 精度说明：地图刻意偏乐观（角点并集 + 俯仰边界外扩一个采样步长）——
+// 判为不可行的目标几乎必然 IK 失败（KinematicsBench 实测误拒 < 0.05%），可放心拒绝；
+// 判为 Ok 的目标在边界附近仍可能 IK 失败，因此它只是“预筛选”，最终以 IK 结果为准。
+class ReachabilityMap
+{
+public:
+	enum CellFlags : uint8_t
+	{
+		kReachable = 1 << 0,    // 至少一个俯仰采样有数学解
+		kWithinLimits = 1 << 1, // 至少一个俯仰采样的解在软限位内
+	};
+
+	// 每体素 4 字节：俯仰范围存采样下标（限位内优先；否则为数学可达范围）。
+	// 可行俯仰集合不一定连续，这里只存包络。
+	struct Cell
+	{
+		uint8_t flags = 0;
+		uint8_t pitchLo = 0;
+		uint8_t pitchHi = 0;
+		uint8_t reserved = 0;
+	};
+
+	struct GridParams
+	{
+		double voxelMm = 10.0;
+		double pitchMinDeg = -90.0;
+		double pitchMaxDeg = 90.0;
+		double pitchStepDeg = 5.0;
+
+		// 构建线程数（0=CPU 核数），不参与缓存键
+		unsigned threads = 0;
+	};
+
+	enum class Verdict : uint8_t
+	{
+		Unknown = 0,     // 地图未就绪，或俯仰超出采样范围：不下结论
+		Ok,              // 位置与俯仰均可行（限位内）
+		PitchOutOfRange, // 位置可行，但该俯仰不在可行范围（可用 ClampPitch 修正）
+		OutOfLimits,     // 数学可达，但任何采样俯仰都超软限位
+		Unreachable,     // 任何采样俯仰都无解
+	};
+
+	enum class Source : uint8_t
+	{
+		None = 0,
+		Loaded, // 从缓存文件映射
+		Built,  // 现场计算（并尝试写缓存）
+	};
+
+public:
+	ReachabilityMap() = default;
+	ReachabilityMap(const ReachabilityMap&) = delete;
+	ReachabilityMap& operator=(const ReachabilityMap&) = delete;
+
+	// 并行计算整张图。pCancel 非空且置 true 时尽快返回 false。
+	bool Build(const KinematicsCalib& calib, const GridParams& params, const std::atomic<bool>* pCancel = nullptr);
+
+	// 缓存：文件头记录标定指纹与网格参数，不匹配则 Load 失败
+	bool Load(const std::wstring& path, const KinematicsCalib& calib, const GridParams& params);
+	bool Save(const std::wstring& path) const;
+
+	// 先尝试 cacheDir 下的缓存，失败则 Build 并写回；cacheDir 为空则不读写缓存
+	Source LoadOrBuild(const KinematicsCalib& calib,
+	                   const GridParams& params,
+	                   const std::wstring& cacheDir,
+	                   const std::atomic<bool>* pCancel = nullptr);
+
+	// 缓存文件名：reach_<标定指纹>_<网格参数哈希>.bin
+	static std::wstring CacheFileName(uint64_t calibFingerprint, const GridParams& params);
+
+	bool IsValid() const { return m_cells != nullptr; }
+	uint64_t GetCalibFingerprint() const { return m_calibFp; }
+	Source GetSource() const { return m_source; }
+
+	// O(1) 查询（位置取所在体素；网格覆盖以肩为球心、臂展为半径的包围盒，盒外即不可达）
+	const Cell* Lookup(double x_mm, double y_mm, double z_mm) const;
+	Verdict Classify(const ArmKinematics::PoseTarget& pose) const;
+
+	// 该位置的可行俯仰范围（度）；位置不可行返回 false
+	bool PitchRange(double x_mm, double y_mm, double z_mm, double& outMinDeg, double& outMaxDeg) const;
+
+	// 将 pose.pitch_deg 钳到该位置的可行范围；位置不可行返回 false（pose 不变）
+	bool ClampPitch(ArmKinematics::PoseTarget& pose) const;
+
+private:
+	size_t CellCount() const { return static_cast<size_t>(m_nx) * m_ny * m_nz; }
+	void SetupGrid(const KinematicsCalib& calib, const GridParams& params);
+	double PitchAt(int idx) const { return m_pitchMinDeg + idx * m_pitchStepDeg; }
+
+private:
+	// 网格
+	double m_originX = 0.0;
+	double m_originY = 0.0;
+	double m_originZ = 0.0;
+	double m_voxelMm = 10.0;
+	double m_invVoxel = 0.1;
+	int m_nx = 0;
+	int m_ny = 0;
+	int m_nz = 0;
+
+	// 俯仰采样
+	double m_pitchMinDeg = 0.0;
+	double m_pitchStepDeg = 5.0;
+	int m_pitchCount = 0;
+
+	uint64_t m_calibFp = 0;
+	uint64_t m_gridHash = 0;
+	Source m_source = Source::None;
+
+	// 数据：现场计算时在 m_owned，缓存加载时在 m_file 映射区；m_cells 指向二者之一
+	std::vector<Cell> m_owned;
+	MappedFile m_file;
+	const Cell* m_cells = nullptr;
+};
+
+// 后台构建（见 BackgroundMapBuilder）：先尝试 cacheDir 下的磁盘缓存，没有再构建并写回。
+class ReachabilityMapBuilder : public BackgroundMapBuilder<ReachabilityMap, ReachabilityMap::GridParams>
+{
+public:
+	void Start(const KinematicsCalib& calib,
+	           const ReachabilityMap::GridParams& params,
+	           const std::wstring& cacheDir)
+	{
+		StartBuild(calib, params, [cacheDir](ReachabilityMap& map, const KinematicsCalib& c,
+		                                     const ReachabilityMap::GridParams& p, const std::atomic<bool>* pCancel)
+		{
+			return map.LoadOrBuild(c, p, cacheDir, pCancel) != ReachabilityMap::Source::None;
+		});
+	}
+};
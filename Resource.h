@@ -96,6 +96,8 @@
 #define IDC_MOTION_CHECK_LOOP        1430
 #define IDC_MOTION_BTN_DEMO_PLAY     1431
 #define IDC_MOTION_BTN_STOP          1432
+#define IDC_MOTION_BTN_PLAY_FILE     1433
+#define IDC_MOTION_BTN_EXPORT_DEMO   1434
 
 #define IDC_MOTION_EDIT_LOG          1440
 
@@ -0,0 +1,230 @@
+#include "pch.h"
+
+#include "ServoStateEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	inline double Clamp01(double v)
+	{
+		if (v < 0.0) return 0.0;
+		if (v > 1.0) return 1.0;
+		return v;
+	}
+}
+
+void ServoStateEstimator::Reset()
+{
+	for (auto& tr : m_tracks)
+	{
+		tr = Track{};
+	}
+	m_stats = Stats{};
+}
+
+double ServoStateEstimator::Progress(const Segment& seg, double t, double* pRate) const
+{
+	if (pRate) *pRate = 0.0;
+	if (!(seg.T > 0.0))
+	{
+		return 1.0; // instant move (timeMs = 0) or a static anchor
+	}
+	const double raw = (t - seg.t0) / seg.T;
+	const double u = Clamp01(raw);
+	const bool inside = raw > 0.0 && raw < 1.0;
+	if (m_params.profile == Profile::Smooth)
+	{
+		if (pRate && inside) *pRate = 6.0 * u * (1.0 - u) / seg.T;
+		return u * u * (3.0 - 2.0 * u);
+	}
+	if (pRate && inside) *pRate = 1.0 / seg.T;
+	return u;
+}
+
+void ServoStateEstimator::AddDrift(Filter& f, double fromMs, double toMs) const
+{
+	const double dt = toMs - fromMs;
+	if (dt > 0.0)
+	{
+		f.P[1][1] += m_params.driftPerSqrtSec * m_params.driftPerSqrtSec * dt * 1e-3;
+	}
+}
+
+ServoStateEstimator::Filter ServoStateEstimator::CurrentFilter(const Track& tr) const
+{
+	Filter f = tr.f;
+	if (tr.committed)
+	{
+		return f;
+	}
+	// Pending: f is the previous move's state. At cur.t0 the servo was at r_prev + carry*a + b = cur.p0 + carry*a + b,
+	// so the new start offset is carry*a; b is kept, plus the new move's own tracking error.
+	AddDrift(f, tr.tState, tr.cur.t0);
+	const double c = tr.carry;
+	f.x[0] *= c;
+	f.P[0][0] *= c * c;
+	f.P[0][1] *= c;
+	f.P[1][0] = f.P[0][1];
+	f.P[1][1] += m_params.offsetSigma * m_params.offsetSigma;
+	return f;
+}
+
+void ServoStateEstimator::Commit(Track& tr) const
+{
+	if (tr.committed)
+	{
+		return;
+	}
+	tr.f = CurrentFilter(tr);
+	if (tr.tState < tr.cur.t0) tr.tState = tr.cur.t0;
+	tr.committed = true;
+}
+
+void ServoStateEstimator::Update(Track& tr, const Segment& seg, double z, double tSample)
+{
+	Filter& f = tr.f;
+	if (tSample > tr.tState)
+	{
+		AddDrift(f, tr.tState, tSample);
+		tr.tState = tSample;
+	}
+
+	double rate = 0.0;
+	const double s = Progress(seg, tSample, &rate);
+	const double span = seg.p1 - seg.p0;
+	const double h0 = 1.0 - s;
+	const double pred = seg.p0 + span * s + h0 * f.x[0] + f.x[1];
+	const double y = z - pred;
+
+	// Latency jitter turns into position noise in proportion to the speed at the sample time.
+	const double speed = (span - f.x[0]) * rate; // counts / ms
+	const double jit = speed * m_params.latencyJitterMs;
+	const double R = m_params.readNoise * m_params.readNoise + jit * jit;
+
+	auto innovationVar = [&]()
+	{
+		return h0 * h0 * f.P[0][0] + 2.0 * h0 * f.P[0][1] + f.P[1][1] + R;
+	};
+
+	double S = innovationVar();
+	const double gate = m_params.gateSigma;
+	if (y * y > gate * gate * S)
+	{
+		// Moved by hand, blocked, power-cycled: the offset model no longer holds. Reopen b and let this reading set it.
+		f.P[1][1] = m_params.unknownSigma * m_params.unknownSigma;
+		f.P[0][1] = f.P[1][0] = 0.0;
+		S = innovationVar();
+		m_stats.reanchors++;
+	}
+
+	const double ph0 = f.P[0][0] * h0 + f.P[0][1];
+	const double ph1 = f.P[1][0] * h0 + f.P[1][1];
+	const double k0 = ph0 / S;
+	const double k1 = ph1 / S;
+	f.x[0] += k0 * y;
+	f.x[1] += k1 * y;
+
+	// P = P - K (H P), H P = [ph0, ph1]
+	f.P[0][0] -= k0 * ph0;
+	f.P[0][1] -= k0 * ph1;
+	f.P[1][1] -= k1 * ph1;
+	f.P[1][0] = f.P[0][1];
+	if (f.P[0][0] < 0.0) f.P[0][0] = 0.0;
+	if (f.P[1][1] < 0.0) f.P[1][1] = 0.0;
+}
+
+void ServoStateEstimator::OnCommand(uint8_t id, double targetPos, double durationMs, double nowMs)
+{
+	if (id < 1 || id > kServoCount) return;
+	Track& tr = m_tracks[id];
+	m_stats.commands++;
+
+	const double T = (durationMs > 0.0) ? durationMs : 0.0;
+	if (!tr.valid)
+	{
+		// Start position unknown: model it as target + a, with a broad a that fades out over the move.
+		tr.cur = Segment{ nowMs, targetPos, targetPos, T };
+		tr.prev = tr.cur;
+		tr.f = Filter{};
+		tr.f.P[0][0] = (T > 0.0) ? m_params.unknownSigma * m_params.unknownSigma : 0.0;
+		tr.f.P[1][1] = m_params.offsetSigma * m_params.offsetSigma;
+		tr.committed = true;
+		tr.tState = nowMs;
+		tr.valid = true;
+		return;
+	}
+
+	// Readbacks for the previous move can still arrive; only two moves are kept apart.
+	Commit(tr);
+	const double s = Progress(tr.cur, nowMs, nullptr);
+	const double here = tr.cur.p0 + (tr.cur.p1 - tr.cur.p0) * s;
+
+	tr.prev = tr.cur;
+	tr.carry = 1.0 - s;
+	tr.cur = Segment{ nowMs, here, targetPos, T };
+	tr.committed = false;
+}
+
+void ServoStateEstimator::OnReadback(uint8_t id, double pos, double rxMs)
+{
+	if (id < 1 || id > kServoCount) return;
+	Track& tr = m_tracks[id];
+	const double tSample = rxMs - m_params.readLatencyMs;
+
+	if (!tr.valid)
+	{
+		tr.cur = Segment{ tSample, pos, pos, 0.0 };
+		tr.prev = tr.cur;
+		tr.f = Filter{};
+		tr.f.P[1][1] = m_params.readNoise * m_params.readNoise;
+		tr.committed = true;
+		tr.tState = tSample;
+		tr.valid = true;
+	}
+	else if (tSample >= tr.cur.t0)
+	{
+		Commit(tr);
+		Update(tr, tr.cur, pos, tSample);
+	}
+	else if (!tr.committed && tSample >= tr.prev.t0)
+	{
+		// Sampled before the latest command took effect: correct the previous move, carried over lazily.
+		Update(tr, tr.prev, pos, tSample);
+	}
+	else
+	{
+		m_stats.stale++;
+		return;
+	}
+	tr.lastReadMs = rxMs;
+	m_stats.readbacks++;
+}
+
+bool ServoStateEstimator::Estimate(uint8_t id, double nowMs, State& out) const
+{
+	out = State{};
+	if (id < 1 || id > kServoCount) return false;
+	const Track& tr = m_tracks[id];
+	if (!tr.valid) return false;
+
+	Filter f = CurrentFilter(tr);
+	AddDrift(f, tr.committed ? tr.tState : std::max(tr.tState, tr.cur.t0), nowMs);
+
+	const Segment& seg = tr.cur;
+	double rate = 0.0;
+	const double s = Progress(seg, nowMs, &rate);
+	const double span = seg.p1 - seg.p0;
+	const double h0 = 1.0 - s;
+
+	const double posVar = h0 * h0 * f.P[0][0] + 2.0 * h0 * f.P[0][1] + f.P[1][1];
+	out.valid = true;
+	out.moving = rate > 0.0;
+	out.pos = seg.p0 + span * s + h0 * f.x[0] + f.x[1];
+	out.vel = (span - f.x[0]) * rate * 1e3;
+	out.posSigma = std::sqrt(posVar > 0.0 ? posVar : 0.0);
+	out.velSigma = std::sqrt(f.P[0][0]) * rate * 1e3;
+	out.readAgeMs = (tr.lastReadMs >= 0.0) ? nowMs - tr.lastReadMs : -1.0;
+	return true;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+
+// Per-servo position/velocity estimate fused from commanded moves and timestamped readbacks.
+// - Prediction: a Move frame makes the servo interpolate from wherever it is to the target over timeMs
+//   (linear, or smoothstep for boards that ease in/out). The reference path r(t) chains these segments.
+// - Error model, per servo: actual(t) = r(t) + a*(1 - s(u)) + b
+//     a: offset at the start of the current move; it vanishes as the move completes (s(u) -> 1),
+//        which is why a finished move pins the position down even without any readback;
+//     b: persistent tracking offset (sag, deadband, a blocked joint); random walk, and each new move
+//        adds offsetSigma of its own (where it settles depends on the approach direction).
+//   A new command starts from the reference position at that instant; the unfinished part of a carries over.
+// - Correction: 2-state Kalman update per readback, at sample time = receive time - readLatencyMs.
+//   Readbacks sampled before the latest command (bus latency) update the previous move's state,
+//   which is carried into the current one; readbacks older than that are dropped as stale.
+//   Innovations beyond gateSigma (servo moved by hand, power cycle) re-anchor to the readback.
+// Time is injected by the caller (milliseconds, any monotonic origin), like SimServoBus.
+// Not thread-safe: owned by ArmCommsService and only accessed under its m_ioMu (UI thread for polled
+// readbacks and queued sends, MotionScheduler thread for timed sends).
+class ServoStateEstimator
+{
+public:
+	// Servo ids 1..kServoCount (same range as the ArmCommsService readback cache).
+	static constexpr int kServoCount = 6;
+
+	enum class Profile : uint8_t
+	{
+		Linear = 0, // constant speed over timeMs
+		Smooth = 1, // smoothstep 3u^2 - 2u^3 (zero speed at both ends)
+	};
+
+	struct Params
+	{
+		Profile profile = Profile::Linear;
+
+		double readNoise = 1.0;        // readback sigma, counts (quantization + sensor)
+		double readLatencyMs = 20.0;   // mean receive time - sample time (servo reply + UART + RX poll period)
+		double latencyJitterMs = 10.0; // sigma of the above; enters as |velocity| * jitter
+		double offsetSigma = 2.0;      // tracking error added by each new move, counts
+		double driftPerSqrtSec = 2.0;  // random walk of b, counts / sqrt(s)
+		double unknownSigma = 300.0;   // start offset sigma when the position is unknown
+		double gateSigma = 6.0;        // innovation gate before re-anchoring
+	};
+
+	struct State
+	{
+		bool valid = false;      // a command or readback has been seen since the last Reset
+		bool moving = false;     // inside a commanded move
+		double pos = 0.0;        // counts
+		double vel = 0.0;        // counts / s
+		double posSigma = 0.0;   // counts
+		double velSigma = 0.0;   // counts / s
+		double readAgeMs = -1.0; // time since the last accepted readback (-1 = none)
+	};
+
+	struct Stats
+	{
+		uint64_t commands = 0;
+		uint64_t readbacks = 0;  // accepted
+		uint64_t stale = 0;      // sampled before the previous command, dropped
+		uint64_t reanchors = 0;  // innovation beyond the gate
+	};
+
+public:
+	ServoStateEstimator() = default;
+	explicit ServoStateEstimator(const Params& params) : m_params(params) {}
+
+	void SetParams(const Params& params) { m_params = params; }
+	const Params& GetParams() const { return m_params; }
+
+	// Forget all servos (disconnect, readback cache cleared).
+	void Reset();
+
+	// Move to targetPos over durationMs, sent at nowMs.
+	void OnCommand(uint8_t id, double targetPos, double durationMs, double nowMs);
+
+	// Position read back, frame received at rxMs.
+	void OnReadback(uint8_t id, double pos, double rxMs);
+
+	// Estimate at nowMs; false (out.valid = false) if nothing is known about this servo.
+	bool Estimate(uint8_t id, double nowMs, State& out) const;
+
+	Stats GetStats() const { return m_stats; }
+
+private:
+	// r(t) = p0 + (p1 - p0) * s(u), u = (t - t0) / T clamped to [0, 1]
+	struct Segment
+	{
+		double t0 = 0.0;
+		double p0 = 0.0;
+		double p1 = 0.0;
+		double T = 0.0;
+	};
+
+	// Filter state [a, b] with covariance P (symmetric, P[0][1] == P[1][0]).
+	struct Filter
+	{
+		double x[2] = {};
+		double P[2][2] = {};
+	};
+
+	struct Track
+	{
+		bool valid = false;
+		Segment cur;
+		Segment prev;
+		// committed: f holds the state of `cur`. Otherwise f belongs to `prev`, and the state of `cur` is
+		// a = carry*a_prev + b_prev (carry = 1 - s_prev at cur.t0), b fresh with variance offsetSigma^2.
+		bool committed = true;
+		double carry = 0.0;
+		Filter f;
+		double tState = 0.0; // time up to which b's random walk has been applied
+		double lastReadMs = -1.0;
+	};
+
+	double Progress(const Segment& seg, double t, double* pRate) const;
+	Filter CurrentFilter(const Track& tr) const;
+	void Commit(Track& tr) const;
+	void AddDrift(Filter& f, double fromMs, double toMs) const;
+	void Update(Track& tr, const Segment& seg, double z, double tSample);
+
+private:
+	Params m_params;
+	Track m_tracks[kServoCount + 1];
+	Stats m_stats;
+};
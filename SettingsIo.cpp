@@ -2,9 +2,11 @@
 
 #include "SettingsIo.h"
 
+#include "CollisionModel.h"
 #include "MotionConfig.h"
 
 #include <windows.h>
+#include <algorithm>
 #include <string>
 
 namespace
@@ -66,6 +68,47 @@ namespace
 		AfxGetApp()->WriteProfileString(section, key, v.c_str());
 	}
 
+	// Collision section: scalar keys with their defaults, then "Collision\BoxN" sections (1..BoxCount).
+	// fn(section, key, default) is either ExportProfileInt or ImportProfileInt bound to the ini path.
+	template <class Fn>
+	void ForEachCollisionKey(int boxCount, Fn fn)
+	{
+		const CollisionModel::Params d;
+		fn(L"Collision", L"Enabled", d.enabled ? 1 : 0);
+		fn(L"Collision", L"TableEnabled", d.tableEnabled ? 1 : 0);
+		fn(L"Collision", L"TableZ_mm", static_cast<int>(d.tableZMm));
+		fn(L"Collision", L"Margin_mm", static_cast<int>(d.marginMm));
+		fn(L"Collision", L"GripperLength_mm", static_cast<int>(d.gripperLengthMm));
+		static const wchar_t* const kRadius[CollisionModel::kLinkCount] = {
+			L"RadiusBase_mm", L"RadiusUpperArm_mm", L"RadiusForearm_mm",
+			L"RadiusWrist_mm", L"RadiusGripper_mm", L"RadiusCamera_mm",
+		};
+		for (int k = 0; k < CollisionModel::kLinkCount; k++)
+		{
+			fn(L"Collision", kRadius[k], static_cast<int>(d.radiusMm[k]));
+		}
+		fn(L"Collision", L"BoxCount", 0);
+
+		boxCount = std::min(std::max(boxCount, 0), CollisionModel::kMaxProfileBoxes);
+		for (int i = 1; i <= boxCount; i++)
+		{
+			wchar_t sec[32] = {};
+			swprintf_s(sec, L"Collision\\Box%d", i);
+			for (const wchar_t* key : { L"MinX_mm", L"MinY_mm", L"MinZ_mm", L"MaxX_mm", L"MaxY_mm", L"MaxZ_mm" })
+			{
+				fn(sec, key, 0);
+			}
+		}
+	}
+
+	// Kinematics\Camera keys written by KinematicsConfig (all default to 0 = nominal mount).
+	template <class Fn>
+	void ForEachCameraMountKey(Fn fn)
+	{
+		static const wchar_t* const kKeys[] = { L"Valid", L"Rx_urad", L"Ry_urad", L"Rz_urad", L"Tx_um", L"Ty_um", L"Tz_um" };
+		for (const wchar_t* key : kKeys) fn(key);
+	}
+
 	// Keep servo positions within a sane range to avoid accidental unsafe values.
 	int ClampServoPos(int v)
 	{
@@ -108,6 +151,24 @@ SettingsIo::Result SettingsIo::ExportToIni(const std::wstring& iniPath)
 	// Throttle
 	ExportProfileInt(iniPath, L"Throttle", L"Ms", 50);
 
+	// Jog (0=closed-form IK, 1=resolved-rate DLS; IK cache, IK candidate scoring, singular slowdown on/off)
+	ExportProfileInt(iniPath, L"Jog", L"Mode", 0);
+	ExportProfileInt(iniPath, L"Jog", L"IkCache", 1);
+	ExportProfileInt(iniPath, L"Jog", L"IkScoring", 1);
+	ExportProfileInt(iniPath, L"Jog", L"SingularSlowdown", 1);
+
+	// Script playback (0=per keyframe, 1=cubic spline, 2=quintic spline; setpoint period; high-resolution scheduler thread)
+	ExportProfileInt(iniPath, L"Script", L"Interp", 1);
+	ExportProfileInt(iniPath, L"Script", L"StreamMs", 50);
+	ExportProfileInt(iniPath, L"Script", L"Scheduler", 1);
+
+	// Collision (link capsule radii, table plane, static obstacle boxes)
+	ForEachCollisionKey(AfxGetApp()->GetProfileInt(L"Collision", L"BoxCount", 0),
+		[&](const wchar_t* sec, const wchar_t* key, int def) { ExportProfileInt(iniPath, sec, key, def); });
+
+	// Wrist camera mount from hand-eye calibration (rotation vector in micro-rad, offset in um)
+	ForEachCameraMountKey([&](const wchar_t* key) { ExportProfileInt(iniPath, L"Kinematics\\Camera", key, 0); });
+
 	// Serial manual move panel
 	ExportProfileInt(iniPath, L"ManualMove", L"Id", 1);
 	ExportProfileInt(iniPath, L"ManualMove", L"Pos", 500);
@@ -131,6 +192,7 @@ SettingsIo::Result SettingsIo::ExportToIni(const std::wstring& iniPath)
 	ExportProfileInt(iniPath, L"CameraOverlay", L"Crosshair", 0);
 	ExportProfileInt(iniPath, L"CameraOverlay", L"Grid", 0);
 	ExportProfileInt(iniPath, L"CameraOverlay", L"Rotation", 0);
+	ExportProfileInt(iniPath, L"CameraOverlay", L"ManipMap", 1);
 
 	// Motion joints (J1..J6)
 	for (int j = 1; j <= MotionConfig::kJointCount; j++)
@@ -218,6 +280,24 @@ SettingsIo::Result SettingsIo::ImportFromIni(const std::wstring& iniPath)
 	// Throttle
 	ImportProfileInt(iniPath, L"Throttle", L"Ms", 50);
 
+	// Jog
+	ImportProfileInt(iniPath, L"Jog", L"Mode", 0);
+	ImportProfileInt(iniPath, L"Jog", L"IkCache", 1);
+	ImportProfileInt(iniPath, L"Jog", L"IkScoring", 1);
+	ImportProfileInt(iniPath, L"Jog", L"SingularSlowdown", 1);
+
+	// Script playback
+	ImportProfileInt(iniPath, L"Script", L"Interp", 1);
+	ImportProfileInt(iniPath, L"Script", L"StreamMs", 50);
+	ImportProfileInt(iniPath, L"Script", L"Scheduler", 1);
+
+	// Collision
+	ForEachCollisionKey(ReadIntW(iniPath, L"Collision", L"BoxCount", 0),
+		[&](const wchar_t* sec, const wchar_t* key, int def) { ImportProfileInt(iniPath, sec, key, def); });
+
+	// Wrist camera mount
+	ForEachCameraMountKey([&](const wchar_t* key) { ImportProfileInt(iniPath, L"Kinematics\\Camera", key, 0); });
+
 	// ManualMove
 	ImportProfileInt(iniPath, L"ManualMove", L"Id", 1);
 	ImportProfileInt(iniPath, L"ManualMove", L"Pos", 500);
@@ -243,6 +323,7 @@ SettingsIo::Result SettingsIo::ImportFromIni(const std::wstring& iniPath)
 	ImportProfileInt(iniPath, L"CameraOverlay", L"Crosshair", 0);
 	ImportProfileInt(iniPath, L"CameraOverlay", L"Grid", 0);
 	ImportProfileInt(iniPath, L"CameraOverlay", L"Rotation", 0);
+	ImportProfileInt(iniPath, L"CameraOverlay", L"ManipMap", 1);
 
 	// Motion joints
 	for (int j = 1; j <= MotionConfig::kJointCount; j++)
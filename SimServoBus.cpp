@@ -0,0 +1,201 @@
+#include "pch.h"
+
+#include "SimServoBus.h"
+#include "ArmProtocol.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace
+{
+	inline double Clamp01(double v)
+	{
+		if (v < 0.0) return 0.0;
+		if (v > 1.0) return 1.0;
+		return v;
+	}
+}
+
+SimServoBus::SimServoBus(uint32_t seed)
+	: m_rng(seed)
+{
+	Reset();
+}
+
+void SimServoBus::Reset()
+{
+	m_in.clear();
+	m_pending.clear();
+	m_stats = Stats{};
+	for (int i = 0; i <= kServoCount; i++)
+	{
+		m_pos[i] = 500;
+	}
+}
+
+void SimServoBus::SetFaultConfig(const FaultConfig& cfg)
+{
+	m_fault = cfg;
+	if (m_fault.maxDelayMs < m_fault.minDelayMs)
+	{
+		std::swap(m_fault.maxDelayMs, m_fault.minDelayMs);
+	}
+	m_fault.dropRate = Clamp01(m_fault.dropRate);
+	m_fault.corruptRate = Clamp01(m_fault.corruptRate);
+}
+
+uint32_t SimServoBus::RandDelayMs()
+{
+	if (m_fault.minDelayMs == m_fault.maxDelayMs)
+	{
+		return m_fault.minDelayMs;
+	}
+	std::uniform_int_distribution<uint32_t> dist(m_fault.minDelayMs, m_fault.maxDelayMs);
+	return dist(m_rng);
+}
+
+bool SimServoBus::Chance(double p)
+{
+	if (p <= 0.0) return false;
+	if (p >= 1.0) return true;
+	std::uniform_real_distribution<double> dist(0.0, 1.0);
+	return dist(m_rng) < p;
+}
+
+void SimServoBus::MaybeCorrupt(std::vector<uint8_t>& bytes)
+{
+	if (bytes.empty()) return;
+	if (!Chance(m_fault.corruptRate)) return;
+
+	std::uniform_int_distribution<size_t> idxDist(0, bytes.size() - 1);
+	const size_t idx = idxDist(m_rng);
+	bytes[idx] ^= 0xFF; // flip bits
+	m_stats.responsesCorrupted++;
+}
+
+void SimServoBus::Write(const uint8_t* data, size_t len, uint64_t nowMs)
+{
+	if (!data || len == 0)
+	{
+		return;
+	}
+
+	m_stats.bytesWritten += len;
+	m_in.insert(m_in.end(), data, data + len);
+
+	// Parse as many frames as possible from the input buffer.
+	size_t head = 0;
+	while (head < m_in.size())
+	{
+		ArmProtocol::ParsedFrame frame;
+		size_t consumed = 0;
+		const bool ok = ArmProtocol::TryParseOne(m_in.data() + head, m_in.size() - head, frame, consumed);
+		head += consumed;
+
+		if (!ok)
+		{
+			// Need more data, or we dropped junk. If nothing was consumed, stop to avoid a loop.
+			if (consumed == 0)
+			{
+				break;
+			}
+			continue;
+		}
+
+		m_stats.framesParsed++;
+
+		if (Chance(m_fault.dropRate))
+		{
+			m_stats.framesDropped++;
+			continue;
+		}
+
+		switch (frame.cmd)
+		{
+		case ArmProtocol::Command::Move:
+		{
+			for (const auto& s : frame.servos)
+			{
+				if (s.id <= kServoCount)
+				{
+					m_pos[s.id] = s.position;
+				}
+			}
+		}
+		break;
+		case ArmProtocol::Command::ReadPosition:
+		{
+			// If parsed as a request: readIds not empty and isReadResponse=false
+			if (!frame.isReadResponse && !frame.readIds.empty())
+			{
+				std::vector<ArmProtocol::ServoTarget> servos;
+				servos.reserve(frame.readIds.size());
+				for (uint8_t id : frame.readIds)
+				{
+					ArmProtocol::ServoTarget st;
+					st.id = id;
+					st.position = (id <= kServoCount) ? m_pos[id] : 0;
+					servos.push_back(st);
+				}
+
+				std::vector<uint8_t> resp = ArmProtocol::PackReadResponse(servos);
+				if (!Chance(m_fault.dropRate))
+				{
+					MaybeCorrupt(resp);
+
+					Pending p;
+					p.dueMs = nowMs + RandDelayMs();
+					p.bytes = std::move(resp);
+					m_pending.push_back(std::move(p));
+					m_stats.responsesQueued++;
+				}
+				else
+				{
+					m_stats.framesDropped++;
+				}
+			}
+		}
+		break;
+		default:
+			break;
+		}
+	}
+
+	// Drop consumed bytes once per Write (not per frame) to keep bursts linear.
+	if (head > 0)
+	{
+		m_in.erase(m_in.begin(), m_in.begin() + static_cast<ptrdiff_t>(head));
+	}
+}
+
+size_t SimServoBus::ReadDue(uint64_t nowMs, std::vector<uint8_t>& out)
+{
+	const size_t before = out.size();
+	while (!m_pending.empty())
+	{
+		if (m_pending.front().dueMs > nowMs)
+		{
+			break;
+		}
+		const auto& bytes = m_pending.front().bytes;
+		out.insert(out.end(), bytes.begin(), bytes.end());
+		m_pending.pop_front();
+	}
+
+	const size_t added = out.size() - before;
+	m_stats.bytesRead += added;
+	return added;
+}
+
+bool SimServoBus::NextDue(uint64_t& outDueMs) const
+{
+	if (m_pending.empty()) return false;
+	outDueMs = m_pending.front().dueMs;
+	return true;
+}
+
+uint16_t SimServoBus::GetServoPosition(uint8_t id) const
+{
+	if (id <= kServoCount) return m_pos[id];
+	return 0;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <vector>
+
+// Platform-neutral virtual servo bus: the servo model behind FakeSerialPort and tools/ArmSimulator.
+// - Write(): ingest host->bus bytes (partial/concatenated frames/junk) and apply protocol frames
+// - ReadDue(): pop bus->host response bytes whose simulated delay has elapsed
+// Time is injected by the caller (milliseconds, any monotonic origin), so the same model runs
+// inside the MFC app (GetTickCount64) and in a headless Linux process (CLOCK_MONOTONIC).
+// Not thread-safe: one bus per thread (the Linux simulator runs several buses side by side).
+class SimServoBus
+{
+public:
+	// Servo ids 1..kServoCount are simulated; other ids read back as 0.
+	static constexpr int kServoCount = 6;
+
+	struct FaultConfig
+	{
+		// Response delay range in milliseconds. min=max means fixed delay.
+		uint32_t minDelayMs = 10;
+		uint32_t maxDelayMs = 10;
+
+		// 0..1: probability to drop a request/response (stress testing)
+		double dropRate = 0.0;
+
+		// 0..1: probability to corrupt one random response byte (parser robustness)
+		double corruptRate = 0.0;
+	};
+
+	struct Stats
+	{
+		uint64_t bytesWritten = 0;
+		uint64_t bytesRead = 0;
+		uint64_t framesParsed = 0;
+		uint64_t framesDropped = 0;
+		uint64_t responsesQueued = 0;
+		uint64_t responsesCorrupted = 0;
+	};
+
+	// Fixed seed by default for reproducibility; give each bus its own seed to decorrelate faults.
+	explicit SimServoBus(uint32_t seed = 0xC0FFEEu);
+
+	// Back to power-on state: all servos at 500, buffers and stats cleared.
+	void Reset();
+
+	void SetFaultConfig(const FaultConfig& cfg);
+	FaultConfig GetFaultConfig() const { return m_fault; }
+
+	// Host -> bus bytes received at nowMs.
+	void Write(const uint8_t* data, size_t len, uint64_t nowMs);
+
+	// Append all responses due at nowMs to out (out is not cleared). Returns bytes appended.
+	size_t ReadDue(uint64_t nowMs, std::vector<uint8_t>& out);
+
+	// Earliest pending response due time; false if nothing is pending (lets callers size poll timeouts).
+	bool NextDue(uint64_t& outDueMs) const;
+
+	uint16_t GetServoPosition(uint8_t id) const;
+	Stats GetStats() const { return m_stats; }
+
+private:
+	struct Pending
+	{
+		uint64_t dueMs = 0;
+		std::vector<uint8_t> bytes;
+	};
+
+	uint32_t RandDelayMs();
+	bool Chance(double p);
+	void MaybeCorrupt(std::vector<uint8_t>& bytes);
+
+private:
+	std::mt19937 m_rng;
+	FaultConfig m_fault{};
+	Stats m_stats{};
+
+	// Input buffer (handles partial/concatenated frames)
+	std::vector<uint8_t> m_in;
+
+	// Scheduled responses, delivered in FIFO order (a serial bus never reorders replies)
+	std::deque<Pending> m_pending;
+
+	// Servo positions (1..kServoCount), default 500
+	uint16_t m_pos[kServoCount + 1] = { 0 };
+};
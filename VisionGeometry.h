@@ -44,10 +44,28 @@ namespace VisionGeometry
 
 	// 默认 Cam->Base 点映射（用于无外参时先跑通链路；与 VisualServoController 的速度映射一致）
 	// Base: X右, Y前, Z上
+	// 注意：只在机械臂处于零位姿态（相机朝 Base +Y）附近时成立；有当前关节角时用下面的 MapCamPointToBase。
 	inline Point3 MapCamPointToBase_Default(const Point3& pCam)
 	{
 		return Point3{ pCam.x, pCam.z, -pCam.y };
 	}
+
+	// 按当前相机位姿映射：camR 的三列为相机 x/y/z 轴在 Base 中的方向，camP 为光心（mm）。
+	// 位姿取 ArmKinematics::ForwardKinematicsFrames(q).f[kCamera]（含手眼标定外参）。
+	inline Point3 MapCamDirToBase(const double camR[3][3], const Point3& vCam)
+	{
+		return Point3{
+			camR[0][0] * vCam.x + camR[0][1] * vCam.y + camR[0][2] * vCam.z,
+			camR[1][0] * vCam.x + camR[1][1] * vCam.y + camR[1][2] * vCam.z,
+			camR[2][0] * vCam.x + camR[2][1] * vCam.y + camR[2][2] * vCam.z,
+		};
+	}
+
+	inline Point3 MapCamPointToBase(const double camR[3][3], const double camP[3], const Point3& pCam)
+	{
+		const Point3 d = MapCamDirToBase(camR, pCam);
+		return Point3{ camP[0] + d.x, camP[1] + d.y, camP[2] + d.z };
+	}
 }
 
 
@@ -234,6 +234,9 @@ void VisionService::ThreadMain()
 		double rayX = 0.0, rayY = 0.0, rayZ = 1.0;
 		bool hasDepth = false;
 		double depthMm = 0.0;
+		bool hasMarkerPose = false;
+		double markerR[9] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+		double markerT[3] = {};
 		VisionDetector::Detection detBox{};
 		bool hasHandLm = false;
 		VisionOverlayService::Gesture handGesture = VisionOverlayService::Gesture::Unknown;
@@ -474,6 +477,9 @@ void VisionService::ThreadMain()
 									Rm.at<double>(2,0), Rm.at<double>(2,1), Rm.at<double>(2,2),
 								};
 								double tarr[3] = { tvecs[bestIdx][0], tvecs[bestIdx][1], tvecs[bestIdx][2] };
+								std::copy(Rarr, Rarr + 9, markerR);
+								std::copy(tarr, tarr + 3, markerT);
+								hasMarkerPose = true;
 
 								VisionGeometry::Plane plane;
 								if (VisionGeometry::PlaneFromMarkerPose(Rarr, tarr, plane))
@@ -1260,6 +1266,9 @@ void VisionService::ThreadMain()
 		obs.rayX = rayX;
 		obs.rayY = rayY;
 		obs.rayZ = rayZ;
+		obs.hasMarkerPose = hasMarkerPose;
+		std::copy(markerR, markerR + 9, obs.markerR);
+		std::copy(markerT, markerT + 3, obs.markerT);
 
 		vs->UpdateObservation(obs);
 
@@ -2,6 +2,8 @@
 
 #include "VisualServoController.h"
 
+#include "VisionGeometry.h"
+
 #include <algorithm>
 #include <cmath>
 
@@ -32,8 +34,17 @@ double VisualServoController::Lerp(double a, double b, double t)
 }
 
 void VisualServoController::MapCamVelToBase(double vxCam, double vyCam, double vzCam,
-                                            double& outVxBase, double& outVyBase, double& outVzBase)
+                                            double& outVxBase, double& outVyBase, double& outVzBase) const
 {
+	if (m_hasCamR)
+	{
+		const VisionGeometry::Point3 v = VisionGeometry::MapCamDirToBase(m_camR, VisionGeometry::Point3{ vxCam, vyCam, vzCam });
+		outVxBase = v.x;
+		outVyBase = v.y;
+		outVzBase = v.z;
+		return;
+	}
+
 	// Cam: X右, Y下, Z前
 	// Base: X右, Y前, Z上
 	outVxBase = vxCam;
@@ -41,6 +52,15 @@ void VisualServoController::MapCamVelToBase(double vxCam, double vyCam, double v
 	outVzBase = -vyCam;
 }
 
+void VisualServoController::SetCameraOrientation(const double camR[3][3])
+{
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++) m_camR[i][j] = camR[i][j];
+	}
+	m_hasCamR = true;
+}
+
 void VisualServoController::SetEnabled(bool on)
 {
 	m_enabled = on;
@@ -184,7 +204,7 @@ bool VisualServoController::ComputeOutput(VisualServoOutput& out) const
 		}
 	}
 
-	// 4) Cam 速度 -> Base 速度（先用默认映射；未来可替换为外参矩阵）
+	// 4) Cam 速度 -> Base 速度（有当前相机姿态时按姿态旋转，否则默认映射）
 	double vxBase = 0.0, vyBase = 0.0, vzBase = 0.0;
 	MapCamVelToBase(vxCam, vyCam, vzCam, vxBase, vyBase, vzBase);
 
@@ -265,6 +285,12 @@ bool VisualServoController::ApplyToJog(JogController& jog, bool overrideManual,
 	jog.SetParams(p);
 
 	outWhy = out.reason;
+	// 上一 tick 目标已越界并被投影：Jog 正沿工作空间边界滑动，提示用户而不是静默
+	if (out.active && jog.GetLastProjectKind() != ArmKinematics::ProjectKind::Unchanged
+		&& jog.GetLastProjectKind() != ArmKinematics::ProjectKind::Failed)
+	{
+		outWhy += L" [边界滑动]";
+	}
 	return true;
 }
 
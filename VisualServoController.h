@@ -84,6 +84,11 @@ public:
 	void SetCameraIntrinsics(const CameraIntrinsics& k) { m_K = k; }
 	CameraIntrinsics GetCameraIntrinsics() const { return m_K; }
 
+	// 当前相机姿态（Base 坐标系，三列为相机 x/y/z 轴；来自 FK 的 kCamera 帧，含手眼外参）。
+	// 设置后 Cam 速度按该姿态旋转到 Base；未设置时用默认映射（只在零位姿态附近正确）。
+	void SetCameraOrientation(const double camR[3][3]);
+	void ClearCameraOrientation() { m_hasCamR = false; }
+
 	// 视觉线程/主线程都可以调用（内部加锁）
 	void UpdateObservation(const VisualObservation& obs);
 
@@ -105,17 +110,19 @@ private:
 	static double Deadband(double v, double db);
 	static double Lerp(double a, double b, double t);
 
-	// 默认的 Cam->Base 速度映射（在没有外参时用于先跑通闭环）
+	// Cam->Base 速度映射：有相机姿态时按姿态旋转；否则用默认映射（在没有外参时用于先跑通闭环）：
 	// 假设相机光轴 +Z_cam 指向 base +Y（向前），相机 +X_cam 对齐 base +X，
 	// 相机 +Y_cam（向下）对齐 base -Z（向上为负）。
-	static void MapCamVelToBase(double vxCam, double vyCam, double vzCam,
-	                            double& outVxBase, double& outVyBase, double& outVzBase);
+	void MapCamVelToBase(double vxCam, double vyCam, double vzCam,
+	                     double& outVxBase, double& outVyBase, double& outVzBase) const;
 
 private:
 	bool m_enabled = false;
 	VisualServoMode m_mode = VisualServoMode::LookAndMove;
 	Params m_params{};
 	CameraIntrinsics m_K{};
+	bool m_hasCamR = false;
+	double m_camR[3][3] = {};
 
 	mutable std::mutex m_mu;
 	VisualObservation m_lastObs{};
@@ -48,6 +48,12 @@ struct VisualObservation
 	double rayY = 0.0;
 	double rayZ = 1.0;
 
+	// marker 位姿（Cam 坐标系，ArUco estimatePoseSingleMarkers）：R 为 marker->cam（行主序），t 为 marker 原点（mm）。
+	// 手眼标定（HandEyeCalib）的观测来源。
+	bool hasMarkerPose = false;
+	double markerR[9] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+	double markerT[3] = {};
+
 	// 置信度（0..1），用于滤除低质量观测（可选）
 	bool hasConfidence = false;
 	double confidence = 0.0;
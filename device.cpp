@@ -109,7 +109,10 @@ DrawDevice::DrawDevice() :
     m_height(0),
     m_lDefaultStride(0),
     m_interlace(MFVideoInterlace_Unknown),
-    m_convertFn(NULL)
+    m_convertFn(NULL),
+    m_manipInsetMap(NULL),
+    m_manipInsetFp(0),
+    m_manipInsetPitch(0.0)
 {
     m_PixelAR.Denominator = m_PixelAR.Numerator = 1; 
 
@@ -1248,6 +1251,94 @@ void DrawDevice::DrawOverlays(IDirect3DSurface9* pBB)
         drawHLine(y2, colGrid, 0, true);
     }
 
+    // =========================================================
+    // 灵活度热图：左下角画当前目标俯仰下的 r-z 切片（横轴 r = 到 J1 轴线距离，纵轴 z），白十字为当前目标。
+    // 红 = 接近奇异（Jog 会降速），绿 = 灵活；无解区域把画面压暗。
+    // 切片图缓存在 m_manipInset 里，只在地图（标定指纹）、俯仰或尺寸变化时重新查询，逐帧只做贴图。
+    // =========================================================
+    if (m_overlay.showManipMap)
+    {
+        const auto snap = KinematicsOverlayService::Instance().GetSnapshot();
+        const ManipulabilityMap* map = snap.manipMap.get();
+        const int iw = 100;
+        const int ih = 200;
+        const int x0 = 10;
+        const int y0 = h - ih - 10;
+        if (map && map->IsValid() && x0 + iw < w && y0 >= 0)
+        {
+            const double rMax = map->RMaxMm();
+            const double zMin = map->ZMinMm();
+            const double zMax = map->ZMaxMm();
+            const double pitch = snap.target.pitch_deg;
+
+            // 无解像素记为 0（有效颜色的 alpha 恒为 0xFF），贴图时压暗背景
+            const DWORD kInsetNoSolution = 0;
+            if (m_manipInset.size() != (size_t)iw * (size_t)ih ||
+                m_manipInsetMap != map ||
+                m_manipInsetFp != map->GetCalibFingerprint() ||
+                m_manipInsetPitch != pitch)
+            {
+                m_manipInset.assign((size_t)iw * (size_t)ih, kInsetNoSolution);
+                const ManipulabilityMap::SpeedParams sp;
+                for (int py = 0; py < ih; py++)
+                {
+                    const double z = zMax - (py + 0.5) * (zMax - zMin) / ih;
+                    for (int px = 0; px < iw; px++)
+                    {
+                        const double r = (px + 0.5) * rMax / iw;
+                        ManipulabilityMap::Sample s;
+                        if (!map->QueryPlanar(r, z, pitch, s))
+                            continue;
+                        // 0 -> 红，0.5 -> 黄，1 -> 绿
+                        const double d = ManipulabilityMap::Dexterity(s, sp);
+                        const int red = (d < 0.5) ? 255 : (int)std::lround(255.0 * (2.0 - 2.0 * d));
+                        const int green = (d < 0.5) ? (int)std::lround(510.0 * d) : 255;
+                        m_manipInset[(size_t)py * iw + px] = (DWORD)D3DCOLOR_XRGB(red, green, 0);
+                    }
+                }
+                m_manipInsetMap = map;
+                m_manipInsetFp = map->GetCalibFingerprint();
+                m_manipInsetPitch = pitch;
+            }
+
+            for (int py = 0; py < ih; py++)
+            {
+                DWORD* row = (DWORD*)((BYTE*)lr.pBits + (size_t)(y0 + py) * (size_t)lr.Pitch);
+                const DWORD* src = &m_manipInset[(size_t)py * iw];
+                for (int px = 0; px < iw; px++)
+                {
+                    row[x0 + px] = (src[px] == kInsetNoSolution)
+                        ? ((row[x0 + px] >> 1) & 0x007F7F7F)
+                        : src[px];
+                }
+            }
+
+            const DWORD colFrame = toD3dColor(RGB(255, 255, 255));
+            for (int px = -1; px <= iw; px++)
+            {
+                setPixel(x0 + px, y0 - 1, colFrame);
+                setPixel(x0 + px, y0 + ih, colFrame);
+            }
+            for (int py = -1; py <= ih; py++)
+            {
+                setPixel(x0 - 1, y0 + py, colFrame);
+                setPixel(x0 + iw, y0 + py, colFrame);
+            }
+
+            const double tr = std::sqrt(snap.target.x_mm * snap.target.x_mm + snap.target.y_mm * snap.target.y_mm);
+            const int mx = x0 + (int)std::lround(tr / rMax * iw);
+            const int my = y0 + (int)std::lround((zMax - snap.target.z_mm) / (zMax - zMin) * ih);
+            if (mx >= x0 && mx < x0 + iw && my >= y0 && my < y0 + ih)
+            {
+                for (int k = -4; k <= 4; k++)
+                {
+                    setPixel(mx + k, my, colFrame);
+                    setPixel(mx, my + k, colFrame);
+                }
+            }
+        }
+    }
+
 	// =========================================================
 	// Visual Servo：目标点 + 误差箭头（不依赖 OpenCV 的兜底绘制路径）
 	// =========================================================
@@ -1380,6 +1471,16 @@ void DrawDevice::DrawOverlays(IDirect3DSurface9* pBB)
 		cv::circle(img, o, 3, cv::Scalar(200, 200, 200, 0), -1, cv::LINE_AA);
 		cv::arrowedLine(img, o, e, cv::Scalar(0, 180, 255, 0), 2, cv::LINE_AA);
 
+		// 灵活度：当前目标处的可操作度 / 逆条件数与 Jog 速度倍率（降速时变橙色）
+		if (snap.manipValid)
+		{
+			char bufDx[256] = {};
+			sprintf_s(bufDx, "Dex w=%.2f 1/k=%.2f  speed x%.2f", snap.manip, snap.invCond, snap.speedScale);
+			cv::putText(img, bufDx, cv::Point(12, 144), cv::FONT_HERSHEY_SIMPLEX, 0.55,
+			            snap.speedScale < 0.999 ? cv::Scalar(0, 160, 255, 0) : cv::Scalar(180, 255, 180, 0),
+			            1, cv::LINE_AA);
+		}
+
 		// Visual Servo：目标点 + 误差箭头（OpenCV 版本）
 		if (snap.vsEnabled)
 		{
@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 // Function pointer for the function that transforms the image.
@@ -32,6 +33,7 @@ struct VideoOverlaySettings
 	VideoRotation rotation = VideoRotation::None;
 	bool showCrosshair = false;
 	bool showReferenceLines = false;
+	bool showManipMap = false;                    // dexterity heat map inset (r-z slice at the jog target pitch)
 	COLORREF crosshairColor = RGB(255, 0, 0);     // Red
 	COLORREF refLineColor = RGB(0, 255, 0);       // Green
 };
@@ -67,6 +69,12 @@ private:
 	// Orientation/overlay
 	VideoOverlaySettings    m_overlay;
 
+	// Dexterity heat map inset, rebuilt only when the map, its calibration or the pitch changes
+	std::vector<DWORD>      m_manipInset;
+	const void*             m_manipInsetMap;
+	uint64_t                m_manipInsetFp;
+	double                  m_manipInsetPitch;
+
 private:
 
 	HRESULT TestCooperativeLevel();
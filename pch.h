@@ -8,6 +8,10 @@
 #define PCH_H
 
 // 添加要在此处预编译的标头
+// 说明：tools/ 下的无头工具（Linux 仿真器/基准）会复用部分与平台无关的源文件，
+// 这些源文件同样 #include "pch.h"；非 Windows 下不引入 MFC。
+#ifdef _WIN32
 #include "framework.h"
+#endif
 
 #endif //PCH_H
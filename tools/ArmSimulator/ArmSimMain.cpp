@@ -0,0 +1,310 @@
+// Headless arm simulator (Linux): one pseudo-terminal per virtual servo bus.
+//
+// Each bus is a SimServoBus (the same servo model as the in-process FakeSerialPort) behind a pty,
+// so any serial client (the real serial code path, minicom, pyserial, a load generator) talks to it
+// byte-for-byte over the wire protocol in ArmProtocol.h.
+//
+// Build (from the repository root, see tools/ArmSimulator/README.md):
+//   g++ -std=c++14 -O2 -I. tools/ArmSimulator/ArmSimMain.cpp SimServoBus.cpp ArmProtocol.cpp -o armsim
+
+#include "SimServoBus.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace
+{
+	volatile std::sig_atomic_t g_stop = 0;
+
+	void OnSignal(int)
+	{
+		g_stop = 1;
+	}
+
+	uint64_t NowMs()
+	{
+		timespec ts{};
+		::clock_gettime(CLOCK_MONOTONIC, &ts);
+		return static_cast<uint64_t>(ts.tv_sec) * 1000ULL + static_cast<uint64_t>(ts.tv_nsec) / 1000000ULL;
+	}
+
+	struct Options
+	{
+		int buses = 1;
+		std::string linkPrefix;     // e.g. /tmp/armsim -> /tmp/armsim0, /tmp/armsim1, ...
+		SimServoBus::FaultConfig fault{};
+		uint32_t seed = 0xC0FFEEu;
+		int statsSec = 5;           // 0 disables periodic stats
+	};
+
+	struct Bus
+	{
+		int master = -1;
+		int slaveKeepAlive = -1;    // keeps the pty alive (no EIO/HUP) while no client is attached
+		std::string slavePath;
+		std::string linkPath;
+		SimServoBus model;
+		std::vector<uint8_t> outbox; // response bytes not yet accepted by the pty
+		SimServoBus::Stats lastStats{};
+
+		explicit Bus(uint32_t seed) : model(seed) {}
+	};
+
+	void PrintUsage(const char* argv0)
+	{
+		std::fprintf(stderr,
+			"Usage: %s [--buses N] [--link PREFIX] [--delay-ms MIN[:MAX]] [--drop P] [--corrupt P]\n"
+			"          [--seed S] [--stats SEC]\n"
+			"  --buses N       number of virtual servo buses (one pty each), default 1\n"
+			"  --link PREFIX   create symlinks PREFIX0..PREFIX{N-1} to the pty slaves\n"
+			"  --delay-ms      response delay range in ms (default 10)\n"
+			"  --drop P        0..1 probability to drop a request/response\n"
+			"  --corrupt P     0..1 probability to corrupt one response byte\n"
+			"  --seed S        base RNG seed (bus i uses S+i)\n"
+			"  --stats SEC     print per-bus throughput every SEC seconds (0 = only at exit)\n",
+			argv0);
+	}
+
+	bool ParseArgs(int argc, char** argv, Options& opt)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string a = argv[i];
+			const bool hasValue = (i + 1 < argc);
+			if (a == "--buses" && hasValue)
+			{
+				opt.buses = std::atoi(argv[++i]);
+			}
+			else if (a == "--link" && hasValue)
+			{
+				opt.linkPrefix = argv[++i];
+			}
+			else if (a == "--delay-ms" && hasValue)
+			{
+				const std::string v = argv[++i];
+				const size_t colon = v.find(':');
+				opt.fault.minDelayMs = static_cast<uint32_t>(std::strtoul(v.c_str(), nullptr, 10));
+				opt.fault.maxDelayMs = (colon == std::string::npos)
+					? opt.fault.minDelayMs
+					: static_cast<uint32_t>(std::strtoul(v.c_str() + colon + 1, nullptr, 10));
+			}
+			else if (a == "--drop" && hasValue)
+			{
+				opt.fault.dropRate = std::atof(argv[++i]);
+			}
+			else if (a == "--corrupt" && hasValue)
+			{
+				opt.fault.corruptRate = std::atof(argv[++i]);
+			}
+			else if (a == "--seed" && hasValue)
+			{
+				opt.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+			}
+			else if (a == "--stats" && hasValue)
+			{
+				opt.statsSec = std::atoi(argv[++i]);
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return opt.buses >= 1 && opt.buses <= 64;
+	}
+
+	bool OpenPty(Bus& b)
+	{
+		b.master = ::posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+		if (b.master < 0) return false;
+		if (::grantpt(b.master) != 0 || ::unlockpt(b.master) != 0) return false;
+
+		const char* name = ::ptsname(b.master);
+		if (!name) return false;
+		b.slavePath = name;
+
+		// Raw mode on the slave side: no echo, no line discipline, 8-bit clean (the protocol is binary).
+		b.slaveKeepAlive = ::open(name, O_RDWR | O_NOCTTY);
+		if (b.slaveKeepAlive < 0) return false;
+		termios tio{};
+		if (::tcgetattr(b.slaveKeepAlive, &tio) != 0) return false;
+		::cfmakeraw(&tio);
+		::cfsetispeed(&tio, B9600);
+		::cfsetospeed(&tio, B9600);
+		return ::tcsetattr(b.slaveKeepAlive, TCSANOW, &tio) == 0;
+	}
+
+	void FlushOutbox(Bus& b)
+	{
+		while (!b.outbox.empty())
+		{
+			const ssize_t n = ::write(b.master, b.outbox.data(), b.outbox.size());
+			if (n <= 0)
+			{
+				// EAGAIN: client is not draining; keep bytes and retry on the next POLLOUT.
+				return;
+			}
+			b.outbox.erase(b.outbox.begin(), b.outbox.begin() + n);
+		}
+	}
+
+	void PrintStats(const std::vector<std::unique_ptr<Bus>>& buses, double seconds, bool delta)
+	{
+		for (size_t i = 0; i < buses.size(); i++)
+		{
+			Bus& b = *buses[i];
+			const SimServoBus::Stats s = b.model.GetStats();
+			const SimServoBus::Stats base = delta ? b.lastStats : SimServoBus::Stats{};
+			const double sec = (seconds > 1e-9) ? seconds : 1.0;
+			std::printf("[bus%zu %s] frames=%llu (%.0f/s) rx=%llu B (%.0f B/s) tx=%llu B dropped=%llu corrupted=%llu\n",
+				i, b.slavePath.c_str(),
+				static_cast<unsigned long long>(s.framesParsed),
+				static_cast<double>(s.framesParsed - base.framesParsed) / sec,
+				static_cast<unsigned long long>(s.bytesWritten),
+				static_cast<double>(s.bytesWritten - base.bytesWritten) / sec,
+				static_cast<unsigned long long>(s.bytesRead),
+				static_cast<unsigned long long>(s.framesDropped),
+				static_cast<unsigned long long>(s.responsesCorrupted));
+			b.lastStats = s;
+		}
+		std::fflush(stdout);
+	}
+
+	// Removes the --link symlinks and closes the ptys (normal exit and early-return error paths).
+	void ReleaseBuses(std::vector<std::unique_ptr<Bus>>& buses)
+	{
+		for (auto& b : buses)
+		{
+			if (!b->linkPath.empty()) ::unlink(b->linkPath.c_str());
+			if (b->slaveKeepAlive >= 0) ::close(b->slaveKeepAlive);
+			if (b->master >= 0) ::close(b->master);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+	if (!ParseArgs(argc, argv, opt))
+	{
+		PrintUsage(argv[0]);
+		return 2;
+	}
+
+	std::signal(SIGINT, OnSignal);
+	std::signal(SIGTERM, OnSignal);
+
+	std::vector<std::unique_ptr<Bus>> buses;
+	for (int i = 0; i < opt.buses; i++)
+	{
+		std::unique_ptr<Bus> b(new Bus(opt.seed + static_cast<uint32_t>(i)));
+		b->model.SetFaultConfig(opt.fault);
+		if (!OpenPty(*b))
+		{
+			std::fprintf(stderr, "Failed to create pty for bus %d: %s\n", i, std::strerror(errno));
+			ReleaseBuses(buses);
+			return 1;
+		}
+		if (!opt.linkPrefix.empty())
+		{
+			b->linkPath = opt.linkPrefix + std::to_string(i);
+			// Only replace a stale symlink from an earlier run; never delete a real file at the link path.
+			struct stat st;
+			if (::lstat(b->linkPath.c_str(), &st) == 0)
+			{
+				if (!S_ISLNK(st.st_mode))
+				{
+					std::fprintf(stderr, "Refusing to replace %s: it exists and is not a symlink\n", b->linkPath.c_str());
+					ReleaseBuses(buses);
+					return 1;
+				}
+				::unlink(b->linkPath.c_str());
+			}
+			if (::symlink(b->slavePath.c_str(), b->linkPath.c_str()) != 0)
+			{
+				std::fprintf(stderr, "Failed to link %s: %s\n", b->linkPath.c_str(), std::strerror(errno));
+				b->linkPath.clear();
+			}
+		}
+		std::printf("bus%d: %s%s%s\n", i, b->slavePath.c_str(),
+			b->linkPath.empty() ? "" : " <- ", b->linkPath.c_str());
+		buses.push_back(std::move(b));
+	}
+	std::fflush(stdout);
+
+	const uint64_t startMs = NowMs();
+	uint64_t lastStatsMs = startMs;
+	std::vector<pollfd> fds(buses.size());
+	std::vector<uint8_t> chunk(4096);
+
+	while (!g_stop)
+	{
+		// Poll timeout: wake for the earliest scheduled response (or 50 ms for stats bookkeeping).
+		uint64_t now = NowMs();
+		int timeoutMs = 50;
+		for (size_t i = 0; i < buses.size(); i++)
+		{
+			uint64_t due = 0;
+			if (buses[i]->model.NextDue(due))
+			{
+				const int wait = (due > now) ? static_cast<int>(due - now) : 0;
+				if (wait < timeoutMs) timeoutMs = wait;
+			}
+			fds[i].fd = buses[i]->master;
+			fds[i].events = static_cast<short>(POLLIN | (buses[i]->outbox.empty() ? 0 : POLLOUT));
+			fds[i].revents = 0;
+		}
+
+		const int rc = ::poll(fds.data(), static_cast<nfds_t>(fds.size()), timeoutMs);
+		if (rc < 0 && errno != EINTR)
+		{
+			std::fprintf(stderr, "poll failed: %s\n", std::strerror(errno));
+			break;
+		}
+
+		now = NowMs();
+		for (size_t i = 0; i < buses.size(); i++)
+		{
+			Bus& b = *buses[i];
+			if (rc > 0 && (fds[i].revents & POLLIN))
+			{
+				for (;;)
+				{
+					const ssize_t n = ::read(b.master, chunk.data(), chunk.size());
+					if (n <= 0) break;
+					b.model.Write(chunk.data(), static_cast<size_t>(n), now);
+				}
+			}
+			b.model.ReadDue(now, b.outbox);
+			FlushOutbox(b);
+		}
+
+		if (opt.statsSec > 0 && now - lastStatsMs >= static_cast<uint64_t>(opt.statsSec) * 1000ULL)
+		{
+			PrintStats(buses, static_cast<double>(now - lastStatsMs) / 1000.0, true);
+			lastStatsMs = now;
+		}
+	}
+
+	std::printf("--- totals over %.1f s ---\n", static_cast<double>(NowMs() - startMs) / 1000.0);
+	for (auto& b : buses)
+	{
+		b->lastStats = SimServoBus::Stats{};
+	}
+	PrintStats(buses, static_cast<double>(NowMs() - startMs) / 1000.0, false);
+
+	ReleaseBuses(buses);
+	return 0;
+}
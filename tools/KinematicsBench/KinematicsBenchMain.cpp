@@ -0,0 +1,3110 @@
+// Kinematics benchmark (headless): batched SoA IK vs. the per-pose ArmKinematics path.
+//
+// Poses are generated by FK from random joint angles inside the soft limits (reachable) mixed with
+// uniformly random points in a box around the arm (partly unreachable). Every batch result is checked
+// against ArmKinematics::InverseKinematics (same calib, same seeds) before timings are reported; the Fast / Float
+// precision variants are checked against the double batch in servo counts and timed alongside.
+// A round-trip section sweeps a dense J1..J4 grid inside the limits through FK -> IK -> FK and fails on accuracy,
+// branch-stability or limit-compliance regressions (optionally also against a saved baseline, see --baseline).
+// An IkCache section replays a hovering workload through the quantized-pose cache and checks it against direct solves.
+// A scoring section simulates jog sessions with the default and the IkScoring candidate choice.
+// An FK section checks ArmKinematics::ForwardKinematicsFrames (all link frames + camera) against the
+// end-effector FK and the batched SIMD FK (every backend and precision) against the per-sample frames.
+// A chain section checks the compile-time KinematicChain (5-joint: against the hand-written model and its timings;
+// 6-joint variant: frames, Jacobian vs. finite differences, DLS IK convergence).
+// A collision section compares CollisionModel::Check with the batched CheckBatch and times both.
+// A planner section plans straight moves with CartesianPlanner and checks the setpoint stream (line deviation,
+// joint velocity/acceleration against the limits).
+// A calibration section fits KinematicsCalibSolver to noisy samples of a perturbed "true" arm and checks that the
+// fitted model matches the truth.
+// A hand-eye section recovers a perturbed camera mount from noisy synthetic ArUco observations (HandEyeCalib).
+// Further sections build the ReachabilityMap (O(1) pre-filter) and the ManipulabilityMap (jog slowdown, checked
+// against a reference SVD and direct values) and time ArmKinematics::ProjectToReachable
+// on the infeasible poses against a 1 kHz control budget.
+// An estimator section checks ServoStateEstimator on a simulated servo with rare, late readbacks.
+// A scheduler section plays a frame list on the MotionScheduler thread (real time) and compares its send-time
+// lateness with the legacy UI-timer playback.
+// A spline section checks that quintic KeyframeSpline segments never leave their end values with uneven durations.
+// A compiled-script section checks the CompiledScript frame arena against the keyframes and its hot swap.
+// A program section round-trips MotionScript files (text and binary), resolves Cartesian keyframes and plays a program
+// in windows on the scheduler stream.
+//
+// Build (from the repository root, see tools/KinematicsBench/README.md):
+//   g++ -std=c++14 -O2 -mavx2 -pthread -I. tools/KinematicsBench/KinematicsBenchMain.cpp ArmKinematics.cpp
+//       ArmKinematicsBatch.cpp KinematicsCalib.cpp KinematicsConfig.cpp MotionConfig.cpp
+//       ReachabilityMap.cpp MappedFile.cpp CollisionModel.cpp CartesianPlanner.cpp KinematicsCalibSolver.cpp HandEyeCalib.cpp
+//       IkCache.cpp ManipulabilityMap.cpp ServoStateEstimator.cpp MotionScheduler.cpp CompiledScript.cpp ArmProtocol.cpp
+//       MotionScript.cpp KeyframeSpline.cpp -o kinbench
+
+#include "ArmKinematics.h"
+#include "ArmKinematicsBatch.h"
+#include "ArmProtocol.h"
+#include "CartesianPlanner.h"
+#include "CollisionModel.h"
+#include "CompiledScript.h"
+#include "HandEyeCalib.h"
+#include "IkCache.h"
+#include "KinematicChain.h"
+#include "KinematicsCalib.h"
+#include "KinematicsCalibSolver.h"
+#include "KinematicsConfig.h"
+#include "KeyframeSpline.h"
+#include "ManipulabilityMap.h"
+#include "MotionConfig.h"
+#include "MotionScheduler.h"
+#include "MotionScript.h"
+#include "ParallelFor.h"
+#include "ReachabilityMap.h"
+#include "ServoStateEstimator.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr double kPi = 3.14159265358979323846;
+
+	struct Options
+	{
+		size_t count = 100000;
+		int reps = 5;
+		uint32_t seed = 12345u;
+		bool useSeeds = true;   // pass "current joints" so the cost term is exercised
+		bool useLimits = true;  // MotionConfig soft limits (min/max) for J1..J4
+		bool roundTrip = true;  // FK -> IK -> FK grid regression section
+		int grid = 16;          // round-trip grid points per joint (J1..J4)
+		std::string baselinePath;     // --baseline: compare round-trip figures with a saved run
+		std::string saveBaselinePath; // --save-baseline: write round-trip figures
+		double perfTol = 0.25;  // allowed ns/call growth against the baseline
+		bool cache = true;      // IkCache section
+		bool scoring = true;    // IK candidate scoring (jog session) section
+		bool fk = true;         // link-frame FK + batched FK section
+		bool chain = true;      // KinematicChain (compile-time chain) section
+		bool collision = true;  // CollisionModel section
+		bool plan = true;       // CartesianPlanner section
+		bool calib = true;      // KinematicsCalibSolver section
+		bool handEye = true;    // HandEyeCalib section
+		bool reach = true;      // ReachabilityMap build + query section
+		bool manip = true;      // ManipulabilityMap section
+		bool project = true;    // ProjectToReachable section
+		bool estimator = true;  // ServoStateEstimator section
+		bool scheduler = true;  // MotionScheduler section (real time, ~5 s)
+		bool spline = true;     // KeyframeSpline section
+		bool compiled = true;   // CompiledScript section
+		bool program = true;    // MotionScript file + windowed playback section (real time, ~4 s)
+		unsigned threads = 0;   // ReachabilityMap / ManipulabilityMap build threads (0 = all cores)
+		double voxelMm = 10.0;  // ReachabilityMap voxel size
+	};
+
+	struct PoseSet
+	{
+		std::vector<double> x, y, z, pitch;
+		std::array<std::vector<double>, ArmKinematics::kJointCount + 1> seed;
+
+		void Resize(size_t n)
+		{
+			x.resize(n);
+			y.resize(n);
+			z.resize(n);
+			pitch.resize(n);
+			for (auto& s : seed) s.resize(n);
+		}
+		size_t Size() const { return x.size(); }
+	};
+
+	struct JointSet
+	{
+		std::array<std::vector<double>, ArmKinematics::kJointCount + 1> q;
+		std::vector<uint8_t> status;
+
+		void Resize(size_t n)
+		{
+			for (auto& v : q) v.assign(n, 0.0);
+			status.assign(n, 0);
+		}
+		ArmKinematicsBatch::JointsSoA View()
+		{
+			ArmKinematicsBatch::JointsSoA v;
+			for (int j = 1; j <= ArmKinematics::kJointCount; j++) v.q[j] = q[j].data();
+			return v;
+		}
+	};
+
+	void PrintUsage(const char* argv0)
+	{
+		std::fprintf(stderr,
+			"Usage: %s [--count N] [--reps R] [--seed S] [--no-seeds] [--no-limits] [--no-roundtrip] [--grid N] [--baseline FILE] [--save-baseline FILE] [--perf-tol F] [--no-cache] [--no-scoring] [--no-fk] [--no-chain] [--no-collision] [--no-plan] [--no-calib] [--no-handeye] [--no-reach] [--no-manip] [--no-project] [--no-estimator] [--no-scheduler] [--no-spline] [--no-compiled] [--no-program] [--threads T] [--voxel MM]\n"
+			"  --count N     poses per batch (default 100000)\n"
+			"  --reps R      timing repetitions, best run is reported (default 5)\n"
+			"  --seed S      RNG seed\n"
+			"  --no-seeds    solve without current-joint seeds (first elbow branch wins ties)\n"
+			"  --no-limits   do not configure MotionConfig soft limits\n"
+			"  --no-roundtrip skip the FK -> IK -> FK grid section\n"
+			"  --grid N      round-trip grid points per joint, N^4 configurations (default 16)\n"
+			"  --baseline FILE      fail if round-trip rates drop or timings grow beyond --perf-tol\n"
+			"  --save-baseline FILE write the round-trip figures for later --baseline runs\n"
+			"  --perf-tol F  allowed relative ns/call growth against the baseline (default 0.25)\n"
+			"  --no-cache    skip the IkCache section\n"
+			"  --no-scoring  skip the IK candidate scoring section\n"
+			"  --no-fk       skip the forward kinematics section\n"
+			"  --no-chain    skip the KinematicChain section\n"
+			"  --no-collision skip the CollisionModel section\n"
+			"  --no-plan     skip the CartesianPlanner section\n"
+			"  --no-calib    skip the KinematicsCalibSolver section\n"
+			"  --no-handeye  skip the HandEyeCalib section\n"
+			"  --no-reach    skip the ReachabilityMap section\n"
+			"  --no-manip    skip the ManipulabilityMap section\n"
+			"  --no-project  skip the ProjectToReachable section\n"
+			"  --no-estimator skip the ServoStateEstimator section\n"
+			"  --no-scheduler skip the MotionScheduler section\n"
+			"  --no-spline   skip the KeyframeSpline section\n"
+			"  --no-compiled skip the CompiledScript section\n"
+			"  --no-program  skip the MotionScript section\n"
+			"  --threads T   ReachabilityMap / ManipulabilityMap build threads (default: all cores)\n"
+			"  --voxel MM    ReachabilityMap voxel size in mm (default 10)\n",
+			argv0);
+	}
+
+	bool ParseArgs(int argc, char** argv, Options& opt)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string a = argv[i];
+			const bool hasValue = (i + 1 < argc);
+			if (a == "--count" && hasValue) opt.count = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+			else if (a == "--reps" && hasValue) opt.reps = std::atoi(argv[++i]);
+			else if (a == "--seed" && hasValue) opt.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+			else if (a == "--no-seeds") opt.useSeeds = false;
+			else if (a == "--no-limits") opt.useLimits = false;
+			else if (a == "--no-roundtrip") opt.roundTrip = false;
+			else if (a == "--grid" && hasValue) opt.grid = std::atoi(argv[++i]);
+			else if (a == "--baseline" && hasValue) opt.baselinePath = argv[++i];
+			else if (a == "--save-baseline" && hasValue) opt.saveBaselinePath = argv[++i];
+			else if (a == "--perf-tol" && hasValue) opt.perfTol = std::atof(argv[++i]);
+			else if (a == "--no-cache") opt.cache = false;
+			else if (a == "--no-scoring") opt.scoring = false;
+			else if (a == "--no-fk") opt.fk = false;
+			else if (a == "--no-chain") opt.chain = false;
+			else if (a == "--no-collision") opt.collision = false;
+			else if (a == "--no-plan") opt.plan = false;
+			else if (a == "--no-calib") opt.calib = false;
+			else if (a == "--no-handeye") opt.handEye = false;
+			else if (a == "--no-reach") opt.reach = false;
+			else if (a == "--no-manip") opt.manip = false;
+			else if (a == "--no-project") opt.project = false;
+			else if (a == "--no-estimator") opt.estimator = false;
+			else if (a == "--no-scheduler") opt.scheduler = false;
+			else if (a == "--no-spline") opt.spline = false;
+			else if (a == "--no-compiled") opt.compiled = false;
+			else if (a == "--no-program") opt.program = false;
+			else if (a == "--threads" && hasValue) opt.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+			else if (a == "--voxel" && hasValue) opt.voxelMm = std::atof(argv[++i]);
+			else return false;
+		}
+		return opt.count > 0 && opt.reps > 0 && opt.grid > 0 && opt.perfTol >= 0.0;
+	}
+
+	// KinematicsConfig keeps its defaults (Reference/mechanics.md); only the joint mapping/limits are set.
+	void MakeMotionConfig(const Options& opt, MotionConfig& mc)
+	{
+		for (int j = 1; j <= ArmKinematics::kJointCount; j++)
+		{
+			auto& jc = mc.Get(j);
+			jc.servoId = j;
+			jc.minPos = opt.useLimits ? 100 : 0;
+			jc.maxPos = opt.useLimits ? 900 : 0;
+		}
+	}
+
+	void MakePoses(const Options& opt, const KinematicsCalib& calib, PoseSet& ps)
+	{
+		std::mt19937 rng(opt.seed);
+		std::uniform_real_distribution<double> u01(0.0, 1.0);
+		const auto& L = calib.Links();
+		const double reach = L.L_arm1 + L.L_arm2 + L.L_wrist;
+
+		ps.Resize(opt.count);
+		for (size_t i = 0; i < opt.count; i++)
+		{
+			// Seeds: random joints inside the limits (or +-90 deg without limits).
+			ArmKinematics::JointAnglesRad q;
+			for (int j = 1; j <= 4; j++)
+			{
+				const auto& jc = calib.GetJoint(j);
+				const double mn = jc.hasLimit ? jc.minRad : -kPi / 2;
+				const double mx = jc.hasLimit ? jc.maxRad : kPi / 2;
+				q.q[j] = mn + (mx - mn) * u01(rng);
+				ps.seed[j][i] = q.q[j];
+			}
+
+			if (u01(rng) < 0.8)
+			{
+				// Reachable: FK of a nearby joint vector, so the seed is a realistic "current pose".
+				ArmKinematics::JointAnglesRad qt = q;
+				for (int j = 1; j <= 4; j++) qt.q[j] += (u01(rng) - 0.5) * 0.2;
+				const auto p = ArmKinematics::ForwardKinematics(calib, qt);
+				ps.x[i] = p.x_mm;
+				ps.y[i] = p.y_mm;
+				ps.z[i] = p.z_mm;
+				ps.pitch[i] = p.pitch_deg;
+			}
+			else
+			{
+				ps.x[i] = (u01(rng) * 2.0 - 1.0) * reach * 1.2;
+				ps.y[i] = (u01(rng) * 2.0 - 1.0) * reach * 1.2;
+				ps.z[i] = L.L_base + (u01(rng) * 2.0 - 1.0) * reach * 1.2;
+				ps.pitch[i] = (u01(rng) * 2.0 - 1.0) * 90.0;
+			}
+		}
+	}
+
+	ArmKinematicsBatch::Status StatusFromScalar(const ArmKinematics::IkResultLite& r)
+	{
+		if (!r.ok) return ArmKinematicsBatch::Status::Unreachable;
+		return (r.error == ArmKinematics::IkError::OutOfLimits) ? ArmKinematicsBatch::Status::OutOfLimits : ArmKinematicsBatch::Status::Ok;
+	}
+
+	double SolveScalar(const Options& opt, const KinematicsCalib& calib, const PoseSet& ps, JointSet& out)
+	{
+		size_t ok = 0;
+		for (size_t i = 0; i < ps.Size(); i++)
+		{
+			ArmKinematics::PoseTarget t;
+			t.x_mm = ps.x[i];
+			t.y_mm = ps.y[i];
+			t.z_mm = ps.z[i];
+			t.pitch_deg = ps.pitch[i];
+			ArmKinematics::JointAnglesRad seed;
+			for (int j = 1; j <= 4; j++) seed.q[j] = ps.seed[j][i];
+
+			ArmKinematics::IkResultLite r;
+			ArmKinematics::InverseKinematics(calib, t, opt.useSeeds ? &seed : nullptr, r);
+			const auto st = StatusFromScalar(r);
+			out.status[i] = static_cast<uint8_t>(st);
+			for (int j = 1; j <= ArmKinematics::kJointCount; j++)
+			{
+				out.q[j][i] = r.ok ? r.chosenQ.q[j] : 0.0;
+			}
+			if (st == ArmKinematicsBatch::Status::Ok) ok++;
+		}
+		return static_cast<double>(ok);
+	}
+
+	double SolveBatch(const Options& opt, const KinematicsCalib& calib, const PoseSet& ps, JointSet& out,
+	                  ArmKinematicsBatch::Backend backend,
+	                  ArmKinematicsBatch::Precision precision = ArmKinematicsBatch::Precision::Double)
+	{
+		ArmKinematicsBatch::PoseSoA in;
+		in.x_mm = ps.x.data();
+		in.y_mm = ps.y.data();
+		in.z_mm = ps.z.data();
+		in.pitch_deg = ps.pitch.data();
+		ArmKinematicsBatch::JointsSoAConst seed;
+		for (int j = 1; j <= ArmKinematics::kJointCount; j++) seed.q[j] = ps.seed[j].data();
+
+		return static_cast<double>(ArmKinematicsBatch::InverseKinematics(calib, in, ps.Size(), out.View(),
+			out.status.data(), opt.useSeeds ? &seed : nullptr, backend, precision));
+	}
+
+	template <class Fn>
+	double BestSeconds(int reps, Fn&& fn)
+	{
+		double best = 1e30;
+		for (int r = 0; r < reps; r++)
+		{
+			const auto t0 = std::chrono::steady_clock::now();
+			fn();
+			const auto t1 = std::chrono::steady_clock::now();
+			best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+		}
+		return best;
+	}
+
+	// Compares a batch result with the scalar reference. At most 0.01% status/branch disagreements are
+	// tolerated: they can only come from poses sitting exactly on a reach/limit boundary or from tied
+	// elbow scores, where the last ulp of atan2/acos decides.
+	bool Verify(const char* name, const PoseSet& ps, const JointSet& ref, const JointSet& got)
+	{
+		size_t statusMismatch = 0;
+		size_t branchMismatch = 0;
+		double maxDq = 0.0;
+		for (size_t i = 0; i < ps.Size(); i++)
+		{
+			if (ref.status[i] != got.status[i])
+			{
+				statusMismatch++;
+				continue;
+			}
+			double dq = 0.0;
+			for (int j = 1; j <= 4; j++)
+			{
+				dq = std::max(dq, std::fabs(ref.q[j][i] - got.q[j][i]));
+			}
+			if (dq > 1e-6)
+			{
+				// Different elbow branch picked because both scores tie within rounding.
+				branchMismatch++;
+				continue;
+			}
+			maxDq = std::max(maxDq, dq);
+		}
+
+		const double n = static_cast<double>(ps.Size());
+		const bool ok = (maxDq < 1e-9) && (statusMismatch + branchMismatch) <= static_cast<size_t>(n * 1e-4);
+		std::printf("  verify %-8s max|dq|=%.3g rad, status mismatches=%zu, branch mismatches=%zu -> %s\n",
+			name, maxDq, statusMismatch, branchMismatch, ok ? "OK" : "FAIL");
+		return ok;
+	}
+
+	// Compares a reduced-precision batch result with the double batch, in servo position units (|posPerRad|·|dq|).
+	// The joint error must stay well below one count: 0.05 for Fast, 0.4 for Float, whose worst case (~0.25) is the
+	// nearly stretched elbow where q3 ~ sqrt(input rounding) (~2e-5 mm at float resolution, i.e. the same flange position).
+	// Status/branch disagreements may only come from poses within rounding of a reach/limit boundary or of an
+	// elbow tie and are capped at 0.1%.
+	bool VerifyPrecision(const char* name, const KinematicsCalib& calib, const PoseSet& ps, const JointSet& ref,
+	                     const JointSet& got, double maxCountsTol)
+	{
+		size_t statusMismatch = 0;
+		size_t branchMismatch = 0;
+		size_t servoMismatch = 0; // rounded servo position differs (a value sitting on a .5 boundary)
+		double maxCounts = 0.0;
+		for (size_t i = 0; i < ps.Size(); i++)
+		{
+			if (ref.status[i] != got.status[i])
+			{
+				statusMismatch++;
+				continue;
+			}
+			if (ref.status[i] == static_cast<uint8_t>(ArmKinematicsBatch::Status::Unreachable)) continue;
+			double counts = 0.0;
+			bool rounded = false;
+			for (int j = 1; j <= 4; j++)
+			{
+				const auto& jc = calib.GetJoint(j);
+				const double a = jc.posOffset + jc.posPerRad * ref.q[j][i];
+				const double b = jc.posOffset + jc.posPerRad * got.q[j][i];
+				counts = std::max(counts, std::fabs(a - b));
+				rounded = rounded || std::lround(a) != std::lround(b);
+			}
+			if (counts > 1.0)
+			{
+				branchMismatch++;
+				continue;
+			}
+			maxCounts = std::max(maxCounts, counts);
+			servoMismatch += rounded ? 1 : 0;
+		}
+
+		const double n = static_cast<double>(ps.Size());
+		const bool ok = (maxCounts < maxCountsTol) && (statusMismatch + branchMismatch) <= static_cast<size_t>(n * 1e-3);
+		std::printf("  verify %-14s max|dq|=%.3g counts, rounded servo diffs=%zu, status mismatches=%zu, branch mismatches=%zu -> %s\n",
+			name, maxCounts, servoMismatch, statusMismatch, branchMismatch, ok ? "OK" : "FAIL");
+		return ok;
+	}
+
+	double WrapAngle(double a)
+	{
+		return std::remainder(a, 2.0 * kPi);
+	}
+
+	// Regression baseline: "key value" lines written by --save-baseline and checked by --baseline.
+	struct Baseline
+	{
+		std::vector<std::pair<std::string, double>> values;
+
+		bool Find(const char* key, double& v) const
+		{
+			for (const auto& kv : values)
+			{
+				if (kv.first == key)
+				{
+					v = kv.second;
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+
+	bool LoadBaseline(const std::string& path, Baseline& b)
+	{
+		FILE* f = std::fopen(path.c_str(), "r");
+		if (!f) return false;
+		char key[64];
+		double v = 0.0;
+		while (std::fscanf(f, "%63s %lf", key, &v) == 2) b.values.emplace_back(key, v);
+		std::fclose(f);
+		return true;
+	}
+
+	bool SaveBaseline(const std::string& path, const Baseline& b)
+	{
+		FILE* f = std::fopen(path.c_str(), "w");
+		if (!f) return false;
+		for (const auto& kv : b.values) std::fprintf(f, "%s %.9g\n", kv.first.c_str(), kv.second);
+		return std::fclose(f) == 0;
+	}
+
+	// FK -> IK -> FK round trips over a dense J1..J4 grid inside the soft limits (default KinematicsConfig).
+	// Every grid point is representable, so a correct IK must reproduce the pose to rounding, recover the
+	// generating joints when seeded with them, keep the elbow branch when seeded with a nearby "previous tick"
+	// and pick a solution inside the limits. Fixed accuracy thresholds always apply; with --baseline the
+	// rates may not drop and the timings may not grow by more than --perf-tol.
+	bool RunRoundTrip(const Options& opt, const KinematicsCalib& calib)
+	{
+		const int n = opt.grid;
+		std::vector<ArmKinematics::JointAnglesRad> qs;
+		qs.reserve(static_cast<size_t>(n) * n * n * n);
+		std::array<double, ArmKinematics::kJointCount + 1> mn{}, mx{};
+		for (int j = 1; j <= 4; j++)
+		{
+			const auto& jc = calib.GetJoint(j);
+			mn[j] = jc.hasLimit ? jc.minRad : -kPi / 2;
+			mx[j] = jc.hasLimit ? jc.maxRad : kPi / 2;
+		}
+		auto at = [&](int j, int k) { return mn[j] + (mx[j] - mn[j]) * (k + 0.5) / n; };
+		for (int a = 0; a < n; a++)
+			for (int b = 0; b < n; b++)
+				for (int c = 0; c < n; c++)
+					for (int d = 0; d < n; d++)
+					{
+						ArmKinematics::JointAnglesRad q;
+						q.q[1] = at(1, a);
+						q.q[2] = at(2, b);
+						q.q[3] = at(3, c);
+						q.q[4] = at(4, d);
+						qs.push_back(q);
+					}
+
+		std::vector<ArmKinematics::PoseTarget> poses(qs.size());
+		const double tFk = BestSeconds(opt.reps, [&]() {
+			for (size_t i = 0; i < qs.size(); i++) poses[i] = ArmKinematics::ForwardKinematics(calib, qs[i]);
+		});
+
+		std::vector<ArmKinematics::IkResultLite> res(qs.size());
+		const double tIk = BestSeconds(opt.reps, [&]() {
+			for (size_t i = 0; i < qs.size(); i++) ArmKinematics::InverseKinematics(calib, poses[i], &qs[i], res[i]);
+		});
+
+		// "Previous tick" seeds: up to +-0.05 rad per joint away from the generating joints.
+		std::mt19937 rng(opt.seed);
+		std::uniform_real_distribution<double> jitter(-0.05, 0.05);
+		std::uniform_real_distribution<double> u01(0.0, 1.0);
+		const auto& jc5 = calib.GetJoint(5);
+		const double mn5 = jc5.hasLimit ? jc5.minRad : -kPi / 2;
+		const double mx5 = jc5.hasLimit ? jc5.maxRad : kPi / 2;
+
+		std::vector<double> posErr;
+		posErr.reserve(qs.size());
+		double maxPitchErr = 0.0;
+		size_t canonical = 0, solved = 0, recovered = 0, branchKept = 0, branchTested = 0, withinLimits = 0;
+		size_t rollRecovered = 0, yawOptimal = 0, yawTested = 0;
+		for (size_t i = 0; i < qs.size(); i++)
+		{
+			const auto& q = qs[i];
+			const auto& r = res[i];
+
+			// IK derives J1 from atan2(x, y), so only configurations whose planar reach points along J1 (arm in
+			// front of the base axis) are expressible as (x, y, z, pitch); reaching over the back is the same
+			// position with a mirrored pitch and J1 + pi, and the base axis itself leaves J1 undefined.
+			const double reach = poses[i].x_mm * std::sin(q.q[1]) + poses[i].y_mm * std::cos(q.q[1]);
+			if (reach < 1.0) continue;
+			canonical++;
+			if (!r.ok) continue;
+			solved++;
+			if (r.error != ArmKinematics::IkError::OutOfLimits) withinLimits++;
+
+			const auto p = ArmKinematics::ForwardKinematics(calib, r.chosenQ);
+			posErr.push_back(std::sqrt((p.x_mm - poses[i].x_mm) * (p.x_mm - poses[i].x_mm)
+				+ (p.y_mm - poses[i].y_mm) * (p.y_mm - poses[i].y_mm)
+				+ (p.z_mm - poses[i].z_mm) * (p.z_mm - poses[i].z_mm)));
+			maxPitchErr = std::max(maxPitchErr, std::fabs(WrapAngle((p.pitch_deg - poses[i].pitch_deg) * kPi / 180.0)) * 180.0 / kPi);
+
+			double dq = 0.0;
+			for (int j = 1; j <= 4; j++) dq = std::max(dq, std::fabs(WrapAngle(r.chosenQ.q[j] - q.q[j])));
+			if (dq < 1e-6) recovered++;
+
+			// J5: an explicit joint roll must come back exactly; a base-yaw roll must orient the gripper's
+			// closing axis (flange x) at least as close to the requested horizontal direction as q5 itself did.
+			{
+				ArmKinematics::JointAnglesRad qr = q;
+				qr.q[5] = mn5 + (mx5 - mn5) * u01(rng);
+				ArmKinematics::PoseTarget t = poses[i];
+				t.rollMode = ArmKinematics::RollMode::Joint;
+				t.roll_deg = qr.q[5] * 180.0 / kPi;
+				ArmKinematics::IkResultLite rr;
+				ArmKinematics::InverseKinematics(calib, t, &q, rr);
+				if (rr.ok && std::fabs(WrapAngle(rr.chosenQ.q[5] - qr.q[5])) < 1e-9) rollRecovered++;
+
+				ArmKinematics::LinkFrames fr;
+				ArmKinematics::ForwardKinematicsFrames(calib, qr, fr);
+				const auto& R = fr.f[ArmKinematics::LinkFrames::kFlange].R;
+				const double h = std::sqrt(R[0][0] * R[0][0] + R[1][0] * R[1][0]);
+				if (h > 0.1)
+				{
+					yawTested++;
+					t.rollMode = ArmKinematics::RollMode::BaseYaw;
+					t.rollSymmetric = false;
+					t.roll_deg = std::atan2(-R[1][0], R[0][0]) * 180.0 / kPi;
+					ArmKinematics::InverseKinematics(calib, t, &q, rr);
+					ArmKinematics::LinkFrames fy;
+					ArmKinematics::ForwardKinematicsFrames(calib, rr.chosenQ, fy);
+					const auto& Ry = fy.f[ArmKinematics::LinkFrames::kFlange].R;
+					if (rr.ok && (Ry[0][0] * R[0][0] + Ry[1][0] * R[1][0]) / h >= h - 1e-9) yawOptimal++;
+				}
+			}
+
+			// Near a straight elbow both branches coincide and either is a correct answer.
+			if (std::fabs(q.q[3]) < 0.1) continue;
+			ArmKinematics::JointAnglesRad seed = q;
+			for (int j = 1; j <= 4; j++) seed.q[j] += jitter(rng);
+			ArmKinematics::IkResultLite rs;
+			ArmKinematics::InverseKinematics(calib, poses[i], &seed, rs);
+			branchTested++;
+			if (rs.ok && (rs.chosenQ.q[3] > 0.0) == (q.q[3] > 0.0)) branchKept++;
+		}
+
+		std::sort(posErr.begin(), posErr.end());
+		auto pct = [&](double p) {
+			return posErr.empty() ? 0.0 : posErr[std::min(posErr.size() - 1, static_cast<size_t>(posErr.size() * p))];
+		};
+		const double total = static_cast<double>(canonical);
+		const double solvedRate = canonical ? solved / total : 0.0;
+		const double recoverRate = canonical ? recovered / total : 0.0;
+		const double branchRate = branchTested ? static_cast<double>(branchKept) / branchTested : 1.0;
+		const double limitRate = solved ? static_cast<double>(withinLimits) / solved : 0.0;
+		const double rollRate = solved ? static_cast<double>(rollRecovered) / solved : 0.0;
+		const double yawRate = yawTested ? static_cast<double>(yawOptimal) / yawTested : 1.0;
+		const double fkNs = 1e9 * tFk / static_cast<double>(qs.size());
+		const double ikNs = 1e9 * tIk / static_cast<double>(qs.size());
+
+		// Every expressible grid point is reachable and inside the limits, so anything short of 100% is a regression.
+		bool ok = solvedRate == 1.0 && recoverRate == 1.0 && branchRate == 1.0 && limitRate == 1.0
+			&& rollRate == 1.0 && yawRate == 1.0
+			&& pct(0.99) < 1e-9 && (posErr.empty() || posErr.back() < 1e-6) && maxPitchErr < 1e-9;
+
+		std::printf("RoundTrip: %d^4 = %zu joint grid points, limits=%s, %zu in front of the base axis\n",
+			n, qs.size(), opt.useLimits ? "on" : "off", canonical);
+		std::printf("  solved %.3f%%, joints recovered %.3f%%, branch kept %.3f%% (%zu jittered seeds), within limits %.3f%%\n",
+			100.0 * solvedRate, 100.0 * recoverRate, 100.0 * branchRate, branchTested, 100.0 * limitRate);
+		std::printf("  roll: J5 recovered %.3f%%, base yaw optimal %.3f%% (%zu poses with a horizontal closing axis)\n",
+			100.0 * rollRate, 100.0 * yawRate, yawTested);
+		std::printf("  position error p50 %.3g mm, p99 %.3g mm, max %.3g mm, max pitch error %.3g deg\n",
+			pct(0.5), pct(0.99), posErr.empty() ? 0.0 : posErr.back(), maxPitchErr);
+		std::printf("  ForwardKinematics %.1f ns/call, InverseKinematics %.1f ns/call\n", fkNs, ikNs);
+
+		Baseline cur;
+		cur.values.emplace_back("roundtrip.grid", n);
+		cur.values.emplace_back("roundtrip.fk_ns", fkNs);
+		cur.values.emplace_back("roundtrip.ik_ns", ikNs);
+		cur.values.emplace_back("roundtrip.recovered", recoverRate);
+		cur.values.emplace_back("roundtrip.branch_kept", branchRate);
+		cur.values.emplace_back("roundtrip.within_limits", limitRate);
+		cur.values.emplace_back("roundtrip.roll_recovered", rollRate);
+
+		if (!opt.baselinePath.empty())
+		{
+			Baseline base;
+			double baseGrid = 0.0;
+			if (!LoadBaseline(opt.baselinePath, base) || !base.Find("roundtrip.grid", baseGrid))
+			{
+				std::printf("  baseline %s: missing or unreadable -> FAIL\n", opt.baselinePath.c_str());
+				ok = false;
+			}
+			else if (static_cast<int>(baseGrid) != n)
+			{
+				std::printf("  baseline %s: recorded with --grid %d -> FAIL\n", opt.baselinePath.c_str(), static_cast<int>(baseGrid));
+				ok = false;
+			}
+			else
+			{
+				// Timings may grow by perfTol; rates may not drop at all (the grid is deterministic).
+				const struct { const char* key; bool higherIsWorse; double tol; } checks[] = {
+					{ "roundtrip.fk_ns", true, opt.perfTol },
+					{ "roundtrip.ik_ns", true, opt.perfTol },
+					{ "roundtrip.recovered", false, 0.0 },
+					{ "roundtrip.branch_kept", false, 0.0 },
+					{ "roundtrip.within_limits", false, 0.0 },
+					{ "roundtrip.roll_recovered", false, 0.0 },
+				};
+				for (const auto& c : checks)
+				{
+					double b = 0.0, v = 0.0;
+					if (!base.Find(c.key, b) || !cur.Find(c.key, v)) continue;
+					const bool regressed = c.higherIsWorse ? (v > b * (1.0 + c.tol)) : (v < b * (1.0 - c.tol));
+					if (regressed)
+					{
+						std::printf("  regression %s: %.4g (baseline %.4g)\n", c.key, v, b);
+						ok = false;
+					}
+				}
+				std::printf("  baseline %s (perf tolerance %.0f%%)\n", opt.baselinePath.c_str(), 100.0 * opt.perfTol);
+			}
+		}
+		if (!opt.saveBaselinePath.empty() && !SaveBaseline(opt.saveBaselinePath, cur))
+		{
+			std::printf("  cannot write baseline %s\n", opt.saveBaselinePath.c_str());
+			ok = false;
+		}
+
+		std::printf("  -> %s\n", ok ? "OK" : "FAIL");
+		return ok;
+	}
+
+	// IkCache: a hovering workload (each pose re-requested with sub-quantum jitter, like visual servo idling
+	// on a target). Every cached answer must equal a direct solve of the snapped pose with the same seed, the
+	// servo positions must equal the conversion of the chosen joints, and a multi-threaded replay must give
+	// the same answers as the single-threaded one.
+	bool RunIkCache(const Options& opt, const KinematicsCalib& calib, const PoseSet& ps)
+	{
+		const size_t poses = std::min<size_t>(ps.Size(), 2000);
+		const size_t repeats = 50;
+		const size_t n = poses * repeats;
+
+		IkCache::Params cp;
+		IkCache cache(cp);
+		const double q = cp.quantMm;
+		const double qd = cp.quantDeg;
+
+		std::mt19937 rng(opt.seed ^ 0x1CCAu);
+		std::uniform_real_distribution<double> jitter(-0.2, 0.2);
+		std::vector<ArmKinematics::PoseTarget> req(n);
+		std::vector<ArmKinematics::JointAnglesRad> seeds(n);
+		for (size_t i = 0; i < poses; i++)
+		{
+			for (size_t r = 0; r < repeats; r++)
+			{
+				auto& t = req[i * repeats + r];
+				t.x_mm = ps.x[i] + jitter(rng) * q;
+				t.y_mm = ps.y[i] + jitter(rng) * q;
+				t.z_mm = ps.z[i] + jitter(rng) * q;
+				t.pitch_deg = ps.pitch[i] + jitter(rng) * qd;
+				for (int j = 1; j <= 4; j++) seeds[i * repeats + r].q[j] = ps.seed[j][i];
+			}
+		}
+
+		std::vector<ArmKinematics::IkResultLite> got(n);
+		std::vector<ArmKinematics::ServoPos> servo(n);
+		std::vector<ArmKinematics::IkError> servoErr(n);
+		const auto t0 = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < n; i++) cache.Solve(calib, req[i], &seeds[i], got[i], &servo[i], &servoErr[i]);
+		const double tCache = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		const IkCache::Stats st = cache.GetStats();
+
+		std::vector<ArmKinematics::IkResultLite> direct(n);
+		std::vector<ArmKinematics::ServoPos> directServo(n);
+		const double tDirect = BestSeconds(1, [&]() {
+			for (size_t i = 0; i < n; i++)
+			{
+				ArmKinematics::InverseKinematics(calib, req[i], &seeds[i], direct[i]);
+				if (direct[i].ok) ArmKinematics::JointAnglesToServoPos(calib, direct[i].chosenQ, directServo[i]);
+			}
+		});
+
+		size_t mismatch = 0;
+		double maxPosErr = 0.0;
+		// Reference: a direct solve of the snapped pose with the same seed.
+		for (size_t i = 0; i < n; i++)
+		{
+			ArmKinematics::PoseTarget t = req[i];
+			t.x_mm = std::llround(t.x_mm / q) * q;
+			t.y_mm = std::llround(t.y_mm / q) * q;
+			t.z_mm = std::llround(t.z_mm / q) * q;
+			t.pitch_deg = std::llround(t.pitch_deg / qd) * qd;
+			ArmKinematics::IkResultLite ref;
+			ArmKinematics::InverseKinematics(calib, t, &seeds[i], ref);
+			bool same = ref.ok == got[i].ok && ref.error == got[i].error && ref.chosenIndex == got[i].chosenIndex;
+			for (int j = 1; same && j <= ArmKinematics::kJointCount; j++) same = ref.chosenQ.q[j] == got[i].chosenQ.q[j];
+			if (same && ref.ok)
+			{
+				ArmKinematics::ServoPos sp;
+				same = ArmKinematics::JointAnglesToServoPos(calib, ref.chosenQ, sp) == servoErr[i] && sp.pos == servo[i].pos;
+				const auto p = ArmKinematics::ForwardKinematics(calib, got[i].chosenQ);
+				maxPosErr = std::max(maxPosErr, std::sqrt((p.x_mm - req[i].x_mm) * (p.x_mm - req[i].x_mm)
+					+ (p.y_mm - req[i].y_mm) * (p.y_mm - req[i].y_mm) + (p.z_mm - req[i].z_mm) * (p.z_mm - req[i].z_mm)));
+			}
+			mismatch += same ? 0 : 1;
+		}
+
+		// Concurrent replay on a fresh cache (forced to 4 threads so the shard locks are contended even on one core).
+		IkCache shared(cp);
+		std::vector<ArmKinematics::IkResultLite> par(n);
+		ParallelFor(n, [&](size_t i) { shared.Solve(calib, req[i], &seeds[i], par[i]); }, std::max(opt.threads, 4u));
+		size_t parMismatch = 0;
+		for (size_t i = 0; i < n; i++)
+		{
+			bool same = par[i].ok == got[i].ok && par[i].chosenIndex == got[i].chosenIndex;
+			for (int j = 1; same && j <= ArmKinematics::kJointCount; j++) same = par[i].chosenQ.q[j] == got[i].chosenQ.q[j];
+			parMismatch += same ? 0 : 1;
+		}
+
+		// Snapping moves the target by at most half a quantum per axis.
+		const bool ok = mismatch == 0 && parMismatch == 0 && maxPosErr <= 0.5 * q * std::sqrt(3.0) + 1e-9;
+		std::printf("IkCache: %zu poses x %zu hover requests, quantum %.2f mm / %.2f deg, capacity %zu\n",
+			poses, repeats, q, qd, cache.GetParams().capacity);
+		std::printf("  hit rate %.1f%% (hits %llu, misses %llu, bypassed %llu, evictions %llu)\n",
+			100.0 * st.HitRate(), static_cast<unsigned long long>(st.hits), static_cast<unsigned long long>(st.misses),
+			static_cast<unsigned long long>(st.bypassed), static_cast<unsigned long long>(st.evictions));
+		std::printf("  mismatches vs direct solve %zu, vs %u-thread replay %zu, max snap error %.4f mm -> %s\n",
+			mismatch, std::max(opt.threads, 4u), parMismatch, maxPosErr, ok ? "OK" : "FAIL");
+		std::printf("  IkCache::Solve (IK + servo) %.1f ns/call, direct IK + servo %.1f ns/call\n",
+			1e9 * tCache / n, 1e9 * tDirect / n);
+		return ok;
+	}
+
+	// Candidate scoring: simulated closed-form jog sessions. Each session starts from FK of a random in-limit joint
+	// vector with the "current joints" at mid-range (no readback yet), then jogs in a constant Cartesian direction,
+	// seeding every tick with the previous solution. A session ends on the first tick whose target has no in-limit
+	// solution, or on an elbow-branch flip (IK jumped to the other branch because the current one hit a limit).
+	// Default scoring and IkScoring run the same sessions; the oracle column tries both start branches and keeps
+	// the longer run, i.e. the best any start choice could have done.
+	bool RunScoring(const Options& opt, const KinematicsCalib& calib)
+	{
+		const size_t sessions = 4000;
+		const int maxTicks = 400;
+		const int kEarlyTicks = 5;
+
+		ArmKinematics::JointAnglesRad home;
+		double mn[ArmKinematics::kJointCount + 1] = {};
+		double mx[ArmKinematics::kJointCount + 1] = {};
+		for (int j = 1; j <= 4; j++)
+		{
+			const auto& jc = calib.GetJoint(j);
+			mn[j] = jc.hasLimit ? jc.minRad : -kPi / 2;
+			mx[j] = jc.hasLimit ? jc.maxRad : kPi / 2;
+			home.q[j] = 0.5 * (mn[j] + mx[j]);
+		}
+
+		std::mt19937 rng(opt.seed ^ 0x5C0Eu);
+		std::uniform_real_distribution<double> u01(0.0, 1.0);
+		std::normal_distribution<double> nd(0.0, 1.0);
+		std::vector<ArmKinematics::PoseTarget> starts;
+		std::vector<ArmKinematics::PoseVelocity> dirs;
+		while (starts.size() < sessions)
+		{
+			ArmKinematics::JointAnglesRad q;
+			for (int j = 1; j <= 4; j++) q.q[j] = mn[j] + (mx[j] - mn[j]) * u01(rng);
+			const auto p = ArmKinematics::ForwardKinematics(calib, q);
+			if (p.x_mm * std::sin(q.q[1]) + p.y_mm * std::cos(q.q[1]) < 1.0) continue; // see RunRoundTrip
+
+			const double x = nd(rng), y = nd(rng), z = nd(rng);
+			const double len = std::sqrt(x * x + y * y + z * z);
+			ArmKinematics::PoseVelocity v;
+			v.x_mm = 2.0 * x / len; // 2 mm per tick (40 mm/s at 20 Hz)
+			v.y_mm = 2.0 * y / len;
+			v.z_mm = 2.0 * z / len;
+			v.pitch_deg = 0.5 * nd(rng);
+			starts.push_back(p);
+			dirs.push_back(v);
+		}
+
+		enum class End : uint8_t { Completed, NoSolution, Flip };
+		auto session = [&](size_t s, const ArmKinematics::JointAnglesRad& start, const ArmKinematics::IkScoring* pScoring,
+		                   int& ticks) {
+			ArmKinematics::IkScoring sc;
+			if (pScoring)
+			{
+				sc = *pScoring;
+				sc.nextStep = dirs[s];
+			}
+			ArmKinematics::PoseTarget target = starts[s];
+			ArmKinematics::JointAnglesRad seed = start;
+			for (ticks = 0; ticks < maxTicks; ticks++)
+			{
+				ArmKinematics::IkResultLite r;
+				ArmKinematics::InverseKinematics(calib, target, &seed, pScoring ? &sc : nullptr, r);
+				if (!r.ok || r.error != ArmKinematics::IkError::None) return End::NoSolution;
+				if (ticks > 0)
+				{
+					// A 2 mm step moves no joint by 0.25 rad except through a branch change (passing the
+					// stretched-out singularity q3 = 0 is continuous and is not counted).
+					double jump = 0.0;
+					for (int j = 1; j <= 4; j++) jump = std::max(jump, std::fabs(WrapAngle(r.chosenQ.q[j] - seed.q[j])));
+					if (jump > 0.25) return End::Flip;
+				}
+				seed = r.chosenQ;
+				target.x_mm += dirs[s].x_mm;
+				target.y_mm += dirs[s].y_mm;
+				target.z_mm += dirs[s].z_mm;
+				target.pitch_deg += dirs[s].pitch_deg;
+			}
+			return End::Completed;
+		};
+
+		struct Tally
+		{
+			double ticks = 0.0;
+			size_t failures = 0;
+			size_t flips = 0;
+			size_t completed = 0;
+			size_t early = 0;   // ended within kEarlyTicks: the start choice sat on a limit / singularity
+		};
+		auto add = [](Tally& t, End e, int ticks) {
+			t.ticks += ticks;
+			if (e == End::NoSolution) t.failures++;
+			else if (e == End::Flip) t.flips++;
+			else t.completed++;
+		};
+
+		ArmKinematics::IkScoring scoring;
+		scoring.enabled = true;
+		ArmKinematics::IkScoring disabled;
+		Tally base, rich, oracle;
+		size_t choices = 0, changed = 0, mismatch = 0;
+		size_t differ = 0, longer = 0, shorter = 0;
+		double differBase = 0.0, differRich = 0.0;
+		double baseSec = 0.0, richSec = 0.0;
+		for (size_t s = 0; s < sessions; s++)
+		{
+			int tb = 0, tr = 0, td = 0;
+			auto t0 = std::chrono::steady_clock::now();
+			const End eb = session(s, home, nullptr, tb);
+			auto t1 = std::chrono::steady_clock::now();
+			const End er = session(s, home, &scoring, tr);
+			auto t2 = std::chrono::steady_clock::now();
+			baseSec += std::chrono::duration<double>(t1 - t0).count();
+			richSec += std::chrono::duration<double>(t2 - t1).count();
+			add(base, eb, tb);
+			add(rich, er, tr);
+			if (tb < kEarlyTicks) base.early++;
+			if (tr < kEarlyTicks) rich.early++;
+			if (tb != tr)
+			{
+				differ++;
+				(tr > tb ? longer : shorter)++;
+				differBase += tb;
+				differRich += tr;
+			}
+
+			// IkScoring with enabled=false must be the default rule exactly.
+			const End ed = session(s, home, &disabled, td);
+			if (ed != eb || td != tb) mismatch++;
+
+			ArmKinematics::IkResultLite r0, r1;
+			ArmKinematics::InverseKinematics(calib, starts[s], &home, r0);
+			ArmKinematics::IkScoring sc = scoring;
+			sc.nextStep = dirs[s];
+			ArmKinematics::InverseKinematics(calib, starts[s], &home, &sc, r1);
+			int both = 0;
+			for (int c = 0; c < r0.candidateCount; c++) both += r0.candidates[c].withinLimits ? 1 : 0;
+			if (both == 2)
+			{
+				choices++;
+				if (r0.chosenIndex != r1.chosenIndex) changed++;
+			}
+
+			End best = End::NoSolution;
+			int bestTicks = -1;
+			for (int c = 0; c < r0.candidateCount; c++)
+			{
+				if (!r0.candidates[c].withinLimits) continue;
+				int tc = 0;
+				const End ec = session(s, r0.candidates[c].q, nullptr, tc);
+				if (tc > bestTicks || (tc == bestTicks && ec == End::Completed))
+				{
+					bestTicks = tc;
+					best = ec;
+				}
+			}
+			add(oracle, best, std::max(bestTicks, 0));
+			if (bestTicks < kEarlyTicks) oracle.early++;
+		}
+
+		std::printf("Scoring: %zu jog sessions, 2 mm/tick, up to %d ticks, start seed at mid-range\n", sessions, maxTicks);
+		std::printf("  start choice: %zu sessions with two in-limit branches, scoring changed %zu\n", choices, changed);
+		auto print = [&](const char* name, const Tally& t, double sec) {
+			std::printf("  %-8s mean run %5.1f ticks, ended < %d ticks %4zu, no-solution ends %4zu, branch flips %4zu, completed %zu",
+				name, t.ticks / sessions, kEarlyTicks, t.early, t.failures, t.flips, t.completed);
+			if (sec > 0.0) std::printf(", %.0f ns/tick", 1e9 * sec / std::max(t.ticks, 1.0));
+			std::printf("\n");
+		};
+		print("default", base, baseSec);
+		print("scored", rich, richSec);
+		print("oracle", oracle, 0.0);
+		std::printf("  sessions whose run length changed: %zu (%zu longer, %zu shorter), mean %.1f -> %.1f ticks\n",
+			differ, longer, shorter, differBase / std::max<size_t>(differ, 1), differRich / std::max<size_t>(differ, 1));
+		std::printf("  disabled IkScoring vs default: %zu mismatched sessions\n", mismatch);
+		// Most sessions end where the target leaves the in-limit workspace, which no branch choice can avoid (see
+		// the oracle row); scoring must not shorten runs overall and must not add early failures.
+		const bool ok = mismatch == 0 && rich.ticks >= base.ticks && rich.early <= base.early;
+		std::printf("  -> %s\n", ok ? "OK" : "FAIL");
+		return ok;
+	}
+
+	// Link-frame FK: every frame must be a proper rotation, link lengths must be preserved, the flange must
+	// coincide with ForwardKinematics and the batched points must match the per-sample frames.
+	bool RunForward(const Options& opt, const KinematicsCalib& calib, const PoseSet& ps)
+	{
+		using F = ArmKinematics::LinkFrames;
+		const size_t count = ps.Size();
+		const auto& L = calib.Links();
+
+		// Joint samples: the IK seeds (inside the limits) plus a random J5 roll.
+		std::mt19937 rng(opt.seed + 1u);
+		std::uniform_real_distribution<double> uRoll(-kPi / 2, kPi / 2);
+		std::vector<double> q5(count);
+		for (double& v : q5) v = uRoll(rng);
+		ArmKinematicsBatch::JointsSoAConst in;
+		for (int j = 1; j <= 4; j++) in.q[j] = ps.seed[j].data();
+		in.q[5] = q5.data();
+
+		auto sampleQ = [&](size_t i)
+		{
+			ArmKinematics::JointAnglesRad q;
+			for (int j = 1; j <= 4; j++) q.q[j] = ps.seed[j][i];
+			q.q[5] = q5[i];
+			return q;
+		};
+		auto dist = [](const double* a, const double* b)
+		{
+			return std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+		};
+
+		// Reference frames + self-consistency.
+		std::array<std::vector<double>, F::kCount> refX, refY, refZ;
+		for (int k = 0; k < F::kCount; k++)
+		{
+			refX[k].resize(count);
+			refY[k].resize(count);
+			refZ[k].resize(count);
+		}
+		double maxOrtho = 0.0;
+		double maxFlange = 0.0;
+		double maxLink = 0.0;
+		for (size_t i = 0; i < count; i++)
+		{
+			const auto q = sampleQ(i);
+			F frames;
+			ArmKinematics::ForwardKinematicsFrames(calib, q, frames);
+			for (int k = 0; k < F::kCount; k++)
+			{
+				const auto& f = frames.f[k];
+				refX[k][i] = f.p[0];
+				refY[k][i] = f.p[1];
+				refZ[k][i] = f.p[2];
+				// R^T R = I and det(R) = +1 (x cross y = z)
+				for (int a = 0; a < 3; a++)
+				{
+					for (int b = 0; b < 3; b++)
+					{
+						double dot = 0.0;
+						for (int r = 0; r < 3; r++) dot += f.R[r][a] * f.R[r][b];
+						maxOrtho = std::max(maxOrtho, std::fabs(dot - (a == b ? 1.0 : 0.0)));
+					}
+				}
+				for (int r = 0; r < 3; r++)
+				{
+					const int r1 = (r + 1) % 3;
+					const int r2 = (r + 2) % 3;
+					const double cz = f.R[r1][0] * f.R[r2][1] - f.R[r2][0] * f.R[r1][1];
+					maxOrtho = std::max(maxOrtho, std::fabs(cz - f.R[r][2]));
+				}
+			}
+			const auto pose = ArmKinematics::ForwardKinematics(calib, q);
+			const double ee[3] = { pose.x_mm, pose.y_mm, pose.z_mm };
+			maxFlange = std::max(maxFlange, dist(ee, frames.f[F::kFlange].p));
+			maxLink = std::max(maxLink, std::fabs(dist(frames.f[F::kShoulder].p, frames.f[F::kElbow].p) - L.L_arm1));
+			maxLink = std::max(maxLink, std::fabs(dist(frames.f[F::kElbow].p, frames.f[F::kWrist].p) - L.L_arm2));
+			maxLink = std::max(maxLink, std::fabs(dist(frames.f[F::kWrist].p, frames.f[F::kFlange].p) - L.L_wrist));
+			maxLink = std::max(maxLink, std::fabs(dist(frames.f[F::kFlange].p, frames.f[F::kCamera].p) - L.L_cam));
+		}
+		bool ok = maxOrtho < 1e-12 && maxFlange < 1e-9 && maxLink < 1e-9;
+		std::printf("FK: %zu joint samples\n", count);
+		std::printf("  frames: max|R^T R - I|=%.2g, flange vs FK %.2g mm, link length err %.2g mm -> %s\n",
+			maxOrtho, maxFlange, maxLink, ok ? "OK" : "FAIL");
+
+		// Batched points vs. reference.
+		std::vector<double> px(count), py(count), pz(count), pp(count);
+		std::array<std::vector<double>, F::kCount> bx, by, bz;
+		ArmKinematicsBatch::PoseSoAOut outPose;
+		outPose.x_mm = px.data();
+		outPose.y_mm = py.data();
+		outPose.z_mm = pz.data();
+		outPose.pitch_deg = pp.data();
+		ArmKinematicsBatch::LinkPointsSoA points;
+		for (int k = 0; k < F::kCount; k++)
+		{
+			bx[k].resize(count);
+			by[k].resize(count);
+			bz[k].resize(count);
+			points.x[k] = bx[k].data();
+			points.y[k] = by[k].data();
+			points.z[k] = bz[k].data();
+		}
+
+		const ArmKinematicsBatch::Backend best = ArmKinematicsBatch::BestBackend();
+		std::vector<ArmKinematicsBatch::Backend> backends(1, ArmKinematicsBatch::Backend::Scalar);
+		if (best != ArmKinematicsBatch::Backend::Scalar) backends.push_back(best);
+		const ArmKinematicsBatch::Precision precisions[] = {
+			ArmKinematicsBatch::Precision::Double, ArmKinematicsBatch::Precision::Fast, ArmKinematicsBatch::Precision::Float };
+		// Double must match to rounding; Fast / Float only far below one servo count at the flange (~1 mm).
+		auto batchTol = [](ArmKinematicsBatch::Precision pr) { return pr == ArmKinematicsBatch::Precision::Double ? 1e-9 : 1e-2; };
+		auto batchLabel = [](ArmKinematicsBatch::Backend b, ArmKinematicsBatch::Precision pr)
+		{
+			std::string s = ArmKinematicsBatch::BackendName(b);
+			if (pr != ArmKinematicsBatch::Precision::Double) s = s + "/" + ArmKinematicsBatch::PrecisionName(pr);
+			return s;
+		};
+		for (auto b : backends)
+		for (auto pr : precisions)
+		{
+			ArmKinematicsBatch::ForwardKinematics(calib, in, count, outPose, &points, b, pr);
+			double maxDp = 0.0;
+			double maxDpitch = 0.0;
+			for (size_t i = 0; i < count; i++)
+			{
+				for (int k = 0; k < F::kCount; k++)
+				{
+					maxDp = std::max(maxDp, std::fabs(bx[k][i] - refX[k][i]));
+					maxDp = std::max(maxDp, std::fabs(by[k][i] - refY[k][i]));
+					maxDp = std::max(maxDp, std::fabs(bz[k][i] - refZ[k][i]));
+				}
+				const auto pose = ArmKinematics::ForwardKinematics(calib, sampleQ(i));
+				maxDp = std::max(maxDp, std::fabs(px[i] - pose.x_mm) + std::fabs(py[i] - pose.y_mm) + std::fabs(pz[i] - pose.z_mm));
+				maxDpitch = std::max(maxDpitch, std::fabs(pp[i] - pose.pitch_deg));
+			}
+			const bool bOk = maxDp < batchTol(pr) && maxDpitch < batchTol(pr);
+			std::printf("  verify %-12s max|dp|=%.3g mm, max|dpitch|=%.3g deg -> %s\n",
+				batchLabel(b, pr).c_str(), maxDp, maxDpitch, bOk ? "OK" : "FAIL");
+			ok = ok && bOk;
+		}
+
+		// Timings.
+		double sink = 0.0;
+		const double tPose = BestSeconds(opt.reps, [&]() {
+			for (size_t i = 0; i < count; i++) sink += ArmKinematics::ForwardKinematics(calib, sampleQ(i)).z_mm;
+		});
+		const double tFrames = BestSeconds(opt.reps, [&]() {
+			F frames;
+			for (size_t i = 0; i < count; i++)
+			{
+				ArmKinematics::ForwardKinematicsFrames(calib, sampleQ(i), frames);
+				sink += frames.f[F::kCamera].p[2];
+			}
+		});
+		const double n = static_cast<double>(count);
+		std::printf("  %-28s %12.0f samples/s  (%.1f ns/sample)\n", "ForwardKinematics (pose)", n / tPose, 1e9 * tPose / n);
+		std::printf("  %-28s %12.0f samples/s  (%.1f ns/sample)\n", "ForwardKinematicsFrames", n / tFrames, 1e9 * tFrames / n);
+		for (auto b : backends)
+		for (auto pr : precisions)
+		{
+			const double tB = BestSeconds(opt.reps, [&]() { ArmKinematicsBatch::ForwardKinematics(calib, in, count, outPose, nullptr, b, pr); });
+			const double tBp = BestSeconds(opt.reps, [&]() { ArmKinematicsBatch::ForwardKinematics(calib, in, count, outPose, &points, b, pr); });
+			const std::string label = "batch " + batchLabel(b, pr);
+			std::printf("  %-28s %12.0f samples/s  (%.1f ns/sample pose, %.1f ns/sample all points)\n",
+				label.c_str(), n / tB, 1e9 * tB / n, 1e9 * tBp / n);
+		}
+		if (sink == 12345.678) std::printf("\n"); // keep the timed loops from being optimized away
+		return ok;
+	}
+
+	// KinematicChain: the generated 5-joint code must reproduce the hand-written model (frames, Jacobian, servo
+	// mapping, axis signs) and not be slower than the pre-chain ForwardKinematicsFrames; the 6-joint variant is
+	// checked for frame orthonormality, its geometric Jacobian against finite differences, and DLS IK convergence
+	// from a perturbed seed.
+	void ReferenceFrames5(const KinematicsConfig::LinkLengthsMm& L, const ArmKinematics::JointAnglesRad& q,
+	                      std::array<KinematicChain::Frame, 5>& out)
+	{
+		// Hand-written planar form (the pre-chain ForwardKinematicsFrames), kept here as the reference.
+		const double s1 = std::sin(q.q[1]);
+		const double c1 = std::cos(q.q[1]);
+		const double ex[3] = { c1, -s1, 0.0 };
+		const double ey[3] = { s1, c1, 0.0 };
+		auto setLink = [&](KinematicChain::Frame& f, double a, double py, double pz)
+		{
+			const double sa = std::sin(a);
+			const double ca = std::cos(a);
+			for (int i = 0; i < 3; i++)
+			{
+				f.R[i][0] = ex[i];
+				f.R[i][1] = ca * ey[i];
+				f.R[i][2] = -sa * ey[i];
+			}
+			f.R[2][1] += sa;
+			f.R[2][2] += ca;
+			f.p[0] = py * s1;
+			f.p[1] = py * c1;
+			f.p[2] = pz;
+		};
+		const double a2 = q.q[2];
+		const double a23 = a2 + q.q[3];
+		const double a234 = a23 + q.q[4];
+		const double yEl = L.L_arm1 * std::cos(a2);
+		const double zEl = L.L_base + L.L_arm1 * std::sin(a2);
+		const double yWr = yEl + L.L_arm2 * std::cos(a23);
+		const double zWr = zEl + L.L_arm2 * std::sin(a23);
+		setLink(out[0], 0.0, 0.0, 0.0);
+		setLink(out[1], a2, 0.0, L.L_base);
+		setLink(out[2], a23, yEl, zEl);
+		setLink(out[3], a234, yWr, zWr);
+		setLink(out[4], a234, yWr + L.L_wrist * std::cos(a234), zWr + L.L_wrist * std::sin(a234));
+		const double s5 = std::sin(q.q[5]);
+		const double c5 = std::cos(q.q[5]);
+		for (int i = 0; i < 3; i++)
+		{
+			const double x = out[4].R[i][0];
+			const double z = out[4].R[i][2];
+			out[4].R[i][0] = c5 * x - s5 * z;
+			out[4].R[i][2] = s5 * x + c5 * z;
+		}
+	}
+
+	double FrameDiff(const KinematicChain::Frame& a, const KinematicChain::Frame& b)
+	{
+		double d = 0.0;
+		for (int r = 0; r < 3; r++)
+		{
+			d = std::max(d, std::fabs(a.p[r] - b.p[r]));
+			for (int c = 0; c < 3; c++) d = std::max(d, 100.0 * std::fabs(a.R[r][c] - b.R[r][c])); // 1 rad ~ 100 mm
+		}
+		return d;
+	}
+
+	double OrthoError(const KinematicChain::Frame& f)
+	{
+		double e = 0.0;
+		for (int a = 0; a < 3; a++)
+		{
+			for (int b = 0; b < 3; b++)
+			{
+				double dot = 0.0;
+				for (int r = 0; r < 3; r++) dot += f.R[r][a] * f.R[r][b];
+				e = std::max(e, std::fabs(dot - (a == b ? 1.0 : 0.0)));
+			}
+		}
+		for (int r = 0; r < 3; r++)
+		{
+			const int r1 = (r + 1) % 3;
+			const int r2 = (r + 2) % 3;
+			e = std::max(e, std::fabs(f.R[r1][0] * f.R[r2][1] - f.R[r2][0] * f.R[r1][1] - f.R[r][2]));
+		}
+		return e;
+	}
+
+	// Geometric Jacobian vs. central differences of the flange pose (linear mm, angular via 1/2 sum x_k cross dx_k).
+	template <class C>
+	double JacobianFdError(const KinematicsConfig::LinkLengthsMm& L, const typename C::Q& q)
+	{
+		typename C::Jacobian J;
+		KinematicChain::ComputeJacobian<C>(L, q, J);
+		const double h = 1e-6;
+		const KinematicChain::Frame f0 = KinematicChain::Forward<C>(L, q);
+		double err = 0.0;
+		for (int c = 0; c < C::kDof; c++)
+		{
+			typename C::Q qp = q;
+			typename C::Q qm = q;
+			qp[c] += h;
+			qm[c] -= h;
+			const KinematicChain::Frame fp = KinematicChain::Forward<C>(L, qp);
+			const KinematicChain::Frame fm = KinematicChain::Forward<C>(L, qm);
+			double w[3] = {};
+			for (int k = 0; k < 3; k++)
+			{
+				const double d[3] = { (fp.R[0][k] - fm.R[0][k]) / (2 * h), (fp.R[1][k] - fm.R[1][k]) / (2 * h), (fp.R[2][k] - fm.R[2][k]) / (2 * h) };
+				w[0] += 0.5 * (f0.R[1][k] * d[2] - f0.R[2][k] * d[1]);
+				w[1] += 0.5 * (f0.R[2][k] * d[0] - f0.R[0][k] * d[2]);
+				w[2] += 0.5 * (f0.R[0][k] * d[1] - f0.R[1][k] * d[0]);
+			}
+			for (int r = 0; r < 3; r++)
+			{
+				err = std::max(err, std::fabs(J[r][c] - (fp.p[r] - fm.p[r]) / (2 * h)));
+				err = std::max(err, 100.0 * std::fabs(J[3 + r][c] - w[r]));
+			}
+		}
+		return err;
+	}
+
+	bool RunChain(const Options& opt, const KinematicsCalib& calib, const PoseSet& ps)
+	{
+		using KinematicChain::Arm5Dof;
+		using KinematicChain::Arm6Dof;
+		using F = ArmKinematics::LinkFrames;
+		const size_t count = ps.Size();
+		const auto& L = calib.Links();
+
+		std::mt19937 rng(opt.seed + 45u);
+		std::uniform_real_distribution<double> uRoll(-kPi / 2, kPi / 2);
+		std::uniform_real_distribution<double> uQ(-1.2, 1.2);
+		std::vector<ArmKinematics::JointAnglesRad> qs(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			for (int j = 1; j <= 4; j++) qs[i].q[j] = ps.seed[j][i];
+			qs[i].q[5] = uRoll(rng);
+		}
+		auto toChain = [](const ArmKinematics::JointAnglesRad& q)
+		{
+			Arm5Dof::Q c;
+			for (int j = 0; j < Arm5Dof::kDof; j++) c[j] = q.q[j + 1];
+			return c;
+		};
+
+		// 5-joint chain vs. the hand-written model.
+		double maxFrame = 0.0;
+		double maxPose = 0.0;
+		double maxJac = 0.0;
+		double maxFd5 = 0.0;
+		size_t servoMismatch = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			const auto& q = qs[i];
+			std::array<KinematicChain::Frame, 5> ref;
+			ReferenceFrames5(L, q, ref);
+			F frames;
+			ArmKinematics::ForwardKinematicsFrames(calib, q, frames);
+			for (int j = 0; j < 5; j++) maxFrame = std::max(maxFrame, FrameDiff(ref[j], frames.f[F::kTurntable + j]));
+
+			const Arm5Dof::Q qc = toChain(q);
+			const KinematicChain::Frame fl = KinematicChain::Forward<Arm5Dof>(L, qc);
+			const auto pose = ArmKinematics::ForwardKinematics(calib, q);
+			maxPose = std::max(maxPose, std::fabs(fl.p[0] - pose.x_mm) + std::fabs(fl.p[1] - pose.y_mm) + std::fabs(fl.p[2] - pose.z_mm));
+
+			// Linear rows must match ComputeJacobian (x, y, z); its pitch row is the angular velocity about the
+			// turntable x axis. J5 (roll) does not move the flange origin.
+			Arm5Dof::Jacobian J;
+			KinematicChain::ComputeJacobian<Arm5Dof>(L, qc, J);
+			const auto Jh = ArmKinematics::ComputeJacobian(calib, q);
+			const double ex[3] = { frames.f[F::kTurntable].R[0][0], frames.f[F::kTurntable].R[1][0], frames.f[F::kTurntable].R[2][0] };
+			for (int c = 0; c < 5; c++)
+			{
+				for (int r = 0; r < 3; r++) maxJac = std::max(maxJac, std::fabs(J[r][c] - (c < 4 ? Jh.m[r][c] : 0.0)));
+				const double pitchRate = J[3][c] * ex[0] + J[4][c] * ex[1] + J[5][c] * ex[2];
+				maxJac = std::max(maxJac, 100.0 * std::fabs(pitchRate - (c < 4 ? Jh.m[3][c] : 0.0)));
+			}
+			if (i < 2000) maxFd5 = std::max(maxFd5, JacobianFdError<Arm5Dof>(L, qc));
+
+			ArmKinematics::ServoPos sp;
+			Arm5Dof::ServoPos cp;
+			const bool hOk = ArmKinematics::JointAnglesToServoPos(calib, q, sp) == ArmKinematics::IkError::None;
+			const bool cOk = KinematicChain::ToServo<Arm5Dof>(KinematicChain::JointsOf(calib), qc, cp);
+			bool same = (hOk == cOk);
+			for (int j = 0; same && hOk && j < 5; j++) same = (sp.pos[j + 1] == cp[j]);
+			Arm5Dof::Q back;
+			if (cOk && KinematicChain::FromServo<Arm5Dof>(KinematicChain::JointsOf(calib), cp, back))
+			{
+				for (int j = 0; j < 5; j++)
+				{
+					double qr = 0.0;
+					calib.ServoPosToJointRad(j + 1, cp[j], qr);
+					same = same && (qr == back[j]);
+				}
+			}
+			if (!same) servoMismatch++;
+		}
+		const int legacySign[6] = { 0, +1, +1, -1, +1, +1 };
+		bool signsOk = true;
+		for (int j = 1; j <= 5; j++) signsOk = signsOk && (KinematicsConfig::AxisSignForJoint(j) == legacySign[j]);
+
+		bool ok = maxFrame < 1e-9 && maxPose < 1e-9 && maxJac < 1e-9 && maxFd5 < 1e-4 && servoMismatch == 0 && signsOk;
+		std::printf("Chain: %zu joint samples (5-joint chain vs. hand-written model)\n", count);
+		std::printf("  frames %.2g, flange vs FK %.2g mm, Jacobian %.2g, FD Jacobian %.2g, servo mismatches %zu, axis signs %s -> %s\n",
+			maxFrame, maxPose, maxJac, maxFd5, servoMismatch, signsOk ? "same" : "DIFFER", ok ? "OK" : "FAIL");
+
+		// 6-joint variant.
+		const size_t n6 = std::min<size_t>(count, 5000);
+		std::vector<Arm6Dof::Q> q6(n6);
+		for (auto& q : q6)
+		{
+			for (double& v : q) v = uQ(rng);
+		}
+		double maxOrtho6 = 0.0;
+		double maxLink6 = 0.0;
+		double maxFd6 = 0.0;
+		for (size_t i = 0; i < n6; i++)
+		{
+			Arm6Dof::Frames f;
+			KinematicChain::ForwardFrames<Arm6Dof>(L, q6[i], f);
+			for (const auto& fr : f) maxOrtho6 = std::max(maxOrtho6, OrthoError(fr));
+			auto dist = [](const KinematicChain::Frame& a, const KinematicChain::Frame& b)
+			{
+				return std::sqrt((a.p[0] - b.p[0]) * (a.p[0] - b.p[0]) + (a.p[1] - b.p[1]) * (a.p[1] - b.p[1]) + (a.p[2] - b.p[2]) * (a.p[2] - b.p[2]));
+			};
+			maxLink6 = std::max(maxLink6, std::fabs(dist(f[1], f[2]) - L.L_arm1));
+			maxLink6 = std::max(maxLink6, std::fabs(dist(f[2], f[3]) - L.L_arm2));
+			maxLink6 = std::max(maxLink6, dist(f[3], f[4])); // spherical wrist: J4/J5 share the wrist center
+			maxLink6 = std::max(maxLink6, std::fabs(dist(f[4], f[5]) - L.L_wrist));
+			if (i < 2000) maxFd6 = std::max(maxFd6, JacobianFdError<Arm6Dof>(L, q6[i]));
+		}
+
+		// DLS IK from a seed 0.3 rad off per joint; targets are FK of the sampled joints (reachable by construction).
+		std::uniform_real_distribution<double> uSeed(-0.3, 0.3);
+		KinematicChain::IkParams ikp;
+		size_t solved6 = 0;
+		size_t solved5 = 0;
+		size_t iters6 = 0;
+		const size_t nIk = std::min<size_t>(n6, 2000);
+		std::vector<Arm6Dof::Q> seeds6(nIk);
+		std::vector<Arm5Dof::Q> seeds5(nIk);
+		for (size_t i = 0; i < nIk; i++)
+		{
+			for (int j = 0; j < 6; j++) seeds6[i][j] = q6[i][j] + uSeed(rng);
+			const Arm5Dof::Q q5 = toChain(qs[i]);
+			for (int j = 0; j < 5; j++) seeds5[i][j] = q5[j] + uSeed(rng);
+
+			Arm6Dof::Q s6 = seeds6[i];
+			const auto r6 = KinematicChain::SolveIk<Arm6Dof>(L, KinematicChain::Forward<Arm6Dof>(L, q6[i]), s6, ikp);
+			if (r6.ok) solved6++;
+			iters6 += r6.iterations;
+			Arm5Dof::Q s5 = seeds5[i];
+			if (KinematicChain::SolveIk<Arm5Dof>(L, KinematicChain::Forward<Arm5Dof>(L, q5), s5, ikp).ok) solved5++;
+		}
+		const double rate6 = static_cast<double>(solved6) / nIk;
+		const double rate5 = static_cast<double>(solved5) / nIk;
+		const bool ok6 = maxOrtho6 < 1e-12 && maxLink6 < 1e-9 && maxFd6 < 1e-4 && rate6 > 0.95 && rate5 > 0.95;
+		std::printf("  6-joint: %zu samples, max|R^T R - I|=%.2g, link err %.2g mm, FD Jacobian %.2g; DLS IK solved %.1f%% (avg %.1f it), 5-joint %.1f%% -> %s\n",
+			n6, maxOrtho6, maxLink6, maxFd6, 100.0 * rate6, static_cast<double>(iters6) / nIk, 100.0 * rate5, ok6 ? "OK" : "FAIL");
+		ok = ok && ok6;
+
+		// Timings: the generated 5-joint code against the hand-written forms.
+		double sink = 0.0;
+		const double tRef = BestSeconds(opt.reps, [&]() {
+			std::array<KinematicChain::Frame, 5> f;
+			for (size_t i = 0; i < count; i++)
+			{
+				ReferenceFrames5(L, qs[i], f);
+				sink += f[4].p[2];
+			}
+		});
+		const double tGen = BestSeconds(opt.reps, [&]() {
+			Arm5Dof::Frames f;
+			for (size_t i = 0; i < count; i++)
+			{
+				KinematicChain::ForwardFrames<Arm5Dof>(L, toChain(qs[i]), f);
+				sink += f[4].p[2];
+			}
+		});
+		const double tPose = BestSeconds(opt.reps, [&]() {
+			for (size_t i = 0; i < count; i++) sink += ArmKinematics::ForwardKinematics(calib, qs[i]).z_mm;
+		});
+		const double tFlange = BestSeconds(opt.reps, [&]() {
+			for (size_t i = 0; i < count; i++) sink += KinematicChain::Forward<Arm5Dof>(L, toChain(qs[i])).p[2];
+		});
+		const double tJh = BestSeconds(opt.reps, [&]() {
+			for (size_t i = 0; i < count; i++) sink += ArmKinematics::ComputeJacobian(calib, qs[i]).m[2][1];
+		});
+		const double tJg = BestSeconds(opt.reps, [&]() {
+			Arm5Dof::Jacobian J;
+			for (size_t i = 0; i < count; i++)
+			{
+				KinematicChain::ComputeJacobian<Arm5Dof>(L, toChain(qs[i]), J);
+				sink += J[2][1];
+			}
+		});
+		const double tF6 = BestSeconds(opt.reps, [&]() {
+			for (size_t i = 0; i < n6; i++) sink += KinematicChain::Forward<Arm6Dof>(L, q6[i]).p[2];
+		});
+		const double tIk6 = BestSeconds(opt.reps, [&]() {
+			for (size_t i = 0; i < nIk; i++)
+			{
+				Arm6Dof::Q s = seeds6[i];
+				KinematicChain::SolveIk<Arm6Dof>(L, KinematicChain::Forward<Arm6Dof>(L, q6[i]), s, ikp);
+				sink += s[0];
+			}
+		});
+		const double n = static_cast<double>(count);
+		std::printf("  %-28s %8.1f ns/sample (hand-written %.1f ns, x%.2f)\n", "frames J1..J5", 1e9 * tGen / n, 1e9 * tRef / n, tRef / tGen);
+		std::printf("  %-28s %8.1f ns/sample (ForwardKinematics pose %.1f ns)\n", "flange frame", 1e9 * tFlange / n, 1e9 * tPose / n);
+		std::printf("  %-28s %8.1f ns/sample (4x4 analytic ComputeJacobian %.1f ns)\n", "6x5 geometric Jacobian", 1e9 * tJg / n, 1e9 * tJh / n);
+		std::printf("  %-28s %8.1f ns/sample, DLS IK %.1f us/solve\n", "6-joint flange frame", 1e9 * tF6 / n6, 1e6 * tIk6 / nIk);
+		// The generated frames replace the hand-written ForwardKinematicsFrames: they must not be slower.
+		const bool perfOk = tGen <= tRef * (1.0 + opt.perfTol);
+		if (!perfOk) std::printf("  generated frames slower than hand-written -> FAIL\n");
+		if (sink == 12345.678) std::printf("\n");
+		return ok && perfOk;
+	}
+
+	// CollisionModel: the batched path (SIMD FK in chunks + per-sample capsule tests) must agree exactly
+	// with the per-sample Check; a box obstacle in front of the base exercises the obstacle branch.
+	bool RunCollision(const Options& opt, const KinematicsCalib& calib, const PoseSet& ps)
+	{
+		const size_t count = ps.Size();
+		std::mt19937 rng(opt.seed + 2u);
+		std::uniform_real_distribution<double> uRoll(-kPi / 2, kPi / 2);
+		std::vector<double> q5(count);
+		for (double& v : q5) v = uRoll(rng);
+		ArmKinematicsBatch::JointsSoAConst in;
+		for (int j = 1; j <= 4; j++) in.q[j] = ps.seed[j].data();
+		in.q[5] = q5.data();
+
+		CollisionModel::Params params;
+		CollisionModel::Box box;
+		box.min[0] = -60.0; box.min[1] = 150.0; box.min[2] = 0.0;
+		box.max[0] = 60.0;  box.max[1] = 250.0; box.max[2] = 80.0;
+		params.obstacles.push_back(box);
+		const CollisionModel model(params);
+
+		std::vector<uint8_t> ref(count), got(count);
+		size_t kinds[4] = {};
+		const double tSingle = BestSeconds(opt.reps, [&]() {
+			for (size_t i = 0; i < count; i++)
+			{
+				ArmKinematics::JointAnglesRad q;
+				for (int j = 1; j <= 4; j++) q.q[j] = ps.seed[j][i];
+				q.q[5] = q5[i];
+				CollisionModel::Result r;
+				model.Check(calib, q, &r);
+				ref[i] = static_cast<uint8_t>(r.hit);
+			}
+		});
+		size_t hits = 0;
+		size_t firstHit = 0;
+		const double tBatch = BestSeconds(opt.reps, [&]() { hits = model.CheckBatch(calib, in, count, got.data(), &firstHit); });
+
+		size_t mismatch = 0;
+		size_t refFirst = count;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (ref[i] != got[i]) mismatch++;
+			if (ref[i] < 4) kinds[ref[i]]++;
+			if (ref[i] != 0 && refFirst == count) refFirst = i;
+		}
+		const bool ok = mismatch == 0 && firstHit == refFirst && hits == count - kinds[0];
+		const double n = static_cast<double>(count);
+		std::printf("Collision: %zu joint samples, 1 obstacle box\n", count);
+		std::printf("  free %.1f%%, table %.1f%%, self %.1f%%, obstacle %.1f%%, batch mismatches=%zu -> %s\n",
+			100.0 * kinds[0] / n, 100.0 * kinds[1] / n, 100.0 * kinds[2] / n, 100.0 * kinds[3] / n,
+			mismatch, ok ? "OK" : "FAIL");
+		std::printf("  %-28s %12.0f samples/s  (%.1f ns/sample)\n", "CollisionModel::Check", n / tSingle, 1e9 * tSingle / n);
+		std::printf("  %-28s %12.0f samples/s  (%.1f ns/sample)\n", "CollisionModel::CheckBatch", n / tBatch, 1e9 * tBatch / n);
+		return ok;
+	}
+
+	// CartesianPlanner: straight moves from an IK seed (current joints) to the FK of a nearby joint vector.
+	// Moves whose straight line leaves the workspace/limits are expected to fail and are only counted.
+	// For planned moves the setpoint stream must stay on the line and within the joint velocity and
+	// acceleration limits, both measured by finite differences of the setpoints.
+	bool RunPlanner(const Options& opt, const KinematicsCalib& calib, const PoseSet& ps)
+	{
+		const size_t plans = std::min<size_t>(ps.Size(), 2000);
+		std::mt19937 rng(opt.seed + 3u);
+		std::uniform_real_distribution<double> uOff(-0.4, 0.4);
+
+		CartesianPlanner::Params params;
+		const CollisionModel model;
+		size_t errors[8] = {};
+		size_t planned = 0;
+		double tPlan = 0.0, tPlanMax = 0.0, sumDuration = 0.0, maxDev = 0.0, maxVelRatio = 0.0, maxAccRatio = 0.0;
+		size_t sumSetpoints = 0;
+
+		for (size_t i = 0; i < plans; i++)
+		{
+			ArmKinematics::JointAnglesRad q0, q1;
+			for (int j = 1; j <= 4; j++)
+			{
+				q0.q[j] = ps.seed[j][i];
+				q1.q[j] = q0.q[j] + uOff(rng);
+			}
+			const std::vector<ArmKinematics::PoseTarget> waypoints{ ArmKinematics::ForwardKinematics(calib, q0),
+				ArmKinematics::ForwardKinematics(calib, q1) };
+
+			CartesianPlanner::Result r;
+			const auto t0 = std::chrono::steady_clock::now();
+			CartesianPlanner::Plan(calib, waypoints, &q0, params, r, &model);
+			const double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+			tPlan += dt;
+			tPlanMax = std::max(tPlanMax, dt);
+			errors[static_cast<int>(r.error) & 7]++;
+			if (!r.ok) continue;
+
+			planned++;
+			sumDuration += r.durationSec;
+			sumSetpoints += r.setpoints.size();
+
+			const auto& a = waypoints[0];
+			const auto& b = waypoints[1];
+			const double d[3] = { b.x_mm - a.x_mm, b.y_mm - a.y_mm, b.z_mm - a.z_mm };
+			const double len2 = std::max(d[0] * d[0] + d[1] * d[1] + d[2] * d[2], 1e-12);
+			const auto& sp = r.setpoints;
+			for (size_t k = 0; k < sp.size(); k++)
+			{
+				const auto p = ArmKinematics::ForwardKinematics(calib, sp[k].q);
+				const double e[3] = { p.x_mm - a.x_mm, p.y_mm - a.y_mm, p.z_mm - a.z_mm };
+				const double t = std::min(1.0, std::max(0.0, (e[0] * d[0] + e[1] * d[1] + e[2] * d[2]) / len2));
+				double dev2 = 0.0;
+				for (int c = 0; c < 3; c++) dev2 += (e[c] - t * d[c]) * (e[c] - t * d[c]);
+				maxDev = std::max(maxDev, std::sqrt(dev2));
+
+				if (k == 0) continue;
+				const double h = sp[k].tSec - sp[k - 1].tSec;
+				if (h <= 1e-9) continue;
+				for (int j = 1; j <= 4; j++)
+				{
+					const double v = std::fabs(sp[k].q.q[j] - sp[k - 1].q.q[j]) / h;
+					maxVelRatio = std::max(maxVelRatio, v / (params.maxVelDegPerSec[j] * kPi / 180.0));
+				}
+				// Only full periods: the last setpoint is clamped to the end time.
+				if (k + 1 < sp.size() && std::fabs((sp[k + 1].tSec - sp[k].tSec) - h) < 1e-9)
+				{
+					for (int j = 1; j <= 4; j++)
+					{
+						const double acc = std::fabs(sp[k + 1].q.q[j] - 2.0 * sp[k].q.q[j] + sp[k - 1].q.q[j]) / (h * h);
+						maxAccRatio = std::max(maxAccRatio, acc / (params.maxAccDegPerSec2[j] * kPi / 180.0));
+					}
+				}
+			}
+		}
+
+		const double n = static_cast<double>(plans);
+		const double np = static_cast<double>(std::max<size_t>(planned, 1));
+		const bool ok = planned > 0 && maxDev < 0.05 && maxVelRatio < 1.02 && maxAccRatio < 1.02;
+		std::printf("Planner: %zu straight moves (joint offset up to 0.4 rad), period %d ms\n", plans, params.setpointPeriodMs);
+		std::printf("  planned %.1f%%, unreachable %.1f%%, out of limits %.1f%%, branch flip %.1f%%, collision %.1f%%\n",
+			100.0 * planned / n,
+			100.0 * errors[static_cast<int>(CartesianPlanner::PlanError::Unreachable)] / n,
+			100.0 * errors[static_cast<int>(CartesianPlanner::PlanError::OutOfLimits)] / n,
+			100.0 * errors[static_cast<int>(CartesianPlanner::PlanError::BranchFlip)] / n,
+			100.0 * errors[static_cast<int>(CartesianPlanner::PlanError::Collision)] / n);
+		std::printf("  avg duration %.2f s, avg %.0f setpoints, max line deviation %.4f mm\n",
+			sumDuration / np, static_cast<double>(sumSetpoints) / np, maxDev);
+		std::printf("  max joint vel %.2f x limit, max joint acc %.2f x limit -> %s\n", maxVelRatio, maxAccRatio, ok ? "OK" : "FAIL");
+		std::printf("  %-28s avg %.1f us, max %.1f us\n", "CartesianPlanner::Plan", 1e6 * tPlan / n, 1e6 * tPlanMax);
+		return ok;
+	}
+
+	// KinematicsCalibSolver: a "true" arm is the default config with perturbed zero offsets, servo scales and link
+	// lengths. Samples are the servo positions of random in-limit joints (integer, as read back) and the true FK plus
+	// Gaussian noise, with a few gross outliers (vision mis-detections). The fit starts from the nominal config; the
+	// figure that matters is how far the fitted model is from the truth (noise-free FK difference), not the residual.
+	bool RunCalib(const Options& opt, const KinematicsConfig& nominal, const MotionConfig& mc, const PoseSet& ps)
+	{
+		const size_t count = std::min<size_t>(ps.Size(), 20000);
+		const double noiseMm = 0.5;
+		const double outlierRate = 0.02;
+		std::mt19937 rng(opt.seed + 5u);
+		std::uniform_real_distribution<double> u01(0.0, 1.0);
+		std::normal_distribution<double> noise(0.0, noiseMm);
+
+		KinematicsConfig truth = nominal;
+		for (int j = 1; j <= KinematicsCalibSolver::kFitJoints; j++)
+		{
+			auto& c = truth.GetJoint(j);
+			c.zeroOffsetDeg = (u01(rng) - 0.5) * 6.0;
+			const int span = c.posAtPlusDeg - c.posAt0Deg;
+			c.posAtPlusDeg = c.posAt0Deg + static_cast<int>(std::lround(span * (1.0 + (u01(rng) - 0.5) * 0.08)));
+		}
+		auto& tl = truth.Links();
+		tl.L_base += (u01(rng) - 0.5) * 8.0;
+		tl.L_arm1 += (u01(rng) - 0.5) * 8.0;
+		tl.L_arm2 += (u01(rng) - 0.5) * 8.0;
+		tl.L_wrist += (u01(rng) - 0.5) * 8.0;
+		const KinematicsCalib truthCalib = KinematicsCalib::Compile(truth, &mc);
+
+		std::vector<KinematicsCalibSolver::Sample> samples(count);
+		std::vector<ArmKinematics::PoseTarget> truePose(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			auto& s = samples[i];
+			ArmKinematics::JointAnglesRad q;
+			for (int j = 1; j <= KinematicsCalibSolver::kFitJoints; j++)
+			{
+				truthCalib.JointRadToServoPos(j, ps.seed[j][i], s.servoPos[j]);
+				truthCalib.ServoPosToJointRad(j, s.servoPos[j], q.q[j]);
+			}
+			truePose[i] = ArmKinematics::ForwardKinematics(truthCalib, q);
+			const double gross = (u01(rng) < outlierRate) ? 30.0 : 0.0;
+			s.x_mm = truePose[i].x_mm + noise(rng) + gross;
+			s.y_mm = truePose[i].y_mm + noise(rng);
+			s.z_mm = truePose[i].z_mm + noise(rng) - gross;
+		}
+
+		KinematicsCalibSolver::Params params;
+		params.huberMm = 4.0 * noiseMm;
+		KinematicsCalibSolver::Result r1, rN;
+		params.threads = 1;
+		const auto t0 = std::chrono::steady_clock::now();
+		KinematicsCalibSolver::Solve(nominal, &mc, samples, params, r1);
+		const auto t1 = std::chrono::steady_clock::now();
+		params.threads = 0;
+		KinematicsCalibSolver::Solve(nominal, &mc, samples, params, rN);
+		const auto t2 = std::chrono::steady_clock::now();
+		const double tOne = std::chrono::duration<double>(t1 - t0).count();
+		const double tAll = std::chrono::duration<double>(t2 - t1).count();
+
+		// Fitted model vs. truth on the noise-free poses, after Apply (integer posAtPlusDeg).
+		KinematicsConfig fitted = nominal;
+		KinematicsCalibSolver::Apply(rN, fitted);
+		std::vector<KinematicsCalibSolver::Sample> clean = samples;
+		for (size_t i = 0; i < count; i++)
+		{
+			clean[i].x_mm = truePose[i].x_mm;
+			clean[i].y_mm = truePose[i].y_mm;
+			clean[i].z_mm = truePose[i].z_mm;
+		}
+		double modelMax = 0.0;
+		const double nominalRms = KinematicsCalibSolver::EvaluateRms(nominal, &mc, clean);
+		const double modelRms = KinematicsCalibSolver::EvaluateRms(fitted, &mc, clean, &modelMax);
+
+		bool same = r1.iterations == rN.iterations;
+		for (int p = 0; p < KinematicsCalibSolver::kParamCount; p++) same = same && r1.value[p] == rN.value[p];
+
+		const bool ok = rN.ok && rN.converged && same && modelRms < 0.2;
+		std::printf("Calib: %zu samples, noise %.1f mm, %.0f%% outliers (30 mm), Huber %.1f mm\n",
+			count, noiseMm, 100.0 * outlierRate, params.huberMm);
+		std::printf("  %d iterations, converged=%s, residual RMS %.2f -> %.2f mm\n",
+			rN.iterations, rN.converged ? "yes" : "no", rN.rmsBeforeMm, rN.rmsAfterMm);
+		for (int j = 1; j <= KinematicsCalibSolver::kFitJoints; j++)
+		{
+			const auto& tc = truth.GetJoint(j);
+			const auto& nc = nominal.GetJoint(j);
+			const double trueScale = static_cast<double>(nc.posAtPlusDeg - nc.posAt0Deg) / (tc.posAtPlusDeg - tc.posAt0Deg);
+			std::printf("  J%d zero %+.3f deg (err %+.4f, 1sigma %.4f)  scale %.4f (err %+.5f, 1sigma %.5f)\n", j,
+				rN.value[KinematicsCalibSolver::kZero1 + j - 1], rN.value[KinematicsCalibSolver::kZero1 + j - 1] - tc.zeroOffsetDeg,
+				rN.stddev[KinematicsCalibSolver::kZero1 + j - 1],
+				rN.value[KinematicsCalibSolver::kScale1 + j - 1], rN.value[KinematicsCalibSolver::kScale1 + j - 1] - trueScale,
+				rN.stddev[KinematicsCalibSolver::kScale1 + j - 1]);
+		}
+		const double trueLinks[4] = { tl.L_base, tl.L_arm1, tl.L_arm2, tl.L_wrist };
+		const char* linkNames[4] = { "L_base", "L_arm1", "L_arm2", "L_wrist" };
+		for (int k = 0; k < 4; k++)
+		{
+			const int p = KinematicsCalibSolver::kLBase + k;
+			std::printf("  %-7s %.3f mm (err %+.4f, 1sigma %.4f)\n", linkNames[k], rN.value[p], rN.value[p] - trueLinks[k], rN.stddev[p]);
+		}
+		std::printf("  model vs truth: nominal RMS %.2f mm -> fitted RMS %.3f mm (max %.3f), threads identical=%s -> %s\n",
+			nominalRms, modelRms, modelMax, same ? "yes" : "no", ok ? "OK" : "FAIL");
+		std::printf("  %-28s 1 thread %.1f ms, all threads %.1f ms (x%.1f)\n", "KinematicsCalibSolver::Solve",
+			1e3 * tOne, 1e3 * tAll, tOne / std::max(tAll, 1e-9));
+		return ok;
+	}
+
+	// HandEyeCalib: the true camera mount is the nominal one rotated by a few degrees and shifted by a few mm.
+	// A marker lies on the table; each sample is a random pose with the wrist pointing down towards it (and random
+	// J5 roll) whose camera sees the marker in front of it, observed with ArUco-like noise (rotation 0.5 deg, translation 1 mm). Several noise seeds are
+	// solved and the worst mount error is reported against a tolerance a visual move can live with.
+	bool RunHandEye(const Options& opt, const KinematicsConfig& nominal, const MotionConfig& mc)
+	{
+		const int trials = 20;
+		const size_t perTrial = 25;
+		const double rotNoiseDeg = 0.5;
+		const double transNoiseMm = 1.0;
+		std::mt19937 rng(opt.seed + 6u);
+		std::uniform_real_distribution<double> u01(0.0, 1.0);
+		std::normal_distribution<double> gauss(0.0, 1.0);
+
+		KinematicsConfig truth = nominal;
+		const KinematicsCalib nominalCalib = KinematicsCalib::Compile(nominal, &mc);
+		{
+			// Nominal mount as a rotation vector (x_cam = x_fl, y_cam = -z_fl, z_cam = y_fl: -90 deg about flange x).
+			auto& cam = truth.Camera();
+			cam.valid = true;
+			cam.rotVec[0] = -kPi / 2 + (u01(rng) - 0.5) * 0.1;
+			cam.rotVec[1] = (u01(rng) - 0.5) * 0.1;
+			cam.rotVec[2] = (u01(rng) - 0.5) * 0.1;
+			for (int i = 0; i < 3; i++) cam.transMm[i] = nominalCalib.Camera().p[i] + (u01(rng) - 0.5) * 10.0;
+		}
+		const KinematicsCalib truthCalib = KinematicsCalib::Compile(truth, &mc);
+
+		// Marker on the table in front of the arm, rotated arbitrarily about the table normal.
+		ArmKinematics::Frame marker;
+		{
+			const double yaw = 0.7;
+			marker.R[0][0] = std::cos(yaw); marker.R[0][1] = -std::sin(yaw); marker.R[0][2] = 0.0;
+			marker.R[1][0] = std::sin(yaw); marker.R[1][1] = std::cos(yaw);  marker.R[1][2] = 0.0;
+			marker.R[2][0] = 0.0;           marker.R[2][1] = 0.0;            marker.R[2][2] = 1.0;
+			marker.p[0] = 0.0;
+			marker.p[1] = 200.0;
+			marker.p[2] = 0.0;
+		}
+
+		// Small rotation from a rotation vector (noise)
+		auto rotFromVec = [](const double w[3], double R[3][3])
+		{
+			KinematicsConfig tmp;
+			tmp.Camera().valid = true;
+			for (int i = 0; i < 3; i++) tmp.Camera().rotVec[i] = w[i];
+			const KinematicsCalib c = KinematicsCalib::Compile(tmp, nullptr);
+			for (int i = 0; i < 3; i++)
+			{
+				for (int j = 0; j < 3; j++) R[i][j] = c.Camera().R[i][j];
+			}
+		};
+
+		double worstRotDeg = 0.0, worstTransMm = 0.0, sumRotDeg = 0.0, sumTransMm = 0.0, sumRms = 0.0, tSolve = 0.0;
+		int solved = 0;
+		size_t used = 0, pairs = 0;
+		for (int trial = 0; trial < trials; trial++)
+		{
+			std::vector<HandEyeCalib::Sample> samples;
+			for (int attempt = 0; samples.size() < perTrial && attempt < 100000; attempt++)
+			{
+				ArmKinematics::JointAnglesRad q;
+				q.q[1] = (u01(rng) - 0.5) * 1.6;
+				q.q[2] = 0.2 + u01(rng) * 1.2;
+				q.q[3] = -0.3 - u01(rng) * 1.5;
+				q.q[4] = -(kPi / 2 + (u01(rng) - 0.5) * 1.4) - q.q[2] - q.q[3];
+				q.q[5] = (u01(rng) - 0.5) * kPi;
+				ArmKinematics::LinkFrames f;
+				ArmKinematics::ForwardKinematicsFrames(truthCalib, q, f);
+				const auto& cam = f.f[ArmKinematics::LinkFrames::kCamera];
+
+				// marker in camera = cam^-1 * marker
+				HandEyeCalib::Sample s;
+				s.flange = f.f[ArmKinematics::LinkFrames::kFlange];
+				double d[3];
+				for (int r = 0; r < 3; r++) d[r] = marker.p[r] - cam.p[r];
+				for (int r = 0; r < 3; r++)
+				{
+					s.marker.p[r] = cam.R[0][r] * d[0] + cam.R[1][r] * d[1] + cam.R[2][r] * d[2];
+					for (int c = 0; c < 3; c++)
+					{
+						s.marker.R[r][c] = cam.R[0][r] * marker.R[0][c] + cam.R[1][r] * marker.R[1][c] + cam.R[2][r] * marker.R[2][c];
+					}
+				}
+				// Visible: in front of the camera within a 45 deg cone, 80..500 mm away, marker facing the camera.
+				const double dist = std::sqrt(s.marker.p[0] * s.marker.p[0] + s.marker.p[1] * s.marker.p[1] + s.marker.p[2] * s.marker.p[2]);
+				if (s.marker.p[2] < dist * std::cos(kPi / 4) || dist < 80.0 || dist > 500.0 || s.marker.R[2][2] > -0.3) continue;
+
+				double w[3];
+				for (int r = 0; r < 3; r++) w[r] = gauss(rng) * rotNoiseDeg * kPi / 180.0;
+				double N[3][3];
+				rotFromVec(w, N);
+				double R[3][3];
+				for (int r = 0; r < 3; r++)
+				{
+					for (int c = 0; c < 3; c++) R[r][c] = N[r][0] * s.marker.R[0][c] + N[r][1] * s.marker.R[1][c] + N[r][2] * s.marker.R[2][c];
+				}
+				for (int r = 0; r < 3; r++)
+				{
+					for (int c = 0; c < 3; c++) s.marker.R[r][c] = R[r][c];
+					s.marker.p[r] += gauss(rng) * transNoiseMm;
+				}
+				samples.push_back(s);
+			}
+
+			HandEyeCalib::Result r;
+			const auto t0 = std::chrono::steady_clock::now();
+			HandEyeCalib::Solve(samples, HandEyeCalib::Params(), r);
+			tSolve += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+			if (!r.ok) continue;
+			solved++;
+			used += r.pairsUsed;
+			pairs += samples.size() * (samples.size() - 1) / 2;
+			sumRms += r.rmsPosMm;
+
+			KinematicsConfig fitted = nominal;
+			HandEyeCalib::Apply(r, fitted);
+			const KinematicsCalib fittedCalib = KinematicsCalib::Compile(fitted, &mc);
+			const auto& fm = fittedCalib.Camera();
+			const auto& tm = truthCalib.Camera();
+			double tr = 0.0, dp2 = 0.0;
+			for (int i = 0; i < 3; i++)
+			{
+				for (int k = 0; k < 3; k++) tr += fm.R[k][i] * tm.R[k][i];
+				dp2 += (fm.p[i] - tm.p[i]) * (fm.p[i] - tm.p[i]);
+			}
+			const double rotErr = std::acos(std::min(1.0, std::max(-1.0, 0.5 * (tr - 1.0)))) * 180.0 / kPi;
+			worstRotDeg = std::max(worstRotDeg, rotErr);
+			worstTransMm = std::max(worstTransMm, std::sqrt(dp2));
+			sumRotDeg += rotErr;
+			sumTransMm += std::sqrt(dp2);
+		}
+
+		// A new camera mount changes the full fingerprint only: arm-only caches (reach / manipulability maps, IK cache)
+		// must survive a hand-eye recalibration.
+		const bool fpOk = KinematicsCalib::ArmFingerprint(truth, &mc) == KinematicsCalib::ArmFingerprint(nominal, &mc)
+			&& KinematicsCalib::Fingerprint(truth, &mc) != KinematicsCalib::Fingerprint(nominal, &mc);
+		const bool ok = solved == trials && worstRotDeg < 1.0 && worstTransMm < 5.0 && fpOk;
+		std::printf("HandEye: %d trials x %zu samples, noise %.1f deg / %.1f mm\n", trials, perTrial, rotNoiseDeg, transNoiseMm);
+		std::printf("  solved %d/%d, pairs used %.0f%%, marker-in-base RMS %.2f mm\n", solved, trials,
+			100.0 * used / std::max<size_t>(pairs, 1), sumRms / std::max(solved, 1));
+		std::printf("  mount error avg %.3f deg / %.2f mm, worst %.3f deg / %.2f mm -> %s\n",
+			sumRotDeg / std::max(solved, 1), sumTransMm / std::max(solved, 1), worstRotDeg, worstTransMm, ok ? "OK" : "FAIL");
+		std::printf("  %-28s avg %.1f us\n", "HandEyeCalib::Solve", 1e6 * tSolve / trials);
+		std::printf("  new mount: arm fingerprint %s, full fingerprint %s\n",
+			fpOk ? "kept" : "wrong", fpOk ? "changed" : "wrong");
+		return ok;
+	}
+
+	// ReachabilityMap: build time, query rate, and pre-filter quality against the scalar IK status.
+	// The map is deliberately optimistic, so the figure that matters is "false rejects" (IK finds a
+	// within-limits solution but the map says no); it must stay near zero or jog would stall early.
+	bool RunReachability(const Options& opt, const KinematicsCalib& calib, const PoseSet& ps, const JointSet& ref)
+	{
+		ReachabilityMap::GridParams gp;
+		gp.threads = opt.threads;
+		gp.voxelMm = opt.voxelMm;
+		// Cover the pose generator's pitch range so every pose gets a verdict.
+		gp.pitchMinDeg = -180.0;
+		gp.pitchMaxDeg = 180.0;
+
+		ReachabilityMap map;
+		const auto t0 = std::chrono::steady_clock::now();
+		if (!map.Build(calib, gp))
+		{
+			std::printf("  reach build failed\n");
+			return false;
+		}
+		const double tBuild = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+		std::vector<uint8_t> verdict(ps.Size());
+		const double tQuery = BestSeconds(opt.reps, [&]() {
+			for (size_t i = 0; i < ps.Size(); i++)
+			{
+				ArmKinematics::PoseTarget p;
+				p.x_mm = ps.x[i];
+				p.y_mm = ps.y[i];
+				p.z_mm = ps.z[i];
+				p.pitch_deg = ps.pitch[i];
+				verdict[i] = static_cast<uint8_t>(map.Classify(p));
+			}
+		});
+
+		size_t feasible = 0, falseReject = 0, infeasible = 0, filtered = 0;
+		for (size_t i = 0; i < ps.Size(); i++)
+		{
+			const bool mapOk = verdict[i] == static_cast<uint8_t>(ReachabilityMap::Verdict::Ok);
+			if (ref.status[i] == static_cast<uint8_t>(ArmKinematicsBatch::Status::Ok))
+			{
+				feasible++;
+				falseReject += mapOk ? 0 : 1;
+			}
+			else
+			{
+				infeasible++;
+				filtered += mapOk ? 0 : 1;
+			}
+		}
+
+		const double falseRate = feasible ? static_cast<double>(falseReject) / feasible : 0.0;
+		const bool ok = falseRate <= 0.005;
+		std::printf("Reach: voxel=%.1fmm pitch=%.0f..%.0f/%.0fdeg\n", gp.voxelMm, gp.pitchMinDeg, gp.pitchMaxDeg, gp.pitchStepDeg);
+		std::printf("  build %.3f s, query %.1f ns/pose\n", tBuild, 1e9 * tQuery / static_cast<double>(ps.Size()));
+		std::printf("  infeasible poses rejected by map: %.1f%%, false rejects: %zu/%zu (%.3f%%) -> %s\n",
+			infeasible ? 100.0 * filtered / infeasible : 0.0, falseReject, feasible, 100.0 * falseRate, ok ? "OK" : "FAIL");
+		return ok;
+	}
+
+	// Cyclic Jacobi eigenvalues of a symmetric 4x4 matrix (reference for ArmKinematics::InverseCondition).
+	void SymEigen4(double (&a)[4][4], double (&eig)[4])
+	{
+		for (int sweep = 0; sweep < 50; sweep++)
+		{
+			double off = 0.0;
+			for (int p = 0; p < 4; p++)
+				for (int q = p + 1; q < 4; q++) off += a[p][q] * a[p][q];
+			if (off < 1e-30) break;
+			for (int p = 0; p < 4; p++)
+			{
+				for (int q = p + 1; q < 4; q++)
+				{
+					if (std::fabs(a[p][q]) < 1e-300) continue;
+					const double theta = 0.5 * (a[q][q] - a[p][p]) / a[p][q];
+					const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+					const double c = 1.0 / std::sqrt(t * t + 1.0);
+					const double s = t * c;
+					for (int k = 0; k < 4; k++)
+					{
+						const double akp = a[k][p], akq = a[k][q];
+						a[k][p] = c * akp - s * akq;
+						a[k][q] = s * akp + c * akq;
+					}
+					for (int k = 0; k < 4; k++)
+					{
+						const double apk = a[p][k], aqk = a[q][k];
+						a[p][k] = c * apk - s * aqk;
+						a[q][k] = s * apk + c * aqk;
+					}
+				}
+			}
+		}
+		for (int i = 0; i < 4; i++) eig[i] = a[i][i];
+	}
+
+	// Manipulability map: the closed-form inverse condition number against a Jacobi SVD of the full weighted 4x4
+	// Jacobian (including J1-invariance), the (r, z, pitch) map against direct per-pose values, and jog slowdown
+	// coverage of near-singular poses.
+	bool RunManipulability(const Options& opt, const KinematicsCalib& calib, const PoseSet& ps)
+	{
+		ManipulabilityMap::GridParams gp;
+		gp.threads = opt.threads;
+		ManipulabilityMap map;
+		const auto t0 = std::chrono::steady_clock::now();
+		if (!map.Build(calib, gp))
+		{
+			std::printf("Manipulability: build failed\n");
+			return false;
+		}
+		const double tBuild = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+		std::mt19937 rng(opt.seed ^ 0x3A41u);
+		std::uniform_real_distribution<double> u01(0.0, 1.0);
+		const size_t n = std::min<size_t>(ps.Size(), 20000);
+
+		// 1) InverseCondition vs reference SVD, at the seed joints and again with a random J1
+		double maxCondErr = 0.0;
+		for (size_t i = 0; i < n; i++)
+		{
+			ArmKinematics::JointAnglesRad q;
+			for (int j = 1; j <= 4; j++) q.q[j] = ps.seed[j][i];
+			const double fast = ArmKinematics::InverseCondition(calib, q, gp.pitchWeightMm);
+
+			q.q[1] = (u01(rng) - 0.5) * 2.0 * kPi;
+			ArmKinematics::Jacobian J = ArmKinematics::ComputeJacobian(calib, q);
+			for (int k = 0; k < 4; k++) J.m[3][k] *= gp.pitchWeightMm;
+			double a[4][4];
+			for (int r = 0; r < 4; r++)
+				for (int c = 0; c < 4; c++)
+				{
+					double s = 0.0;
+					for (int k = 0; k < 4; k++) s += J.m[k][r] * J.m[k][c];
+					a[r][c] = s;
+				}
+			double eig[4];
+			SymEigen4(a, eig);
+			double eMin = eig[0], eMax = eig[0];
+			for (int k = 1; k < 4; k++)
+			{
+				eMin = std::min(eMin, eig[k]);
+				eMax = std::max(eMax, eig[k]);
+			}
+			const double ref = eMax > 0.0 ? std::sqrt(std::max(0.0, eMin) / eMax) : 0.0;
+			maxCondErr = std::max(maxCondErr, std::fabs(fast - ref));
+		}
+
+		// 2) Map (interpolated) vs the direct value of the worse in-limit candidate, on canonical in-limit poses
+		std::vector<double> errW, errK;
+		size_t near = 0, nearSlowed = 0, slowed = 0, sampled = 0;
+		const ManipulabilityMap::SpeedParams sp;
+		for (size_t i = 0; i < n; i++)
+		{
+			ArmKinematics::PoseTarget target;
+			target.x_mm = ps.x[i];
+			target.y_mm = ps.y[i];
+			target.z_mm = ps.z[i];
+			target.pitch_deg = ps.pitch[i];
+			ArmKinematics::IkResultLite ik;
+			if (!ArmKinematics::InverseKinematics(calib, target, nullptr, ik) || ik.error != ArmKinematics::IkError::None) continue;
+
+			double w = 2.0, k = 2.0;
+			for (int c = 0; c < ik.candidateCount; c++)
+			{
+				if (!ik.candidates[c].withinLimits) continue;
+				w = std::min(w, ArmKinematics::Manipulability(calib, ik.candidates[c].q));
+				k = std::min(k, ArmKinematics::InverseCondition(calib, ik.candidates[c].q, gp.pitchWeightMm));
+			}
+			ManipulabilityMap::Sample s;
+			if (!map.Query(target.x_mm, target.y_mm, target.z_mm, target.pitch_deg, s)) continue;
+			sampled++;
+			errW.push_back(std::fabs(s.manip - w));
+			errK.push_back(std::fabs(s.invCond - k));
+			const double scale = map.SpeedScale(target, sp);
+			if (scale < 1.0) slowed++;
+			if (w < 0.5 * sp.manipThreshold || k < 0.5 * sp.invCondThreshold)
+			{
+				near++;
+				if (scale < 1.0) nearSlowed++;
+			}
+		}
+		auto pct = [](std::vector<double>& v, double p) {
+			if (v.empty()) return 0.0;
+			const size_t idx = std::min(v.size() - 1, static_cast<size_t>(p * v.size()));
+			std::nth_element(v.begin(), v.begin() + idx, v.end());
+			return v[idx];
+		};
+
+		const double tQuery = BestSeconds(opt.reps, [&]() {
+			volatile double sink = 0.0;
+			for (size_t i = 0; i < n; i++)
+			{
+				ArmKinematics::PoseTarget p;
+				p.x_mm = ps.x[i];
+				p.y_mm = ps.y[i];
+				p.z_mm = ps.z[i];
+				p.pitch_deg = ps.pitch[i];
+				sink = sink + map.SpeedScale(p, sp);
+			}
+		});
+
+		const double w50 = pct(errW, 0.5), w99 = pct(errW, 0.99), k50 = pct(errK, 0.5), k99 = pct(errK, 0.99);
+		std::printf("Manipulability: (r, z, pitch) map %.1f mm / %.1f deg, build %.3f s\n", gp.cellMm, gp.pitchStepDeg, tBuild);
+		std::printf("  InverseCondition vs Jacobi SVD (random J1): max err %.2e\n", maxCondErr);
+		std::printf("  map vs direct on %zu poses: |dw| p50 %.4f p99 %.4f, |d(1/k)| p50 %.4f p99 %.4f\n", sampled, w50, w99, k50, k99);
+		std::printf("  slowed %.1f%% of poses; near-singular poses slowed %zu/%zu\n",
+			sampled ? 100.0 * slowed / sampled : 0.0, nearSlowed, near);
+		std::printf("  SpeedScale %.1f ns/query\n", 1e9 * tQuery / std::max<size_t>(n, 1));
+
+		// Interpolation smooths the values near the edges of the solvable region, so only the median is held tight;
+		// every pose that is clearly near-singular must be slowed.
+		const bool ok = maxCondErr < 1e-9 && w50 < 0.01 && k50 < 0.01 && nearSlowed == near;
+		std::printf("  -> %s\n", ok ? "OK" : "FAIL");
+		return ok;
+	}
+
+	// ProjectToReachable on every pose the scalar IK rejects. Each result must be limit-compliant:
+	// the returned joints lie inside the soft limits and reproduce the returned pose through FK.
+	bool RunProjection(const Options& opt, const KinematicsCalib& calib, const PoseSet& ps, const JointSet& ref)
+	{
+		std::vector<size_t> idx;
+		for (size_t i = 0; i < ps.Size(); i++)
+		{
+			if (ref.status[i] != static_cast<uint8_t>(ArmKinematicsBatch::Status::Ok)) idx.push_back(i);
+		}
+		if (idx.empty())
+		{
+			return true;
+		}
+
+		const ArmKinematics::ProjectParams pp;
+		size_t kinds[5] = {};
+		size_t bad = 0;
+		std::vector<double> callNs(idx.size());
+		double sumDist = 0.0;
+		double sumPitch = 0.0;
+		const double tTotal = BestSeconds(opt.reps, [&]() {
+			std::fill(std::begin(kinds), std::end(kinds), 0);
+			bad = 0;
+			sumDist = 0.0;
+			sumPitch = 0.0;
+			for (size_t k = 0; k < idx.size(); k++)
+			{
+				const size_t i = idx[k];
+				ArmKinematics::PoseTarget t;
+				t.x_mm = ps.x[i];
+				t.y_mm = ps.y[i];
+				t.z_mm = ps.z[i];
+				t.pitch_deg = ps.pitch[i];
+				ArmKinematics::JointAnglesRad seed;
+				for (int j = 1; j <= ArmKinematics::kJointCount; j++) seed.q[j] = ps.seed[j][i];
+
+				ArmKinematics::ProjectResult r;
+				const auto t0 = std::chrono::steady_clock::now();
+				ArmKinematics::ProjectToReachable(calib, t, opt.useSeeds ? &seed : nullptr, pp, r);
+				callNs[k] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+
+				kinds[static_cast<int>(r.kind)]++;
+				sumDist += r.distMm;
+				sumPitch += std::fabs(r.pitchDeltaDeg);
+				if (!r.ok) continue;
+
+				const auto fk = ArmKinematics::ForwardKinematics(calib, r.q);
+				bool good = std::fabs(fk.x_mm - r.pose.x_mm) < 1e-6 && std::fabs(fk.y_mm - r.pose.y_mm) < 1e-6
+					&& std::fabs(fk.z_mm - r.pose.z_mm) < 1e-6;
+				for (int j = 1; j <= 4; j++) good = good && calib.WithinLimits(j, r.q.q[j]);
+				bad += good ? 0 : 1;
+			}
+		});
+
+		// Tail latency from the last repetition; the single worst call is usually an OS preemption,
+		// so p99.9 is the figure compared with the control budget.
+		std::sort(callNs.begin(), callNs.end());
+		const double p999Ns = callNs[std::min(callNs.size() - 1, static_cast<size_t>(callNs.size() * 0.999))];
+		const double n = static_cast<double>(idx.size());
+		const double avgNs = 1e9 * tTotal / n;
+		const bool ok = (bad == 0) && (kinds[static_cast<int>(ArmKinematics::ProjectKind::Failed)] == 0);
+		std::printf("Project: %zu infeasible poses, seeds=%s\n", idx.size(), opt.useSeeds ? "on" : "off");
+		std::printf("  pitch relaxed %zu, position projected %zu, joint clamped %zu, failed %zu\n",
+			kinds[static_cast<int>(ArmKinematics::ProjectKind::PitchRelaxed)],
+			kinds[static_cast<int>(ArmKinematics::ProjectKind::PositionProjected)],
+			kinds[static_cast<int>(ArmKinematics::ProjectKind::JointClamped)],
+			kinds[static_cast<int>(ArmKinematics::ProjectKind::Failed)]);
+		std::printf("  mean move %.1f mm / %.1f deg, invalid=%zu\n", sumDist / n, sumPitch / n, bad);
+		std::printf("  avg %.0f ns, p99.9 %.0f ns (%.2f%% of a 1 kHz tick), max %.0f ns -> %s\n",
+			avgNs, p999Ns, p999Ns / 1e4, callNs.back(), ok ? "OK" : "FAIL");
+		return ok;
+	}
+
+	// Servo state estimator: a simulated servo follows a jog-like command stream (20 Hz short moves) mixed with
+	// long point-to-point moves, with a per-session sag and a per-move settling error. Readbacks are rare (every
+	// ~0.5 s), quantized and arrive 10..30 ms after they were sampled. The estimate is queried every 10 ms and
+	// compared with the two things the UI used before: the last readback and the last commanded target.
+	// Every session starts from an unknown position (no readback before the first command); every fourth one is
+	// knocked off its position midway (gear slip, moved while unpowered), which the estimator has to detect from the
+	// next readback and re-anchor on.
+	bool RunEstimator(const Options& opt)
+	{
+		const int sessions = 200;
+		const double sessionMs = 20000.0;
+		const double stepMs = 1.0;
+
+		std::mt19937 rng(opt.seed ^ 0xE571u);
+		std::uniform_real_distribution<double> u01(0.0, 1.0);
+		std::normal_distribution<double> nd(0.0, 1.0);
+
+		struct Err
+		{
+			std::vector<double> e;
+			void Add(double v) { e.push_back(v); }
+			double Rms() const
+			{
+				double s = 0.0;
+				for (double v : e) s += v * v;
+				return e.empty() ? 0.0 : std::sqrt(s / e.size());
+			}
+			double P99()
+			{
+				if (e.empty()) return 0.0;
+				for (double& v : e) v = std::fabs(v);
+				std::sort(e.begin(), e.end());
+				return e[std::min(e.size() - 1, static_cast<size_t>(e.size() * 0.99))];
+			}
+		};
+		Err est, lastRead, lastTarget;
+		size_t covered = 0;
+		size_t unknownStarts = 0, unknownBad = 0;
+		double unknownErr = 0.0;
+		double sigmaSettled = 0.0;
+		size_t settledCount = 0;
+		double estimateSec = 0.0;
+		size_t estimateCalls = 0;
+		ServoStateEstimator::Stats stats;
+
+		const uint8_t id = 1;
+		for (int sIdx = 0; sIdx < sessions; sIdx++)
+		{
+			ServoStateEstimator ose;
+			const double sag = 3.0 * nd(rng);
+
+			// True servo: linear interpolation from where it actually is to target + sag + settling error.
+			double truePos = 200.0 + 600.0 * u01(rng);
+			double moveFrom = truePos, moveTo = truePos, moveT0 = 0.0, moveT = 0.0;
+			auto trueAt = [&](double t) {
+				if (!(moveT > 0.0) || t >= moveT0 + moveT) return moveTo;
+				const double u = std::max(0.0, (t - moveT0) / moveT);
+				return moveFrom + (moveTo - moveFrom) * u;
+			};
+
+			double target = 500.0;
+			double lastCmdTarget = -1.0, lastReadVal = -1.0;
+			double nextCmd = 0.0, nextRead = 300.0 + 400.0 * u01(rng), nextQuery = 0.0;
+			double jogVel = 0.0, phaseEnd = 0.0;
+			bool longMove = false;
+			struct Pending { double rx; double value; };
+			std::vector<Pending> inFlight;
+			bool firstCheck = true;
+			double firstDoneMs = -1.0;
+
+			for (double t = 0.0; t < sessionMs; t += stepMs)
+			{
+				// Every fourth session the servo is knocked 80 counts off halfway through (the estimator must re-anchor).
+				if (sIdx % 4 == 0 && t == sessionMs / 2)
+				{
+					moveFrom += 80.0;
+					moveTo += 80.0;
+				}
+				if (t >= nextCmd)
+				{
+					double T = 60.0;
+					if (t >= phaseEnd)
+					{
+						longMove = u01(rng) < 0.3;
+						jogVel = (u01(rng) < 0.2) ? 0.0 : 300.0 * (2.0 * u01(rng) - 1.0); // counts / s
+						phaseEnd = t + 500.0 + 2500.0 * u01(rng);
+					}
+					if (longMove)
+					{
+						target = 100.0 + 800.0 * u01(rng);
+						T = 500.0 + 1000.0 * u01(rng);
+						nextCmd = t + T + 200.0 + 800.0 * u01(rng);
+						phaseEnd = nextCmd;
+					}
+					else
+					{
+						target = std::min(950.0, std::max(50.0, target + jogVel * 0.05));
+						nextCmd = t + 50.0;
+					}
+					const double cmd = std::floor(target + 0.5);
+					moveFrom = trueAt(t);
+					moveTo = cmd + sag + 1.5 * nd(rng);
+					moveT0 = t;
+					moveT = T;
+					ose.OnCommand(id, cmd, T, t);
+					lastCmdTarget = cmd;
+					if (firstDoneMs < 0.0) firstDoneMs = t + T;
+				}
+				if (t >= nextRead)
+				{
+					const double value = std::floor(trueAt(t) + 0.5 * nd(rng) + 0.5);
+					inFlight.push_back(Pending{ t + 10.0 + 20.0 * u01(rng), value });
+					nextRead = t + 300.0 + 400.0 * u01(rng);
+				}
+				for (size_t i = 0; i < inFlight.size();)
+				{
+					if (inFlight[i].rx <= t)
+					{
+						ose.OnReadback(id, inFlight[i].value, t);
+						lastReadVal = inFlight[i].value;
+						inFlight.erase(inFlight.begin() + static_cast<ptrdiff_t>(i));
+					}
+					else
+					{
+						i++;
+					}
+				}
+
+				if (t >= nextQuery)
+				{
+					nextQuery = t + 10.0;
+					ServoStateEstimator::State st;
+					const auto t0 = std::chrono::steady_clock::now();
+					const bool valid = ose.Estimate(id, t, st);
+					estimateSec += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+					estimateCalls++;
+					const double truth = trueAt(t);
+
+					// Unknown start (no readback yet): once a move has finished, the target alone must pin the servo
+					// down to about the sag + settling error, from a start anywhere in 200..800.
+					if (firstCheck && valid && firstDoneMs >= 0.0 && t >= firstDoneMs && !st.moving && lastReadVal < 0.0)
+					{
+						firstCheck = false;
+						unknownStarts++;
+						unknownErr = std::max(unknownErr, std::fabs(st.pos - truth));
+						if (std::fabs(st.pos - truth) > 20.0 || st.posSigma > 10.0) unknownBad++;
+					}
+					if (valid && lastReadVal >= 0.0 && lastCmdTarget >= 0.0)
+					{
+						est.Add(st.pos - truth);
+						lastRead.Add(lastReadVal - truth);
+						lastTarget.Add(lastCmdTarget - truth);
+						if (std::fabs(st.pos - truth) <= 3.0 * st.posSigma) covered++;
+						if (!st.moving)
+						{
+							sigmaSettled += st.posSigma;
+							settledCount++;
+						}
+					}
+				}
+			}
+			const auto s = ose.GetStats();
+			stats.commands += s.commands;
+			stats.readbacks += s.readbacks;
+			stats.stale += s.stale;
+			stats.reanchors += s.reanchors;
+		}
+
+		const double coverage = est.e.empty() ? 0.0 : static_cast<double>(covered) / est.e.size();
+		const double estRms = est.Rms(), readRms = lastRead.Rms(), targetRms = lastTarget.Rms();
+		std::printf("Estimator: %d sessions x %.0f s, jog 20 Hz + long moves, readback every ~0.5 s (10..30 ms late)\n",
+			sessions, sessionMs / 1000.0);
+		std::printf("  commands %llu, readbacks %llu (stale %llu, re-anchored %llu), %zu queries\n",
+			static_cast<unsigned long long>(stats.commands), static_cast<unsigned long long>(stats.readbacks),
+			static_cast<unsigned long long>(stats.stale), static_cast<unsigned long long>(stats.reanchors), est.e.size());
+		std::printf("  %-14s rms %6.2f counts, p99 %6.2f\n", "last readback", readRms, lastRead.P99());
+		std::printf("  %-14s rms %6.2f counts, p99 %6.2f\n", "last target", targetRms, lastTarget.P99());
+		std::printf("  %-14s rms %6.2f counts, p99 %6.2f, 3-sigma coverage %.1f%%, settled sigma %.2f\n", "estimator",
+			estRms, est.P99(), 100.0 * coverage, sigmaSettled / std::max<size_t>(settledCount, 1));
+		std::printf("  unknown start: %zu sessions settled before any readback, max error %.1f counts, %zu bad (> 20 or sigma > 10)\n",
+			unknownStarts, unknownErr, unknownBad);
+		std::printf("  Estimate %.0f ns/call\n", 1e9 * estimateSec / std::max<size_t>(estimateCalls, 1));
+		const bool ok = estRms < 0.5 * readRms && estRms < targetRms && coverage >= 0.95 && unknownBad == 0
+			&& stats.reanchors > 0;
+		std::printf("  -> %s\n", ok ? "OK" : "FAIL");
+		return ok;
+	}
+
+	// MotionScheduler: a spline-like stream (50 ms setpoints, every 8th frame a 230 ms keyframe) is played on the scheduler thread and,
+	// for comparison, with the legacy MotionController::Tick logic polled by an ideal 50 ms UI timer
+	// (ms clock, due += duration, resync after a stall). Checks order, count, end-of-script drift and that Stop()
+	// on a looping list returns promptly with no send after it.
+	bool RunScheduler(const Options&)
+	{
+		using Clock = MotionScheduler::Clock;
+		const size_t frameCount = 48;
+
+		// Joint 1 -> servo 1, no clamping: frame i moves servo 1 to position i (the tag read back from the bytes).
+		MotionConfig cfg;
+		cfg.Get(1).servoId = 1;
+		auto tagOf = [](const uint8_t* b, size_t len) {
+			ArmProtocol::ServoTarget st[1];
+			uint16_t timeMs = 0;
+			size_t n = 0;
+			return (ArmProtocol::DecodeMove(b, len, timeMs, st, 1, n) && n == 1) ? static_cast<uint8_t>(st[0].position) : uint8_t(0xFF);
+		};
+		std::vector<CompiledScript::Keyframe> frames(frameCount);
+		std::vector<double> idealMs(frameCount);
+		double t = 0.0;
+		for (size_t i = 0; i < frameCount; i++)
+		{
+			frames[i].durationMs = (i % 8 == 7) ? 230 : 50;
+			frames[i].jointPos.fill(-1);
+			frames[i].jointPos[1] = static_cast<int>(i);
+			idealMs[i] = t;
+			t += frames[i].durationMs;
+		}
+		const auto script = CompiledScript::Compile(cfg, frames, 0);
+
+		struct Send
+		{
+			Clock::time_point at;
+			uint8_t tag;
+		};
+		auto lateness = [&](const std::vector<Send>& sends, Clock::time_point start, std::vector<double>& lateMs) {
+			lateMs.clear();
+			for (const auto& s : sends)
+			{
+				const double at = std::chrono::duration<double, std::milli>(s.at - start).count();
+				lateMs.push_back(at - idealMs[s.tag]);
+			}
+		};
+		auto pct = [](std::vector<double> v, double q) {
+			if (v.empty()) return 0.0;
+			std::sort(v.begin(), v.end());
+			return v[std::min(v.size() - 1, static_cast<size_t>(v.size() * q))];
+		};
+
+		// Scheduler thread. Sends are recorded under a mutex; the first frame is due at Start.
+		std::mutex mu;
+		std::vector<Send> sent;
+		sent.reserve(frameCount);
+		MotionScheduler sched;
+		const Clock::time_point t0 = Clock::now();
+		sched.Start(script, false, [&](const uint8_t* b, size_t len) {
+			const Clock::time_point at = Clock::now();
+			std::lock_guard<std::mutex> lock(mu);
+			sent.push_back(Send{ at, tagOf(b, len) });
+			return true;
+		});
+		while (sched.IsRunning()) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		const MotionScheduler::Stats st = sched.GetStats();
+		bool orderOk = sent.size() == frameCount && st.sent == frameCount;
+		for (size_t i = 0; orderOk && i < sent.size(); i++) orderOk = sent[i].tag == static_cast<uint8_t>(i);
+		std::vector<double> schedLate;
+		lateness(sent, t0, schedLate);
+		const double endDrift = schedLate.empty() ? 1e9 : schedLate.back();
+
+		// Legacy: UI timer every 50 ms, GetTickCount64-style integer ms clock.
+		std::vector<Send> legacy;
+		{
+			auto ms = [](Clock::time_point a) {
+				return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(a.time_since_epoch()).count());
+			};
+			const Clock::time_point l0 = Clock::now();
+			uint64_t nextDue = ms(l0);
+			size_t index = 0;
+			Clock::time_point poll = l0;
+			while (index < frameCount)
+			{
+				std::this_thread::sleep_until(poll);
+				poll += std::chrono::milliseconds(50);
+				const uint64_t now = ms(Clock::now());
+				if (now < nextDue) continue;
+				legacy.push_back(Send{ Clock::now(), static_cast<uint8_t>(index) });
+				const uint64_t delta = static_cast<uint64_t>(frames[index].durationMs);
+				nextDue += delta;
+				if (nextDue + delta < now) nextDue = now + delta;
+				index++;
+			}
+			std::vector<double> legacyLate;
+			lateness(legacy, l0, legacyLate);
+			std::printf("Scheduler: %zu frames, 50 ms setpoints + 230 ms keyframes (%.1f s)\n", frameCount, t / 1000.0);
+			std::printf("  %-22s late p50 %7.2f ms, p99 %7.2f ms, max %7.2f ms, end drift %7.1f ms\n", "legacy 50 ms UI timer",
+				pct(legacyLate, 0.5), pct(legacyLate, 0.99), pct(legacyLate, 1.0), legacyLate.empty() ? 0.0 : legacyLate.back());
+		}
+		std::printf("  %-22s late p50 %7.2f ms, p99 %7.2f ms, max %7.2f ms, end drift %7.1f ms\n", "MotionScheduler",
+			pct(schedLate, 0.5), pct(schedLate, 0.99), pct(schedLate, 1.0), endDrift);
+		std::printf("  scheduler stats: sent %llu, mean %.0f us, p99 %.0f us, max %.0f us, >1 ms %llu, resyncs %llu\n",
+			static_cast<unsigned long long>(st.sent), st.meanLateUs, st.p99LateUs, st.maxLateUs,
+			static_cast<unsigned long long>(st.lateOver1ms), static_cast<unsigned long long>(st.resyncs));
+
+		// Looping list stopped from outside.
+		std::atomic<size_t> loopSends(0);
+		std::atomic<bool> stopped(false);
+		std::atomic<size_t> afterStop(0);
+		std::vector<CompiledScript::Keyframe> loopFrames(10);
+		for (auto& f : loopFrames)
+		{
+			f.durationMs = 10;
+			f.jointPos.fill(-1);
+			f.jointPos[1] = 0;
+		}
+		sched.Start(CompiledScript::Compile(cfg, loopFrames, 2), true, [&](const uint8_t*, size_t) {
+			loopSends++;
+			if (stopped.load()) afterStop++;
+			return true;
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		const Clock::time_point s0 = Clock::now();
+		sched.Stop();
+		const double stopMs = std::chrono::duration<double, std::milli>(Clock::now() - s0).count();
+		stopped.store(true);
+		std::this_thread::sleep_for(std::chrono::milliseconds(30));
+		const MotionScheduler::Stats ls = sched.GetStats();
+		const bool stopOk = stopMs < 20.0 && afterStop.load() == 0 && !sched.IsRunning() && ls.loops >= 2;
+		std::printf("  loop + Stop: %zu sends, %llu loops, Stop took %.2f ms, sends after Stop %zu\n", loopSends.load(),
+			static_cast<unsigned long long>(ls.loops), stopMs, afterStop.load());
+
+		// Timing limits are loose enough for a loaded single-core CI machine; the legacy path is late by tens of ms.
+		// The histogram p99 must be a real latency: not above the measured maximum.
+		const bool statsOk = st.p99LateUs <= st.maxLateUs && st.p99LateUs >= 0.0;
+		const bool ok = orderOk && stopOk && statsOk && pct(schedLate, 0.99) < 10.0 && std::fabs(endDrift) < 10.0;
+		std::printf("  order/count %s, stats p99 <= max %s -> %s\n", orderOk ? "OK" : "wrong", statsOk ? "OK" : "wrong",
+			ok ? "OK" : "FAIL");
+		return ok;
+	}
+
+	// KeyframeSpline: random keyframe scripts (3..8 keyframes, 50..2050 ms each, all joints, open and looping) are
+	// sampled every 2 ms; every segment must stay between its two keyframe values (quintic) and pass through the
+	// keyframes. The cubic spline may overshoot by design and is only reported.
+	bool RunSpline(const Options& opt)
+	{
+		using Clock = std::chrono::steady_clock;
+		const int scripts = 2000;
+		std::mt19937 rng(opt.seed ^ 0x5B11u);
+		std::uniform_int_distribution<int> pos(0, 1000);
+		std::uniform_int_distribution<int> dur(50, 2050);
+		std::uniform_int_distribution<int> knotCount(3, 8);
+
+		int quinticWorst = 0, cubicWorst = 0;
+		size_t quinticBad = 0, knotMisses = 0, segments = 0;
+		double buildSec = 0.0;
+		for (int sIdx = 0; sIdx < scripts; sIdx++)
+		{
+			const bool closed = (sIdx % 4) == 3;
+			std::vector<KeyframeSpline::Knot> knots(static_cast<size_t>(knotCount(rng)));
+			for (auto& k : knots)
+			{
+				k.durationMs = dur(rng);
+				k.pos[0] = -1;
+				for (int j = 1; j <= MotionConfig::kJointCount; j++) k.pos[j] = pos(rng);
+			}
+			// Knot times and values as Build sees them (looping scripts wrap back to knot 0).
+			std::vector<KeyframeSpline::Knot> seq = knots;
+			if (closed) seq.push_back(knots.front());
+			std::vector<double> t(seq.size(), 0.0);
+			for (size_t i = 1; i < seq.size(); i++) t[i] = t[i - 1] + seq[i].durationMs;
+
+			const KeyframeSpline::Kind kinds[] = { KeyframeSpline::Kind::Quintic, KeyframeSpline::Kind::Cubic };
+			for (auto kind : kinds)
+			{
+				KeyframeSpline spline;
+				const Clock::time_point b0 = Clock::now();
+				spline.Build(knots, kind, closed);
+				if (kind == KeyframeSpline::Kind::Quintic) buildSec += std::chrono::duration<double>(Clock::now() - b0).count();
+
+				KeyframeSpline::JointPosArray out;
+				for (size_t i = 0; i + 1 < seq.size(); i++)
+				{
+					int worst = 0;
+					for (double tt = t[i]; tt <= t[i + 1]; tt += 2.0)
+					{
+						spline.Evaluate(tt, out);
+						for (int j = 1; j <= MotionConfig::kJointCount; j++)
+						{
+							const int lo = std::min(seq[i].pos[j], seq[i + 1].pos[j]);
+							const int hi = std::max(seq[i].pos[j], seq[i + 1].pos[j]);
+							worst = std::max(worst, std::max(out[j] - hi, lo - out[j]));
+						}
+					}
+					if (kind == KeyframeSpline::Kind::Cubic)
+					{
+						cubicWorst = std::max(cubicWorst, worst);
+						continue;
+					}
+					segments++;
+					quinticWorst = std::max(quinticWorst, worst);
+					if (worst > 0) quinticBad++;
+					spline.Evaluate(t[i + 1], out);
+					for (int j = 1; j <= MotionConfig::kJointCount; j++)
+					{
+						if (out[j] != seq[i + 1].pos[j]) knotMisses++;
+					}
+				}
+			}
+		}
+
+		const bool ok = quinticBad == 0 && knotMisses == 0;
+		std::printf("Spline: %d random scripts (3..8 keyframes, 50..2050 ms, every 4th looping), %d joints, sampled every 2 ms\n",
+			scripts, MotionConfig::kJointCount);
+		std::printf("  quintic: %zu segments, overshoot max %d counts (%zu segments), keyframe misses %zu -> %s\n",
+			segments, quinticWorst, quinticBad, knotMisses, ok ? "OK" : "FAIL");
+		std::printf("  cubic (C2, may overshoot): max %d counts\n", cubicWorst);
+		std::printf("  KeyframeSpline::Build (quintic) avg %.1f us\n", 1e6 * buildSec / scripts);
+		return ok;
+	}
+
+	// CompiledScript: a long random script (unset joints, targets beyond the soft limits, negative and over-long
+	// durations) is compiled against the bench MotionConfig; every arena frame is decoded and checked against an
+	// independent clamp of its keyframe, deadlines against the running sum of durations. Times compile, per-frame
+	// replay (copy out of the arena) and the per-frame clamp + pack it replaces, then checks IsStale and that
+	// MotionScheduler::Replace switches a looping playback to a recompiled script at a frame boundary.
+	bool RunCompiled(const Options& opt, const MotionConfig& mc)
+	{
+		using Clock = std::chrono::steady_clock;
+		const size_t frameCount = 20000;
+		std::mt19937 rng(opt.seed ^ 0xC0417EDu);
+		std::uniform_int_distribution<int> pos(-150, 1100); // < 0 = not set
+		std::uniform_int_distribution<int> dur(-20, 400);
+
+		std::vector<CompiledScript::Keyframe> frames(frameCount);
+		for (size_t i = 0; i < frameCount; i++)
+		{
+			auto& kf = frames[i];
+			kf.durationMs = (i % 997 == 5) ? 70000 : dur(rng);
+			for (int j = 0; j <= MotionConfig::kJointCount; j++) kf.jointPos[j] = (j == 0) ? -1 : pos(rng);
+			if (i % 50 == 3) kf.jointPos.fill(-1); // nothing to send
+		}
+
+		const Clock::time_point c0 = Clock::now();
+		const auto script = CompiledScript::Compile(mc, frames, 7);
+		const double compileSec = std::chrono::duration<double>(Clock::now() - c0).count();
+
+		// Reference: the rules of MotionController::BuildServoTargetsFromJoints, written out again.
+		size_t bad = 0, clamped = 0, empty = 0, clampedDur = 0;
+		uint64_t t = 0;
+		for (size_t i = 0; i < frameCount; i++)
+		{
+			const auto& kf = frames[i];
+			const auto& f = script->Frame(i);
+			ArmProtocol::ServoTarget expect[MotionConfig::kJointCount];
+			size_t n = 0;
+			for (int j = 1; j <= MotionConfig::kJointCount; j++)
+			{
+				const auto& jc = mc.Get(j);
+				if (kf.jointPos[j] < 0 || jc.servoId < 1 || jc.servoId > 6) continue;
+				int v = kf.jointPos[j];
+				if (v < std::min(jc.minPos, jc.maxPos)) v = std::min(jc.minPos, jc.maxPos);
+				if (v > std::max(jc.minPos, jc.maxPos)) v = std::max(jc.minPos, jc.maxPos);
+				if (v != kf.jointPos[j]) clamped++;
+				expect[n].id = static_cast<uint8_t>(jc.servoId);
+				expect[n].position = static_cast<uint16_t>(v);
+				n++;
+			}
+			const int d = std::max(kf.durationMs, 0);
+			if (kf.durationMs < 0 || kf.durationMs > CompiledScript::kMaxMoveTimeMs) clampedDur++;
+			if (f.startMs != t || f.durationMs != static_cast<uint32_t>(d)) bad++;
+			t += static_cast<uint64_t>(d);
+			if (n == 0)
+			{
+				empty++;
+				if (f.size != 0) bad++;
+				continue;
+			}
+			ArmProtocol::ServoTarget got[MotionConfig::kJointCount];
+			uint16_t timeMs = 0;
+			size_t gotN = 0;
+			if (!ArmProtocol::DecodeMove(script->Bytes(f), f.size, timeMs, got, MotionConfig::kJointCount, gotN) || gotN != n
+				|| timeMs != std::min(d, CompiledScript::kMaxMoveTimeMs))
+			{
+				bad++;
+				continue;
+			}
+			for (size_t k = 0; k < n; k++)
+			{
+				if (got[k].id != expect[k].id || got[k].position != expect[k].position) bad++;
+			}
+		}
+		const auto& rep = script->GetReport();
+		const bool reportOk = rep.frames == frameCount && rep.emptyFrames == empty && rep.clampedTargets == clamped
+			&& rep.clampedDurations == clampedDur && script->TotalMs() == t && script->LoopStart() == 7
+			&& script->LoopMs() == t - script->Frame(7).startMs;
+
+		// Per-frame cost: replay copies the frame into a recycled TX buffer (the legacy Tick path);
+		// the old path clamped and packed each keyframe on every send.
+		std::vector<uint8_t> buf;
+		buf.reserve(64);
+		size_t sink = 0;
+		const Clock::time_point r0 = Clock::now();
+		for (int rep2 = 0; rep2 < opt.reps; rep2++)
+		{
+			for (size_t i = 0; i < frameCount; i++)
+			{
+				const auto& f = script->Frame(i);
+				buf.assign(script->Bytes(f), script->Bytes(f) + f.size);
+				sink += buf.size();
+			}
+		}
+		const double replaySec = std::chrono::duration<double>(Clock::now() - r0).count();
+		const Clock::time_point p0 = Clock::now();
+		for (int rep2 = 0; rep2 < opt.reps; rep2++)
+		{
+			for (size_t i = 0; i < frameCount; i++)
+			{
+				ArmProtocol::ServoTarget servos[MotionConfig::kJointCount];
+				const size_t n = CompiledScript::BuildServoTargets(mc, frames[i].jointPos, servos);
+				buf.clear();
+				if (n > 0)
+				{
+					ArmProtocol::PackMoveInto(servos, n, static_cast<uint16_t>(std::min(std::max(frames[i].durationMs, 0),
+						CompiledScript::kMaxMoveTimeMs)), buf);
+				}
+				sink -= buf.size();
+			}
+		}
+		const double packSec = std::chrono::duration<double>(Clock::now() - p0).count();
+		const double perFrame = 1e9 / (static_cast<double>(frameCount) * opt.reps);
+
+		// Recompile only on a config change.
+		MotionConfig changed = mc;
+		const bool staleOk = !script->IsStale(mc) && !script->IsStale(MotionConfig(mc));
+		changed.Get(2).minPos += 1;
+		const bool staleChanged = script->IsStale(changed);
+		changed.Get(2).minPos -= 1;
+		changed.Get(4).homePos += 10; // not in the frames
+		const bool staleHome = script->IsStale(changed);
+
+		// Hot swap: servo 1 clamped to 300 in the first script, to 600 after Replace.
+		MotionConfig a;
+		a.Get(1).servoId = 1;
+		a.Get(1).maxPos = 300;
+		MotionConfig b = a;
+		b.Get(1).maxPos = 600;
+		std::vector<CompiledScript::Keyframe> loopFrames(10);
+		for (auto& f : loopFrames)
+		{
+			f.durationMs = 10;
+			f.jointPos.fill(-1);
+			f.jointPos[1] = 1000;
+		}
+		std::atomic<int> lastPos(-1);
+		std::atomic<int> switches(0);
+		MotionScheduler sched;
+		sched.Start(CompiledScript::Compile(a, loopFrames, 0), true, [&](const uint8_t* bytes, size_t len) {
+			ArmProtocol::ServoTarget st[1];
+			uint16_t timeMs = 0;
+			size_t n = 0;
+			const int p = (ArmProtocol::DecodeMove(bytes, len, timeMs, st, 1, n) && n == 1) ? st[0].position : -2;
+			if (p != lastPos.exchange(p)) switches++;
+			return true;
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		sched.Replace(CompiledScript::Compile(b, std::vector<CompiledScript::Keyframe>(3, loopFrames[0]), 0)); // wrong length: ignored
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		const int beforeSwap = lastPos.load();
+		sched.Replace(CompiledScript::Compile(b, loopFrames, 0));
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		sched.Stop();
+		const bool swapOk = beforeSwap == 300 && lastPos.load() == 600 && switches.load() == 2;
+
+		std::printf("Compiled script: %zu keyframes -> %zu arena bytes (%zu empty, %zu targets clamped, %zu durations clamped), compile %.2f ms\n",
+			frameCount, rep.arenaBytes, rep.emptyFrames, rep.clampedTargets, rep.clampedDurations, 1e3 * compileSec);
+		std::printf("  per frame: replay %.1f ns, clamp + pack %.1f ns (%s)\n", replaySec * perFrame, packSec * perFrame,
+			sink == 0 ? "same bytes" : "byte count differs");
+		std::printf("  frames %s, report %s, stale: same %s / limits %s / home %s, Replace %s (%d -> %d)\n",
+			bad == 0 ? "OK" : "wrong", reportOk ? "OK" : "wrong", staleOk ? "no" : "YES", staleChanged ? "yes" : "NO",
+			staleHome ? "YES" : "no", swapOk ? "OK" : "wrong", beforeSwap, lastPos.load());
+		const bool ok = bad == 0 && reportOk && sink == 0 && staleOk && staleChanged && !staleHome && swapOk;
+		std::printf("  -> %s\n", ok ? "OK" : "FAIL");
+		return ok;
+	}
+
+	// MotionScript: a long program along a smooth joint path (Cartesian keyframes from FK, every 10th a joint keyframe)
+	// is saved as text and binary, read back through the mapped MotionScriptReader and compared; broken files must be
+	// rejected with the right line. Cartesian keyframes are resolved (IK) and checked by FK. Finally a program is played
+	// in windows on the MotionScheduler stream, refilled from a simulated 20 ms UI tick like MotionController does,
+	// checking order, timing across window boundaries and how many windows are alive at once.
+	bool RunProgram(const Options&, const KinematicsCalib& calib)
+	{
+		using Clock = std::chrono::steady_clock;
+		const size_t count = 50000;
+		const size_t loopStart = 17;
+		const double kTwoPi = 2.0 * kPi;
+
+		std::vector<MotionScript::Keyframe> program(count);
+		for (size_t k = 0; k < count; k++)
+		{
+			ArmKinematics::JointAnglesRad q;
+			for (int j = 1; j <= 4; j++)
+			{
+				const int pos = static_cast<int>(std::lround(500.0 + 250.0 * std::sin(kTwoPi * k / (700.0 + 130.0 * j) + j)));
+				calib.ServoPosToJointRad(j, pos, q.q[j]);
+			}
+			MotionScript::Keyframe& kf = program[k];
+			kf.durationMs = 20 + static_cast<int>(k % 7);
+			const auto pose = ArmKinematics::ForwardKinematics(calib, q);
+			// Only poses reaching in front of the base axis are expressible as (x, y, z, pitch), see RunRoundTrip.
+			const double reach = pose.x_mm * std::sin(q.q[1]) + pose.y_mm * std::cos(q.q[1]);
+			if (k % 10 == 0 || reach < 1.0)
+			{
+				for (int j = 1; j <= MotionConfig::kJointCount; j++) kf.jointPos[j] = static_cast<int>(100 + (k + 97 * j) % 800);
+				kf.jointPos[3] = -1;
+				continue;
+			}
+			kf.kind = MotionScript::Kind::Cartesian;
+			kf.x_mm = pose.x_mm;
+			kf.y_mm = pose.y_mm;
+			kf.z_mm = pose.z_mm;
+			kf.pitch_deg = pose.pitch_deg;
+			kf.jointPos[6] = 300; // gripper
+		}
+
+		const std::wstring textPath = L"kinbench_program.armt";
+		const std::wstring binPath = L"kinbench_program.arms";
+		std::wstring err;
+		bool saved = MotionScript::SaveText(textPath, program, loopStart, err);
+		saved = MotionScript::SaveBinary(binPath, program, loopStart, err) && saved;
+
+		auto readAll = [&](const std::wstring& path, const char* name, double& openNs, double& readNs) {
+			MotionScriptReader reader;
+			std::wstring e;
+			const Clock::time_point t0 = Clock::now();
+			bool ok = reader.Open(path, e);
+			const Clock::time_point t1 = Clock::now();
+			size_t bad = 0, n = 0;
+			MotionScript::Keyframe kf;
+			while (ok && reader.Next(kf))
+			{
+				const MotionScript::Keyframe& src = program[n++];
+				bool same = kf.kind == src.kind && kf.durationMs == src.durationMs && kf.jointPos == src.jointPos;
+				if (src.kind == MotionScript::Kind::Cartesian)
+				{
+					same = same && std::fabs(kf.x_mm - src.x_mm) < 1e-3 && std::fabs(kf.y_mm - src.y_mm) < 1e-3
+						&& std::fabs(kf.z_mm - src.z_mm) < 1e-3 && std::fabs(kf.pitch_deg - src.pitch_deg) < 1e-3;
+				}
+				if (!same) bad++;
+			}
+			const Clock::time_point t2 = Clock::now();
+			uint64_t totalMs = 0;
+			size_t cart = 0;
+			for (const auto& f : program)
+			{
+				totalMs += static_cast<uint64_t>(f.durationMs);
+				if (f.kind == MotionScript::Kind::Cartesian) cart++;
+			}
+			ok = ok && n == count && bad == 0 && reader.Count() == count && reader.CartesianCount() == cart
+				&& reader.TotalMs() == totalMs && reader.LoopStart() == loopStart;
+			reader.RewindToLoopStart();
+			ok = ok && reader.Next(kf) && kf.durationMs == program[loopStart].durationMs && reader.Position() == loopStart + 1;
+			openNs = 1e9 * std::chrono::duration<double>(t1 - t0).count() / count;
+			readNs = 1e9 * std::chrono::duration<double>(t2 - t1).count() / count;
+			std::printf("  %-6s open+validate %6.1f ns/keyframe, read %6.1f ns/keyframe, %zu mismatches -> %s\n", name, openNs,
+				readNs, bad, ok ? "OK" : "FAIL");
+			return ok;
+		};
+		std::printf("Program: %zu keyframes (%zu s), text + binary files\n", count,
+			static_cast<size_t>(23 * count / 1000));
+		double openNs = 0.0, readNs = 0.0;
+		bool ok = saved;
+		ok = readAll(textPath, "text", openNs, readNs) && ok;
+		ok = readAll(binPath, "binary", openNs, readNs) && ok;
+		std::remove("kinbench_program.armt");
+		std::remove("kinbench_program.arms");
+
+		// Broken programs: rejected on Open, with the line.
+		struct Broken
+		{
+			const char* text;
+			const wchar_t* expect;
+		};
+		const Broken broken[] = {
+			{ "J 100 1 2 3 4 5 6\n", L"Line 1:" },
+			{ "# c\nARMSCRIPT 1\nJ 100 1 2 3 4 5\n", L"Line 3:" },
+			{ "ARMSCRIPT 1\nJ 100 1 2 3 4 5 1001\n", L"Line 2:" },
+			{ "ARMSCRIPT 1\r\nC 100 1 2 3\r\n", L"Line 2:" },
+			{ "ARMSCRIPT 1\nJ 100 1 2 3 4 5 6\nloop 0\n", L"Line 3:" },
+			{ "ARMSCRIPT 1\nloop 5\nJ 100 1 2 3 4 5 6\n", L"Loop start" },
+			{ "ARMSCRIPT 2\n", L"Line 1:" },
+			{ "ARMSCRIPT 1\n# nothing\n", L"no keyframes" },
+			{ "ARMSCRIPT 1\nX 100\n", L"Line 2:" },
+		};
+		size_t rejected = 0;
+		for (const auto& b : broken)
+		{
+			MotionScriptReader r;
+			std::wstring e;
+			if (!r.OpenMemory(reinterpret_cast<const uint8_t*>(b.text), std::strlen(b.text), e) && e.find(b.expect) != std::wstring::npos)
+			{
+				rejected++;
+			}
+		}
+		const char* good = "\xEF\xBB\xBF# demo\r\nARMSCRIPT 1\r\nloop 1\r\nJ 800 500 - 500 500 500 500  # home\r\nC 600 180 0 120.5 -30 - - - - - 250\r\nC 600 180 40 120 -30\r\n";
+		MotionScriptReader goodReader;
+		const bool goodOk = goodReader.OpenMemory(reinterpret_cast<const uint8_t*>(good), std::strlen(good), err)
+			&& goodReader.Count() == 3 && goodReader.CartesianCount() == 2 && goodReader.LoopStart() == 1 && goodReader.TotalMs() == 2000;
+		std::printf("  broken files rejected %zu / %zu, commented/CRLF/BOM file %s\n", rejected,
+			sizeof(broken) / sizeof(broken[0]), goodOk ? "OK" : "wrong");
+		ok = ok && rejected == sizeof(broken) / sizeof(broken[0]) && goodOk;
+
+		// Cartesian -> servo targets (IK seeded along the path), checked by FK of the rounded servo positions.
+		MotionScriptResolver resolver;
+		size_t unresolved = 0, cartesian = 0, gripperOk = 0;
+		double maxErrMm = 0.0, maxErrDeg = 0.0;
+		const Clock::time_point r0 = Clock::now();
+		for (size_t k = 0; k < count; k++)
+		{
+			CompiledScript::Keyframe out;
+			if (!resolver.Resolve(calib, program[k], out))
+			{
+				unresolved++;
+				continue;
+			}
+			if (program[k].kind != MotionScript::Kind::Cartesian) continue;
+			cartesian++;
+			ArmKinematics::JointAnglesRad q;
+			for (int j = 1; j <= ArmKinematics::kJointCount; j++) calib.ServoPosToJointRad(j, out.jointPos[j], q.q[j]);
+			const auto p = ArmKinematics::ForwardKinematics(calib, q);
+			const double e = std::sqrt((p.x_mm - program[k].x_mm) * (p.x_mm - program[k].x_mm)
+				+ (p.y_mm - program[k].y_mm) * (p.y_mm - program[k].y_mm) + (p.z_mm - program[k].z_mm) * (p.z_mm - program[k].z_mm));
+			maxErrMm = std::max(maxErrMm, e);
+			maxErrDeg = std::max(maxErrDeg, std::fabs(WrapAngle((p.pitch_deg - program[k].pitch_deg) * kPi / 180.0)) * 180.0 / kPi);
+			if (out.jointPos[6] == 300) gripperOk++;
+		}
+		const double resolveNs = 1e9 * std::chrono::duration<double>(Clock::now() - r0).count() / count;
+		const bool resolveOk = unresolved == 0 && gripperOk == cartesian && maxErrMm < 3.0 && maxErrDeg < 1.5;
+		std::printf("  resolve: %zu Cartesian, unresolved %zu, FK of servo targets max %.2f mm / %.2f deg, %.0f ns/keyframe -> %s\n",
+			cartesian, unresolved, maxErrMm, maxErrDeg, resolveNs, resolveOk ? "OK" : "FAIL");
+		ok = ok && resolveOk;
+
+		// Windowed playback (MotionController::StartProgram with the scheduler): 700 keyframes of 5 ms, windows of 128.
+		const size_t playCount = 700;
+		const size_t window = 128;
+		std::vector<MotionScript::Keyframe> play(playCount);
+		for (size_t k = 0; k < playCount; k++)
+		{
+			play[k].durationMs = 5;
+			play[k].jointPos[1] = static_cast<int>(k);
+		}
+		std::vector<uint8_t> bin;
+		{
+			// Serialized like a file on disk, then read from memory.
+			MotionScript::SaveBinary(L"kinbench_play.arms", play, 0, err);
+			MappedFile mf;
+			if (mf.OpenRead(L"kinbench_play.arms")) bin.assign(mf.Data(), mf.Data() + mf.Size());
+			std::remove("kinbench_play.arms");
+		}
+		MotionScriptReader reader;
+		bool playOk = reader.OpenMemory(bin.data(), bin.size(), err);
+		MotionConfig cfg;
+		cfg.Get(1).servoId = 1;
+		std::vector<CompiledScript::Keyframe> frames;
+		frames.reserve(window);
+		std::vector<std::weak_ptr<const CompiledScript>> made;
+		auto nextWindow = [&]() -> std::shared_ptr<const CompiledScript> {
+			frames.clear();
+			MotionScript::Keyframe in;
+			CompiledScript::Keyframe out;
+			while (frames.size() < window && reader.Next(in))
+			{
+				resolver.Resolve(calib, in, out);
+				frames.push_back(out);
+			}
+			if (frames.empty()) return nullptr;
+			auto s = CompiledScript::Compile(cfg, frames, 0);
+			made.push_back(s);
+			return s;
+		};
+
+		struct Send
+		{
+			Clock::time_point at;
+			int pos;
+		};
+		std::mutex mu;
+		std::vector<Send> sent;
+		sent.reserve(playCount);
+		MotionScheduler sched;
+		std::shared_ptr<const CompiledScript> current = nextWindow();
+		const Clock::time_point t0 = Clock::now();
+		sched.StartStream(current, [&](const uint8_t* b, size_t len) {
+			const Clock::time_point at = Clock::now();
+			ArmProtocol::ServoTarget st[1];
+			uint16_t timeMs = 0;
+			size_t n = 0;
+			const int p = (ArmProtocol::DecodeMove(b, len, timeMs, st, 1, n) && n == 1) ? st[0].position : -1;
+			std::lock_guard<std::mutex> lock(mu);
+			sent.push_back(Send{ at, p });
+			return true;
+		});
+		size_t maxQueued = 0, maxAlive = 0;
+		bool ended = false;
+		while (sched.IsRunning())
+		{
+			if (!ended && sched.Queued() == 0)
+			{
+				current = nextWindow();
+				if (current) sched.Append(current);
+				else
+				{
+					ended = true;
+					sched.CloseStream();
+				}
+			}
+			maxQueued = std::max(maxQueued, sched.Queued());
+			size_t alive = 0;
+			for (const auto& w : made) alive += w.expired() ? 0 : 1;
+			maxAlive = std::max(maxAlive, alive);
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		}
+		current.reset();
+		const MotionScheduler::Stats st = sched.GetStats();
+		size_t orderBad = 0;
+		std::vector<double> late;
+		for (size_t i = 0; i < sent.size(); i++)
+		{
+			if (sent[i].pos != static_cast<int>(i)) orderBad++;
+			late.push_back(std::chrono::duration<double, std::milli>(sent[i].at - t0).count() - 5.0 * i);
+		}
+		std::sort(late.begin(), late.end());
+		const double p99 = late.empty() ? 1e9 : late[std::min(late.size() - 1, late.size() * 99 / 100)];
+		playOk = playOk && sent.size() == playCount && orderBad == 0 && st.underruns == 0 && maxQueued <= 1 && maxAlive <= 3
+			&& p99 < 10.0;
+		std::printf("  windowed playback: %zu keyframes in %zu windows of %zu, sent %zu (order %s), late p99 %.2f ms, underruns %llu,\n"
+			"    max queued %zu, max windows alive %zu -> %s\n", playCount, made.size(), window, sent.size(),
+			orderBad == 0 ? "OK" : "wrong", p99, static_cast<unsigned long long>(st.underruns), maxQueued, maxAlive,
+			playOk ? "OK" : "FAIL");
+		ok = ok && playOk;
+		std::printf("  -> %s\n", ok ? "OK" : "FAIL");
+		return ok;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+	if (!ParseArgs(argc, argv, opt))
+	{
+		PrintUsage(argv[0]);
+		return 2;
+	}
+
+	KinematicsConfig kc;
+	MotionConfig mc;
+	MakeMotionConfig(opt, mc);
+	const KinematicsCalib calib = KinematicsCalib::Compile(kc, &mc);
+
+	PoseSet ps;
+	MakePoses(opt, calib, ps);
+
+	std::printf("IK: %zu poses, reps=%d, seeds=%s, limits=%s, best backend=%s\n",
+		opt.count, opt.reps, opt.useSeeds ? "on" : "off", opt.useLimits ? "on" : "off",
+		ArmKinematicsBatch::BackendName(ArmKinematicsBatch::BestBackend()));
+
+	JointSet ref, batchScalar, batchBest;
+	ref.Resize(opt.count);
+	batchScalar.Resize(opt.count);
+	batchBest.Resize(opt.count);
+
+	double okCount = 0.0;
+	const double tScalar = BestSeconds(opt.reps, [&]() { okCount = SolveScalar(opt, calib, ps, ref); });
+	const double tBatchScalar = BestSeconds(opt.reps, [&]() {
+		SolveBatch(opt, calib, ps, batchScalar, ArmKinematicsBatch::Backend::Scalar);
+	});
+	const ArmKinematicsBatch::Backend best = ArmKinematicsBatch::BestBackend();
+	const double tBatchBest = BestSeconds(opt.reps, [&]() { SolveBatch(opt, calib, ps, batchBest, best); });
+
+	bool ok = true;
+	ok = Verify("scalar", ps, ref, batchScalar) && ok;
+	if (best != ArmKinematicsBatch::Backend::Scalar)
+	{
+		ok = Verify(ArmKinematicsBatch::BackendName(best), ps, ref, batchBest) && ok;
+	}
+
+	// Reduced-precision variants, each against the double batch of the same backend.
+	struct PrecisionRun
+	{
+		std::string label;
+		double seconds = 0.0;
+		double doubleSeconds = 0.0;
+	};
+	std::vector<PrecisionRun> precisionRuns;
+	{
+		std::vector<ArmKinematicsBatch::Backend> backends(1, ArmKinematicsBatch::Backend::Scalar);
+		if (best != ArmKinematicsBatch::Backend::Scalar) backends.push_back(best);
+		const ArmKinematicsBatch::Precision precisions[] = { ArmKinematicsBatch::Precision::Fast, ArmKinematicsBatch::Precision::Float };
+		JointSet approx;
+		approx.Resize(opt.count);
+		for (auto b : backends)
+		{
+			const JointSet& exact = (b == ArmKinematicsBatch::Backend::Scalar) ? batchScalar : batchBest;
+			for (auto pr : precisions)
+			{
+				PrecisionRun run;
+				run.label = std::string(ArmKinematicsBatch::BackendName(b)) + "/" + ArmKinematicsBatch::PrecisionName(pr);
+				run.seconds = BestSeconds(opt.reps, [&]() { SolveBatch(opt, calib, ps, approx, b, pr); });
+				run.doubleSeconds = (b == ArmKinematicsBatch::Backend::Scalar) ? tBatchScalar : tBatchBest;
+				const double tol = (pr == ArmKinematicsBatch::Precision::Float) ? 0.4 : 0.05;
+				ok = VerifyPrecision(run.label.c_str(), calib, ps, exact, approx, tol) && ok;
+				precisionRuns.push_back(run);
+			}
+		}
+	}
+
+	const double n = static_cast<double>(opt.count);
+	std::printf("  reachable within limits: %.1f%%\n", 100.0 * okCount / n);
+	std::printf("  %-28s %12.0f poses/s  (%.1f ns/pose)\n", "ArmKinematics (per pose)", n / tScalar, 1e9 * tScalar / n);
+	std::printf("  %-28s %12.0f poses/s  (%.1f ns/pose, x%.1f)\n", "ArmKinematicsBatch scalar", n / tBatchScalar,
+		1e9 * tBatchScalar / n, tScalar / tBatchScalar);
+	if (best != ArmKinematicsBatch::Backend::Scalar)
+	{
+		const std::string label = std::string("ArmKinematicsBatch ") + ArmKinematicsBatch::BackendName(best);
+		std::printf("  %-28s %12.0f poses/s  (%.1f ns/pose, x%.1f)\n", label.c_str(), n / tBatchBest,
+			1e9 * tBatchBest / n, tScalar / tBatchBest);
+	}
+	for (const auto& run : precisionRuns)
+	{
+		const std::string label = "ArmKinematicsBatch " + run.label;
+		std::printf("  %-28s %12.0f poses/s  (%.1f ns/pose, x%.1f, x%.2f vs double)\n", label.c_str(), n / run.seconds,
+			1e9 * run.seconds / n, tScalar / run.seconds, run.doubleSeconds / run.seconds);
+	}
+
+	if (opt.roundTrip)
+	{
+		ok = RunRoundTrip(opt, calib) && ok;
+	}
+	if (opt.cache)
+	{
+		ok = RunIkCache(opt, calib, ps) && ok;
+	}
+	if (opt.scoring)
+	{
+		ok = RunScoring(opt, calib) && ok;
+	}
+	if (opt.fk)
+	{
+		ok = RunForward(opt, calib, ps) && ok;
+	}
+	if (opt.chain)
+	{
+		ok = RunChain(opt, calib, ps) && ok;
+	}
+	if (opt.collision)
+	{
+		ok = RunCollision(opt, calib, ps) && ok;
+	}
+	if (opt.plan)
+	{
+		ok = RunPlanner(opt, calib, ps) && ok;
+	}
+	if (opt.calib)
+	{
+		ok = RunCalib(opt, kc, mc, ps) && ok;
+	}
+	if (opt.handEye)
+	{
+		ok = RunHandEye(opt, kc, mc) && ok;
+	}
+	if (opt.reach)
+	{
+		ok = RunReachability(opt, calib, ps, ref) && ok;
+	}
+	if (opt.manip)
+	{
+		ok = RunManipulability(opt, calib, ps) && ok;
+	}
+	if (opt.project)
+	{
+		ok = RunProjection(opt, calib, ps, ref) && ok;
+	}
+	if (opt.estimator)
+	{
+		ok = RunEstimator(opt) && ok;
+	}
+	if (opt.scheduler)
+	{
+		ok = RunScheduler(opt) && ok;
+	}
+	if (opt.spline)
+	{
+		ok = RunSpline(opt) && ok;
+	}
+	if (opt.compiled)
+	{
+		ok = RunCompiled(opt, mc) && ok;
+	}
+	if (opt.program)
+	{
+		ok = RunProgram(opt, calib) && ok;
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,470 @@
+// Multithreaded fuzz + throughput harness for ArmProtocol (PackMove / PackReadPosition / TryParseOne / DecodeMove).
+//
+// Every worker thread runs three scenarios in a loop until the time budget is spent:
+// - roundtrip: Pack* -> TryParseOne on the exact frame must reproduce every field; DecodeMove must agree on
+//              Move frames and reject every other command
+// - stream:    valid frames concatenated with junk (never 0x55) and fed in random chunk sizes,
+//              the decoded sequence must equal the packed sequence exactly
+// - chaos:     random bytes / truncated / bit-flipped / concatenated frames, only safety invariants
+//              (no over-consumption, no unjustified stall, bounded leftover after a flush)
+// Reports frames/s and bytes/s per thread; exit code 1 on the first invariant violation.
+//
+// Build (from the repository root, see tools/ProtocolFuzz/README.md):
+//   g++ -std=c++14 -O2 -pthread -I. tools/ProtocolFuzz/ProtocolFuzzMain.cpp ArmProtocol.cpp -o protofuzz
+
+#include "ArmProtocol.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	constexpr uint8_t kHeader = 0x55;
+	constexpr size_t kMaxFrameSize = 2 + 0xFF;
+
+	struct Options
+	{
+		unsigned threads = 0; // 0 = hardware_concurrency
+		double seconds = 5.0;
+		uint32_t seed = 0xC0FFEEu;
+		size_t maxChunk = 64;
+	};
+
+	// What the decoder is expected to yield for one packed frame.
+	struct Expected
+	{
+		ArmProtocol::Command cmd = ArmProtocol::Command::Move;
+		bool isReadResponse = false;
+		uint16_t timeMs = 0;
+		std::vector<ArmProtocol::ServoTarget> servos;
+		std::vector<uint8_t> readIds;
+	};
+
+	struct WorkerResult
+	{
+		uint64_t framesDecoded = 0;
+		uint64_t bytesFed = 0;
+		uint64_t roundtrips = 0;
+		uint64_t streams = 0;
+		uint64_t chaosRuns = 0;
+		double seconds = 0.0;
+	};
+
+	// First failure wins; other threads stop as soon as they notice.
+	std::atomic<bool> g_failed{ false };
+	std::mutex g_failMu;
+	std::string g_failText;
+
+	std::string Hex(const uint8_t* p, size_t n, size_t limit = 96)
+	{
+		static const char* kHex = "0123456789ABCDEF";
+		std::string s;
+		const size_t m = std::min(n, limit);
+		for (size_t i = 0; i < m; i++)
+		{
+			s.push_back(kHex[p[i] >> 4]);
+			s.push_back(kHex[p[i] & 0xF]);
+			if (i + 1 < m) s.push_back(' ');
+		}
+		if (n > limit) s += " ...";
+		return s;
+	}
+
+	void Fail(unsigned worker, const char* scenario, const std::string& what, const std::vector<uint8_t>& input)
+	{
+		std::lock_guard<std::mutex> lk(g_failMu);
+		if (g_failed.exchange(true)) return;
+		g_failText = "worker " + std::to_string(worker) + " [" + scenario + "] " + what +
+			"\n  input(" + std::to_string(input.size()) + " B): " + Hex(input.data(), input.size());
+	}
+
+	bool SameServos(const std::vector<ArmProtocol::ServoTarget>& a, const std::vector<ArmProtocol::ServoTarget>& b)
+	{
+		if (a.size() != b.size()) return false;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			if (a[i].id != b[i].id || a[i].position != b[i].position) return false;
+		}
+		return true;
+	}
+
+	bool Matches(const Expected& e, const ArmProtocol::ParsedFrame& f)
+	{
+		if (f.cmd != e.cmd) return false;
+		if (e.cmd == ArmProtocol::Command::Move)
+		{
+			return f.timeMs == e.timeMs && SameServos(f.servos, e.servos);
+		}
+		if (f.isReadResponse != e.isReadResponse) return false;
+		return e.isReadResponse ? SameServos(f.servos, e.servos) : (f.readIds == e.readIds);
+	}
+
+	class Worker
+	{
+	public:
+		Worker(unsigned index, uint32_t seed, const Options& opt)
+			: m_index(index), m_rng(seed), m_opt(opt)
+		{
+		}
+
+		WorkerResult Run(Clock::time_point deadline)
+		{
+			const Clock::time_point t0 = Clock::now();
+			while (!g_failed.load(std::memory_order_relaxed))
+			{
+				// Check the clock every batch, not every frame.
+				for (int i = 0; i < 64; i++)
+				{
+					RoundTripOnce();
+					StreamOnce();
+					if ((i & 7) == 0) ChaosOnce();
+				}
+				if (Clock::now() >= deadline) break;
+			}
+			m_res.seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+			return m_res;
+		}
+
+	private:
+		uint32_t Rand(uint32_t lo, uint32_t hi)
+		{
+			return std::uniform_int_distribution<uint32_t>(lo, hi)(m_rng);
+		}
+
+		std::vector<uint8_t> RandomFrame(Expected& e)
+		{
+			// n <= 40 keeps len (n*3 + 5) inside one byte, like every real caller.
+			const uint32_t kind = Rand(0, 2);
+			e = Expected{};
+			if (kind == 0)
+			{
+				e.cmd = ArmProtocol::Command::Move;
+				e.timeMs = static_cast<uint16_t>(Rand(0, 0xFFFF));
+				e.servos.resize(Rand(0, 40));
+				for (auto& s : e.servos)
+				{
+					s.id = static_cast<uint8_t>(Rand(0, 0xFF));
+					s.position = static_cast<uint16_t>(Rand(0, 0xFFFF));
+				}
+				return ArmProtocol::PackMove(e.servos, e.timeMs);
+			}
+			e.cmd = ArmProtocol::Command::ReadPosition;
+			if (kind == 1)
+			{
+				e.isReadResponse = false;
+				e.readIds.resize(Rand(1, 40));
+				for (auto& id : e.readIds) id = static_cast<uint8_t>(Rand(0, 0xFF));
+				return ArmProtocol::PackReadPosition(e.readIds);
+			}
+			// Responses with n=0 are indistinguishable from an empty request on the wire.
+			e.isReadResponse = true;
+			e.servos.resize(Rand(1, 40));
+			for (auto& s : e.servos)
+			{
+				s.id = static_cast<uint8_t>(Rand(0, 0xFF));
+				s.position = static_cast<uint16_t>(Rand(0, 0xFFFF));
+			}
+			return ArmProtocol::PackReadResponse(e.servos);
+		}
+
+		void AppendJunk(std::vector<uint8_t>& out, size_t n)
+		{
+			for (size_t i = 0; i < n; i++)
+			{
+				uint8_t b = static_cast<uint8_t>(Rand(0, 0xFE));
+				if (b == kHeader) b = 0xFF; // junk never forms (or completes) a header
+				out.push_back(b);
+			}
+		}
+
+		// Incremental decoder, same contract as ArmCommsService::PollRx / SimServoBus::Write.
+		// Checks the per-call invariants; calls onFrame for every parsed frame. Returns false on violation.
+		template <typename OnFrame>
+		bool Decode(const char* scenario, const std::vector<uint8_t>& input, size_t& head,
+		            std::vector<uint8_t>& buf, size_t feedEnd, size_t& fed, OnFrame onFrame)
+		{
+			while (fed < feedEnd)
+			{
+				const size_t chunk = std::min<size_t>(Rand(1, static_cast<uint32_t>(m_opt.maxChunk)), feedEnd - fed);
+				buf.insert(buf.end(), input.begin() + static_cast<ptrdiff_t>(fed), input.begin() + static_cast<ptrdiff_t>(fed + chunk));
+				fed += chunk;
+				m_res.bytesFed += chunk;
+
+				while (head < buf.size())
+				{
+					const size_t remaining = buf.size() - head;
+					ArmProtocol::ParsedFrame f;
+					size_t consumed = 0;
+					const bool ok = ArmProtocol::TryParseOne(buf.data() + head, remaining, f, consumed);
+					if (consumed > remaining)
+					{
+						Fail(m_index, scenario, "consumed beyond buffer", input);
+						return false;
+					}
+					if (ok)
+					{
+						const size_t frameSize = 2 + static_cast<size_t>(buf[head + 2]);
+						if (consumed != frameSize || consumed < 4)
+						{
+							Fail(m_index, scenario, "frame size mismatch", input);
+							return false;
+						}
+						if (f.servos.size() * 3 > consumed)
+						{
+							Fail(m_index, scenario, "more entries than payload bytes", input);
+							return false;
+						}
+						m_res.framesDecoded++;
+						head += consumed;
+						if (!onFrame(f)) return false;
+						continue;
+					}
+					if (consumed == 0)
+					{
+						// A stall is only legal while waiting for the rest of a frame.
+						const uint8_t* p = buf.data() + head;
+						const bool waitingHeader = remaining < 4;
+						const bool waitingBody = remaining >= 3 && p[0] == kHeader && p[1] == kHeader &&
+							remaining < 2 + static_cast<size_t>(p[2]);
+						if (!waitingHeader && !waitingBody)
+						{
+							Fail(m_index, scenario, "decoder stalled on a decodable buffer", input);
+							return false;
+						}
+						break;
+					}
+					head += consumed;
+				}
+
+				// Compact like a real RX buffer would.
+				if (head > 4096)
+				{
+					buf.erase(buf.begin(), buf.begin() + static_cast<ptrdiff_t>(head));
+					head = 0;
+				}
+			}
+			return true;
+		}
+
+		void RoundTripOnce()
+		{
+			Expected e;
+			const std::vector<uint8_t> bytes = RandomFrame(e);
+			ArmProtocol::ParsedFrame f;
+			size_t consumed = 0;
+			const bool ok = ArmProtocol::TryParseOne(bytes.data(), bytes.size(), f, consumed);
+			m_res.bytesFed += bytes.size();
+			if (!ok || consumed != bytes.size() || !Matches(e, f))
+			{
+				Fail(m_index, "roundtrip", "Pack -> TryParseOne did not reproduce the frame", bytes);
+				return;
+			}
+
+			ArmProtocol::ServoTarget moved[255];
+			uint16_t timeMs = 0;
+			size_t count = 0;
+			const bool isMove = ArmProtocol::DecodeMove(bytes.data(), bytes.size(), timeMs, moved, 255, count);
+			if (isMove != (e.cmd == ArmProtocol::Command::Move) ||
+				(isMove && (timeMs != e.timeMs || !SameServos(e.servos, std::vector<ArmProtocol::ServoTarget>(moved, moved + count)))))
+			{
+				Fail(m_index, "roundtrip", "DecodeMove disagrees with TryParseOne", bytes);
+				return;
+			}
+
+			// Every strict prefix must ask for more data without consuming anything.
+			const size_t cut = Rand(0, static_cast<uint32_t>(bytes.size() - 1));
+			ArmProtocol::ParsedFrame g;
+			if (ArmProtocol::TryParseOne(bytes.data(), cut, g, consumed) || consumed != 0)
+			{
+				Fail(m_index, "roundtrip", "truncated frame (" + std::to_string(cut) + " B) was not held back", bytes);
+				return;
+			}
+			m_res.framesDecoded++;
+			m_res.roundtrips++;
+		}
+
+		void StreamOnce()
+		{
+			std::vector<Expected> expected(Rand(1, 32));
+			std::vector<uint8_t> input;
+			for (auto& e : expected)
+			{
+				if (Rand(0, 3) == 0) AppendJunk(input, Rand(1, 16));
+				const std::vector<uint8_t> bytes = RandomFrame(e);
+				input.insert(input.end(), bytes.begin(), bytes.end());
+			}
+
+			std::vector<uint8_t> buf;
+			size_t head = 0, fed = 0, next = 0;
+			const bool ok = Decode("stream", input, head, buf, input.size(), fed,
+				[&](const ArmProtocol::ParsedFrame& f) -> bool
+				{
+					if (next >= expected.size() || !Matches(expected[next], f))
+					{
+						Fail(m_index, "stream", "frame #" + std::to_string(next) + " decoded wrong", input);
+						return false;
+					}
+					next++;
+					return true;
+				});
+			if (!ok) return;
+			if (next != expected.size())
+			{
+				Fail(m_index, "stream", "decoded " + std::to_string(next) + "/" + std::to_string(expected.size()) + " frames", input);
+				return;
+			}
+			m_res.streams++;
+		}
+
+		void ChaosOnce()
+		{
+			std::vector<uint8_t> input;
+			const uint32_t pieces = Rand(1, 24);
+			for (uint32_t i = 0; i < pieces; i++)
+			{
+				switch (Rand(0, 4))
+				{
+				case 0: // raw noise, header-heavy
+					for (uint32_t k = Rand(1, 48); k > 0; k--)
+						input.push_back(Rand(0, 3) == 0 ? kHeader : static_cast<uint8_t>(Rand(0, 0xFF)));
+					break;
+				case 1: // truncated frame
+				{
+					Expected e;
+					const std::vector<uint8_t> b = RandomFrame(e);
+					input.insert(input.end(), b.begin(), b.begin() + static_cast<ptrdiff_t>(Rand(0, static_cast<uint32_t>(b.size() - 1))));
+				}
+				break;
+				case 2: // bit-flipped frame (often the len byte)
+				{
+					Expected e;
+					std::vector<uint8_t> b = RandomFrame(e);
+					b[Rand(0, static_cast<uint32_t>(b.size() - 1))] ^= static_cast<uint8_t>(1u << Rand(0, 7));
+					input.insert(input.end(), b.begin(), b.end());
+				}
+				break;
+				case 3: // bare header with an arbitrary len/cmd
+					input.push_back(kHeader);
+					input.push_back(kHeader);
+					input.push_back(static_cast<uint8_t>(Rand(0, 0xFF)));
+					input.push_back(static_cast<uint8_t>(Rand(0, 0xFF)));
+					break;
+				default: // intact frame
+				{
+					Expected e;
+					const std::vector<uint8_t> b = RandomFrame(e);
+					input.insert(input.end(), b.begin(), b.end());
+				}
+				break;
+				}
+			}
+			// Flush: enough non-header bytes to complete any open frame and then be dropped as junk.
+			input.insert(input.end(), kMaxFrameSize + 8, 0x00);
+
+			std::vector<uint8_t> buf;
+			size_t head = 0, fed = 0;
+			if (!Decode("chaos", input, head, buf, input.size(), fed,
+				[](const ArmProtocol::ParsedFrame&) { return true; }))
+			{
+				return;
+			}
+			if (buf.size() - head >= 4)
+			{
+				Fail(m_index, "chaos", "leftover " + std::to_string(buf.size() - head) + " B after flush", input);
+				return;
+			}
+			m_res.chaosRuns++;
+		}
+
+	private:
+		unsigned m_index = 0;
+		std::mt19937 m_rng;
+		Options m_opt;
+		WorkerResult m_res{};
+	};
+
+	bool ParseArgs(int argc, char** argv, Options& opt)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string a = argv[i];
+			const bool hasValue = (i + 1 < argc);
+			if (a == "--threads" && hasValue) opt.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+			else if (a == "--seconds" && hasValue) opt.seconds = std::atof(argv[++i]);
+			else if (a == "--seed" && hasValue) opt.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+			else if (a == "--max-chunk" && hasValue) opt.maxChunk = static_cast<size_t>(std::atoi(argv[++i]));
+			else return false;
+		}
+		return opt.seconds > 0.0 && opt.maxChunk >= 1;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+	if (!ParseArgs(argc, argv, opt))
+	{
+		std::fprintf(stderr, "Usage: %s [--threads N] [--seconds S] [--seed S] [--max-chunk BYTES]\n", argv[0]);
+		return 2;
+	}
+	if (opt.threads == 0)
+	{
+		opt.threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	std::printf("ArmProtocol fuzz: %u threads, %.1f s, seed=0x%X, max chunk=%zu B\n",
+		opt.threads, opt.seconds, opt.seed, opt.maxChunk);
+
+	const Clock::time_point deadline = Clock::now() +
+		std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.seconds));
+
+	std::vector<WorkerResult> results(opt.threads);
+	std::vector<std::thread> threads;
+	for (unsigned i = 0; i < opt.threads; i++)
+	{
+		threads.emplace_back([&, i]()
+		{
+			Worker w(i, opt.seed + i * 0x9E3779B9u, opt);
+			results[i] = w.Run(deadline);
+		});
+	}
+	for (auto& t : threads) t.join();
+
+	WorkerResult total{};
+	std::printf("%-6s %12s %12s %14s %12s %10s %10s %8s\n",
+		"thread", "frames", "frames/s", "bytes/s", "roundtrips", "streams", "chaos", "sec");
+	for (unsigned i = 0; i < opt.threads; i++)
+	{
+		const WorkerResult& r = results[i];
+		const double sec = (r.seconds > 1e-9) ? r.seconds : 1.0;
+		std::printf("%-6u %12llu %12.0f %14.0f %12llu %10llu %10llu %8.2f\n", i,
+			static_cast<unsigned long long>(r.framesDecoded), r.framesDecoded / sec, r.bytesFed / sec,
+			static_cast<unsigned long long>(r.roundtrips), static_cast<unsigned long long>(r.streams),
+			static_cast<unsigned long long>(r.chaosRuns), r.seconds);
+		total.framesDecoded += r.framesDecoded;
+		total.bytesFed += r.bytesFed;
+		total.seconds = std::max(total.seconds, r.seconds);
+	}
+	const double sec = (total.seconds > 1e-9) ? total.seconds : 1.0;
+	std::printf("%-6s %12llu %12.0f %14.0f\n", "total",
+		static_cast<unsigned long long>(total.framesDecoded), total.framesDecoded / sec, total.bytesFed / sec);
+
+	if (g_failed.load())
+	{
+		std::printf("FAIL: %s\n", g_failText.c_str());
+		return 1;
+	}
+	std::printf("PASS\n");
+	return 0;
+}
@@ -176,6 +176,18 @@ namespace
 		const int top = dstRect.top + (dh - outH) / 2;
 		return CRect(left, top, left + outW, top + outH);
 	}
+
+	// 可达性图缓存目录：exe 同级的 cache 目录
+	std::wstring ReachabilityCacheDir()
+	{
+		wchar_t buf[MAX_PATH] = {};
+		const DWORD n = ::GetModuleFileNameW(nullptr, buf, ARRAYSIZE(buf));
+		std::wstring s(buf, buf + n);
+		const size_t pos = s.find_last_of(L"\\/");
+		if (pos == std::wstring::npos) return std::wstring();
+		s.resize(pos);
+		return s + L"\\cache";
+	}
 }
 
 
@@ -379,6 +391,8 @@ BOOL C智能机械臂Dlg::OnInitDialog()
 	m_motion.LoadConfig();
 	m_kc.LoadAll();
 	m_jog.Bind(&m_motion, &m_kc);
+	m_motion.BindKinematics(&m_kc); // 程序文件中的笛卡尔关键帧
+	LoadJogSettingsFromProfile();
 
 	// ===== VisionService 初始化（独立视觉线程）=====
 	m_vision.SetVisualServo(&m_vs);
@@ -388,29 +402,9 @@ BOOL C智能机械臂Dlg::OnInitDialog()
 	m_vision.SetEnabled(m_chkVisionProcEnable.GetSafeHwnd() && (m_chkVisionProcEnable.GetCheck() == BST_CHECKED) && m_visionAlgoEnabled);
 	m_vision.Start();
 
-	// 以“当前姿态估计（优先回读，否则home）”的 FK 结果作为初始目标，避免一开始就不可达
+	// 以“当前关节角（舵机状态估计，否则 home）”的 FK 结果作为初始目标，避免一开始就不可达
 	{
-		ArmKinematics::JointAnglesRad qCur{};
-		for (int j = 0; j <= ArmKinematics::kJointCount; j++) qCur.q[j] = 0.0;
-		for (int j = 1; j <= ArmKinematics::kJointCount; j++)
-		{
-			const auto& jc = m_motion.Config().Get(j);
-			int pos = jc.homePos;
-			if (jc.servoId >= 1 && jc.servoId <= 6)
-			{
-				uint16_t rb = 0;
-				if (ArmCommsService::Instance().GetLastReadPos((uint8_t)jc.servoId, rb))
-				{
-					pos = (int)rb;
-				}
-			}
-			double rad = 0.0;
-			if (!ArmKinematics::ServoPosToJointRad(m_kc, &m_motion.Config(), j, pos, rad))
-			{
-				rad = 0.0;
-			}
-			qCur.q[j] = rad;
-		}
+		const ArmKinematics::JointAnglesRad qCur = ReadCurrentJoints();
 		const auto pose0 = ArmKinematics::ForwardKinematics(m_kc, qCur);
 		m_jog.SetTargetPose(pose0);
 		CString s;
@@ -453,6 +447,35 @@ void C智能机械臂Dlg::SyncVisionAlgoUiFromState()
 	m_comboVisionAlgo.SetCurSel(sel);
 }
 
+void C智能机械臂Dlg::LoadJogSettingsFromProfile()
+{
+	CWinApp* app = AfxGetApp();
+
+	// Jog\\Mode：0=闭式 IK（默认），1=速度级 DLS（奇异点附近更平滑，不跳肘解）
+	JogController::Params jp = m_jog.GetParams();
+	jp.mode = (app->GetProfileInt(L"Jog", L"Mode", 0) == 1)
+		? JogController::Mode::ResolvedRate
+		: JogController::Mode::ClosedFormIk;
+	// Jog\\IkScoring：1=肘解择优考虑限位余量 / 可操作度 / 下一步可行性（默认），0=只看离当前姿态的距离
+	jp.scoring.enabled = app->GetProfileInt(L"Jog", L"IkScoring", 1) != 0;
+	// Jog\\SingularSlowdown：1=奇异点附近按灵活度图自动降速（默认），0=恒速
+	jp.singularSlowdown = app->GetProfileInt(L"Jog", L"SingularSlowdown", 1) != 0;
+	m_jog.SetParams(jp);
+
+	// Jog\\IkCache：1=按量化位姿缓存 IK 结果（默认），0=每 tick 重解；已有的缓存保留（条目按标定指纹失效）
+	if (app->GetProfileInt(L"Jog", L"IkCache", 1) != 0)
+	{
+		if (!m_jog.GetIkCache()) m_jog.SetIkCache(std::make_shared<IkCache>());
+	}
+	else
+	{
+		m_jog.SetIkCache(nullptr);
+	}
+
+	// 碰撞模型（Collision 段：连杆半径 / 桌面高度 / 障碍盒），下发前检查
+	m_jog.SetCollisionModel(std::make_shared<CollisionModel>(CollisionModel::LoadProfile()));
+}
+
 void C智能机械臂Dlg::LoadVisionSettingsFromProfile()
 {
 	CWinApp* app = AfxGetApp();
@@ -654,9 +677,50 @@ LRESULT C智能机械臂Dlg::OnSettingsImported(WPARAM /*wParam*/, LPARAM /*lPar
 {
 	if (m_bDestroying) return 0;
 	LoadVisionSettingsFromProfile();
+	// 与 OnInitDialog 相同的加载顺序：关节映射/软限位、脚本播放参数 -> 运动学 -> Jog / IK 缓存 / 碰撞模型
+	m_motion.LoadConfig();
+	m_kc.LoadAll(); // 相机外参等（Jog / 可达性图按标定指纹自动重建）
+	LoadJogSettingsFromProfile();
 	return 0;
 }
 
+const KinematicsCalib& C智能机械臂Dlg::ArmCalib()
+{
+	const MotionConfig& mc = m_motion.Config();
+	if (m_armCalib.IsStale(m_kc, &mc))
+	{
+		m_armCalib = KinematicsCalib::Compile(m_kc, &mc);
+	}
+	return m_armCalib;
+}
+
+ArmKinematics::JointAnglesRad C智能机械臂Dlg::ReadCurrentJoints()
+{
+	const KinematicsCalib& calib = ArmCalib();
+	ArmKinematics::JointAnglesRad q{};
+	for (int j = 1; j <= ArmKinematics::kJointCount; j++)
+	{
+		const auto& jc = m_motion.Config().Get(j);
+		int pos = jc.homePos;
+		if (jc.servoId >= 1 && jc.servoId <= 6)
+		{
+			// 舵机状态估计（指令预测 + 回读校正），运动中也跟得上；视觉伺服用它取相机姿态
+			ServoStateEstimator::State est;
+			if (ArmCommsService::Instance().GetServoEstimate((uint8_t)jc.servoId, est))
+			{
+				pos = (int)std::lround(est.pos);
+			}
+		}
+		double rad = 0.0;
+		if (!calib.ServoPosToJointRad(j, pos, rad))
+		{
+			rad = 0.0;
+		}
+		q.q[j] = rad;
+	}
+	return q;
+}
+
 void C智能机械臂Dlg::OnCbnSelChangeVisionAlgo()
 {
 	if (!m_comboVisionAlgo.GetSafeHwnd()) return;
@@ -1028,13 +1092,14 @@ void C智能机械臂Dlg::OnTimer(UINT_PTR nIDEvent)
 			}
 		}
 
-		// 读取键盘输入（WASD：平面；Q/E：上下；R/F：Pitch）
+		// 读取键盘输入（WASD：平面；Q/E：上下；R/F：Pitch；T/G：Roll（J5））
 		// 说明：这里用 GetAsyncKeyState 读取“按住状态”，符合“按住持续移动”的手感。
 		JogController::InputState in{};
 		in.x = 0.0;
 		in.y = 0.0;
 		in.z = 0.0;
 		in.pitch = 0.0;
+		in.roll = 0.0;
 
 		const auto keyDown = [](int vk) -> bool {
 			return (::GetAsyncKeyState(vk) & 0x8000) != 0;
@@ -1048,6 +1113,8 @@ void C智能机械臂Dlg::OnTimer(UINT_PTR nIDEvent)
 		if (keyDown('Q')) in.z -= 1.0;
 		if (keyDown('R')) in.pitch += 1.0;
 		if (keyDown('F')) in.pitch -= 1.0;
+		if (keyDown('T')) in.roll += 1.0;
+		if (keyDown('G')) in.roll -= 1.0;
 
 		// 鼠标摇杆：优先用于 X/Y（更接近“虚拟摇杆”手感）
 		if (m_staticMainJogPad.GetSafeHwnd() && m_staticMainJogPad.IsActive())
@@ -1056,7 +1123,7 @@ void C智能机械臂Dlg::OnTimer(UINT_PTR nIDEvent)
 			in.y = m_staticMainJogPad.GetY();
 		}
 
-		in.active = (std::fabs(in.x) + std::fabs(in.y) + std::fabs(in.z) + std::fabs(in.pitch)) > 0.0;
+		in.active = (std::fabs(in.x) + std::fabs(in.y) + std::fabs(in.z) + std::fabs(in.pitch) + std::fabs(in.roll)) > 0.0;
 
 		// 同步滑条参数到 JogController（实时调参）
 		JogController::Params p = m_jog.GetParams();
@@ -1067,6 +1134,7 @@ void C智能机械臂Dlg::OnTimer(UINT_PTR nIDEvent)
 		}
 		p.speedMmPerSec = (double)m_sliderSpeedMm.GetPos() * speedMul;
 		p.pitchDegPerSec = (double)m_sliderSpeedPitch.GetPos() * speedMul;
+		p.rollDegPerSec = p.pitchDegPerSec; // 滚转与俯仰共用角速度滑条
 		m_jog.SetParams(p);
 
 		// ===== 视觉跟随（Visual Servo）=====
@@ -1132,6 +1200,14 @@ void C智能机械臂Dlg::OnTimer(UINT_PTR nIDEvent)
 		}
 		m_vs.SetAdvanceCommand(adv);
 
+		// 相机姿态：当前关节角 FK（含手眼外参），让 Cam 速度在任意姿态下都映射到正确的 Base 方向
+		{
+			const ArmKinematics::JointAnglesRad q = ReadCurrentJoints();
+			ArmKinematics::LinkFrames frames;
+			ArmKinematics::ForwardKinematicsFrames(ArmCalib(), q, frames);
+			m_vs.SetCameraOrientation(frames.f[ArmKinematics::LinkFrames::kCamera].R);
+		}
+
 		// Compute output once
 		VisualServoOutput vsOut;
 		m_vs.ComputeOutput(vsOut);
@@ -1201,6 +1277,32 @@ void C智能机械臂Dlg::OnTimer(UINT_PTR nIDEvent)
 			m_staticVsStatus.SetWindowTextW(s);
 		}
 
+		// 可达性图：标定变化（含首次）时后台加载/重建，就绪后交给 Jog
+		{
+			const MotionConfig& mc = m_motion.Config();
+			if (KinematicsCalib::ArmFingerprint(m_kc, &mc) != m_reachBuilder.RequestedFingerprint())
+			{
+				m_reachBuilder.Start(KinematicsCalib::Compile(m_kc, &mc), ReachabilityMap::GridParams(), ReachabilityCacheDir());
+			}
+			if (auto map = m_reachBuilder.TakeResult())
+			{
+				m_jog.SetReachabilityMap(map);
+			}
+		}
+
+		// 灵活度图：同样按标定指纹后台重建（只算 J2..J4，与 J1 无关，不写缓存）
+		{
+			const MotionConfig& mc = m_motion.Config();
+			if (KinematicsCalib::ArmFingerprint(m_kc, &mc) != m_manipBuilder.RequestedFingerprint())
+			{
+				m_manipBuilder.Start(KinematicsCalib::Compile(m_kc, &mc), ManipulabilityMap::GridParams());
+			}
+			if (auto map = m_manipBuilder.TakeResult())
+			{
+				m_jog.SetManipulabilityMap(map);
+			}
+		}
+
 		std::wstring why;
 		const bool ok = m_jog.Tick(why);
 		if (!ok)
@@ -1212,10 +1314,23 @@ void C智能机械臂Dlg::OnTimer(UINT_PTR nIDEvent)
 		// 更新 UI pose 文本（先显示 target，后续 HUD 会更丰富）
 		const auto pose = m_jog.GetTargetPose();
 		CString s;
-		s.Format(L"Pose: (X=%.0f,Y=%.0f,Z=%.0f,p=%.1f)%s%s",
+		const ArmKinematics::ProjectKind pk = m_jog.GetLastProjectKind();
+		const bool sliding = in.active && ok
+			&& pk != ArmKinematics::ProjectKind::Unchanged && pk != ArmKinematics::ProjectKind::Failed;
+		const bool collided = (m_jog.GetLastCollision() != CollisionModel::Hit::None);
+		const IkCache* ikCache = m_jog.GetIkCache();
+		s.Format(L"Pose: (X=%.0f,Y=%.0f,Z=%.0f,p=%.1f)%s%s%s",
 		         pose.x_mm, pose.y_mm, pose.z_mm, pose.pitch_deg,
 		         in.active ? L" [Jog]" : L"",
-		         (!ok && !why.empty()) ? L" [IK失败]" : L"");
+		         sliding ? L" [边界]" : L"",
+		         collided ? L" [碰撞]" : ((!ok && !why.empty()) ? L" [IK失败]" : L""));
+		if (ikCache)
+		{
+			// IK 缓存命中率（累计），悬停/微动时应接近 100%
+			CString c;
+			c.Format(L" IK缓存%.0f%%", 100.0 * ikCache->GetStats().HitRate());
+			s += c;
+		}
 		m_staticMainPose.SetWindowTextW(s);
 
 		// 更新 HUD 叠加层状态（渲染线程会读取）
@@ -1229,6 +1344,11 @@ void C智能机械臂Dlg::OnTimer(UINT_PTR nIDEvent)
 			                                              pose,
 			                                              ok,
 			                                              why);
+			const auto manipMap = m_jog.GetManipulabilityMap();
+			ManipulabilityMap::Sample dex;
+			const bool dexValid = manipMap && manipMap->Query(pose.x_mm, pose.y_mm, pose.z_mm, pose.pitch_deg, dex);
+			KinematicsOverlayService::Instance().UpdateManipulability(manipMap, dexValid, dex.manip, dex.invCond,
+			                                                         m_jog.GetLastSpeedScale());
 			KinematicsOverlayService::Instance().UpdateVisualServo(
 				vsEnable,
 				useVs,
@@ -1779,6 +1899,8 @@ void C智能机械臂Dlg::ApplyMainOverlaySettings()
 	s.mirrorHorizontal = (m_chkMainMirror.GetCheck() == BST_CHECKED);
 	s.showCrosshair = (m_chkMainCrosshair.GetCheck() == BST_CHECKED);
 	s.showReferenceLines = (m_chkMainGrid.GetCheck() == BST_CHECKED);
+	// 灵活度热图（CameraOverlay\\ManipMap，默认开；无界面开关）
+	s.showManipMap = AfxGetApp()->GetProfileInt(L"CameraOverlay", L"ManipMap", 1) != 0;
 
 	const int sel = m_comboMainRotation.GetCurSel();
 	if (sel == 1) s.rotation = VideoRotation::Rotate90;
@@ -14,6 +14,8 @@
 #include "MotionController.h"
 #include "KinematicsConfig.h"
 #include "JogController.h"
+#include "ManipulabilityMap.h"
+#include "ReachabilityMap.h"
 #include "JogPadCtrl.h"
 #include "VisualServoController.h"
 #include "VisionService.h"
@@ -70,8 +72,15 @@ protected:
 private:
 	void BroadcastSettingsImported();
 	void LoadVisionSettingsFromProfile();
+	// Jog 段（模式 / IK 缓存 / 择优 / 奇异降速）与碰撞模型；启动与导入参数后调用
+	void LoadJogSettingsFromProfile();
 	void SyncVisionAlgoUiFromState();
 
+	// 当前关节角：取 ServoStateEstimator 的估计（指令预测 + 回读校正），尚无估计的关节取 Home
+	ArmKinematics::JointAnglesRad ReadCurrentJoints();
+	// m_armCalib，配置（关节映射 / 标定 / 手眼外参）变化时先重编译
+	const KinematicsCalib& ArmCalib();
+
 	// ===== 主界面：相机预览 =====
 private:
 	struct DeviceInfo
@@ -163,9 +172,18 @@ private:
 	KinematicsConfig m_kc;
 	JogController m_jog;
 
+	// 工作空间可达性图（后台构建/加载缓存，标定变化时重建），供 Jog 预筛选目标
+	ReachabilityMapBuilder m_reachBuilder;
+
+	// 灵活度图（后台并行计算，标定变化时重建），供 Jog 奇异点降速与 HUD 热图
+	ManipulabilityMapBuilder m_manipBuilder;
+
 	// 视觉伺服：将视觉观测转换为 Jog 输入（未来视觉协同）
 	VisualServoController m_vs;
 
+	// 主界面每 tick 用的标定表（ReadCurrentJoints 的舵机位置换算、视觉伺服的相机姿态），经 ArmCalib() 取用
+	KinematicsCalib m_armCalib;
+
 	// 视觉线程：从预览拉帧并产出 VisualObservation（先提供基础验证管线）
 	VisionService m_vision;
 };